@@ -463,6 +463,12 @@ public:
     enum EntryType { Directory, File, Symlink };
 
     void addEntry(EntryType type, const QString &fileName, const QByteArray &contents);
+    void addStream(const QString &fileName, QIODevice *source);
+    void addDeflated(const QString &fileName, QIODevice *deflated, uint crc_32, qint64 size, const QDateTime &modified);
+
+private:
+    FileHeader newHeader(EntryType type, const QString &fileName, const QDateTime &modified);
+    void writeLocalHeader(const FileHeader &header);
 };
 
 LocalFileHeader CentralFileHeader::toLocalHeader() const
@@ -595,13 +601,8 @@ void ZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const Q
             compression = ZipWriter::AlwaysCompress;
     }
 
-    FileHeader header;
-    memset(&header.h, 0, sizeof(CentralFileHeader));
-    writeUInt(header.h.signature, 0x02014b50);
-
-    writeUShort(header.h.version_needed, 0x14);
+    FileHeader header = newHeader(type, fileName, QDateTime::currentDateTime());
     writeUInt(header.h.uncompressed_size, contents.length());
-    writeMSDosDate(header.h.last_mod_file, QDateTime::currentDateTime());
     QByteArray data = contents;
     if (compression == ZipWriter::AlwaysCompress) {
         writeUShort(header.h.compression_method, 8);
@@ -634,6 +635,23 @@ void ZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const Q
     crc_32 = ::crc32(crc_32, (const uchar *)contents.constData(), contents.length());
     writeUInt(header.h.crc_32, crc_32);
 
+    fileHeaders.append(header);
+
+    writeLocalHeader(header);
+    device->write(data);
+    start_of_directory = device->pos();
+    dirtyFileTree = true;
+}
+
+FileHeader ZipWriterPrivate::newHeader(EntryType type, const QString &fileName, const QDateTime &modified)
+{
+    FileHeader header;
+    memset(&header.h, 0, sizeof(CentralFileHeader));
+    writeUInt(header.h.signature, 0x02014b50);
+
+    writeUShort(header.h.version_needed, 0x14);
+    writeMSDosDate(header.h.last_mod_file, modified);
+
     header.file_name = fileName.toLocal8Bit();
     if (header.file_name.size() > 0xffff) {
         qWarning("QZip: Filename too long, chopping it to 65535 characters");
@@ -653,18 +671,179 @@ void ZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const Q
     }
     writeUInt(header.h.external_file_attributes, mode << 16);
     writeUInt(header.h.offset_local_header, start_of_directory);
+    return header;
+}
 
-
-    fileHeaders.append(header);
-
+void ZipWriterPrivate::writeLocalHeader(const FileHeader &header)
+{
     LocalFileHeader h = header.h.toLocalHeader();
     device->write((const char *)&h, sizeof(LocalFileHeader));
     device->write(header.file_name);
-    device->write(data);
+}
+
+// the contents are compressed and written a piece at a time, the sizes
+// and crc in the local header are filled in once they are all written.
+// if anything goes wrong the entry is dropped and the status set, a
+// broken entry isn't left in the archive
+void ZipWriterPrivate::addStream(const QString &fileName, QIODevice *source)
+{
+    ZDEBUG() << "streaming file  :" << fileName.toUtf8().data();
+
+    if (! (device->isOpen() || device->open(QIODevice::WriteOnly))) {
+        status = ZipWriter::FileOpenError;
+        return;
+    }
+    device->seek(start_of_directory);
+
+    bool compress = compressionPolicy != ZipWriter::NeverCompress;
+    FileHeader header = newHeader(File, fileName, QDateTime::currentDateTime());
+    if (compress)
+        writeUShort(header.h.compression_method, 8);
+    writeLocalHeader(header);
+
+    ZipDeflater deflater;
+    QByteArray in(256 * 1024, 0), out;
+    uint crc_32 = ::crc32(0, 0, 0);
+    qint64 size = 0, written = 0;
+    qint64 n = 0;
+    bool ok = true;
+    while (ok && (n = source->read(in.data(), in.size())) > 0) {
+        if (compress) {
+            ok = deflater.add(in.constData(), n, out) && device->write(out) == out.size();
+            written += out.size();
+            out.clear();
+        } else {
+            crc_32 = ::crc32(crc_32, (const uchar *)in.constData(), n);
+            size += n;
+            ok = device->write(in.constData(), n) == n;
+            written += n;
+        }
+    }
+    ok = ok && n == 0;
+    if (ok && compress) {
+        ok = deflater.finish(out) && device->write(out) == out.size();
+        written += out.size();
+        crc_32 = deflater.checksum();
+        size = deflater.size();
+    }
+
+    if (!ok) {
+        qWarning("QZip: failed to add %s, skipping", fileName.toLocal8Bit().constData());
+        status = ZipWriter::FileWriteError;
+        device->seek(start_of_directory);
+        return;
+    }
+
+    writeUInt(header.h.crc_32, crc_32);
+    writeUInt(header.h.compressed_size, written);
+    writeUInt(header.h.uncompressed_size, size);
+    fileHeaders.append(header);
+
+    start_of_directory = device->pos();
+    device->seek(readUInt(header.h.offset_local_header));
+    writeLocalHeader(header);
+    device->seek(start_of_directory);
+    dirtyFileTree = true;
+}
+
+// deflated by the caller with ZipDeflater, just copied across, dropped
+// as above if it can't all be
+void ZipWriterPrivate::addDeflated(const QString &fileName, QIODevice *deflated, uint crc_32, qint64 size, const QDateTime &modified)
+{
+    ZDEBUG() << "adding deflated :" << fileName.toUtf8().data();
+
+    if (! (device->isOpen() || device->open(QIODevice::WriteOnly))) {
+        status = ZipWriter::FileOpenError;
+        return;
+    }
+    device->seek(start_of_directory);
+
+    FileHeader header = newHeader(File, fileName, modified);
+    writeUShort(header.h.compression_method, 8);
+    writeUInt(header.h.crc_32, crc_32);
+    writeUInt(header.h.compressed_size, deflated->size());
+    writeUInt(header.h.uncompressed_size, size);
+    writeLocalHeader(header);
+
+    QByteArray buffer(256 * 1024, 0);
+    qint64 n = 0, written = 0;
+    bool ok = true;
+    while (ok && (n = deflated->read(buffer.data(), buffer.size())) > 0) {
+        ok = device->write(buffer.constData(), n) == n;
+        written += n;
+    }
+
+    if (!ok || n != 0 || written != deflated->size()) {
+        qWarning("QZip: failed to add %s, skipping", fileName.toLocal8Bit().constData());
+        status = ZipWriter::FileWriteError;
+        device->seek(start_of_directory);
+        return;
+    }
+
+    fileHeaders.append(header);
     start_of_directory = device->pos();
     dirtyFileTree = true;
 }
 
+//////////////////////////////  Deflater
+
+ZipDeflater::ZipDeflater()
+    : stream(new z_stream), ok(false), crc(::crc32(0, 0, 0)), total(0)
+{
+    memset(stream, 0, sizeof(z_stream));
+    ok = deflateInit2(stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+ZipDeflater::~ZipDeflater()
+{
+    if (ok)
+        deflateEnd(stream);
+    delete stream;
+}
+
+bool ZipDeflater::add(const char *data, qint64 length, QByteArray &out)
+{
+    while (ok && length > 0) {
+        uInt piece = length > (1 << 30) ? (1 << 30) : uInt(length);
+        crc = ::crc32(crc, (const Bytef *)data, piece);
+        total += piece;
+
+        stream->next_in = (Bytef *)data;
+        stream->avail_in = piece;
+        ok = run(Z_NO_FLUSH, out);
+
+        data += piece;
+        length -= piece;
+    }
+    return ok;
+}
+
+bool ZipDeflater::finish(QByteArray &out)
+{
+    stream->next_in = 0;
+    stream->avail_in = 0;
+    return ok && (ok = run(Z_FINISH, out));
+}
+
+bool ZipDeflater::run(int flush, QByteArray &out)
+{
+    const int chunk = 64 * 1024;
+    forever {
+        int at = out.size();
+        out.resize(at + chunk);
+        stream->next_out = (Bytef *)out.data() + at;
+        stream->avail_out = chunk;
+
+        int res = ::deflate(stream, flush);
+        out.resize(at + chunk - stream->avail_out);
+
+        if (res == Z_STREAM_ERROR)
+            return false;
+        if (flush == Z_FINISH ? res == Z_STREAM_END : stream->avail_out != 0)
+            return true;
+    }
+}
+
 //////////////////////////////  Reader
 
 /*!
@@ -1180,8 +1359,9 @@ void ZipWriter::addFile(const QString &fileName, const QByteArray &data)
 
 /*!
     Add a file to the archive with \a device as the source of the contents.
-    The contents returned from QIODevice::readAll() will be used as the
-    filedata.
+    The contents are read and compressed a piece at a time, so the file
+    doesn't need to fit in memory, the device only needs to be writable
+    to patch the sizes in when it's done.
     The file will be stored in the archive using the \a fileName which
     includes the full path in the archive.
 */
@@ -1197,11 +1377,23 @@ void ZipWriter::addFile(const QString &fileName, QIODevice *device)
             return;
         }
     }
-    d->addEntry(ZipWriterPrivate::File, QDir::fromNativeSeparators(fileName), device->readAll());
+    d->addStream(QDir::fromNativeSeparators(fileName), device);
     if (opened)
         device->close();
 }
 
+/*!
+    Add a file that has already been compressed with ZipDeflater, the
+    compressed contents are copied from the \a deflated device (which
+    must be open and at the start) a piece at a time. The \a crc32 and
+    \a size of the uncompressed data are the deflater's.
+*/
+void ZipWriter::addDeflatedFile(const QString &fileName, QIODevice *deflated, uint crc32, qint64 size, const QDateTime &lastModified)
+{
+    Q_ASSERT(deflated);
+    d->addDeflated(QDir::fromNativeSeparators(fileName), deflated, crc32, size, lastModified);
+}
+
 /*!
     Create a new directory in the archive with the specified \a dirName and
     the \a permissions;
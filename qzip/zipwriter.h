@@ -55,11 +55,41 @@
 
 #include <QtCore/qstring.h>
 #include <QtCore/qfile.h>
+#include <QtCore/qdatetime.h>
+
+struct z_stream_s;
 
 QT_BEGIN_NAMESPACE
 
 class ZipWriterPrivate;
 
+// Raw deflate a piece at a time, the way entries are compressed in the
+// archive, so files can be compressed away from the writer (in another
+// thread say) without having all of the file in memory, and added with
+// ZipWriter::addDeflatedFile().
+class ZipDeflater
+{
+public:
+    ZipDeflater();
+    ~ZipDeflater();
+
+    // the compressed data is appended to out, false on error
+    bool add(const char *data, qint64 length, QByteArray &out);
+    bool finish(QByteArray &out);
+
+    uint checksum() const { return crc; } // crc32 of the uncompressed data
+    qint64 size() const { return total; } // uncompressed bytes
+
+private:
+    bool run(int flush, QByteArray &out);
+
+    z_stream_s *stream;
+    bool ok;
+    uint crc;
+    qint64 total;
+    Q_DISABLE_COPY(ZipDeflater)
+};
+
 
 class ZipWriter
 {
@@ -100,6 +130,8 @@ public:
 
     void addFile(const QString &fileName, QIODevice *device);
 
+    void addDeflatedFile(const QString &fileName, QIODevice *deflated, uint crc32, qint64 size, const QDateTime &lastModified);
+
     void addDirectory(const QString &dirName);
 
     void addSymLink(const QString &fileName, const QString &destination);
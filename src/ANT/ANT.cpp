@@ -85,7 +85,7 @@ const ant_sensor_type_t ANT::ant_sensor_types[] = {
 // thread and is part of the GC architecture NOT related to the
 // hardware controller.
 //
-ANT::ANT(QObject *parent, DeviceConfiguration *devConf, QString athlete) : QThread(parent), devConf(devConf), portInitDone(1)
+ANT::ANT(QObject *parent, DeviceConfiguration *devConf, QString athlete) : QThread(parent), devConf(devConf), portInitDone(1), latest(1)
 {
     qRegisterMetaType<ANTMessage>("ANTMessage");
     qRegisterMetaType<uint16_t>("uint16_t");
@@ -126,10 +126,10 @@ ANT::ANT(QObject *parent, DeviceConfiguration *devConf, QString athlete) : QThre
     if (!elapsedTimer.isMonotonic())
         qDebug() << "Caution: ANT timer is not monotonic";
 
-    // state machine
-    state = ST_WAIT_FOR_SYNC;
-    length = bytes = 0;
-    checksum = ANT_SYNC_BYTE;
+    // receive buffer and telemetry copies
+    rxBytes = 0;
+    writing = 0;
+    reading = 2;
 
     // ant ids - may not be configured of course
     if (devConf && devConf->deviceProfile.length())
@@ -246,9 +246,7 @@ void ANT::run()
 
     for (int i=0; i<ANT_MAX_CHANNELS; i++) antChannel[i]->init();
 
-    state = ST_WAIT_FOR_SYNC;
-    length = bytes = 0;
-    checksum = ANT_SYNC_BYTE;
+    rxBytes = 0;
 
     if (openPort() == 0) {
 
@@ -268,14 +266,19 @@ void ANT::run()
 
     while(1)
     {
-        // read more bytes from the device
-        uint8_t byte;
+        // wait for the device and take everything it has
+        int ready = waitForData(ANT_READWAIT);
+        int rc = ready ? rawRead(rxBuffer + rxBytes, ANT_RX_BUFFER_SIZE - rxBytes) : 0;
 
-        int rc = rawRead(&byte, 1);
+        if (rc > 0) {
 
-        if (rc > 0)
-            receiveByte((unsigned char)byte);
-        else {
+            // keep a partial message at the end for next time
+            rxBytes += rc;
+            int used = receiveBytes(rxBuffer, rxBytes);
+            rxBytes -= used;
+            if (rxBytes) memmove(rxBuffer, rxBuffer + used, rxBytes);
+
+        } else if (ready) {
 
             // Recognise USB device removal. Linux transitions through -5 (I/O error)
             // to -6 (No such device or address). Windows seems to stick on -5
@@ -289,6 +292,9 @@ void ANT::run()
             msleep(5);
         }
 
+        // let the controller see it
+        publishTelemetry();
+
         //----------------------------------------------------------------------
         // LISTEN TO CONTROLLER FOR COMMANDS
         //----------------------------------------------------------------------
@@ -641,10 +647,22 @@ ANT::quit(int code)
     return 0;
 }
 
+// on the thread, swap the copy we wrote for the one that was latest
+void
+ANT::publishTelemetry()
+{
+    published[writing] = telemetry;
+    writing = latest.fetchAndStoreOrdered(writing | TELEMETRY_FRESH) & TELEMETRY_INDEX;
+}
+
 void
 ANT::getRealtimeData(RealtimeData &rtData)
 {
-    rtData = telemetry;
+    // swap for the latest if there is a newer one
+    if (latest.loadAcquire() & TELEMETRY_FRESH)
+        reading = latest.fetchAndStoreOrdered(reading) & TELEMETRY_INDEX;
+
+    rtData = published[reading];
     rtData.mode = mode;
     rtData.setLoad(load);
     rtData.setSlope(gradient);
@@ -949,52 +967,45 @@ ANT::sendMessage(ANTMessage m) {
     rawWrite((uint8_t*)padding, 5);
 }
 
-void
-ANT::receiveByte(unsigned char byte) {
-
-    switch (state) {
-        case ST_WAIT_FOR_SYNC:
-            if (byte == ANT_SYNC_BYTE) {
-                state = ST_GET_LENGTH;
-                checksum = ANT_SYNC_BYTE;
-                rxMessage[0] = byte;
-            }
-            break;
+//
+// Handle the messages in the bytes read, each is handled where it is
+// rather than copied out. A message is sync, length, id, data and a
+// checksum of all of them. Returns how many bytes were used, a partial
+// message at the end is left for when the rest of it has been read.
+//
+int
+ANT::receiveBytes(unsigned char *data, int count) {
 
-        case ST_GET_LENGTH:
-            if ((byte == 0) || (byte > ANT_MAX_LENGTH)) {
-                state = ST_WAIT_FOR_SYNC;
-            }
-            else {
-              rxMessage[ANT_OFFSET_LENGTH] = byte;
-                checksum ^= byte;
-                length = byte;
-                bytes = 0;
-                state = ST_GET_MESSAGE_ID;
-            }
-            break;
+    int i = 0;
+    while (i < count) {
 
-        case ST_GET_MESSAGE_ID:
-            rxMessage[ANT_OFFSET_ID] = byte;
-            checksum ^= byte;
-            state = ST_GET_DATA;
-            break;
+        // look for the start of a message
+        if (data[i] != ANT_SYNC_BYTE) {
+            i++;
+            continue;
+        }
 
-        case ST_GET_DATA:
-            rxMessage[ANT_OFFSET_DATA + bytes] = byte;
-            checksum ^= byte;
-            if (++bytes >= length){
-                state = ST_VALIDATE_PACKET;
-            }
-            break;
+        if (i + ANT_OFFSET_LENGTH >= count) break;
+        int length = data[i + ANT_OFFSET_LENGTH];
+        if (length == 0 || length > ANT_MAX_LENGTH) {
+            i++;
+            continue;
+        }
+        if (i + length + 4 > count) break;
 
-        case ST_VALIDATE_PACKET:
-            if (checksum == byte){
-                processMessage();
-            }
-            state = ST_WAIT_FOR_SYNC;
-            break;
+        unsigned char checksum = 0;
+        for (int k=0; k < length + 3; k++) checksum ^= data[i + k];
+
+        // not a message after all, look again from the next byte
+        if (checksum != data[i + length + 3]) {
+            i++;
+            continue;
+        }
+
+        processMessage(data + i);
+        i += length + 4;
     }
+    return i;
 }
 
 
@@ -1002,21 +1013,21 @@ ANT::receiveByte(unsigned char byte) {
 // Pass inbound message to channel for handling
 //
 void
-ANT::handleChannelEvent(void) {
-    int channel = rxMessage[ANT_OFFSET_DATA] & 0x7;
+ANT::handleChannelEvent(unsigned char *message) {
+    int channel = message[ANT_OFFSET_DATA] & 0x7;
     if(channel >= 0 && channel < channels) {
 
         // handle a channel event here!
-        antChannel[channel]->receiveMessage(rxMessage);
+        antChannel[channel]->receiveMessage(message);
     }
 }
 
 void
-ANT::processMessage(void) {
+ANT::processMessage(unsigned char *message) {
 
-    ANTMessage m(this, rxMessage); // for debug!
+    ANTMessage m(this, message); // for debug!
 
-//fprintf(stderr, "<< receive %i: ", rxMessage[ANT_OFFSET_CHANNEL_NUMBER]);
+//fprintf(stderr, "<< receive %i: ", message[ANT_OFFSET_CHANNEL_NUMBER]);
 //for(int i=0; i<m.length+3; i++) fprintf(stderr, "%02x ", m.data[i]);
 //fprintf(stderr, "\n");
 
@@ -1025,7 +1036,7 @@ ANT::processMessage(void) {
     unsigned char RS = 'R';
     emit receivedAntMessage(RS, m, timestamp);
 
-    switch (rxMessage[ANT_OFFSET_ID]) {
+    switch (message[ANT_OFFSET_ID]) {
         case ANT_NOTIF_STARTUP:
             ANT_Reset_Acknowledge = true;
             break;
@@ -1034,17 +1045,17 @@ ANT::processMessage(void) {
         case ANT_CHANNEL_STATUS:
         case ANT_CHANNEL_ID:
         case ANT_BURST_DATA:
-            handleChannelEvent();
+            handleChannelEvent(message);
             break;
 
         case ANT_CHANNEL_EVENT:
-          switch (rxMessage[ANT_OFFSET_MESSAGE_CODE]) {
+          switch (message[ANT_OFFSET_MESSAGE_CODE]) {
           case EVENT_TRANSFER_TX_FAILED:
             break;
           case EVENT_TRANSFER_TX_COMPLETED:
             // fall through
           default:
-            handleChannelEvent();
+            handleChannelEvent(message);
           }
           break;
 
@@ -1280,22 +1291,39 @@ int ANT::rawRead(uint8_t bytes[], int size)
         return usb2->read((char *)bytes, size);
     }
 #endif
-    int i=0;
-    uint8_t byte;
-
-    // read one byte at a time sleeping when no data ready
-    // until we timeout waiting then return error
-    for (i=0; i<size; i++) {
-        int rc = read(devicePort, &byte, 1);
-        if (rc == -1 || rc == 0) return -1; // error!
-        else bytes[i] = byte;
-    }
-    return i;
+    // whatever is there, up to size, the port is non-blocking
+    int rc = read(devicePort, bytes, size);
+    if (rc > 0) return rc;
+    if (rc == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+    return rc == -1 ? -errno : -1; // error or hangup
 
 #endif
     return -1; // keep compiler happy.
 }
 
+// wait up to msecs for bytes to read; 1 when there are (or the read will
+// say so), 0 if not and -1 when we can't wait, the USB2 reads wait for
+// bytes themselves
+int ANT::waitForData(int msecs)
+{
+#ifdef WIN32
+    Q_UNUSED(msecs);
+    return -1;
+#else
+#ifdef GC_HAVE_LIBUSB
+    if (usbMode == USB2) return -1;
+#endif
+    struct pollfd fd;
+    fd.fd = devicePort;
+    fd.events = POLLIN;
+    fd.revents = 0;
+
+    int rc = poll(&fd, 1, msecs);
+    if (rc == 0 || (rc == -1 && errno == EINTR)) return 0;
+    return 1;
+#endif
+}
+
 // convert 'p' 'c' etc into ANT values for device type
 int ANT::interpretSuffix(char c)
 {
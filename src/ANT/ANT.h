@@ -42,6 +42,7 @@
 #include <QProgressDialog>
 #include <QFile>
 #include <QSemaphore>
+#include <QAtomicInt>
 
 //
 // Time
@@ -70,6 +71,7 @@
 #else
 #include <termios.h> // unix!!
 #include <unistd.h> // unix!!
+#include <poll.h>
 #include <sys/ioctl.h>
 #ifndef N_TTY // for OpenBSD
 #define N_TTY 0
@@ -88,6 +90,12 @@
 #define ANT_READTIMEOUT    1000
 #define ANT_WRITETIMEOUT   2000
 
+// how long the reader waits for bytes before checking for commands, ms
+#define ANT_READWAIT       10
+
+// bytes read from the device in one go
+#define ANT_RX_BUFFER_SIZE 512
+
 class ANTMessage;
 class ANTChannel;
 
@@ -497,9 +505,9 @@ public:
 
     // transmission
     void sendMessage(ANTMessage);
-    void receiveByte(unsigned char byte);
-    void handleChannelEvent(void);
-    void processMessage(void);
+    int receiveBytes(unsigned char *data, int count); // returns bytes used
+    void handleChannelEvent(unsigned char *message);
+    void processMessage(unsigned char *message);
 
     // calibration
     uint8_t getCalibrationType()
@@ -589,6 +597,7 @@ public:
     int closePort();
     int rawRead(uint8_t bytes[], int size);
     int rawWrite(uint8_t *bytes, int size);
+    int waitForData(int msecs);
 
     bool modeERGO(void) const;
     bool modeSLOPE(void) const;
@@ -679,6 +688,16 @@ private:
     RealtimeData telemetry;
     CalibrationData calibration;
 
+    // telemetry is handed to the controller without a lock, there are
+    // three copies; the one we are writing, the one it is reading and
+    // the latest complete one. latest is its index, or'd with
+    // TELEMETRY_FRESH until the controller takes it.
+    enum { TELEMETRY_FRESH = 4, TELEMETRY_INDEX = 3 };
+    void publishTelemetry();
+    RealtimeData published[3];
+    QAtomicInt latest;
+    int writing, reading;
+
     QMutex pvars;  // lock/unlock access to telemetry data between thread and controller
     int Status;     // what status is the client in?
     bool configuring; // set to true if we're in configuration mode.
@@ -708,14 +727,12 @@ private:
 #endif
 
     bool ANT_Reset_Acknowledge;
-    unsigned char rxMessage[ANT_MAX_MESSAGE_SIZE];
-
-    // state machine whilst receiving bytes
-    enum States {ST_WAIT_FOR_SYNC, ST_GET_LENGTH, ST_GET_MESSAGE_ID, ST_GET_DATA, ST_VALIDATE_PACKET} state;
-    //enum States state;
-    int length;
-    int bytes;
-    int checksum;
+
+    // bytes read but not parsed yet, messages are handled where they are
+    // in here. The slack lets ANTMessage copy a full message from any of them.
+    unsigned char rxBuffer[ANT_RX_BUFFER_SIZE + ANT_MAX_MESSAGE_SIZE];
+    int rxBytes;
+
     int powerchannels; // how many power channels do we have?
     QDateTime lastCadenceMessage;
 
@@ -160,6 +160,9 @@ ANTlocalController::getRealtimeData(RealtimeData &rtData)
 {
     if(!myANTlocal->isRunning())
     {
+        // the telemetry thread only just missed it, the gui will find out
+        if (QThread::currentThread() != qApp->thread()) return;
+
         QMessageBox msgBox;
         msgBox.setText(tr("Cannot open ANT+ device"));
         msgBox.setIcon(QMessageBox::Critical);
@@ -174,6 +177,14 @@ ANTlocalController::getRealtimeData(RealtimeData &rtData)
     processRealtimeData(rtData);
 }
 
+// the telemetry is handed over without a lock and loads are just sent,
+// as long as it is running the gui will never need to tell anyone
+bool
+ANTlocalController::threadSafe()
+{
+    return myANTlocal->isRunning();
+}
+
 uint8_t
 ANTlocalController::getCalibrationType()
 {
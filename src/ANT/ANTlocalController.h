@@ -59,6 +59,7 @@ public:
     // telemetry push pull
     bool doesPush(), doesPull(), doesLoad();
     void getRealtimeData(RealtimeData &rtData);
+    bool threadSafe();
     void pushRealtimeData(RealtimeData &rtData);
 
     // now with the kickr we can control trainers
@@ -22,6 +22,7 @@
 #include "Athlete.h"
 #include "AllPlotWindow.h"
 #include "AllPlotSlopeCurve.h"
+#include "AllPlotDecimatedData.h"
 #include "ReferenceLineDialog.h"
 #include "ExhaustionDialog.h"
 #include "RideFile.h"
@@ -281,6 +282,26 @@ class TimeScaleDraw: public ScaleScaleDraw
 static inline double
 max(double a, double b) { if (a > b) return a; else return b; }
 
+// copy a ride column into a plot array (if it is wanted, i.e. not empty)
+// converting units and clipping at zero as we go. a column that is not
+// present is all zeroes, see RideFile::column()
+static void
+fillFromColumn(QVector<double> &array, const double *column, bool positive, double scale=1.0, double add=0.0)
+{
+    if (array.isEmpty()) return;
+
+    if (column == NULL) {
+        array.fill(positive ? 0 : add);
+        return;
+    }
+
+    double *data = array.data();
+    for (int i=0; i<array.count(); i++) {
+        double value = (column[i] * scale) + add;
+        data[i] = positive ? max(0, value) : value;
+    }
+}
+
 AllPlotObject::AllPlotObject(AllPlot *plot, QList<UserData*> user) : plot(plot)
 {
     maxKM = maxSECS = 0;
@@ -531,6 +552,7 @@ AllPlotObject::setUserData(QList<UserData*>user)
         U[k].curve->detach(); delete U[k].curve;
     }
     U.clear();
+    smoothing.clear();
 
     // setup the U array
     int k=0;
@@ -1635,30 +1657,6 @@ AllPlot::setHighlightIntervals(bool state)
     }
 }
 
-struct DataPoint {
-
-    double time, hr, watts, atiss, antiss, np, rv, rcad, rgct,
-           smo2, thb, o2hb, hhb, ap, xp, speed, cad, 
-           alt, temp, wind, torque, lrbalance, lte, rte, lps, rps,
-           lpco, rpco, lppb, rppb, lppe, rppe, lpppb, rpppb, lpppe, rpppe,
-           kphd, wattsd, cadd, nmd, hrd, slope, tcore;
-
-    // user values
-    QList<double>user;
-
-    DataPoint(double t, double h, double w, double at, double an, double n, double rv, double rcad, double rgct,
-              double smo2, double thb, double o2hb, double hhb, double l, double x, double s, double c,
-              double a, double te, double wi, double tq, double lrb, double lte, double rte, double lps, double rps,
-              double lpco, double rpco, double lppb, double rppb, double lppe, double rppe, double lpppb, double rpppb, double lpppe, double rpppe,
-              double kphd, double wattsd, double cadd, double nmd, double hrd, double sl, double tcore, QList<double>user) :
-
-              time(t), hr(h), watts(w), atiss(at), antiss(an), np(n), rv(rv), rcad(rcad), rgct(rgct),
-              smo2(smo2), thb(thb), o2hb(o2hb), hhb(hhb), ap(l), xp(x), speed(s), cad(c),
-              alt(a), temp(te), wind(wi), torque(tq), lrbalance(lrb), lte(lte), rte(rte), lps(lps), rps(rps),
-              lpco(lpco), rpco(rpco), lppb(lppb), rppb(rppb), lppe(lppe), rppe(rppe), lpppb(lpppb), rpppb(rpppb), lpppe(lpppe), rpppe(rpppe),
-              kphd(kphd), wattsd(wattsd), cadd(cadd), nmd(nmd), hrd(hrd), slope(sl), tcore(tcore), user(user) {}
-};
-
 bool AllPlot::shadeZones() const
 {
     return shade_zones;
@@ -1836,11 +1834,6 @@ AllPlot::recalc(AllPlotObject *objects)
     
     // we should only smooth the curves if objects->smoothed rate is greater than sample rate
 
-    // user data totals
-    QVector<double> utotals;
-    utotals.resize(objects->U.count());
-    utotals.fill(0);
-
     // Offset for timeOfDay
     if (context->isCompareIntervals || !bytimeofday)
         timeoffset = 0;
@@ -1849,382 +1842,166 @@ AllPlot::recalc(AllPlotObject *objects)
 
     if (applysmooth > 0) {
 
-        double totalWatts = 0.0;
-        double totalNP = 0.0;
-        double totalRCad = 0.0;
-        double totalRV = 0.0;
-        double totalRGCT = 0.0;
-        double totalSmO2 = 0.0;
-        double totaltHb = 0.0;
-        double totalO2Hb = 0.0;
-        double totalHHb = 0.0;
-        double totalATISS = 0.0;
-        double totalANTISS = 0.0;
-        double totalXP = 0.0;
-        double totalAP = 0.0;
-        double totalHr = 0.0;
-        double totalTcore = 0.0;
-        double totalSpeed = 0.0;
-        double totalAccel = 0.0;
-        double totalWattsD = 0.0;
-        double totalCadD = 0.0;
-        double totalNmD = 0.0;
-        double totalHrD = 0.0;
-        double totalCad = 0.0;
-        double totalDist = 0.0;
-        double totalAlt = 0.0;
-        double totalSlope = 0.0;
-        double totalTemp = 0.0;
-        double totalWind = 0.0;
-        double totalTorque = 0.0;
-        double totalBalance = 0.0;
-        double totalLTE = 0.0;
-        double totalRTE = 0.0;
-        double totalLPS = 0.0;
-        double totalRPS = 0.0;
-        double totalLPCO = 0.0;
-        double totalRPCO = 0.0;
-        double totalLPPB = 0.0;
-        double totalRPPB = 0.0;
-        double totalLPPE = 0.0;
-        double totalRPPE = 0.0;
-        double totalLPPPB = 0.0;
-        double totalRPPPB = 0.0;
-        double totalLPPPE = 0.0;
-        double totalRPPPE = 0.0;
-        double currentGearRatio = 0.0;
-
-
-        QList<DataPoint> list;
-
-        objects->smoothWatts.resize(rideTimeSecs + 1);
-        objects->smoothNP.resize(rideTimeSecs + 1);
+        // the smoothed ends of the pedal power phases
+        QVector<double> balance, lppb, rppb, lppe, rppe, lpppb, rpppb, lpppe, rpppe;
+
+        // the series that are averaged, along with what must be done to
+        // the samples first. Gear and distance are not smoothed.
+        enum { Raw, Positive, Balance, Carry };
+        struct {
+            const QVector<double> *array;
+            QVector<double> *smoothed;
+            int fill;
+        } series[] = {
+            { &objects->wattsArray, &objects->smoothWatts, Raw },
+            { &objects->npArray, &objects->smoothNP, Raw },
+            { &objects->rvArray, &objects->smoothRV, Raw },
+            { &objects->rcadArray, &objects->smoothRCad, Raw },
+            { &objects->rgctArray, &objects->smoothRGCT, Raw },
+            { &objects->smo2Array, &objects->smoothSmO2, Raw },
+            { &objects->thbArray, &objects->smoothtHb, Raw },
+            { &objects->o2hbArray, &objects->smoothO2Hb, Raw },
+            { &objects->hhbArray, &objects->smoothHHb, Raw },
+            { &objects->atissArray, &objects->smoothAT, Raw },
+            { &objects->antissArray, &objects->smoothANT, Raw },
+            { &objects->xpArray, &objects->smoothXP, Raw },
+            { &objects->apArray, &objects->smoothAP, Raw },
+            { &objects->hrArray, &objects->smoothHr, Raw },
+            { &objects->tcoreArray, &objects->smoothTcore, Raw },
+            { &objects->speedArray, &objects->smoothSpeed, Raw },
+            { &objects->accelArray, &objects->smoothAccel, Raw },
+            { &objects->wattsDArray, &objects->smoothWattsD, Raw },
+            { &objects->cadDArray, &objects->smoothCadD, Raw },
+            { &objects->nmDArray, &objects->smoothNmD, Raw },
+            { &objects->hrDArray, &objects->smoothHrD, Raw },
+            { &objects->cadArray, &objects->smoothCad, Raw },
+            { &objects->altArray, &objects->smoothAltitude, Raw },
+            { &objects->slopeArray, &objects->smoothSlope, Raw },
+            { &objects->tempArray, &objects->smoothTemp, Carry },
+            { &objects->windArray, &objects->smoothWind, Raw },
+            { &objects->torqueArray, &objects->smoothTorque, Raw },
+            { &objects->balanceArray, &balance, Balance },
+            { &objects->lteArray, &objects->smoothLTE, Positive },
+            { &objects->rteArray, &objects->smoothRTE, Positive },
+            { &objects->lpsArray, &objects->smoothLPS, Positive },
+            { &objects->rpsArray, &objects->smoothRPS, Positive },
+            { &objects->lpcoArray, &objects->smoothLPCO, Raw },
+            { &objects->rpcoArray, &objects->smoothRPCO, Raw },
+            { &objects->lppbArray, &lppb, Positive },
+            { &objects->rppbArray, &rppb, Positive },
+            { &objects->lppeArray, &lppe, Positive },
+            { &objects->rppeArray, &rppe, Positive },
+            { &objects->lpppbArray, &lpppb, Positive },
+            { &objects->rpppbArray, &rpppb, Positive },
+            { &objects->lpppeArray, &lpppe, Positive },
+            { &objects->rpppeArray, &rpppe, Positive }
+        };
+        const int nseries = sizeof(series) / sizeof(series[0]);
+
+        // where each column of the engine goes, the series with no
+        // samples are not in it and are just 0
+        QVector<double*> out;
+        for (int s=0; s<nseries; s++) {
+            series[s].smoothed->fill(0.0, rideTimeSecs + 1);
+            if (!series[s].array->empty()) out << series[s].smoothed->data();
+        }
+        for (int k=0; k<objects->U.count(); k++) {
+            objects->U[k].smooth.fill(0.0, rideTimeSecs + 1);
+            if (!objects->U[k].array.empty()) out << objects->U[k].smooth.data();
+        }
+
+        // the series are integrated once for the ride, moving the
+        // slider only takes the differences
+        SmoothingEngine &engine = objects->smoothing;
+        if (engine.count() != objects->timeArray.count() || engine.columns() != out.count()) {
+
+            engine.setTimes(objects->timeArray.constData(), objects->timeArray.count(), rideItem->ride()->recIntSecs());
+
+            QVector<double> values;
+            for (int s=0; s<nseries; s++) {
+                const QVector<double> &array = *series[s].array;
+                if (array.empty()) continue;
+
+                values = array;
+                double last = 0.0;
+                for (int i=0; i<values.count(); i++) {
+                    switch (series[s].fill) {
+                    case Positive: if (values[i] < 0) values[i] = 0; break;
+                    case Balance: if (values[i] <= 0) values[i] = 50; break;
+                    case Carry: if (values[i] == RideFile::NA) values[i] = last; last = values[i]; break;
+                    default: break;
+                    }
+                }
+                engine.addSeries(values);
+            }
+            for (int k=0; k<objects->U.count(); k++) {
+                if (!objects->U[k].array.empty()) engine.addSeries(objects->U[k].array);
+            }
+            engine.prepare();
+        }
+
         objects->smoothGear.resize(rideTimeSecs + 1);
-        objects->smoothRV.resize(rideTimeSecs + 1);
-        objects->smoothRCad.resize(rideTimeSecs + 1);
-        objects->smoothRGCT.resize(rideTimeSecs + 1);
-        objects->smoothSmO2.resize(rideTimeSecs + 1);
-        objects->smoothtHb.resize(rideTimeSecs + 1);
-        objects->smoothO2Hb.resize(rideTimeSecs + 1);
-        objects->smoothHHb.resize(rideTimeSecs + 1);
-        objects->smoothAT.resize(rideTimeSecs + 1);
-        objects->smoothANT.resize(rideTimeSecs + 1);
-        objects->smoothXP.resize(rideTimeSecs + 1);
-        objects->smoothAP.resize(rideTimeSecs + 1);
-        objects->smoothHr.resize(rideTimeSecs + 1);
-        objects->smoothTcore.resize(rideTimeSecs + 1);
-        objects->smoothSpeed.resize(rideTimeSecs + 1);
-        objects->smoothAccel.resize(rideTimeSecs + 1);
-        objects->smoothWattsD.resize(rideTimeSecs + 1);
-        objects->smoothCadD.resize(rideTimeSecs + 1);
-        objects->smoothNmD.resize(rideTimeSecs + 1);
-        objects->smoothHrD.resize(rideTimeSecs + 1);
-        objects->smoothCad.resize(rideTimeSecs + 1);
         objects->smoothTime.resize(rideTimeSecs + 1);
         objects->smoothDistance.resize(rideTimeSecs + 1);
-        objects->smoothAltitude.resize(rideTimeSecs + 1);
-        objects->smoothSlope.resize(rideTimeSecs + 1);
-        objects->smoothTemp.resize(rideTimeSecs + 1);
-        objects->smoothWind.resize(rideTimeSecs + 1);
         objects->smoothRelSpeed.resize(rideTimeSecs + 1);
-        objects->smoothTorque.resize(rideTimeSecs + 1);
         objects->smoothBalanceL.resize(rideTimeSecs + 1);
         objects->smoothBalanceR.resize(rideTimeSecs + 1);
-        objects->smoothLTE.resize(rideTimeSecs + 1);
-        objects->smoothRTE.resize(rideTimeSecs + 1);
-        objects->smoothLPS.resize(rideTimeSecs + 1);
-        objects->smoothRPS.resize(rideTimeSecs + 1);
-        objects->smoothLPCO.resize(rideTimeSecs + 1);
-        objects->smoothRPCO.resize(rideTimeSecs + 1);
         objects->smoothLPP.resize(rideTimeSecs + 1);
         objects->smoothRPP.resize(rideTimeSecs + 1);
         objects->smoothLPPP.resize(rideTimeSecs + 1);
         objects->smoothRPPP.resize(rideTimeSecs + 1);
-        for(int k=0; k<objects->U.count(); k++) {
-            objects->U[k].smooth.resize(rideTimeSecs + 1);
-        }
 
-        // do the smoothing by calculating the average of the "applysmooth" values left
-        // of the current data point - for points in time smaller than "applysmooth"
+        // the average of the samples in the "applysmooth" seconds up to and
+        // including each second - for points in time smaller than "applysmooth"
         // only the available datapoints left are used to build the average
-        int i = 0;
+        QVector<int> ends(rideTimeSecs + 1), counts(rideTimeSecs + 1);
+        engine.smooth(applysmooth, 0, rideTimeSecs, out.constData(), ends.data(), counts.data());
+
+        // and then the ones that are not just an average
         for (int secs = 0; secs <= rideTimeSecs; ++secs) {
-            while ((i < objects->timeArray.count()) && (objects->timeArray[i] <= secs)) {
-
-                // collect user data if its there
-                QList<double> udata;
-                for (int k=0; k<objects->U.count(); k++) udata << (objects->U[k].array.size() > i ? objects->U[k].array[i] : 0);
-
-                // add to list
-                DataPoint dp(objects->timeArray[i],
-                             (!objects->hrArray.empty() ? objects->hrArray[i] : 0),
-                             (!objects->wattsArray.empty() ? objects->wattsArray[i] : 0),
-                             (!objects->atissArray.empty() ? objects->atissArray[i] : 0),
-                             (!objects->antissArray.empty() ? objects->antissArray[i] : 0),
-                             (!objects->npArray.empty() ? objects->npArray[i] : 0),
-                             (!objects->rvArray.empty() ? objects->rvArray[i] : 0),
-                             (!objects->rcadArray.empty() ? objects->rcadArray[i] : 0),
-                             (!objects->rgctArray.empty() ? objects->rgctArray[i] : 0),
-                             (!objects->smo2Array.empty() ? objects->smo2Array[i] : 0),
-                             (!objects->thbArray.empty() ? objects->thbArray[i] : 0),
-                             (!objects->o2hbArray.empty() ? objects->o2hbArray[i] : 0),
-                             (!objects->hhbArray.empty() ? objects->hhbArray[i] : 0),
-                             (!objects->apArray.empty() ? objects->apArray[i] : 0),
-                             (!objects->xpArray.empty() ? objects->xpArray[i] : 0),
-                             (!objects->speedArray.empty() ? objects->speedArray[i] : 0),
-                             (!objects->cadArray.empty() ? objects->cadArray[i] : 0),
-                             (!objects->altArray.empty() ? objects->altArray[i] : 0),
-                             (!objects->tempArray.empty() ? objects->tempArray[i] : 0),
-                             (!objects->windArray.empty() ? objects->windArray[i] : 0),
-                             (!objects->torqueArray.empty() ? objects->torqueArray[i] : 0),
-                             (!objects->balanceArray.empty() ? objects->balanceArray[i] : 0),
-                             (!objects->lteArray.empty() ? objects->lteArray[i] : 0),
-                             (!objects->rteArray.empty() ? objects->rteArray[i] : 0),
-                             (!objects->lpsArray.empty() ? objects->lpsArray[i] : 0),
-                             (!objects->rpsArray.empty() ? objects->rpsArray[i] : 0),
-                             (!objects->lpcoArray.empty() ? objects->lpcoArray[i] : 0),
-                             (!objects->rpcoArray.empty() ? objects->rpcoArray[i] : 0),
-                             (!objects->lppbArray.empty() ? objects->lppbArray[i] : 0),
-                             (!objects->rppbArray.empty() ? objects->rppbArray[i] : 0),
-                             (!objects->lppeArray.empty() ? objects->lppeArray[i] : 0),
-                             (!objects->rppeArray.empty() ? objects->rppeArray[i] : 0),
-                             (!objects->lpppbArray.empty() ? objects->lpppbArray[i] : 0),
-                             (!objects->rpppbArray.empty() ? objects->rpppbArray[i] : 0),
-                             (!objects->lpppeArray.empty() ? objects->lpppeArray[i] : 0),
-                             (!objects->rpppeArray.empty() ? objects->rpppeArray[i] : 0),
-                             (!objects->accelArray.empty() ? objects->accelArray[i] : 0),
-                             (!objects->wattsDArray.empty() ? objects->wattsDArray[i] : 0),
-                             (!objects->cadDArray.empty() ? objects->cadDArray[i] : 0),
-                             (!objects->nmDArray.empty() ? objects->nmDArray[i] : 0),
-                             (!objects->hrDArray.empty() ? objects->hrDArray[i] : 0),
-                             (!objects->slopeArray.empty() ? objects->slopeArray[i] : 0),
-                             (!objects->tcoreArray.empty() ? objects->tcoreArray[i] : 0),
-                            udata);
-
-                // apend to list
-                list.append(dp);
-
-                // maintain totals
-                if (!objects->wattsArray.empty()) totalWatts += objects->wattsArray[i];
-                if (!objects->npArray.empty()) totalNP += objects->npArray[i];
-                if (!objects->rvArray.empty()) totalRV += objects->rvArray[i];
-                if (!objects->rcadArray.empty()) totalRCad += objects->rcadArray[i];
-                if (!objects->rgctArray.empty()) totalRGCT += objects->rgctArray[i];
-                if (!objects->smo2Array.empty()) totalSmO2 += objects->smo2Array[i];
-                if (!objects->thbArray.empty()) totaltHb += objects->thbArray[i];
-                if (!objects->o2hbArray.empty()) totalO2Hb += objects->o2hbArray[i];
-                if (!objects->hhbArray.empty()) totalHHb += objects->hhbArray[i];
-                if (!objects->atissArray.empty()) totalATISS += objects->atissArray[i];
-                if (!objects->antissArray.empty()) totalANTISS += objects->antissArray[i];
-                if (!objects->xpArray.empty()) totalXP += objects->xpArray[i];
-                if (!objects->apArray.empty()) totalAP += objects->apArray[i];
-                if (!objects->tcoreArray.empty()) totalTcore    += objects->tcoreArray[i];
-                if (!objects->hrArray.empty()) totalHr    += objects->hrArray[i];
-                if (!objects->accelArray.empty()) totalAccel += objects->accelArray[i];
-                if (!objects->wattsDArray.empty()) totalWattsD += objects->wattsDArray[i];
-                if (!objects->cadDArray.empty()) totalCadD += objects->cadDArray[i];
-                if (!objects->nmDArray.empty()) totalNmD += objects->nmDArray[i];
-                if (!objects->hrDArray.empty()) totalHrD += objects->hrDArray[i];
-                if (!objects->speedArray.empty()) totalSpeed += objects->speedArray[i];
-                if (!objects->cadArray.empty()) totalCad   += objects->cadArray[i];
-                if (!objects->altArray.empty()) totalAlt   += objects->altArray[i];
-                if (!objects->slopeArray.empty()) totalSlope   += objects->slopeArray[i];
-                if (!objects->windArray.empty()) totalWind   += objects->windArray[i];
-                if (!objects->torqueArray.empty()) totalTorque   += objects->torqueArray[i];
-                if (!objects->tempArray.empty() ) {
-                    if (objects->tempArray[i] == RideFile::NA) {
-                        dp.temp = (i>0 && !list.empty()?list.back().temp:0.0);
-                        totalTemp   += dp.temp;
-                    }
-                    else {
-                        totalTemp   += objects->tempArray[i];
-                    }
-                }
-                if (!objects->balanceArray.empty()) totalBalance   += (objects->balanceArray[i]>0?objects->balanceArray[i]:50);
-                if (!objects->lteArray.empty()) totalLTE   += (objects->lteArray[i]>0?objects->lteArray[i]:0);
-                if (!objects->rteArray.empty()) totalRTE   += (objects->rteArray[i]>0?objects->rteArray[i]:0);
-                if (!objects->lpsArray.empty()) totalLPS   += (objects->lpsArray[i]>0?objects->lpsArray[i]:0);
-                if (!objects->rpsArray.empty()) totalRPS   += (objects->rpsArray[i]>0?objects->rpsArray[i]:0);
-                if (!objects->lpcoArray.empty()) totalLPCO   += objects->lpcoArray[i];
-                if (!objects->rpcoArray.empty()) totalRPCO   += objects->rpcoArray[i];
-                if (!objects->lppbArray.empty()) totalLPPB   += (objects->lppbArray[i]>0?objects->lppbArray[i]:0);
-                if (!objects->rppbArray.empty()) totalRPPB   += (objects->rppbArray[i]>0?objects->rppbArray[i]:0);
-                if (!objects->lppeArray.empty()) totalLPPE   += (objects->lppeArray[i]>0?objects->lppeArray[i]:0);
-                if (!objects->rppeArray.empty()) totalRPPE   += (objects->rppeArray[i]>0?objects->rppeArray[i]:0);
-                if (!objects->lpppbArray.empty()) totalLPPPB   += (objects->lpppbArray[i]>0?objects->lpppbArray[i]:0);
-                if (!objects->rpppbArray.empty()) totalRPPPB   += (objects->rpppbArray[i]>0?objects->rpppbArray[i]:0);
-                if (!objects->lpppeArray.empty()) totalLPPPE   += (objects->lpppeArray[i]>0?objects->lpppeArray[i]:0);
-                if (!objects->rpppeArray.empty()) totalRPPPE   += (objects->rpppeArray[i]>0?objects->rpppeArray[i]:0);
-
-                // set values which must not be smoothed
-                if (!objects->gearArray.empty()) currentGearRatio = (objects->gearArray[i]>0?objects->gearArray[i]:0);
-                totalDist   = objects->distanceArray[i];
-
-                // totalise user data
-                for(int k=0; k<utotals.count(); k++) utotals[k] += udata[k];
-
-                ++i;
-            }
 
-            // remove data from before smoothing duration (er, really?)
-            while (!list.empty() && (list.front().time < secs - applysmooth)) {
-                DataPoint &dp = list.front();
-                totalWatts -= dp.watts;
-                totalNP -= dp.np;
-                totalRV -= dp.rv;
-                totalRCad -= dp.rcad;
-                totalRGCT -= dp.rgct;
-                totalSmO2 -= dp.smo2;
-                totaltHb -= dp.thb;
-                totalO2Hb -= dp.o2hb;
-                totalHHb -= dp.hhb;
-                totalATISS -= dp.atiss;
-                totalANTISS -= dp.antiss;
-                totalAP -= dp.ap;
-                totalXP -= dp.xp;
-                totalHr    -= dp.hr;
-                totalTcore    -= dp.tcore;
-                totalSpeed -= dp.speed;
-                totalAccel -= dp.kphd;
-                totalWattsD -= dp.wattsd;
-                totalCadD -= dp.cadd;
-                totalNmD -= dp.nmd;
-                totalHrD -= dp.hrd;
-                totalCad   -= dp.cad;
-                totalAlt   -= dp.alt;
-                totalSlope -= dp.slope;
-                totalTemp   -= dp.temp;
-                totalWind   -= dp.wind;
-                totalTorque   -= dp.torque;
-                totalLTE   -= dp.lte;
-                totalRTE   -= dp.rte;
-                totalLPS   -= dp.lps;
-                totalRPS   -= dp.rps;
-                totalLPCO  -= dp.lpco;
-                totalRPCO  -= dp.rpco;
-                totalLPPB   -= dp.lppb;
-                totalRPPB   -= dp.rppb;
-                totalLPPE   -= dp.lppe;
-                totalRPPE   -= dp.rppe;
-                totalLPPPB  -= dp.lpppb;
-                totalRPPPB  -= dp.rpppb;
-                totalLPPPE  -= dp.lpppe;
-                totalRPPPE  -= dp.rpppe;
-                totalBalance   -= (dp.lrbalance>0?dp.lrbalance:50);
-                for(int k=0; k<utotals.count(); k++) utotals[k] -= dp.user[k];
-
-                list.removeFirst();
-            }
+            // set values which must not be smoothed, from the last sample so far
+            int last = ends[secs] - 1;
+            double totalDist = last >= 0 ? objects->distanceArray[last] : 0.0;
+            double x = bydist ? totalDist : secs / 60.0;
 
-            // TODO: this is wrong.  We should do a weighted average over the
-            // seconds represented by each point...
-            if (list.empty()) {
-
-                for (int k=0; k<objects->U.count(); k++) objects->U[k].smooth[secs] = 0.0;
-                objects->smoothWatts[secs] = 0.0;
-                objects->smoothNP[secs] = 0.0;
-                objects->smoothRV[secs] = 0.0;
-                objects->smoothRCad[secs] = 0.0;
-                objects->smoothRGCT[secs] = 0.0;
-                objects->smoothSmO2[secs] = 0.0;
-                objects->smoothtHb[secs] = 0.0;
-                objects->smoothO2Hb[secs] = 0.0;
-                objects->smoothHHb[secs] = 0.0;
-                objects->smoothAT[secs] = 0.0;
-                objects->smoothANT[secs] = 0.0;
-                objects->smoothXP[secs] = 0.0;
-                objects->smoothAP[secs] = 0.0;
-                objects->smoothHr[secs]    = 0.0;
-                objects->smoothTcore[secs]    = 0.0;
-                objects->smoothSpeed[secs] = 0.0;
-                objects->smoothAccel[secs] = 0.0;
-                objects->smoothWattsD[secs] = 0.0;
-                objects->smoothCadD[secs] = 0.0;
-                objects->smoothNmD[secs] = 0.0;
-                objects->smoothHrD[secs] = 0.0;
-                objects->smoothCad[secs]   = 0.0;
-                objects->smoothAltitude[secs]   = ((secs > 0) ? objects->smoothAltitude[secs - 1] : objects->altArray[secs] ) ;
-                objects->smoothSlope[secs]   =  0.0;
-                objects->smoothTemp[secs]   = 0.0;
-                objects->smoothWind[secs] = 0.0;
-                objects->smoothRelSpeed[secs] =  QwtIntervalSample();
-                objects->smoothTorque[secs] = 0.0;
-                objects->smoothLTE[secs] = 0.0;
-                objects->smoothRTE[secs] = 0.0;
-                objects->smoothLPS[secs] = 0.0;
-                objects->smoothRPS[secs] = 0.0;
-                objects->smoothLPCO[secs] = 0.0;
-                objects->smoothRPCO[secs] = 0.0;
+            objects->smoothGear[secs] = (last >= 0 && !objects->gearArray.empty() && objects->gearArray[last] > 0) ? objects->gearArray[last] : 0.0;
+            objects->smoothDistance[secs] = totalDist;
+            objects->smoothTime[secs]  =  secs / 60.0;
+
+            if (counts[secs] == 0) {
+
+                objects->smoothAltitude[secs] = secs > 0 ? objects->smoothAltitude[secs - 1] : objects->altArray.value(0);
+                objects->smoothRelSpeed[secs] = QwtIntervalSample();
                 objects->smoothLPP[secs] = QwtIntervalSample();
                 objects->smoothRPP[secs] = QwtIntervalSample();
                 objects->smoothLPPP[secs] = QwtIntervalSample();
                 objects->smoothRPPP[secs] = QwtIntervalSample();
                 objects->smoothBalanceL[secs] = 50;
                 objects->smoothBalanceR[secs] = 50;
+                continue;
+            }
 
-            } else {
-
-                for(int k=0; k<utotals.count(); k++) objects->U[k].smooth[secs] = utotals[k] / list.size();
-                objects->smoothWatts[secs]    = totalWatts / list.size();
-                objects->smoothNP[secs]    = totalNP / list.size();
-                objects->smoothRV[secs]    = totalRV / list.size();
-                objects->smoothRCad[secs]    = totalRCad / list.size();
-                objects->smoothRGCT[secs]    = totalRGCT / list.size();
-                objects->smoothSmO2[secs]    = totalSmO2 / list.size();
-                objects->smoothtHb[secs]    = totaltHb / list.size();
-                objects->smoothO2Hb[secs]    = totalO2Hb / list.size();
-                objects->smoothHHb[secs]    = totalHHb / list.size();
-                objects->smoothAT[secs]    = totalATISS / list.size();
-                objects->smoothANT[secs]    = totalANTISS / list.size();
-                objects->smoothXP[secs]    = totalXP / list.size();
-                objects->smoothAP[secs]    = totalAP / list.size();
-                objects->smoothHr[secs]       = totalHr / list.size();
-                objects->smoothTcore[secs]       = totalTcore / list.size();
-                objects->smoothSpeed[secs]    = totalSpeed / list.size();
-                objects->smoothAccel[secs]    = totalAccel / double(list.size());
-                objects->smoothWattsD[secs]    = totalWattsD / double(list.size());
-                objects->smoothCadD[secs]    = totalCadD / double(list.size());
-                objects->smoothNmD[secs]    = totalNmD / double(list.size());
-                objects->smoothHrD[secs]    = totalHrD / double(list.size());
-                objects->smoothCad[secs]      = totalCad / list.size();
-                objects->smoothAltitude[secs]      = totalAlt / list.size();
-                objects->smoothSlope[secs]      = totalSlope / double(list.size());
-                objects->smoothTemp[secs]      = totalTemp / list.size();
-                objects->smoothWind[secs]    = totalWind / list.size();
-                objects->smoothTorque[secs]    = totalTorque / list.size();
-                objects->smoothRelSpeed[secs] =  QwtIntervalSample(bydist ? totalDist : secs / 60.0, 
-                                                                   QwtInterval(qMin(totalWind / list.size(),
-                                                                   totalSpeed / list.size()), 
-                                                                   qMax(totalWind / list.size(), 
-                                                                   totalSpeed / list.size())));
-
-                // left /right pedal data
-                double balance = totalBalance / list.size();
-                if (balance == 0) {
-                    objects->smoothBalanceL[secs]    = 50;
-                    objects->smoothBalanceR[secs]    = 50;
-                } else if (balance >= 50) {
-                    objects->smoothBalanceL[secs]    = balance;
-                    objects->smoothBalanceR[secs]    = 50;
-                }
-                else {
-                    objects->smoothBalanceL[secs]    = 50;
-                    objects->smoothBalanceR[secs]    = balance;
-                }
-                objects->smoothLTE[secs]    = totalLTE / list.size();
-                objects->smoothRTE[secs]    = totalRTE / list.size();
-                objects->smoothLPS[secs]    = totalLPS / list.size();
-                objects->smoothRPS[secs]    = totalRPS / list.size();
-                objects->smoothLPCO[secs]   = totalLPCO / list.size();
-                objects->smoothRPCO[secs]   = totalRPCO / list.size();
-                objects->smoothLPP[secs]    = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalLPPB / list.size(), totalLPPE / list.size() ) );
-                objects->smoothRPP[secs]    = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalRPPB / list.size(), totalRPPE / list.size() ) );
-                objects->smoothLPPP[secs]   = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalLPPPB / list.size(), totalLPPPE / list.size() ) );
-                objects->smoothRPPP[secs]   = QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(totalRPPPB / list.size(), totalRPPPE / list.size() ) );
+            double wind = objects->smoothWind[secs];
+            double speed = objects->smoothSpeed[secs];
+            objects->smoothRelSpeed[secs] = QwtIntervalSample(x, QwtInterval(qMin(wind, speed), qMax(wind, speed)));
+
+            // left /right pedal data
+            if (balance[secs] == 0) {
+                objects->smoothBalanceL[secs]    = 50;
+                objects->smoothBalanceR[secs]    = 50;
+            } else if (balance[secs] >= 50) {
+                objects->smoothBalanceL[secs]    = balance[secs];
+                objects->smoothBalanceR[secs]    = 50;
             }
-            objects->smoothGear[secs] = currentGearRatio;
-            objects->smoothDistance[secs] = totalDist;
-            objects->smoothTime[secs]  =  secs / 60.0;
+            else {
+                objects->smoothBalanceL[secs]    = 50;
+                objects->smoothBalanceR[secs]    = balance[secs];
+            }
+            objects->smoothLPP[secs]    = QwtIntervalSample(x, QwtInterval(lppb[secs], lppe[secs]));
+            objects->smoothRPP[secs]    = QwtIntervalSample(x, QwtInterval(rppb[secs], rppe[secs]));
+            objects->smoothLPPP[secs]   = QwtIntervalSample(x, QwtInterval(lpppb[secs], lpppe[secs]));
+            objects->smoothRPPP[secs]   = QwtIntervalSample(x, QwtInterval(rpppb[secs], rpppe[secs]));
         }
 
     } else {
@@ -2306,7 +2083,7 @@ AllPlot::recalc(AllPlotObject *objects)
             objects->smoothAltitude.append(context->athlete->useMetricUnits ? dp->alt : dp->alt * FEET_PER_METER);
             objects->smoothSlope.append(dp->slope);
             if (dp->temp == RideFile::NA && !objects->smoothTemp.empty())
-                dp->temp = objects->smoothTemp.last();
+                rideItem->ride()->setPointValue(objects->smoothWatts.count()-1, RideFile::temp, objects->smoothTemp.last());
             objects->smoothTemp.append(context->athlete->useMetricUnits ? dp->temp : dp->temp * FAHRENHEIT_PER_CENTIGRADE + FAHRENHEIT_ADD_CENTIGRADE);
             objects->smoothWind.append(context->athlete->useMetricUnits ? dp->headwind : dp->headwind * MILES_PER_KM);
             objects->smoothTorque.append(dp->nm);
@@ -2360,113 +2137,113 @@ AllPlot::recalc(AllPlotObject *objects)
     // set curve.
     for(int k=0; k<objects->U.count(); k++) {
         if (!objects->U[k].array.empty()) {
-            objects->U[k].curve->setSamples(xaxis.data() + startingIndex, objects->U[k].smooth.data() + startingIndex, totalPoints);
+            AllPlotDecimatedData::setSamples(objects->U[k].curve, xaxis.data() + startingIndex, objects->U[k].smooth.data() + startingIndex, totalPoints);
             //XXXXHEREXXX
         }
     }
 
     if (!objects->wattsArray.empty()) {
-        objects->wattsCurve->setSamples(xaxis.data() + startingIndex, objects->smoothWatts.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->wattsCurve, xaxis.data() + startingIndex, objects->smoothWatts.data() + startingIndex, totalPoints);
     }
 
     if (!objects->antissArray.empty()) {
-        objects->antissCurve->setSamples(xaxis.data() + startingIndex, objects->smoothANT.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->antissCurve, xaxis.data() + startingIndex, objects->smoothANT.data() + startingIndex, totalPoints);
     }
 
     if (!objects->atissArray.empty()) {
-        objects->atissCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAT.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->atissCurve, xaxis.data() + startingIndex, objects->smoothAT.data() + startingIndex, totalPoints);
     }
 
     if (!objects->rvArray.empty()) {
-        objects->rvCurve->setSamples(xaxis.data() + startingIndex, objects->smoothRV.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->rvCurve, xaxis.data() + startingIndex, objects->smoothRV.data() + startingIndex, totalPoints);
     }
 
     if (!objects->rcadArray.empty()) {
-        objects->rcadCurve->setSamples(xaxis.data() + startingIndex, objects->smoothRCad.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->rcadCurve, xaxis.data() + startingIndex, objects->smoothRCad.data() + startingIndex, totalPoints);
     }
 
     if (!objects->rgctArray.empty()) {
-        objects->rgctCurve->setSamples(xaxis.data() + startingIndex, objects->smoothRGCT.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->rgctCurve, xaxis.data() + startingIndex, objects->smoothRGCT.data() + startingIndex, totalPoints);
     }
 
     if (!objects->gearArray.empty()) {
-        objects->gearCurve->setSamples(xaxis.data() + startingIndex, objects->smoothGear.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->gearCurve, xaxis.data() + startingIndex, objects->smoothGear.data() + startingIndex, totalPoints);
     }
 
     if (!objects->smo2Array.empty()) {
-        objects->smo2Curve->setSamples(xaxis.data() + startingIndex, objects->smoothSmO2.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->smo2Curve, xaxis.data() + startingIndex, objects->smoothSmO2.data() + startingIndex, totalPoints);
     }
 
     if (!objects->thbArray.empty()) {
-        objects->thbCurve->setSamples(xaxis.data() + startingIndex, objects->smoothtHb.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->thbCurve, xaxis.data() + startingIndex, objects->smoothtHb.data() + startingIndex, totalPoints);
     }
 
     if (!objects->o2hbArray.empty()) {
-        objects->o2hbCurve->setSamples(xaxis.data() + startingIndex, objects->smoothO2Hb.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->o2hbCurve, xaxis.data() + startingIndex, objects->smoothO2Hb.data() + startingIndex, totalPoints);
     }
 
     if (!objects->hhbArray.empty()) {
-        objects->hhbCurve->setSamples(xaxis.data() + startingIndex, objects->smoothHHb.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->hhbCurve, xaxis.data() + startingIndex, objects->smoothHHb.data() + startingIndex, totalPoints);
     }
 
     if (!objects->npArray.empty()) {
-        objects->npCurve->setSamples(xaxis.data() + startingIndex, objects->smoothNP.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->npCurve, xaxis.data() + startingIndex, objects->smoothNP.data() + startingIndex, totalPoints);
     }
 
     if (!objects->xpArray.empty()) {
-        objects->xpCurve->setSamples(xaxis.data() + startingIndex, objects->smoothXP.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->xpCurve, xaxis.data() + startingIndex, objects->smoothXP.data() + startingIndex, totalPoints);
     }
 
     if (!objects->apArray.empty()) {
-        objects->apCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAP.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->apCurve, xaxis.data() + startingIndex, objects->smoothAP.data() + startingIndex, totalPoints);
     }
 
     if (!objects->hrArray.empty()) {
-        objects->hrCurve->setSamples(xaxis.data() + startingIndex, objects->smoothHr.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->hrCurve, xaxis.data() + startingIndex, objects->smoothHr.data() + startingIndex, totalPoints);
     }
 
     if (!objects->tcoreArray.empty()) {
-        objects->tcoreCurve->setSamples(xaxis.data() + startingIndex, objects->smoothTcore.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->tcoreCurve, xaxis.data() + startingIndex, objects->smoothTcore.data() + startingIndex, totalPoints);
     }
 
     if (!objects->speedArray.empty()) {
-        objects->speedCurve->setSamples(xaxis.data() + startingIndex, objects->smoothSpeed.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->speedCurve, xaxis.data() + startingIndex, objects->smoothSpeed.data() + startingIndex, totalPoints);
     }
 
     if (!objects->accelArray.empty()) {
-        objects->accelCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAccel.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->accelCurve, xaxis.data() + startingIndex, objects->smoothAccel.data() + startingIndex, totalPoints);
     }
 
     if (!objects->wattsDArray.empty()) {
-        objects->wattsDCurve->setSamples(xaxis.data() + startingIndex, objects->smoothWattsD.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->wattsDCurve, xaxis.data() + startingIndex, objects->smoothWattsD.data() + startingIndex, totalPoints);
     }
 
     if (!objects->cadDArray.empty()) {
-        objects->cadDCurve->setSamples(xaxis.data() + startingIndex, objects->smoothCadD.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->cadDCurve, xaxis.data() + startingIndex, objects->smoothCadD.data() + startingIndex, totalPoints);
     }
 
     if (!objects->nmDArray.empty()) {
-        objects->nmDCurve->setSamples(xaxis.data() + startingIndex, objects->smoothNmD.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->nmDCurve, xaxis.data() + startingIndex, objects->smoothNmD.data() + startingIndex, totalPoints);
     }
 
     if (!objects->hrDArray.empty()) {
-        objects->hrDCurve->setSamples(xaxis.data() + startingIndex, objects->smoothHrD.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->hrDCurve, xaxis.data() + startingIndex, objects->smoothHrD.data() + startingIndex, totalPoints);
     }
 
     if (!objects->cadArray.empty()) {
-        objects->cadCurve->setSamples(xaxis.data() + startingIndex, objects->smoothCad.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->cadCurve, xaxis.data() + startingIndex, objects->smoothCad.data() + startingIndex, totalPoints);
     }
 
     if (!objects->altArray.empty()) {
-        objects->altCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAltitude.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->altCurve, xaxis.data() + startingIndex, objects->smoothAltitude.data() + startingIndex, totalPoints);
         objects->altSlopeCurve->setSamples(xaxis.data() + startingIndex, objects->smoothAltitude.data() + startingIndex, totalPoints);
     }
     if (!objects->slopeArray.empty()) {
-        objects->slopeCurve->setSamples(xaxis.data() + startingIndex, objects->smoothSlope.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->slopeCurve, xaxis.data() + startingIndex, objects->smoothSlope.data() + startingIndex, totalPoints);
     }
 
     if (!objects->tempArray.empty()) {
-        objects->tempCurve->setSamples(xaxis.data() + startingIndex, objects->smoothTemp.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->tempCurve, xaxis.data() + startingIndex, objects->smoothTemp.data() + startingIndex, totalPoints);
     }
 
 
@@ -2475,28 +2252,28 @@ AllPlot::recalc(AllPlotObject *objects)
     }
 
     if (!objects->torqueArray.empty()) {
-        objects->torqueCurve->setSamples(xaxis.data() + startingIndex, objects->smoothTorque.data() + startingIndex, totalPoints);
+        AllPlotDecimatedData::setSamples(objects->torqueCurve, xaxis.data() + startingIndex, objects->smoothTorque.data() + startingIndex, totalPoints);
     }
 
     // left/right pedals
     if (!objects->balanceArray.empty()) {
-        objects->balanceLCurve->setSamples(xaxis.data() + startingIndex, 
+        AllPlotDecimatedData::setSamples(objects->balanceLCurve, xaxis.data() + startingIndex, 
                                            objects->smoothBalanceL.data() + startingIndex, totalPoints);
-        objects->balanceRCurve->setSamples(xaxis.data() + startingIndex, 
+        AllPlotDecimatedData::setSamples(objects->balanceRCurve, xaxis.data() + startingIndex, 
                                            objects->smoothBalanceR.data() + startingIndex, totalPoints);
     }
-    if (!objects->lteArray.empty()) objects->lteCurve->setSamples(xaxis.data() + startingIndex, 
+    if (!objects->lteArray.empty()) AllPlotDecimatedData::setSamples(objects->lteCurve, xaxis.data() + startingIndex, 
                                              objects->smoothLTE.data() + startingIndex, totalPoints);
-    if (!objects->rteArray.empty()) objects->rteCurve->setSamples(xaxis.data() + startingIndex, 
+    if (!objects->rteArray.empty()) AllPlotDecimatedData::setSamples(objects->rteCurve, xaxis.data() + startingIndex, 
                                              objects->smoothRTE.data() + startingIndex, totalPoints);
-    if (!objects->lpsArray.empty()) objects->lpsCurve->setSamples(xaxis.data() + startingIndex, 
+    if (!objects->lpsArray.empty()) AllPlotDecimatedData::setSamples(objects->lpsCurve, xaxis.data() + startingIndex, 
                                              objects->smoothLPS.data() + startingIndex, totalPoints);
-    if (!objects->rpsArray.empty()) objects->rpsCurve->setSamples(xaxis.data() + startingIndex, 
+    if (!objects->rpsArray.empty()) AllPlotDecimatedData::setSamples(objects->rpsCurve, xaxis.data() + startingIndex, 
                                              objects->smoothRPS.data() + startingIndex, totalPoints);
 
-    if (!objects->lpcoArray.empty()) objects->lpcoCurve->setSamples(xaxis.data() + startingIndex,
+    if (!objects->lpcoArray.empty()) AllPlotDecimatedData::setSamples(objects->lpcoCurve, xaxis.data() + startingIndex,
                                              objects->smoothLPCO.data() + startingIndex, totalPoints);
-    if (!objects->rpcoArray.empty()) objects->rpcoCurve->setSamples(xaxis.data() + startingIndex,
+    if (!objects->rpcoArray.empty()) AllPlotDecimatedData::setSamples(objects->rpcoCurve, xaxis.data() + startingIndex,
                                              objects->smoothRPCO.data() + startingIndex, totalPoints);
     if (!objects->lppbArray.empty()) {
         objects->lppCurve->setSamples(new QwtIntervalSeriesData(objects->smoothLPP));
@@ -4104,16 +3881,13 @@ AllPlot::setDataFromPlot(AllPlot *plot)
             ourCurve->attach(this);
 
             // lets clone the data
-            QVector<QPointF> array;
-            for (size_t i=0; i<thereCurve->data()->size(); i++) array << thereCurve->data()->sample(i);
-
-            ourCurve->setSamples(array);
+            AllPlotDecimatedData::copySamples(ourCurve, thereCurve);
             ourCurve->setYAxis(yLeft);
             ourCurve->setBaseline(thereCurve->baseline());
             ourCurve->setStyle(thereCurve->style());
 
             // symbol when zoomed in super close
-            if (array.size() < 150) {
+            if (AllPlotDecimatedData::sampleCount(thereCurve) < 150) {
                 QwtSymbol *sym = new QwtSymbol;
                 sym->setPen(QPen(GColor(CPLOTMARKER)));
                 sym->setStyle(QwtSymbol::Ellipse);
@@ -4133,15 +3907,12 @@ AllPlot::setDataFromPlot(AllPlot *plot)
             ourCurve2->attach(this);
 
             // lets clone the data
-            QVector<QPointF> array;
-            for (size_t i=0; i<thereCurve2->data()->size(); i++) array << thereCurve2->data()->sample(i);
-
-            ourCurve2->setSamples(array);
+            AllPlotDecimatedData::copySamples(ourCurve2, thereCurve2);
             ourCurve2->setYAxis(yLeft);
             ourCurve2->setBaseline(thereCurve2->baseline());
 
             // symbol when zoomed in super close
-            if (array.size() < 150) {
+            if (AllPlotDecimatedData::sampleCount(thereCurve2) < 150) {
                 QwtSymbol *sym = new QwtSymbol;
                 sym->setPen(QPen(GColor(CPLOTMARKER)));
                 sym->setStyle(QwtSymbol::Ellipse);
@@ -4205,9 +3976,9 @@ AllPlot::setDataFromPlot(AllPlot *plot)
 
             // minimum non-zero value... worst case its zero !
             double minNZ = 0.00f;
-            for (size_t i=0; i<thereCurve->data()->size(); i++) {
-                if (!minNZ) minNZ = thereCurve->data()->sample(i).y();
-                else if (thereCurve->data()->sample(i).y()<minNZ) minNZ = thereCurve->data()->sample(i).y();
+            foreach(QPointF sample, AllPlotDecimatedData::samples(thereCurve)) {
+                if (!minNZ) minNZ = sample.y();
+                else if (sample.y()<minNZ) minNZ = sample.y();
             }
             setAxisScale(QwtPlot::yLeft, minNZ, thereCurve->maxYValue() + 0.10f);
 
@@ -4890,13 +4661,7 @@ AllPlot::setDataFromPlots(QList<AllPlot *> plots)
                     ourCurve->attach(this);
 
                     // lets clone the data
-                    QVector<double> x,y;
-                    for (size_t i=0; i<thereCurve->data()->size(); i++) {
-                        x << thereCurve->data()->sample(i).x();
-                        y << thereCurve->data()->sample(i).y();
-                    }
-
-                    ourCurve->setSamples(x,y);
+                    AllPlotDecimatedData::copySamples(ourCurve, thereCurve);
                     ourCurve->setYAxis(yLeft);
                     ourCurve->setBaseline(thereCurve->baseline());
 
@@ -4904,7 +4669,7 @@ AllPlot::setDataFromPlots(QList<AllPlot *> plots)
                     if (ourCurve->minYValue() < MINY) MINY = ourCurve->minYValue();
 
                     // symbol when zoomed in super close
-                    if (x.size() < 150) {
+                    if (AllPlotDecimatedData::sampleCount(thereCurve) < 150) {
                         QwtSymbol *sym = new QwtSymbol;
                         sym->setPen(QPen(GColor(CPLOTMARKER)));
                         sym->setStyle(QwtSymbol::Ellipse);
@@ -4931,10 +4696,7 @@ AllPlot::setDataFromPlots(QList<AllPlot *> plots)
                     ourCurve2->setPen(pen);
 
                     // lets clone the data
-                    QVector<QPointF> array;
-                    for (size_t i=0; i<thereCurve2->data()->size(); i++) array << thereCurve2->data()->sample(i);
-
-                    ourCurve2->setSamples(array);
+                    AllPlotDecimatedData::copySamples(ourCurve2, thereCurve2);
                     ourCurve2->setYAxis(yLeft);
                     ourCurve2->setBaseline(thereCurve2->baseline());
 
@@ -4942,7 +4704,7 @@ AllPlot::setDataFromPlots(QList<AllPlot *> plots)
                     if (ourCurve2->minYValue() < MINY) MINY = ourCurve2->minYValue();
 
                     // symbol when zoomed in super close
-                    if (array.size() < 150) {
+                    if (AllPlotDecimatedData::sampleCount(thereCurve2) < 150) {
                         QwtSymbol *sym = new QwtSymbol;
                         sym->setPen(QPen(GColor(CPLOTMARKER)));
                         sym->setStyle(QwtSymbol::Ellipse);
@@ -5182,7 +4944,7 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
 
         if (!object->U[k].smooth.empty()) {
 
-            standard->U[k].curve->setSamples(xaxis.data(), object->U[k].smooth.data(), totalPoints);
+            AllPlotDecimatedData::setSamples(standard->U[k].curve, xaxis.data(), object->U[k].smooth.data(), totalPoints);
             //XXXXHEREXXX
             standard->U[k].curve->attach(this);
             standard->U[k].curve->setVisible(true);
@@ -5190,145 +4952,145 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->wattsArray.empty()) {
-        standard->wattsCurve->setSamples(xaxis.data(), object->smoothWatts.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->wattsCurve, xaxis.data(), object->smoothWatts.data(), totalPoints);
         standard->wattsCurve->attach(this);
         standard->wattsCurve->setVisible(true);
     }
 
     if (!object->antissArray.empty()) {
-        standard->antissCurve->setSamples(xaxis.data(), object->smoothANT.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->antissCurve, xaxis.data(), object->smoothANT.data(), totalPoints);
         standard->antissCurve->attach(this);
         standard->antissCurve->setVisible(true);
     }
 
     if (!object->atissArray.empty()) {
-        standard->atissCurve->setSamples(xaxis.data(), object->smoothAT.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->atissCurve, xaxis.data(), object->smoothAT.data(), totalPoints);
         standard->atissCurve->attach(this);
         standard->atissCurve->setVisible(true);
     }
 
     if (!object->npArray.empty()) {
-        standard->npCurve->setSamples(xaxis.data(), object->smoothNP.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->npCurve, xaxis.data(), object->smoothNP.data(), totalPoints);
         standard->npCurve->attach(this);
         standard->npCurve->setVisible(true);
     }
 
     if (!object->rvArray.empty()) {
-        standard->rvCurve->setSamples(xaxis.data(), object->smoothRV.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->rvCurve, xaxis.data(), object->smoothRV.data(), totalPoints);
         standard->rvCurve->attach(this);
         standard->rvCurve->setVisible(true);
     }
 
     if (!object->rcadArray.empty()) {
-        standard->rcadCurve->setSamples(xaxis.data(), object->smoothRCad.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->rcadCurve, xaxis.data(), object->smoothRCad.data(), totalPoints);
         standard->rcadCurve->attach(this);
         standard->rcadCurve->setVisible(true);
     }
 
     if (!object->rgctArray.empty()) {
-        standard->rgctCurve->setSamples(xaxis.data(), object->smoothRGCT.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->rgctCurve, xaxis.data(), object->smoothRGCT.data(), totalPoints);
         standard->rgctCurve->attach(this);
         standard->rgctCurve->setVisible(true);
     }
 
     if (!object->gearArray.empty()) {
-        standard->gearCurve->setSamples(xaxis.data(), object->smoothGear.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->gearCurve, xaxis.data(), object->smoothGear.data(), totalPoints);
         standard->gearCurve->attach(this);
         standard->gearCurve->setVisible(true);
     }
 
     if (!object->smo2Array.empty()) {
-        standard->smo2Curve->setSamples(xaxis.data(), object->smoothSmO2.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->smo2Curve, xaxis.data(), object->smoothSmO2.data(), totalPoints);
         standard->smo2Curve->attach(this);
         standard->smo2Curve->setVisible(true);
     }
 
     if (!object->thbArray.empty()) {
-        standard->thbCurve->setSamples(xaxis.data(), object->smoothtHb.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->thbCurve, xaxis.data(), object->smoothtHb.data(), totalPoints);
         standard->thbCurve->attach(this);
         standard->thbCurve->setVisible(true);
     }
 
     if (!object->o2hbArray.empty()) {
-        standard->o2hbCurve->setSamples(xaxis.data(), object->smoothO2Hb.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->o2hbCurve, xaxis.data(), object->smoothO2Hb.data(), totalPoints);
         standard->o2hbCurve->attach(this);
         standard->o2hbCurve->setVisible(true);
     }
 
     if (!object->hhbArray.empty()) {
-        standard->hhbCurve->setSamples(xaxis.data(), object->smoothHHb.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->hhbCurve, xaxis.data(), object->smoothHHb.data(), totalPoints);
         standard->hhbCurve->attach(this);
         standard->hhbCurve->setVisible(true);
     }
 
     if (!object->xpArray.empty()) {
-        standard->xpCurve->setSamples(xaxis.data(), object->smoothXP.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->xpCurve, xaxis.data(), object->smoothXP.data(), totalPoints);
         standard->xpCurve->attach(this);
         standard->xpCurve->setVisible(true);
     }
 
     if (!object->apArray.empty()) {
-        standard->apCurve->setSamples(xaxis.data(), object->smoothAP.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->apCurve, xaxis.data(), object->smoothAP.data(), totalPoints);
         standard->apCurve->attach(this);
         standard->apCurve->setVisible(true);
     }
 
     if (!object->tcoreArray.empty()) {
-        standard->tcoreCurve->setSamples(xaxis.data(), object->smoothTcore.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->tcoreCurve, xaxis.data(), object->smoothTcore.data(), totalPoints);
         standard->tcoreCurve->attach(this);
         standard->tcoreCurve->setVisible(true);
     }
 
     if (!object->hrArray.empty()) {
-        standard->hrCurve->setSamples(xaxis.data(), object->smoothHr.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->hrCurve, xaxis.data(), object->smoothHr.data(), totalPoints);
         standard->hrCurve->attach(this);
         standard->hrCurve->setVisible(true);
     }
 
     if (!object->speedArray.empty()) {
-        standard->speedCurve->setSamples(xaxis.data(), object->smoothSpeed.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->speedCurve, xaxis.data(), object->smoothSpeed.data(), totalPoints);
         standard->speedCurve->attach(this);
         standard->speedCurve->setVisible(true);
     }
 
     if (!object->accelArray.empty()) {
-        standard->accelCurve->setSamples(xaxis.data(), object->smoothAccel.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->accelCurve, xaxis.data(), object->smoothAccel.data(), totalPoints);
         standard->accelCurve->attach(this);
         standard->accelCurve->setVisible(true);
     }
 
     if (!object->wattsDArray.empty()) {
-        standard->wattsDCurve->setSamples(xaxis.data(), object->smoothWattsD.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->wattsDCurve, xaxis.data(), object->smoothWattsD.data(), totalPoints);
         standard->wattsDCurve->attach(this);
         standard->wattsDCurve->setVisible(true);
     }
 
     if (!object->cadDArray.empty()) {
-        standard->cadDCurve->setSamples(xaxis.data(), object->smoothCadD.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->cadDCurve, xaxis.data(), object->smoothCadD.data(), totalPoints);
         standard->cadDCurve->attach(this);
         standard->cadDCurve->setVisible(true);
     }
 
     if (!object->nmDArray.empty()) {
-        standard->nmDCurve->setSamples(xaxis.data(), object->smoothNmD.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->nmDCurve, xaxis.data(), object->smoothNmD.data(), totalPoints);
         standard->nmDCurve->attach(this);
         standard->nmDCurve->setVisible(true);
     }
 
     if (!object->hrDArray.empty()) {
-        standard->hrDCurve->setSamples(xaxis.data(), object->smoothHrD.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->hrDCurve, xaxis.data(), object->smoothHrD.data(), totalPoints);
         standard->hrDCurve->attach(this);
         standard->hrDCurve->setVisible(true);
     }
 
     if (!object->cadArray.empty()) {
-        standard->cadCurve->setSamples(xaxis.data(), object->smoothCad.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->cadCurve, xaxis.data(), object->smoothCad.data(), totalPoints);
         standard->cadCurve->attach(this);
         standard->cadCurve->setVisible(true);
     }
 
     if (!object->altArray.empty()) {
-        standard->altCurve->setSamples(xaxis.data(), object->smoothAltitude.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->altCurve, xaxis.data(), object->smoothAltitude.data(), totalPoints);
         standard->altCurve->attach(this);
         standard->altCurve->setVisible(true);
         standard->altSlopeCurve->setSamples(xaxis.data(), object->smoothAltitude.data(), totalPoints);
@@ -5337,13 +5099,13 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->slopeArray.empty()) {
-        standard->slopeCurve->setSamples(xaxis.data(), object->smoothSlope.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->slopeCurve, xaxis.data(), object->smoothSlope.data(), totalPoints);
         standard->slopeCurve->attach(this);
         standard->slopeCurve->setVisible(true);
     }
 
     if (!object->tempArray.empty()) {
-        standard->tempCurve->setSamples(xaxis.data(), object->smoothTemp.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->tempCurve, xaxis.data(), object->smoothTemp.data(), totalPoints);
         standard->tempCurve->attach(this);
         standard->tempCurve->setVisible(true);
     }
@@ -5356,14 +5118,14 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->torqueArray.empty()) {
-        standard->torqueCurve->setSamples(xaxis.data(), object->smoothTorque.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->torqueCurve, xaxis.data(), object->smoothTorque.data(), totalPoints);
         standard->torqueCurve->attach(this);
         standard->torqueCurve->setVisible(true);
     }
 
     if (!object->balanceArray.empty()) {
-        standard->balanceLCurve->setSamples(xaxis.data(), object->smoothBalanceL.data(), totalPoints);
-        standard->balanceRCurve->setSamples(xaxis.data(), object->smoothBalanceR.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->balanceLCurve, xaxis.data(), object->smoothBalanceL.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->balanceRCurve, xaxis.data(), object->smoothBalanceR.data(), totalPoints);
         standard->balanceLCurve->attach(this);
         standard->balanceLCurve->setVisible(true);
         standard->balanceRCurve->attach(this);
@@ -5371,8 +5133,8 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->lteArray.empty()) {
-        standard->lteCurve->setSamples(xaxis.data(), object->smoothLTE.data(), totalPoints);
-        standard->rteCurve->setSamples(xaxis.data(), object->smoothRTE.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->lteCurve, xaxis.data(), object->smoothLTE.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->rteCurve, xaxis.data(), object->smoothRTE.data(), totalPoints);
         standard->lteCurve->attach(this);
         standard->lteCurve->setVisible(true);
         standard->rteCurve->attach(this);
@@ -5380,8 +5142,8 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->lpsArray.empty()) {
-        standard->lpsCurve->setSamples(xaxis.data(), object->smoothLPS.data(), totalPoints);
-        standard->rpsCurve->setSamples(xaxis.data(), object->smoothRPS.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->lpsCurve, xaxis.data(), object->smoothLPS.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->rpsCurve, xaxis.data(), object->smoothRPS.data(), totalPoints);
         standard->lpsCurve->attach(this);
         standard->lpsCurve->setVisible(true);
         standard->rpsCurve->attach(this);
@@ -5389,8 +5151,8 @@ AllPlot::setDataFromObject(AllPlotObject *object, AllPlot *reference)
     }
 
     if (!object->lpcoArray.empty()) {
-        standard->lpcoCurve->setSamples(xaxis.data(), object->smoothLPCO.data(), totalPoints);
-        standard->rpcoCurve->setSamples(xaxis.data(), object->smoothRPCO.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->lpcoCurve, xaxis.data(), object->smoothLPCO.data(), totalPoints);
+        AllPlotDecimatedData::setSamples(standard->rpcoCurve, xaxis.data(), object->smoothRPCO.data(), totalPoints);
         standard->lpcoCurve->attach(this);
         standard->lpcoCurve->setVisible(true);
         standard->rpcoCurve->attach(this);
@@ -5730,104 +5492,86 @@ AllPlot::setDataFromRideFile(RideFile *ride, AllPlotObject *here, QList<UserData
         here->nmDCurve->setVisible(dataPresent->nm && showTorqueD);
         here->hrDCurve->setVisible(dataPresent->hr && showHrD);
 
-        int arrayLength = 0;
-        foreach (const RideFilePoint *point, ride->dataPoints()) {
+        // we round the time to nearest 100th of a second
+        // before adding to the array, to avoid situation
+        // where 'high precision' time slice is an artefact
+        // of double precision or slight timing anomalies
+        // e.g. where realtime gives timestamps like
+        // 940.002 followed by 940.998 and were previously
+        // both rounded to 940s
+        //
+        // NOTE: this rounding mechanism is identical to that
+        //       used by the Ride Editor.
+        RideFileColumn time = ride->column(RideFile::secs);
+        for (int i=0; i<npoints; i++) {
 
-            // we round the time to nearest 100th of a second
-            // before adding to the array, to avoid situation
-            // where 'high precision' time slice is an artefact
-            // of double precision or slight timing anomalies
-            // e.g. where realtime gives timestamps like
-            // 940.002 followed by 940.998 and were previously
-            // both rounded to 940s
-            //
-            // NOTE: this rounding mechanism is identical to that
-            //       used by the Ride Editor.
-            double secs = floor(point->secs);
-            double msecs = round((point->secs - secs) * 100) * 10;
+            double secs = floor(time[i]);
+            double msecs = round((time[i] - secs) * 100) * 10;
 
-            here->timeArray[arrayLength]  = secs + msecs/1000;
+            here->timeArray[i]  = secs + msecs/1000;
 
             for(int k=0; k<here->U.count() && k<user.count(); k++) {
-                here->U[k].array[arrayLength] = user[k]->vector[arrayLength];
+                here->U[k].array[i] = user[k]->vector[i];
             }
-            if (!here->wattsArray.empty()) here->wattsArray[arrayLength] = max(0, point->watts);
-            if (!here->atissArray.empty()) here->atissArray[arrayLength] = max(0, point->atiss);
-            if (!here->antissArray.empty()) here->antissArray[arrayLength] = max(0, point->antiss);
-            if (!here->npArray.empty()) here->npArray[arrayLength] = max(0, point->np);
-            if (!here->rvArray.empty()) here->rvArray[arrayLength] = max(0, point->rvert);
-            if (!here->rcadArray.empty()) here->rcadArray[arrayLength] = max(0, point->rcad);
-            if (!here->rgctArray.empty()) here->rgctArray[arrayLength] = max(0, point->rcontact);
-            if (!here->gearArray.empty()) here->gearArray[arrayLength] = max(0, point->gear);
-            if (!here->smo2Array.empty()) here->smo2Array[arrayLength] = max(0, point->smo2);
-            if (!here->thbArray.empty()) here->thbArray[arrayLength] = max(0, point->thb);
-            if (!here->o2hbArray.empty()) here->o2hbArray[arrayLength] = max(0, point->o2hb);
-            if (!here->hhbArray.empty()) here->hhbArray[arrayLength] = max(0, point->hhb);
-            if (!here->xpArray.empty()) here->xpArray[arrayLength] = max(0, point->xp);
-            if (!here->apArray.empty()) here->apArray[arrayLength] = max(0, point->apower);
-            if (!here->hrArray.empty()) here->hrArray[arrayLength]    = max(0, point->hr);
-            if (!here->tcoreArray.empty()) here->tcoreArray[arrayLength]    = max(0, point->tcore);
-
-            // delta series
-            if (!here->accelArray.empty()) here->accelArray[arrayLength] = point->kphd;
-            if (!here->wattsDArray.empty()) here->wattsDArray[arrayLength] = point->wattsd;
-            if (!here->cadDArray.empty()) here->cadDArray[arrayLength] = point->cadd;
-            if (!here->nmDArray.empty()) here->nmDArray[arrayLength] = point->nmd;
-            if (!here->hrDArray.empty()) here->hrDArray[arrayLength] = point->hrd;
-
-            if (!here->speedArray.empty())
-                here->speedArray[arrayLength] = max(0,
-                                              (context->athlete->useMetricUnits
-                                               ? point->kph
-                                               : point->kph * MILES_PER_KM));
-            if (!here->cadArray.empty())
-                here->cadArray[arrayLength]   = max(0, point->cad);
-            if (!here->altArray.empty())
-                here->altArray[arrayLength]   = (context->athlete->useMetricUnits
-                                           ? point->alt
-                                           : point->alt * FEET_PER_METER);
-
-            if (!here->slopeArray.empty()) here->slopeArray[arrayLength] = point->slope;
-
-            if (!here->tempArray.empty())
-                here->tempArray[arrayLength]   = context->athlete->useMetricUnits ? point->temp
-                                                 : point->temp * FAHRENHEIT_PER_CENTIGRADE + FAHRENHEIT_ADD_CENTIGRADE;
-
-            if (!here->windArray.empty())
-                here->windArray[arrayLength] = max(0,
-                                             (context->athlete->useMetricUnits
-                                              ? point->headwind
-                                              : point->headwind * MILES_PER_KM));
-
-            // pedal data
-            if (!here->balanceArray.empty()) here->balanceArray[arrayLength] = point->lrbalance;
-            if (!here->lteArray.empty()) here->lteArray[arrayLength] = point->lte;
-            if (!here->rteArray.empty()) here->rteArray[arrayLength] = point->rte;
-            if (!here->lpsArray.empty()) here->lpsArray[arrayLength] = point->lps;
-            if (!here->rpsArray.empty()) here->rpsArray[arrayLength] = point->rps;
-            if (!here->lpcoArray.empty()) here->lpcoArray[arrayLength] = point->lpco;
-            if (!here->rpcoArray.empty()) here->rpcoArray[arrayLength] = point->rpco;
-            if (!here->lppbArray.empty()) here->lppbArray[arrayLength] = point->lppb;
-            if (!here->rppbArray.empty()) here->rppbArray[arrayLength] = point->rppb;
-            if (!here->lppeArray.empty()) here->lppeArray[arrayLength] = point->lppe;
-            if (!here->rppeArray.empty()) here->rppeArray[arrayLength] = point->rppe;
-            if (!here->lpppbArray.empty()) here->lpppbArray[arrayLength] = point->lpppb;
-            if (!here->rpppbArray.empty()) here->rpppbArray[arrayLength] = point->rpppb;
-            if (!here->lpppeArray.empty()) here->lpppeArray[arrayLength] = point->lpppe;
-            if (!here->rpppeArray.empty()) here->rpppeArray[arrayLength] = point->rpppe;
-
-            here->distanceArray[arrayLength] = max(0,
-                                             (context->athlete->useMetricUnits
-                                              ? point->km
-                                              : point->km * MILES_PER_KM));
-
-            if (!here->torqueArray.empty())
-                here->torqueArray[arrayLength] = max(0,
-                                              (context->athlete->useMetricUnits
-                                               ? point->nm
-                                               : point->nm * FEET_LB_PER_NM));
-            ++arrayLength;
         }
+
+        // the rest are copied a series at a time from the ride columns
+        bool metric = context->athlete->useMetricUnits;
+
+        fillFromColumn(here->wattsArray, ride->column(RideFile::watts), true);
+        fillFromColumn(here->atissArray, ride->column(RideFile::aTISS), true);
+        fillFromColumn(here->antissArray, ride->column(RideFile::anTISS), true);
+        fillFromColumn(here->npArray, ride->column(RideFile::IsoPower), true);
+        fillFromColumn(here->rvArray, ride->column(RideFile::rvert), true);
+        fillFromColumn(here->rcadArray, ride->column(RideFile::rcad), true);
+        fillFromColumn(here->rgctArray, ride->column(RideFile::rcontact), true);
+        fillFromColumn(here->gearArray, ride->column(RideFile::gear), true);
+        fillFromColumn(here->smo2Array, ride->column(RideFile::smo2), true);
+        fillFromColumn(here->thbArray, ride->column(RideFile::thb), true);
+        fillFromColumn(here->o2hbArray, ride->column(RideFile::o2hb), true);
+        fillFromColumn(here->hhbArray, ride->column(RideFile::hhb), true);
+        fillFromColumn(here->xpArray, ride->column(RideFile::xPower), true);
+        fillFromColumn(here->apArray, ride->column(RideFile::aPower), true);
+        fillFromColumn(here->hrArray, ride->column(RideFile::hr), true);
+        fillFromColumn(here->tcoreArray, ride->column(RideFile::tcore), true);
+
+        // delta series
+        fillFromColumn(here->accelArray, ride->column(RideFile::kphd), false);
+        fillFromColumn(here->wattsDArray, ride->column(RideFile::wattsd), false);
+        fillFromColumn(here->cadDArray, ride->column(RideFile::cadd), false);
+        fillFromColumn(here->nmDArray, ride->column(RideFile::nmd), false);
+        fillFromColumn(here->hrDArray, ride->column(RideFile::hrd), false);
+
+        fillFromColumn(here->speedArray, ride->column(RideFile::kph), true, metric ? 1.0 : MILES_PER_KM);
+        fillFromColumn(here->cadArray, ride->column(RideFile::cad), true);
+        fillFromColumn(here->altArray, ride->column(RideFile::alt), false, metric ? 1.0 : FEET_PER_METER);
+        fillFromColumn(here->slopeArray, ride->column(RideFile::slope), false);
+        fillFromColumn(here->tempArray, ride->column(RideFile::temp), false,
+                       metric ? 1.0 : FAHRENHEIT_PER_CENTIGRADE, metric ? 0.0 : FAHRENHEIT_ADD_CENTIGRADE);
+        fillFromColumn(here->windArray, ride->column(RideFile::headwind), true, metric ? 1.0 : MILES_PER_KM);
+
+        // pedal data
+        fillFromColumn(here->balanceArray, ride->column(RideFile::lrbalance), false);
+        fillFromColumn(here->lteArray, ride->column(RideFile::lte), false);
+        fillFromColumn(here->rteArray, ride->column(RideFile::rte), false);
+        fillFromColumn(here->lpsArray, ride->column(RideFile::lps), false);
+        fillFromColumn(here->rpsArray, ride->column(RideFile::rps), false);
+        fillFromColumn(here->lpcoArray, ride->column(RideFile::lpco), false);
+        fillFromColumn(here->rpcoArray, ride->column(RideFile::rpco), false);
+        fillFromColumn(here->lppbArray, ride->column(RideFile::lppb), false);
+        fillFromColumn(here->rppbArray, ride->column(RideFile::rppb), false);
+        fillFromColumn(here->lppeArray, ride->column(RideFile::lppe), false);
+        fillFromColumn(here->rppeArray, ride->column(RideFile::rppe), false);
+        fillFromColumn(here->lpppbArray, ride->column(RideFile::lpppb), false);
+        fillFromColumn(here->rpppbArray, ride->column(RideFile::rpppb), false);
+        fillFromColumn(here->lpppeArray, ride->column(RideFile::lpppe), false);
+        fillFromColumn(here->rpppeArray, ride->column(RideFile::rpppe), false);
+
+        fillFromColumn(here->distanceArray, ride->column(RideFile::km), true, metric ? 1.0 : MILES_PER_KM);
+        fillFromColumn(here->torqueArray, ride->column(RideFile::nm), true, metric ? 1.0 : FEET_LB_PER_NM);
+
+        // new samples, integrate them again
+        here->smoothing.clear();
         recalc(here);
 
     }
@@ -7000,6 +6744,25 @@ QRectF IntervalPlotData::boundingRect() const
     return QRectF(0, 5000, 5100, 5100);
 }
 
+// the hovered curve may be decimated so its index is no use in another
+// curve, find the sample nearest x instead, x never goes backwards
+static int
+nearestSample(const QwtSeriesData<QwtIntervalSample> *data, double x)
+{
+    size_t n = data->size();
+    if (n == 0) return -1;
+
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (data->sample(mid).value < x) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == n) return n - 1;
+    if (lo > 0 && x - data->sample(lo-1).value < data->sample(lo).value - x) return lo - 1;
+    return lo;
+}
+
 void
 AllPlot::pointHover(QwtPlotCurve *curve, int index)
 {
@@ -7042,11 +6805,12 @@ AllPlot::pointHover(QwtPlotCurve *curve, int index)
             else
             {
                 // Add to tooltip headwind value relative to the rider speed.
-                if ((standard != nullptr) && showWind && (static_cast<size_t>(index) < standard->windCurve->data()->size()))
+                int wIndex = (standard != nullptr) ? nearestSample(standard->windCurve->data(), xvalue) : -1;
+                if (showWind && wIndex >= 0)
                 {
                     // Get Headwind curve minimum and maximum values.
-                    double wHeadWindMax = standard->windCurve->sample(index).interval.maxValue();
-                    double wHeadWindMin = standard->windCurve->sample(index).interval.minValue();
+                    double wHeadWindMax = standard->windCurve->sample(wIndex).interval.maxValue();
+                    double wHeadWindMin = standard->windCurve->sample(wIndex).interval.minValue();
 
                     // Head wind.
                     if (wHeadWindMax > yvalue)
@@ -21,6 +21,7 @@
 #include "GoldenCheetah.h"
 #include "Colors.h"
 #include "AllPlotSlopeCurve.h"
+#include "SmoothingEngine.h"
 
 #include <qwt_plot.h>
 #include <qwt_axis_id.h>
@@ -532,6 +533,9 @@ class AllPlotObject : public QObject
     QVector<QwtIntervalSample> smoothRPPP;
     QVector<QwtIntervalSample> smoothRelSpeed;
 
+    // the series integrated for smoothing, cleared when they change
+    SmoothingEngine smoothing;
+
     // setup as copy from user data
     void setUserData(QList<UserData*>); // reset below to reflect current
     QList<UserObject> U;
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "AllPlotDecimatedData.h"
+
+#include "qwt_plot_curve.h"
+
+#include <QApplication>
+#include <QDesktopWidget>
+#include <algorithm>
+
+AllPlotDecimatedData::AllPlotDecimatedData(const double *x, const double *y, int size) : level(0), from(0), count(size)
+{
+    Pyramid *p = new Pyramid;
+    p->x = QVector<double>(size);
+    p->y = QVector<double>(size);
+    if (size) {
+        std::copy(x, x + size, p->x.begin());
+        std::copy(y, y + size, p->y.begin());
+    }
+
+    // bounds and whether we can binary search on x
+    p->sorted = true;
+    double miny = size ? y[0] : 0, maxy = miny;
+    for (int i=1; i<size; i++) {
+        if (x[i] < x[i-1]) p->sorted = false;
+        if (y[i] < miny) miny = y[i];
+        if (y[i] > maxy) maxy = y[i];
+    }
+    if (size) p->bounds = QRectF(qMin(x[0], x[size-1]), miny, qAbs(x[size-1] - x[0]), maxy - miny);
+    else p->bounds = QRectF(1.0, 1.0, -2.0, -2.0); // invalid, as Qwt does
+
+    // each level keeps the min and max of every 4 points in the one below,
+    // in the order they were recorded, until it is less than the screen
+    QVector<int> below(size);
+    for (int i=0; i<size; i++) below[i] = i;
+    while (below.count() > 4 * pixels()) {
+
+        QVector<int> level;
+        level.reserve(below.count() / 2 + 2);
+        for (int i=0; i < below.count(); i += 4) {
+            int last = qMin(i + 4, below.count());
+            int lo = below[i], hi = below[i];
+            for (int j=i+1; j<last; j++) {
+                if (y[below[j]] < y[lo]) lo = below[j];
+                if (y[below[j]] > y[hi]) hi = below[j];
+            }
+            if (lo == hi) level << lo;
+            else if (lo < hi) level << lo << hi;
+            else level << hi << lo;
+        }
+
+        p->levels << level;
+        below = level;
+    }
+
+    pyramid = QSharedPointer<const Pyramid>(p);
+    setRectOfInterest(QRectF());
+}
+
+AllPlotDecimatedData::AllPlotDecimatedData(const AllPlotDecimatedData &other) :
+    QwtSeriesData<QPointF>(), pyramid(other.pyramid), level(other.level), from(other.from), count(other.count)
+{
+}
+
+int
+AllPlotDecimatedData::pixels()
+{
+    static int width = qMax(1024, QApplication::desktop()->geometry().width());
+    return width;
+}
+
+size_t
+AllPlotDecimatedData::size() const
+{
+    return count;
+}
+
+QPointF
+AllPlotDecimatedData::sample(size_t i) const
+{
+    int index = from + int(i);
+    if (level) index = pyramid->levels[level-1][index];
+    return QPointF(pyramid->x[index], pyramid->y[index]);
+}
+
+QRectF
+AllPlotDecimatedData::boundingRect() const
+{
+    return pyramid->bounds;
+}
+
+// the axes changed, pick the level for the samples that are visible
+void
+AllPlotDecimatedData::setRectOfInterest(const QRectF &rect)
+{
+    const QVector<double> &x = pyramid->x;
+
+    // visible samples, and one either side so the line runs off the edge
+    int first = 0, last = x.count();
+    if (pyramid->sorted && rect.isValid()) {
+        first = std::lower_bound(x.constBegin(), x.constEnd(), rect.left()) - x.constBegin();
+        last = std::upper_bound(x.constBegin(), x.constEnd(), rect.right()) - x.constBegin();
+        first = qMax(0, first - 1);
+        last = qMin(x.count(), last + 1);
+    }
+
+    // coarsest level with 2 buckets a pixel
+    level = 0;
+    while (level < pyramid->levels.count() && ((last - first) >> (level + 1)) >= 4 * pixels()) level++;
+
+    if (level == 0) {
+        from = first;
+        count = last - first;
+    } else {
+        const QVector<int> &points = pyramid->levels[level-1];
+        int start = std::lower_bound(points.constBegin(), points.constEnd(), first) - points.constBegin();
+        int end = std::lower_bound(points.constBegin(), points.constEnd(), last) - points.constBegin();
+        from = qMax(0, start - 1);
+        count = qMin(points.count(), end + 1) - from;
+    }
+}
+
+void
+AllPlotDecimatedData::setSamples(QwtPlotCurve *curve, const double *x, const double *y, int size)
+{
+    // not worth it unless there are more samples than pixels
+    if (size <= 4 * pixels()) curve->setSamples(x, y, size);
+    else curve->setSamples(new AllPlotDecimatedData(x, y, size));
+}
+
+void
+AllPlotDecimatedData::copySamples(QwtPlotCurve *to, const QwtPlotCurve *from)
+{
+    const AllPlotDecimatedData *data = dynamic_cast<const AllPlotDecimatedData*>(from->data());
+    if (data) to->setSamples(new AllPlotDecimatedData(*data));
+    else to->setSamples(samples(from));
+}
+
+int
+AllPlotDecimatedData::sampleCount(const QwtPlotCurve *curve)
+{
+    const AllPlotDecimatedData *data = dynamic_cast<const AllPlotDecimatedData*>(curve->data());
+    return data ? data->pyramid->x.count() : int(curve->data()->size());
+}
+
+QVector<QPointF>
+AllPlotDecimatedData::samples(const QwtPlotCurve *curve)
+{
+    QVector<QPointF> returning;
+
+    const AllPlotDecimatedData *data = dynamic_cast<const AllPlotDecimatedData*>(curve->data());
+    if (data) {
+        const Pyramid *p = data->pyramid.data();
+        returning.reserve(p->x.count());
+        for (int i=0; i<p->x.count(); i++) returning << QPointF(p->x[i], p->y[i]);
+    } else {
+        returning.reserve(curve->data()->size());
+        for (size_t i=0; i<curve->data()->size(); i++) returning << curve->data()->sample(i);
+    }
+    return returning;
+}
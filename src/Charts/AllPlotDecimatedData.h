@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_AllPlotDecimatedData_h
+#define _GC_AllPlotDecimatedData_h 1
+#include "GoldenCheetah.h"
+
+#include "qwt_series_data.h"
+
+#include <QVector>
+#include <QRectF>
+#include <QPointF>
+#include <QSharedPointer>
+
+class QwtPlotCurve;
+
+// AllPlotDecimatedData is the data behind the AllPlot curves of a long
+// ride. When the curve is set a min/max pyramid of the samples is built,
+// each level keeping the lowest and highest sample of every 4 in the
+// level below, so half as many, and no peak is ever lost.
+//
+// Qwt tells the data the visible x range whenever the axes change, then
+// the curve only sees the samples in that range, from the coarsest level
+// that still has 2 buckets for every pixel the screen is wide. Zoomed
+// out on a 10 hour ride that is a few thousand points rather than
+// 36,000 per series, zoomed in it is every sample.
+//
+// The samples are real samples, so hovering over the curve still shows
+// the values recorded.
+class AllPlotDecimatedData : public QwtSeriesData<QPointF>
+{
+    public:
+
+        AllPlotDecimatedData(const double *x, const double *y, int size);
+        AllPlotDecimatedData(const AllPlotDecimatedData &other); // shares the pyramid
+
+        // QwtSeriesData, the visible samples of the level in use
+        virtual size_t size() const;
+        virtual QPointF sample(size_t i) const;
+        virtual QRectF boundingRect() const;
+        virtual void setRectOfInterest(const QRectF &rect);
+
+        // set the curve's samples, decimated when there are enough of them
+        static void setSamples(QwtPlotCurve *curve, const double *x, const double *y, int size);
+
+        // copy the samples of one curve to another, all of them
+        static void copySamples(QwtPlotCurve *to, const QwtPlotCurve *from);
+        static QVector<QPointF> samples(const QwtPlotCurve *curve);
+        static int sampleCount(const QwtPlotCurve *curve); // not just the visible ones
+
+    private:
+
+        struct Pyramid {
+            QVector<double> x, y;
+            QVector<QVector<int> > levels;  // indexes into x and y, levels[0] is level 1
+            QRectF bounds;
+            bool sorted;                    // x never goes backwards
+        };
+
+        // the widest the canvas can be, in pixels
+        static int pixels();
+
+        QSharedPointer<const Pyramid> pyramid;
+        int level;          // 0 is every sample
+        int from, count;    // the visible part of the level
+};
+
+#endif // _GC_AllPlotDecimatedData_h
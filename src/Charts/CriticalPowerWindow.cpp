@@ -1197,11 +1197,10 @@ CriticalPowerWindow::showIntervalCurve(IntervalItem *current, int index)
     // for xpower and acceleration et al
     f.recalculateDerivedSeries();
 
-    // compute the mean max, this is BLAZINGLY fast, thanks to Mark Rages'
-    // mean-max computer. Does a 11hr ride in 150ms
+    // compute the mean max, this is BLAZINGLY fast, see MeanMaxEngine
     QVector<float>vector;
-    MeanMaxComputer thread1(&f, vector, getRideSeries(series())); thread1.run();
-    thread1.wait();
+    MeanMaxComputer computer(&f, vector, getRideSeries(series()));
+    computer.run();
 
     // no data!
     if (vector.count() == 0) return;
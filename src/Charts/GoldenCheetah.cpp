@@ -20,6 +20,7 @@
 #include "MainWindow.h"
 #include "GcOverlayWidget.h"
 #include "Context.h"
+#include "RideItem.h"
 #include "Colors.h"
 #include "Settings.h"
 #include "Utils.h"
@@ -116,6 +117,12 @@ RideItem* GcWindow::rideItem() const
 
 void GcWindow::setRideItem(RideItem* x)
 {
+    // charts keep the RideFile, it mustn't be closed under them
+    if (pinned != x) {
+        if (pinned) pinned->unpin();
+        pinned = x;
+        if (pinned) pinned->pin();
+    }
     _rideItem = x;
     emit rideItemChanged(_rideItem);
 }
@@ -227,6 +234,7 @@ GcWindow::GcWindow(Context *context) : QFrame(context->mainWindow), dragState(No
 
 GcWindow::~GcWindow()
 {
+    if (pinned) pinned->unpin();
 }
 
 bool
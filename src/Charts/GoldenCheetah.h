@@ -38,6 +38,7 @@ class Context;
 #include <QVariant>
 #include <QMetaType>
 #include <QFrame>
+#include <QPointer>
 #include <QtGui>
 
 #include "GcWindowRegistry.h"
@@ -95,6 +96,7 @@ private:
     QString _subtitle;
     //QString _instanceName;
     RideItem *_rideItem;
+    QPointer<RideItem> pinned; // so it stays open, see OpenRideCache
     GcWinID _type;
     DateRange _dr;
     double _widthFactor;
@@ -612,6 +612,7 @@ NotioCDAPlot::setData(RideItem *_rideItem, bool new_zoom) {
     altHeadUnitArray.clear();
     distanceArray.clear();
     timeArray.clear();
+    windMeans.clear();
 
     if (ride && ride->xdata("CDAData")) {
 
@@ -809,6 +810,14 @@ NotioCDAPlot::setData(RideItem *_rideItem, bool new_zoom) {
                 ++arrayLength;
             }
             //fclose(veLog);
+
+            // the wind over the selected intervals comes from the sums
+            QVector<double> secs(arrayLength);
+            for (int i = 0; i < arrayLength; i++) secs[i] = timeArray[i] * 60.0;
+            windMeans.setTimes(secs.constData(), arrayLength, dt);
+            windMeans.addSeries(vWindArray.constData(), arrayLength);
+            windMeans.addSeries(windArray.constData(), arrayLength);
+            windMeans.prepare();
         } else {
             //NKC1
 
@@ -936,16 +945,8 @@ NotioCDAPlot::recalc( bool new_zoom ) {
                 int idx3 = wCdaDataSeries->timeIndex(interval->stop);
                 double cda = NotioCDAData.intervalCDA(idx2, idx3);
 
-                double vWindTotal = 0.0;
-                double aWindTotal = 0.0;
-                for (int j = idx2 ; j <idx3 ; j++) {
-                    vWindTotal += vWindArray[j];
-                    aWindTotal += windArray[j];
-                }
-                if (idx3 > idx2) {
-                    vWindTotal /= (idx3-idx2);
-                    aWindTotal /= (idx3-idx2);
-                }
+                double vWindTotal = windMeans.mean(0, idx2, idx3);
+                double aWindTotal = windMeans.mean(1, idx2, idx3);
 
                 cout << "vWindAverage " << vWindTotal << endl;
                 cout << "aWindAverage " << aWindTotal << endl;
@@ -38,6 +38,7 @@ class NotioCDAWindow;
 class IntervalNotioCDAData;
 
 #include "NotioData.h"
+#include "SmoothingEngine.h"
 
 class NotioCDAData  {
 public :
@@ -189,6 +190,9 @@ protected:
     QVector<double> timeArray;
     QVector<double> distanceArray;
 
+    // integrated vWindArray (column 0) and windArray (column 1)
+    SmoothingEngine windMeans;
+
     int smooth;
     bool bydist;
     bool constantAlt;
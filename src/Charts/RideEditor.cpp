@@ -1718,14 +1718,18 @@ void
 RideEditor::endCommand(bool undo, RideCommand *cmd)
 {
 
-    // Update the undo/redo toolbar icons
-    if (ride->ride()->command->redoCount() == 0) redoAct->setEnabled(false);
-    else redoAct->setEnabled(true);
-    if (ride->ride()->command->undoCount() == 0) undoAct->setEnabled(false);
-    else undoAct->setEnabled(true);
+    // once for a LUW, not for each of the commands in it
+    if (!inLUW || cmd->type == RideCommand::LUW) {
 
-    // react to xdata changes
-    setTabBar(false);
+        // Update the undo/redo toolbar icons
+        if (ride->ride()->command->redoCount() == 0) redoAct->setEnabled(false);
+        else redoAct->setEnabled(true);
+        if (ride->ride()->command->undoCount() == 0) undoAct->setEnabled(false);
+        else undoAct->setEnabled(true);
+
+        // react to xdata changes
+        setTabBar(false);
+    }
 
     // update the selection model when a command has been executed
     switch (cmd->type) {
@@ -1748,6 +1752,22 @@ RideEditor::endCommand(bool undo, RideCommand *cmd)
 
             break;
         }
+        case RideCommand::SetPointValues:
+        {
+            SetPointValuesCommand *spv = (SetPointValuesCommand*)cmd;
+
+            int column = model->columnFor(spv->series);
+            QModelIndex top = model->index(spv->row, column);
+            QModelIndex bottom = model->index(spv->row + spv->count - 1, column);
+
+            if (inLUW) { // the corners are enough, it selects the bounding box
+                itemselection << top << bottom;
+            } else {
+                table->selectionModel()->select(QItemSelection(top, bottom), QItemSelectionModel::ClearAndSelect);
+                table->selectionModel()->setCurrentIndex(top, QItemSelectionModel::Select);
+            }
+            break;
+        }
         case RideCommand::InsertPoint:
         {
             InsertPointCommand *ip = (InsertPointCommand *)cmd;
@@ -1892,9 +1912,10 @@ RideEditor::endCommand(bool undo, RideCommand *cmd)
                 if (index.column() < left) left = index.column();
                 if (index.column() > right) right = index.column();
             }
+            if (itemselection.count())
+                table->selectionModel()->select(QItemSelection(model->index(top,left),
+                            model->index(bottom,right)), QItemSelectionModel::Select);
             itemselection.clear();
-            table->selectionModel()->select(QItemSelection(model->index(top,left),
-                        model->index(bottom,right)), QItemSelectionModel::Select);
         }
             break;
 
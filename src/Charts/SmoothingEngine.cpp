@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "SmoothingEngine.h"
+
+#include <algorithm>
+
+SmoothingEngine::SmoothingEngine() : width(0)
+{
+}
+
+void
+SmoothingEngine::clear()
+{
+    width = 0;
+    times.clear();
+    weights.clear();
+    series.clear();
+    sums.clear();
+    seconds.clear();
+}
+
+void
+SmoothingEngine::setTimes(const double *secs, int count, double recIntSecs)
+{
+    clear();
+    if (recIntSecs <= 0) recIntSecs = 1;
+
+    times.resize(count);
+    weights.resize(count);
+    for (int i=0; i<count; i++) {
+        times[i] = secs[i];
+
+        // the time since the last sample, unless there was a gap
+        // or the samples are out of order
+        double dt = i ? secs[i] - secs[i-1] : 0;
+        weights[i] = (dt > 0 && dt <= 2 * recIntSecs) ? dt : recIntSecs;
+    }
+}
+
+int
+SmoothingEngine::addSeries(const double *values, int size)
+{
+    QVector<double> column(times.count(), 0.0);
+    if (size > column.count()) size = column.count();
+    if (size > 0) std::copy(values, values + size, column.begin());
+
+    series << column;
+    return width++;
+}
+
+void
+SmoothingEngine::prepare()
+{
+    int n = times.count();
+
+    sums.resize((n + 1) * width);
+    seconds.resize(n + 1);
+    std::fill(sums.begin(), sums.begin() + width, 0.0);
+    seconds[0] = 0;
+
+    double *row = sums.data();
+    for (int i=0; i<n; i++) {
+        double w = weights[i];
+        double *next = row + width;
+        for (int c=0; c<width; c++) next[c] = row[c] + w * series[c][i];
+        seconds[i+1] = seconds[i] + w;
+        row = next;
+    }
+
+    // the columns are all in the sums now
+    series.clear();
+}
+
+double
+SmoothingEngine::mean(int column, int from, int to) const
+{
+    from = qMax(0, from);
+    to = qMin(times.count(), to);
+    if (to <= from || column < 0 || column >= width) return 0;
+
+    return (sums[to * width + column] - sums[from * width + column]) / (seconds[to] - seconds[from]);
+}
+
+void
+SmoothingEngine::smooth(double window, int from, int to, double * const *out, int *ends, int *counts) const
+{
+    if (to < from) return;
+
+    const double *time = times.constData();
+    const int n = times.count();
+
+    // samples in the window of the first second, after that the
+    // window only ever moves forward
+    int hi = std::upper_bound(time, time + n, double(from)) - time;
+    int lo = std::lower_bound(time, time + n, from - window) - time;
+
+    QVector<double> row(width);
+    double *mean = row.data();
+
+    for (int secs = from; secs <= to; secs++) {
+
+        while (hi < n && time[hi] <= secs) hi++;
+        while (lo < hi && time[lo] < secs - window) lo++;
+
+        int k = secs - from;
+        if (ends) ends[k] = hi;
+        if (counts) counts[k] = hi - lo;
+
+        if (hi == lo) {
+            for (int c=0; c<width; c++) out[c][k] = 0;
+            continue;
+        }
+
+        // all the series at once, then out to each one
+        const double *a = sums.constData() + hi * width;
+        const double *b = sums.constData() + lo * width;
+        const double scale = 1.0 / (seconds[hi] - seconds[lo]);
+        for (int c=0; c<width; c++) mean[c] = (a[c] - b[c]) * scale;
+        for (int c=0; c<width; c++) out[c][k] = mean[c];
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_SmoothingEngine_h
+#define _GC_SmoothingEngine_h 1
+#include "GoldenCheetah.h"
+
+#include <QVector>
+
+// SmoothingEngine is the moving average behind the ride plots. The series
+// of a ride are added once, as columns of a matrix with a row for every
+// sample, and integrated, then the mean of every series over any run of
+// samples is the difference of two rows divided by the time between them.
+// Moving the smoothing slider only takes differences, it never goes back
+// to the samples.
+//
+// The rows are stored one after another so the inner loop runs across
+// all the series of a sample at once, which the compiler vectorises.
+//
+// The mean is weighted by the time each sample represents, the time since
+// the sample before it, so a ride recorded at an irregular rate is not
+// biased towards the parts with more samples. For a ride recorded at a
+// steady rate that is the plain average of the samples in the window, as
+// it always was. The first sample and the one after a gap (recording
+// stopped for more than 2 intervals) count for one interval.
+class SmoothingEngine
+{
+    public:
+
+        SmoothingEngine();
+
+        void clear();
+
+        // the time of each sample in seconds, this starts again
+        void setTimes(const double *secs, int count, double recIntSecs);
+
+        // add a series and return its column, values past size are 0
+        int addSeries(const double *values, int size);
+        int addSeries(const QVector<double> &values) { return addSeries(values.constData(), values.count()); }
+
+        // integrate the series, call it once they are all added
+        void prepare();
+
+        int count() const { return times.count(); }
+        int columns() const { return width; }
+
+        // mean of a column over the samples from..to-1, 0 if there are none
+        double mean(int column, int from, int to) const;
+
+        // the moving average of every column for each second from..to, where
+        // the window at a second is the samples recorded between secs-window
+        // and secs. The mean of column c goes in out[c][secs-from], 0 when
+        // the window is empty.
+        //
+        // ends (if given) gets one past the last sample at or before each
+        // second and counts the number of samples in its window, indexed
+        // the same way
+        void smooth(double window, int from, int to, double * const *out,
+                    int *ends = NULL, int *counts = NULL) const;
+
+    private:
+
+        int width;                      // columns
+        QVector<double> times;          // per sample
+        QVector<double> weights;        // per sample, the seconds it represents
+        QVector<QVector<double> > series; // as added, until prepared
+
+        // prepared, count+1 rows of width, row r is the total of the
+        // weighted samples before r and seconds[r] the total weight
+        QVector<double> sums;
+        QVector<double> seconds;
+};
+
+#endif // _GC_SmoothingEngine_h
@@ -21,6 +21,7 @@
 #include "Settings.h"
 #include "GcUpgrade.h"
 #include "RideDB.h"
+#include "RideDBStore.h"
 
 #include "RideFile.h"
 #include "RideFileCache.h"
@@ -72,8 +73,8 @@ APIWebService::athleteData(QStringList &paths, HttpRequest &request, HttpRespons
         response.write("missing athlete.");
         return;
     } else {
-        QFile ridedb(home.absolutePath() + "/" + paths[0] + "/cache/rideDB.json");
-        if (!ridedb.exists()) {
+        QString cacheDir = home.absolutePath() + "/" + paths[0] + "/cache";
+        if (!QFile(RideDBStore::jsonFileName(cacheDir)).exists() && !QFile(RideDBStore::storeFileName(cacheDir)).exists()) {
             response.setStatus(404); // malformed URL
             response.setHeader("Content-Type", "text; charset=ISO-8859-1");
             response.write("unknown athlete " + paths[0].toLocal8Bit());
@@ -174,8 +175,22 @@ APIWebService::listAthletes(HttpRequest &, HttpResponse &response)
 
         // sure fire sign the athlete has been upgraded to post 3.2 and not some
         // random directory full of other things & check something basic is set
-        QString ridedb = home.absolutePath() + "/" + name + "/cache/rideDB.json";
-        if (QFile(ridedb).exists() && appsettings->cvalue(name, GC_SEX, "") != "") {
+        // once seen an athlete won't lose it, so remember them
+        mutex.lock();
+        bool ridedb = athletes.contains(name);
+        mutex.unlock();
+
+        if (!ridedb) {
+            QString cacheDir = home.absolutePath() + "/" + name + "/cache";
+            ridedb = QFile(RideDBStore::jsonFileName(cacheDir)).exists() || QFile(RideDBStore::storeFileName(cacheDir)).exists();
+            if (ridedb) {
+                mutex.lock();
+                athletes.insert(name);
+                mutex.unlock();
+            }
+        }
+
+        if (ridedb && appsettings->cvalue(name, GC_SEX, "") != "") {
             // we got one
             QString line = name;
             line += ", " + appsettings->cvalue(name, GC_DOB).toDate().toString("yyyy/MM/dd");
@@ -191,27 +206,34 @@ APIWebService::listAthletes(HttpRequest &, HttpResponse &response)
 }
 
 
-void 
-APIWebService::writeRideLine(RideItem &item, HttpRequest *request, HttpResponse *response)
+void
+APIRideIndex::add(RideItem &item)
 {
+    APIRideIndexEntry add;
+    add.dateTime = item.dateTime;
+    add.fileName = item.fileName;
+    add.metrics = item.metrics();
+    add.metadata = item.metadata();
+    foreach(IntervalItem *interval, item.intervals()) {
+        APIRideIndexEntry::Interval i;
+        i.name = interval->name;
+        i.type = static_cast<int>(interval->type);
+        i.metrics = interval->metrics();
+        add.intervals << i;
+    }
+    rides << add;
+}
 
-    // honour the since parameter
-    QString sincep(request->getParameter("since"));
-    QDate since(1900,01,01);
-    if (sincep != "") since = QDate::fromString(sincep,"yyyy/MM/dd");
-
-    // before parameter
-    QString beforep(request->getParameter("before"));
-    QDate before(3000,01,01);
-    if (beforep != "") before = QDate::fromString(beforep,"yyyy/MM/dd");
-
-    // in range?
-    if (item.dateTime.date() < since) return;
-    if (item.dateTime.date() > before) return;
-
+void 
+APIWebService::writeRideLine(RideItem &item, HttpRequest *, HttpResponse *response)
+{
     // are we doing rides or intervals?
     listRideSettings *settings = static_cast<listRideSettings *>(response->userData());
 
+    // in range? (since and before parameters)
+    if (item.dateTime.date() < settings->since) return;
+    if (item.dateTime.date() > settings->before) return;
+
     if (settings->intervals == true) {
 
         // loop through all available intervals for this ride item
@@ -231,7 +253,9 @@ APIWebService::writeRideLine(RideItem &item, HttpRequest *request, HttpResponse
             response->bwrite(QString("%1").arg(static_cast<int>(interval->type)).toLocal8Bit());
 
             // essentially the same as below .. cut and paste (refactor?XXX)
-            if (settings->wanted.count()) {
+            if (settings->nometrics) {
+                // just the intervals
+            } else if (settings->wanted.count()) {
                 // specific metrics
                 foreach(int index, settings->wanted) {
                     double value = interval->metrics()[index];
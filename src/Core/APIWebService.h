@@ -23,14 +23,57 @@
 #include "RideItem.h"
 #include "RideMetadata.h"
 #include <QDir>
+#include <QMutex>
+#include <QSet>
+#include <QSharedPointer>
 
 struct listRideSettings {
     bool intervals;
+    QDate since, before; // date range wanted
     QList<int> wanted; // metrics to list
+    bool nometrics; // metrics=none, wanted is empty but means none not all
     QList<FieldDefinition> metafields;
     QList<QString> metawanted; // metadata to list
 };
 
+// The rides for an athlete as read from the ride db, kept in memory
+// between requests and rebuilt when the file on disk changes. This
+// avoids re-reading the ride db for every request when dashboards
+// are polling the api every few seconds.
+struct APIRideIndexEntry {
+    QDateTime dateTime;
+    QString fileName;
+    QVector<double> metrics;
+    QMap<QString,QString> metadata;
+
+    // for ?intervals=true
+    struct Interval {
+        QString name;
+        int type;
+        QVector<double> metrics;
+    };
+    QVector<Interval> intervals;
+
+    bool operator< (const APIRideIndexEntry &right) const { return dateTime < right.dateTime; }
+};
+
+class APIRideIndex
+{
+    public:
+        APIRideIndex() : size(0), generation(0) {}
+
+        // add from the rideDB parser or binary store
+        void add(RideItem &item);
+
+        // source file and its state when we read it
+        QString source;
+        QDateTime modified;
+        qint64 size;
+        quint32 generation;
+
+        QVector<APIRideIndexEntry> rides; // sorted by date
+};
+
 class APIWebService : public HttpRequestHandler
 {
 
@@ -54,8 +97,17 @@ class APIWebService : public HttpRequestHandler
         // utility
         void writeRideLine(RideItem &item, HttpRequest *request, HttpResponse *response);
 
+        // get the ride index for the athlete, reading the ride db
+        // only if it changed since last time, NULL if there isn't one
+        QSharedPointer<APIRideIndex> rideIndex(QString athlete);
+
     private:
         QDir home;
+
+        // requests are serviced on multiple threads
+        QMutex mutex;
+        QHash<QString, QSharedPointer<APIRideIndex> > indexes;
+        QSet<QString> athletes; // known to have a ride db
 };
 
 #endif
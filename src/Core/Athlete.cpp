@@ -26,6 +26,7 @@
 #include "RideCache.h"
 #include "Estimator.h"
 #include "RideFileCache.h"
+#include "RideFileCacheTree.h"
 #include "RideMetric.h"
 #include "Settings.h"
 #include "TimeUtils.h"
@@ -177,6 +178,10 @@ Athlete::Athlete(Context *context, const QDir &homeDir)
     cloudAutoDownload = new CloudServiceAutoDownload(context);
     connect(context, SIGNAL(refreshEnd()), cloudAutoDownload, SLOT(autoDownload()));
 
+    // aggregated bests, before the ride cache can refresh any .cpx
+    // the nodes are read from the cache folder as they are needed
+    cpxTree = new RideFileCacheTree(context);
+
     // now most dependencies are in get cache
     QEventLoop loop;
     rideCache = new RideCache(context);
@@ -238,6 +243,10 @@ Athlete::~Athlete()
     // close the ride cache down first
     delete rideCache;
 
+    // keep the aggregated bests built this time for next time
+    cpxTree->save();
+    delete cpxTree;
+
     // save those preset charts
     LTMSettings reader;
     reader.writeChartXML(home->config(), presets); // don't write it until we fix the code
@@ -304,6 +313,7 @@ Athlete::checkCPX(RideItem*ride)
             newList.append(p);
     }
     cpxCache = newList;
+    cpxTree->invalidate(ride->dateTime.date());
 }
 
 void
@@ -45,6 +45,7 @@ class Seasons;
 class RideNavigator;
 class NamedSearches;
 class RideFileCache;
+class RideFileCacheTree;
 class RideItem;
 class IntervalItem;
 class IntervalTreeView;
@@ -99,6 +100,7 @@ class Athlete : public QObject
         Seasons *seasons;
         Routes *routes;
         QList<RideFileCache*> cpxCache;
+        RideFileCacheTree *cpxTree; // bests by week, month and year
         RideCache *rideCache;
         Measures *measures;
 
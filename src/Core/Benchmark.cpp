@@ -0,0 +1,805 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "Benchmark.h"
+#include "Context.h"
+#include "Athlete.h"
+#include "RideItem.h"
+#include "IntervalItem.h"
+#include "RideCache.h"
+#include "RideFile.h"
+#include "RideFileCache.h"
+#include "FitRideFile.h"
+#include "JsonRideFile.h"
+#include "JsonRideFileStream.h"
+#include "RideMetric.h"
+#include "MeanMaxEngine.h"
+#include "DataFilter.h"
+#include "Specification.h"
+#include "Zones.h"
+#include "HrZones.h"
+#include "PaceZones.h"
+#include "ANT.h"
+#include "ANTMessage.h"
+
+#include <QDir>
+#include <QFile>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QAtomicInt>
+#include <cmath>
+#include <algorithm>
+#include <stdio.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+int
+Benchmark::run(QString folder, Context *context)
+{
+    if (folder == "") folder = "test/rides";
+
+    Benchmark benchmark(folder, context);
+    bool replayed = benchmark.antReplay();
+    if (!benchmark.load()) return replayed ? 0 : 1;
+
+    benchmark.meanMax();
+    benchmark.fit();
+    benchmark.json();
+    benchmark.rideCache();
+    if (context) {
+        benchmark.metrics();
+        benchmark.dataFilter();
+    }
+
+    return 0;
+}
+
+Benchmark::Benchmark(QString folder, Context *context) : folder(folder), context(context)
+{
+}
+
+Benchmark::~Benchmark()
+{
+    qDeleteAll(rides);
+}
+
+bool
+Benchmark::load()
+{
+    QDir dir(folder);
+    if (!dir.exists()) {
+        fprintf(stderr, "benchmark: %s not found.\n", folder.toUtf8().constData());
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    foreach (QString name, dir.entryList(QDir::Files, QDir::Name)) {
+
+        if (!RideFileFactory::instance().supportedFormat(name)) continue;
+
+        QFile file(dir.absoluteFilePath(name));
+        QStringList errors;
+        RideFile *ride = RideFileFactory::instance().openRideFile(NULL, file, errors);
+        if (ride) {
+            rides << ride;
+            names << name;
+            files << file.fileName();
+        }
+    }
+
+    fprintf(stderr, "benchmark: loaded %d rides from %s in %lld ms\n\n", rides.count(),
+            folder.toUtf8().constData(), timer.elapsed());
+
+    return rides.count() > 0;
+}
+
+// the item owns the ride and it needs the context for weight etc
+RideItem *
+Benchmark::openItem(int r)
+{
+    QFile file(files[r]);
+    QStringList errors;
+    RideFile *ride = RideFileFactory::instance().openRideFile(context, file, errors);
+    if (!ride) return NULL;
+
+    RideItem *item = new RideItem(ride, context);
+    item->dateTime = ride->startTime();
+    item->isRun = ride->isRun();
+    item->isSwim = ride->isSwim();
+    item->present = ride->getTag("Data", "");
+    item->samples = ride->dataPoints().count() > 0;
+    QDate date = item->dateTime.date();
+    item->zoneRange = context->athlete->zones(item->isRun) ? context->athlete->zones(item->isRun)->whichRange(date) : -1;
+    item->hrZoneRange = context->athlete->hrZones(item->isRun) ? context->athlete->hrZones(item->isRun)->whichRange(date) : -1;
+    item->paceZoneRange = context->athlete->paceZones(item->isSwim) ? context->athlete->paceZones(item->isSwim)->whichRange(date) : -1;
+    return item;
+}
+
+//
+// Mean-max - exact MeanMaxEngine against the stepped Mark Rages search
+// that RideFileCache::fastSearch() still uses, for each kernel the cpu
+// has. The stepped search can only ever be the same or lower.
+//
+void
+Benchmark::meanMax()
+{
+    QStringList kernels = MeanMaxEngine::kernels();
+    QVector<qint64> engineNs(kernels.count());
+    qint64 ragesNs = 0;
+
+    int series = 0, samples = 0;
+    int durations = 0, differ = 0, above = 0, mismatch = 0;
+    double worst = 0;
+    int worstDuration = 0;
+    QString worstRide;
+
+    QElapsedTimer timer;
+    for (int r=0; r<rides.count(); r++) {
+
+        RideFile *ride = rides[r];
+
+        foreach (RideFile::SeriesType type, RideFileCache::meanMaxList()) {
+
+            if (!ride->isDataPresent(type)) continue;
+
+            // same scaling as the cache
+            double decimals = pow(10, RideFileCache::decimalsFor(type));
+            QVector<int> input;
+            input.reserve(ride->dataPoints().count());
+            foreach (const RideFilePoint *p, ride->dataPoints())
+                input << int(round(p->value(type) * decimals));
+            if (input.count() < 2) continue;
+
+            QVector<double> values(input.count());
+            for (int i=0; i<input.count(); i++) values[i] = input[i];
+
+            series++;
+            samples += input.count();
+
+            // the old way
+            QVector<int> rages, offsets;
+            timer.start();
+            RideFileCache::fastSearch(input, rages, offsets);
+            ragesNs += timer.nsecsElapsed();
+
+            // the new way, once per kernel
+            QVector<double> first;
+            for (int k=0; k<kernels.count(); k++) {
+
+                MeanMaxEngine engine;
+                engine.setKernel(kernels[k]);
+
+                timer.start();
+                engine.append(values);
+                engineNs[k] += timer.nsecsElapsed();
+
+                // all kernels must agree exactly
+                if (k == 0) first = engine.totals();
+                else if (engine.totals() != first) mismatch++;
+            }
+
+            // accuracy, fastSearch truncates to int
+            for (int d=1; d<input.count(); d++) {
+
+                int exact = int(first[d] / double(d));
+                durations++;
+
+                if (rages[d] > exact) above++;
+                if (rages[d] != exact) {
+                    differ++;
+                    double error = exact ? double(exact - rages[d]) / double(exact) : 0;
+                    if (error > worst) {
+                        worst = error;
+                        worstDuration = d;
+                        worstRide = names[r] + " " + RideFile::seriesName(type);
+                    }
+                }
+            }
+        }
+    }
+
+    fprintf(stderr, "mean-max: %d series, %d samples, %d durations\n", series, samples, durations);
+    fprintf(stderr, "  %-10s %10.1f ms\n", "rages", ragesNs / 1000000.0);
+    for (int k=0; k<kernels.count(); k++)
+        fprintf(stderr, "  %-10s %10.1f ms  %.1fx\n", kernels[k].toUtf8().constData(), engineNs[k] / 1000000.0,
+                engineNs[k] ? double(ragesNs) / double(engineNs[k]) : 0);
+    fprintf(stderr, "  %d durations differ, worst %.2f%% low at %ds in %s\n", differ, worst * 100.0,
+            worstDuration, worstRide.toUtf8().constData());
+    if (above) fprintf(stderr, "  ERROR: %d durations where rages is above the exact best\n", above);
+    if (mismatch) fprintf(stderr, "  ERROR: %d series where kernels disagree\n", mismatch);
+    fprintf(stderr, "\n");
+}
+
+//
+// Metrics - computeMetrics() levelling the dependency graph and computing
+// each level in parallel against the worklist it replaced. Each ride is
+// computed once first so W' and anything else cached is already there
+// for both of them.
+//
+void
+Benchmark::metrics()
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+    QStringList all = factory.allMetrics();
+
+    qint64 worklistNs = 0, levelsNs = 0;
+    int differ = 0, computed = 0;
+
+    QElapsedTimer timer;
+    for (int r=0; r<files.count(); r++) {
+
+        RideItem *opened = openItem(r);
+        if (!opened) continue;
+        RideItem &item = *opened;
+
+        RideMetric::computeMetrics(&item, Specification(), all);
+
+        timer.start();
+        QHash<QString,RideMetricPtr> before = RideMetric::computeMetricsWorklist(&item, Specification(), all);
+        worklistNs += timer.nsecsElapsed();
+
+        timer.start();
+        QHash<QString,RideMetricPtr> after = RideMetric::computeMetrics(&item, Specification(), all);
+        levelsNs += timer.nsecsElapsed();
+
+        // same answers?
+        computed++;
+        foreach(QString symbol, all) {
+            if (!before.contains(symbol) || !after.contains(symbol)) continue;
+            double a = before.value(symbol)->value(true);
+            double b = after.value(symbol)->value(true);
+            if (a != b && !(std::isnan(a) && std::isnan(b))) {
+                if (differ < 10) fprintf(stderr, "  %s %s %g != %g\n", names[r].toUtf8().constData(),
+                                         symbol.toUtf8().constData(), a, b);
+                differ++;
+            }
+        }
+        delete opened;
+    }
+
+    RideMetricGraph graph = RideMetricFactory::instance().graph();
+    fprintf(stderr, "metrics: %d rides, %d metrics in %d levels\n", computed, all.count(), graph.levels.count());
+    if (computed) {
+        fprintf(stderr, "  %-10s %10.2f ms per ride\n", "worklist", worklistNs / 1000000.0 / computed);
+        fprintf(stderr, "  %-10s %10.2f ms per ride  %.1fx\n", "levels", levelsNs / 1000000.0 / computed,
+                levelsNs ? double(worklistNs) / double(levelsNs) : 0);
+    }
+    if (differ) fprintf(stderr, "  ERROR: %d metric values differ\n", differ);
+    fprintf(stderr, "\n");
+}
+
+//
+// DataFilter - sample formulas (as used for user data series) compiled
+// and evaluated a block at a time against Leaf::eval a sample at a time
+//
+void
+Benchmark::dataFilter()
+{
+    QStringList formulas;
+    formulas << "POWER"
+             << "POWER * 2 + HEARTRATE"
+             << "CADENCE > 0 ? POWER / CADENCE : 0"
+             << "(SPEED > 10 && HEARTRATE) ? round(SPEED * 10) / 10 : NA"
+             << "isRun ? SPEED : POWER / Duration";
+
+    qint64 leafNs = 0, programNs = 0;
+    int samples = 0, differ = 0, compiled = 0;
+
+    QList<DataFilter*> filters;
+    foreach(QString formula, formulas) {
+        DataFilter *filter = new DataFilter(NULL, context, formula);
+        QSharedPointer<DataFilterProgram> program = filter->compile(filter->root());
+        if (program && program->isValid()) compiled++;
+        else fprintf(stderr, "  %s did not compile\n", formula.toUtf8().constData());
+        filters << filter;
+    }
+
+    // ride level formulas, also checked against an interval spec as
+    // both paths must read the interval's metrics and not the ride's
+    QStringList rideFormulas;
+    rideFormulas << "Duration"
+                 << "Average_Power * 2 + Work / 1000"
+                 << "Duration > 0 ? Work / Duration : 0";
+
+    QList<DataFilter*> rideFilters;
+    foreach(QString formula, rideFormulas) {
+        DataFilter *filter = new DataFilter(NULL, context, formula);
+        QSharedPointer<DataFilterProgram> program = filter->compile(filter->root());
+        if (!program || !program->isValid())
+            fprintf(stderr, "  %s did not compile\n", formula.toUtf8().constData());
+        rideFilters << filter;
+    }
+    int intervals = 0;
+
+    QElapsedTimer timer;
+    for (int r=0; r<files.count(); r++) {
+
+        RideItem *item = openItem(r);
+        if (!item) continue;
+        RideMetric::computeMetrics(item, Specification(), RideMetricFactory::instance().allMetrics());
+
+        foreach(DataFilter *filter, filters) {
+
+            Leaf *root = filter->root();
+            if (!root) continue;
+
+            // the reference
+            QVector<double> reference;
+            timer.start();
+            foreach(RideFilePoint *p, item->ride()->dataPoints())
+                reference << root->eval(&filter->rt, root, 0, item, p).number;
+            leafNs += timer.nsecsElapsed();
+
+            timer.start();
+            QVector<double> values = filter->evaluateSamples(item);
+            programNs += timer.nsecsElapsed();
+
+            samples += reference.count();
+            for (int i=0; i<reference.count() && i<values.count(); i++) {
+                if (reference[i] != values[i] && !(std::isnan(reference[i]) && std::isnan(values[i]))) {
+                    if (differ < 10) fprintf(stderr, "  %s %s sample %d %g != %g\n", names[r].toUtf8().constData(),
+                                             filter->signature().toUtf8().constData(), i, reference[i], values[i]);
+                    differ++;
+                }
+            }
+            if (values.count() != reference.count()) differ++;
+        }
+
+        // the first half of the ride as an interval, no precomputed hash
+        RideFile *f = item->ride();
+        if (f->dataPoints().count() > 1) {
+            double start = f->dataPoints().first()->secs;
+            double stop = start + (f->dataPoints().last()->secs - start) / 2;
+            IntervalItem *interval = new IntervalItem(item, "benchmark", start, stop,
+                                                      f->timeToDistance(start), f->timeToDistance(stop),
+                                                      0, QColor(Qt::darkBlue), false, RideFileInterval::USER);
+            interval->refresh();
+            Specification spec(interval, f->recIntSecs());
+
+            foreach(DataFilter *filter, rideFilters) {
+                Leaf *root = filter->root();
+                QSharedPointer<DataFilterProgram> program = filter->compile(root);
+                if (!root || !program || !program->usable(&filter->rt, false)) continue;
+
+                double reference = root->eval(&filter->rt, root, 0, item, NULL, NULL, spec).number;
+                double value = program->eval(&filter->rt, item, NULL, NULL, 0, spec);
+                if (reference != value && !(std::isnan(reference) && std::isnan(value))) {
+                    if (differ < 10) fprintf(stderr, "  %s %s interval %g != %g\n", names[r].toUtf8().constData(),
+                                             filter->signature().toUtf8().constData(), reference, value);
+                    differ++;
+                }
+                intervals++;
+            }
+            delete interval;
+        }
+        delete item;
+    }
+    qDeleteAll(filters);
+    qDeleteAll(rideFilters);
+
+    fprintf(stderr, "datafilter: %d formulas (%d compiled), %d samples, %d interval checks\n", formulas.count(),
+            compiled, samples, intervals);
+    fprintf(stderr, "  %-10s %10.1f ms\n", "leaf", leafNs / 1000000.0);
+    fprintf(stderr, "  %-10s %10.1f ms  %.1fx\n", "program", programNs / 1000000.0,
+            programNs ? double(leafNs) / double(programNs) : 0);
+    if (differ) fprintf(stderr, "  ERROR: %d samples or interval values differ\n", differ);
+    fprintf(stderr, "\n");
+}
+
+//
+// FIT - decoding throughput for the FIT files in the folder, each
+// file is decoded a few times and the best time kept so it is the
+// decoder being measured and not the disk
+//
+void
+Benchmark::fit()
+{
+    QDir dir(folder);
+    QStringList filters;
+    filters << "*.fit" << "*.FIT";
+
+    FitFileReader reader;
+    qint64 bytes = 0, ns = 0;
+    int count = 0, samples = 0, failed = 0;
+
+    QElapsedTimer timer;
+    foreach (QString name, dir.entryList(filters, QDir::Files, QDir::Name)) {
+
+        QFile file(dir.absoluteFilePath(name));
+        qint64 best = 0;
+        for (int i=0; i<5; i++) {
+
+            QStringList errors;
+            timer.start();
+            RideFile *ride = reader.openRideFile(file, errors);
+            qint64 took = timer.nsecsElapsed();
+
+            if (!ride) {
+                failed++;
+                break;
+            }
+            if (i == 0) samples += ride->dataPoints().count();
+            if (i == 0 || took < best) best = took;
+            delete ride;
+        }
+
+        if (best) {
+            count++;
+            bytes += file.size();
+            ns += best;
+        }
+    }
+
+    fprintf(stderr, "fit: %d files, %.1f MB, %d samples\n", count, bytes / 1000000.0, samples);
+    if (ns) fprintf(stderr, "  %-10s %10.1f ms  %.1f MB/s\n", "decode", ns / 1000000.0,
+                    (bytes / 1000000.0) / (ns / 1000000000.0));
+    if (failed) fprintf(stderr, "  ERROR: %d files did not decode\n", failed);
+    fprintf(stderr, "\n");
+}
+
+//
+// JSON - every ride written as .json and read back by the grammar and
+// by JsonRideFileStream, both must give a ride that writes the same
+// bytes, which must read back and write the same again. The number
+// formatting is checked against QString::arg() value by value, as that
+// is what the writer used to do.
+//
+void
+Benchmark::json()
+{
+    JsonFileReader writer;
+    qint64 bytes = 0, writeNs = 0, grammarNs = 0, streamNs = 0, argNs = 0, numberNs = 0;
+    int count = 0, values = 0, failed = 0, differ = 0, formatted = 0;
+
+    QElapsedTimer timer;
+    for (int r=0; r<rides.count(); r++) {
+
+        timer.start();
+        QByteArray json = writer.toByteArray(NULL, rides[r], true, true, true, true);
+        writeNs += timer.nsecsElapsed();
+        bytes += json.size();
+
+        QStringList errors;
+        timer.start();
+        RideFile *grammar = JsonFileReader::parseGrammar(QString::fromUtf8(json), errors);
+        grammarNs += timer.nsecsElapsed();
+
+        timer.start();
+        RideFile *stream = JsonRideFileStream::read(json.constData(), json.size());
+        streamNs += timer.nsecsElapsed();
+
+        if (!grammar || !stream) {
+            if (failed < 10) fprintf(stderr, "  %s did not read back\n", names[r].toUtf8().constData());
+            failed++;
+        } else {
+            count++;
+
+            // the same ride as the grammar read, and once through reading
+            // (which drops bad samples) it must round trip exactly
+            QByteArray again = writer.toByteArray(NULL, stream, true, true, true, true);
+            RideFile *twice = JsonRideFileStream::read(again.constData(), again.size());
+            bool same = again == writer.toByteArray(NULL, grammar, true, true, true, true) &&
+                        twice && again == writer.toByteArray(NULL, twice, true, true, true, true);
+            delete twice;
+            if (!same) {
+                if (differ < 10) fprintf(stderr, "  %s differs after reading back\n", names[r].toUtf8().constData());
+                differ++;
+            }
+        }
+        delete grammar;
+        delete stream;
+
+        // formatting, the way the writer does it for every sample value
+        QVector<double> numbers;
+        foreach(const RideFilePoint *p, rides[r]->dataPoints())
+            numbers << p->secs << p->km << p->watts << p->cad << p->kph << p->hr << p->alt << p->slope;
+        values += numbers.count();
+
+        QByteArray before, after;
+        timer.start();
+        foreach(double v, numbers) before += QString("%1").arg(v);
+        argNs += timer.nsecsElapsed();
+
+        timer.start();
+        foreach(double v, numbers) JsonRideFileStream::number(after, v);
+        numberNs += timer.nsecsElapsed();
+
+        foreach(const RideFilePoint *p, rides[r]->dataPoints()) {
+            QByteArray text;
+            JsonRideFileStream::number(text, p->lat, 'g', 11);
+            if (text != QString("%1").arg(p->lat, 0, 'g', 11).toLatin1()) formatted++;
+        }
+        if (before != after) formatted++;
+    }
+
+    fprintf(stderr, "json: %d rides, %.1f MB, %d values\n", count, bytes / 1000000.0, values);
+    if (writeNs) fprintf(stderr, "  %-10s %10.1f ms  %.1f MB/s\n", "write", writeNs / 1000000.0,
+                         (bytes / 1000000.0) / (writeNs / 1000000000.0));
+    if (grammarNs) fprintf(stderr, "  %-10s %10.1f ms  %.1f MB/s\n", "grammar", grammarNs / 1000000.0,
+                           (bytes / 1000000.0) / (grammarNs / 1000000000.0));
+    if (streamNs) fprintf(stderr, "  %-10s %10.1f ms  %.1f MB/s  %.1fx\n", "stream", streamNs / 1000000.0,
+                          (bytes / 1000000.0) / (streamNs / 1000000000.0), double(grammarNs) / double(streamNs));
+    fprintf(stderr, "  %-10s %10.1f ms\n", "arg", argNs / 1000000.0);
+    fprintf(stderr, "  %-10s %10.1f ms  %.1fx\n", "number", numberNs / 1000000.0,
+            numberNs ? double(argNs) / double(numberNs) : 0);
+    if (failed) fprintf(stderr, "  ERROR: %d rides did not read back\n", failed);
+    if (differ) fprintf(stderr, "  ERROR: %d rides differ after reading back\n", differ);
+    if (formatted) fprintf(stderr, "  ERROR: %d numbers formatted differently\n", formatted);
+    fprintf(stderr, "\n");
+}
+
+//
+// Ride cache - importing 10,000 synthetic rides in a random order, the
+// way it used to be done (look for the name, append and sort the lot for
+// every ride) against the date ordered inserts and the batch merge that
+// RideCache does now, then looking up every ride by name. All three
+// must leave the rides in the same order.
+//
+static bool
+rideCacheLessThan(const RideItem *a, const RideItem *b)
+{
+    return a->dateTime < b->dateTime;
+}
+
+void
+Benchmark::rideCache()
+{
+    const int count = 10000;
+
+    // some of them share a start time, as rides do from time to time
+    QList<RideItem*> items;
+    QDateTime start(QDate(2010, 1, 1), QTime(8, 0, 0));
+    qsrand(42);
+    for (int i=0; i<count; i++) {
+        QDateTime dt = start.addSecs(qint64(i / 2) * 86400 / 3);
+        QString name = dt.toString("yyyy_MM_dd_hh_mm_ss") + QString("_%1.json").arg(i);
+        RideItem *item = new RideItem("", name, dt, NULL, false);
+        item->isstale = false;
+        items << item;
+    }
+    for (int i=count-1; i>0; i--) items.swap(i, qrand() % (i+1));
+
+    QElapsedTimer timer;
+
+    // the old way
+    QVector<RideItem*> before;
+    timer.start();
+    foreach(RideItem *item, items) {
+        bool added = false;
+        for (int index=0; index < before.count(); index++) {
+            if (before[index]->fileName == item->fileName) {
+                before[index] = item;
+                added = true;
+                break;
+            }
+        }
+        if (!added) {
+            before << item;
+            qSort(before.begin(), before.end(), rideCacheLessThan);
+        }
+    }
+    qint64 sortNs = timer.nsecsElapsed();
+
+    // one at a time in date order
+    QVector<RideItem*> inserted;
+    QHash<QString, RideItem*> names;
+    timer.start();
+    foreach(RideItem *item, items) {
+        RideItem *there = names.value(item->fileName, NULL);
+        if (there) inserted[RideCache::indexOf(inserted, there)] = item;
+        else inserted.insert(RideCache::position(inserted, item), item);
+        names.insert(item->fileName, item);
+    }
+    qint64 insertNs = timer.nsecsElapsed();
+
+    // all at once
+    QVector<RideItem*> merged;
+    QHash<QString, RideItem*> mergedNames;
+    timer.start();
+    RideCache::merge(merged, mergedNames, items);
+    qint64 mergeNs = timer.nsecsElapsed();
+
+    // the old sort isn't stable so compare dates, not items
+    int differ = 0;
+    for (int i=0; i<count; i++) {
+        if (before[i]->dateTime != inserted[i]->dateTime || inserted[i] != merged[i]) differ++;
+    }
+    if (inserted.count() != count || merged.count() != count) differ++;
+
+    // and finding them again
+    int found = 0, missing = 0;
+    timer.start();
+    foreach(RideItem *item, items) {
+        foreach(RideItem *there, before) {
+            if (there->fileName == item->fileName) {
+                found++;
+                break;
+            }
+        }
+    }
+    qint64 scanNs = timer.nsecsElapsed();
+
+    timer.start();
+    foreach(RideItem *item, items) {
+        if (names.value(item->fileName, NULL) == item) found--;
+        else missing++;
+    }
+    qint64 hashNs = timer.nsecsElapsed();
+
+    fprintf(stderr, "ride cache: %d rides\n", count);
+    fprintf(stderr, "  %-10s %10.1f ms\n", "sort", sortNs / 1000000.0);
+    fprintf(stderr, "  %-10s %10.1f ms  %.1fx\n", "insert", insertNs / 1000000.0,
+            insertNs ? double(sortNs) / double(insertNs) : 0);
+    fprintf(stderr, "  %-10s %10.1f ms  %.1fx\n", "merge", mergeNs / 1000000.0,
+            mergeNs ? double(sortNs) / double(mergeNs) : 0);
+    fprintf(stderr, "  %-10s %10.1f ms\n", "scan", scanNs / 1000000.0);
+    fprintf(stderr, "  %-10s %10.1f ms  %.1fx\n", "lookup", hashNs / 1000000.0,
+            hashNs ? double(scanNs) / double(hashNs) : 0);
+    if (differ) fprintf(stderr, "  ERROR: %d rides out of order\n", differ);
+    if (found || missing) fprintf(stderr, "  ERROR: %d rides not found by name\n", missing + qAbs(found));
+    fprintf(stderr, "\n");
+
+    qDeleteAll(items);
+}
+
+//
+// ANT - the messages in antlog.raw written to a pseudo terminal that the
+// ANT reader has open as if it were a USB1 stick. First as fast as they
+// can be written for throughput, then one every 2ms (about what 8 busy
+// channels send) for the time from the write to the message being handled.
+//
+bool
+Benchmark::antReplay()
+{
+#ifdef WIN32
+    return false;
+#else
+    QFile log(QDir(folder).absoluteFilePath("antlog.raw"));
+    if (!log.open(QIODevice::ReadOnly)) return false;
+    QByteArray raw = log.readAll();
+    log.close();
+
+    // RS, 8 bytes of millis then the message, just what was received
+    // and rebuilt as it came off the stick
+    QByteArray frames;
+    QVector<int> sizes;
+    const int record = 1 + 8 + ANT_MAX_MESSAGE_SIZE;
+    for (int i=0; i + record <= raw.size(); i += record) {
+        const unsigned char *m = reinterpret_cast<const unsigned char*>(raw.constData()) + i + 9;
+        int length = m[ANT_OFFSET_LENGTH];
+        if (raw[i] != 'R' || m[0] != ANT_SYNC_BYTE || length == 0 || length > ANT_MAX_MESSAGE_SIZE - 4) continue;
+
+        unsigned char checksum = 0;
+        for (int k=0; k < length + 3; k++) {
+            frames.append(char(m[k]));
+            checksum ^= m[k];
+        }
+        frames.append(char(checksum));
+        sizes << length + 4;
+    }
+    if (sizes.isEmpty()) {
+        fprintf(stderr, "ant: no messages in %s\n\n", log.fileName().toUtf8().constData());
+        return false;
+    }
+
+    // enough of them to time, the log is just played again
+    const int total = qMax(sizes.count(), 50000);
+
+    // the ANT reader opens the slave side by name
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master == -1 || grantpt(master) || unlockpt(master)) {
+        fprintf(stderr, "ant: no pseudo terminal\n\n");
+        if (master != -1) ::close(master);
+        return false;
+    }
+    QString slaveName = ptsname(master);
+
+    // hold it open so it isn't hung up between us and the reader
+    int slave = ::open(slaveName.toLatin1().constData(), O_RDWR | O_NOCTTY);
+    struct termios settings;
+    tcgetattr(slave, &settings);
+    cfmakeraw(&settings);
+    tcsetattr(slave, TCSANOW, &settings);
+
+    QElapsedTimer clock;
+    clock.start();
+    QVector<qint64> handled(total);
+    QAtomicInt received(0);
+
+    ANT ant(NULL, NULL, "");
+    QObject::connect(&ant, &ANT::receivedAntMessage, &ant,
+                     [&](const unsigned char RS, const ANTMessage, const struct timeval) {
+        if (RS != 'R') return;
+        int n = received.fetchAndAddOrdered(1);
+        if (n < total) handled[n] = clock.nsecsElapsed();
+    }, Qt::DirectConnection);
+
+    ant.setDevice(slaveName);
+    ant.start();
+
+    // wait for the reader to get n messages, false if it never does
+    auto waitFor = [&](int n) {
+        QElapsedTimer waiting;
+        waiting.start();
+        while (received.loadAcquire() < n && waiting.elapsed() < 10000) usleep(1000);
+        return received.loadAcquire() >= n;
+    };
+
+    // throughput, all of them in one go
+    QByteArray all;
+    for (int sent=0; sent < total; sent += sizes.count()) {
+        int n = qMin(sizes.count(), total - sent);
+        int bytes = 0;
+        for (int k=0; k<n; k++) bytes += sizes[k];
+        all.append(frames.constData(), bytes);
+    }
+    qint64 start = clock.nsecsElapsed();
+    for (int offset=0; offset < all.size(); ) {
+        int rc = ::write(master, all.constData() + offset, all.size() - offset);
+        if (rc <= 0) break;
+        offset += rc;
+    }
+    bool complete = waitFor(total);
+    qint64 throughputNs = received.loadAcquire() ? handled[qMin(received.loadAcquire(), total) - 1] - start : 0;
+    int lost = total - received.loadAcquire();
+
+    // latency, one at a time paced out
+    const int paced = qMin(1000, total);
+    QVector<qint64> written(paced);
+    received.storeRelease(0);
+    start = clock.nsecsElapsed();
+    int offset = 0;
+    for (int k=0; k<paced; k++) {
+        while (clock.nsecsElapsed() - start < k * 2000000LL) usleep(100);
+
+        int size = sizes[k % sizes.count()];
+        if (k % sizes.count() == 0) offset = 0;
+        written[k] = clock.nsecsElapsed();
+        if (::write(master, frames.constData() + offset, size) != size) break;
+        offset += size;
+    }
+    complete = waitFor(paced) && complete;
+
+    ant.stop();
+    ant.wait();
+    ::close(slave);
+    ::close(master);
+
+    QVector<double> latency;
+    for (int k=0; k < qMin(paced, received.loadAcquire()); k++) latency << (handled[k] - written[k]) / 1000.0;
+    std::sort(latency.begin(), latency.end());
+    auto percentile = [&](double p) { return latency.isEmpty() ? 0 : latency[qMin(latency.count() - 1, int(p * latency.count()))]; };
+
+    fprintf(stderr, "ant: %d messages in the log, %d replayed\n", sizes.count(), total);
+    if (throughputNs > 0) fprintf(stderr, "  %-10s %10.1f ms  %.0f messages/s\n", "bulk", throughputNs / 1000000.0,
+                                  (total - lost) / (throughputNs / 1000000000.0));
+    fprintf(stderr, "  %-10s %10.1f us p50  %.1f us p90  %.1f us p99  %.1f us max\n", "latency",
+            percentile(0.5), percentile(0.9), percentile(0.99), latency.isEmpty() ? 0 : latency.last());
+    if (!complete) fprintf(stderr, "  ERROR: messages were not handled, %d lost in bulk\n", qMax(0, lost));
+    fprintf(stderr, "\n");
+    return true;
+#endif
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_Benchmark_h
+#define _GC_Benchmark_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+class RideFile;
+class RideItem;
+class Context;
+
+// Developer benchmarks, run with --benchmark [folder] and they load
+// the rides in the folder (test/rides by default), print timings to
+// stderr and exit. They are not tests, they are there to check that an
+// optimisation is worth having and gives the same answers as the
+// code it replaced.
+//
+// Metrics and DataFilter need zones and settings so they are only
+// benchmarked when an athlete is given too, --benchmark folder athlete,
+// and run once it is open.
+//
+// If the folder has an antlog.raw (as logged by ANTLogger) the messages
+// in it are replayed to the ANT reader through a pseudo terminal, that
+// doesn't need any rides.
+class Benchmark
+{
+    public:
+
+        // returns the exit code
+        static int run(QString folder, Context *context=NULL);
+
+    private:
+
+        Benchmark(QString folder, Context *context);
+        ~Benchmark();
+
+        bool load();
+        RideItem *openItem(int r);
+
+        // the benchmarks
+        void meanMax();
+        void fit();
+        void json();
+        void rideCache();
+        void metrics();
+        void dataFilter();
+        bool antReplay();
+
+        QString folder;
+        Context *context;
+        QStringList names, files;
+        QList<RideFile*> rides;
+};
+
+#endif // _GC_Benchmark_h
@@ -1563,6 +1563,54 @@ DataFilter::DataFilter(QObject *parent, Context *context, QString formula) : QOb
     // save away the results if it passed semantic validation
     if (DataFiltererrors.count() != 0)
         treeRoot= NULL;
+
+    compileRoot();
+}
+
+DataFilter::~DataFilter()
+{
+    clearPrograms();
+}
+
+QSharedPointer<DataFilterProgram>
+DataFilter::compile(Leaf *expr)
+{
+    if (!expr) return QSharedPointer<DataFilterProgram>();
+
+    QMutexLocker locker(&programsLock);
+    QSharedPointer<DataFilterProgram> compiled = programs.value(expr);
+    if (!compiled) {
+        compiled = QSharedPointer<DataFilterProgram>(new DataFilterProgram);
+        compiled->compile(&rt, expr);
+        programs.insert(expr, compiled);
+    }
+    return compiled;
+}
+
+void
+DataFilter::compileRoot()
+{
+    // evaluate() starts at main when there are functions
+    QSharedPointer<DataFilterProgram> compiled;
+    if (treeRoot && rt.functions.count() == 0) compiled = compile(treeRoot);
+
+    QMutexLocker locker(&programsLock);
+    program = compiled;
+}
+
+QSharedPointer<DataFilterProgram>
+DataFilter::rootProgram()
+{
+    QMutexLocker locker(&programsLock);
+    return program;
+}
+
+void
+DataFilter::clearPrograms()
+{
+    QMutexLocker locker(&programsLock);
+    programs.clear();
+    program.clear();
 }
 
 Result DataFilter::evaluate(RideItem *item, RideFilePoint *p)
@@ -1573,6 +1621,11 @@ Result DataFilter::evaluate(RideItem *item, RideFilePoint *p)
     // reset stack
     rt.stack = 0;
 
+    // compiled is quicker, same answer
+    QSharedPointer<DataFilterProgram> program = rootProgram();
+    if (program && program->usable(&rt, p != NULL))
+        return Result(program->eval(&rt, item, p));
+
     Result res(0);
 
     // if we are a set of functions..
@@ -1591,6 +1644,26 @@ Result DataFilter::evaluate(RideItem *item, RideFilePoint *p)
     return res;
 }
 
+QVector<double>
+DataFilter::evaluateSamples(RideItem *item)
+{
+    QVector<double> returning;
+    if (!item || !item->ride()) return returning;
+
+    // a column at a time if we can
+    QSharedPointer<DataFilterProgram> program = rootProgram();
+    if (treeRoot && !DataFiltererrors.count() && program && program->usable(&rt, true)) {
+        rt.stack = 0;
+        return program->evalSamples(&rt, item);
+    }
+
+    // otherwise a sample at a time
+    returning.reserve(item->ride()->dataPoints().count());
+    foreach(RideFilePoint *p, item->ride()->dataPoints())
+        returning << evaluate(item, p).number;
+    return returning;
+}
+
 QStringList DataFilter::check(QString query)
 {
     // since we may use it afterwards
@@ -1618,6 +1691,7 @@ QStringList DataFilter::check(QString query)
         if (!treeRoot) DataFiltererrors << tr("malformed expression.");
 
     }
+    compileRoot();
 
     errors = DataFiltererrors;
     return errors;
@@ -1663,6 +1737,7 @@ QStringList DataFilter::parseFilter(Context *context, QString query, QStringList
     } else { // yep! .. we have a winner!
 
         rt.isdynamic = treeRoot->isDynamic(treeRoot);
+        compileRoot();
 
         // successfully parsed, lets check semantics
         //treeRoot->print(0,NULL);
@@ -1672,10 +1747,12 @@ QStringList DataFilter::parseFilter(Context *context, QString query, QStringList
         filenames.clear();
 
         // get all fields...
+        QSharedPointer<DataFilterProgram> program = rootProgram();
         foreach(RideItem *item, context->athlete->rideCache->rides()) {
 
             // evaluate each ride...
-            Result result = treeRoot->eval(&rt, treeRoot, 0, item, NULL);
+            Result result = (program && program->usable(&rt, false)) ? Result(program->eval(&rt, item))
+                                                                      : treeRoot->eval(&rt, treeRoot, 0, item, NULL);
             if (result.isNumber && result.number) {
                 filenames << item->fileName;
             }
@@ -1698,10 +1775,12 @@ DataFilter::dynamicParse()
         filenames.clear();
 
         // get all fields...
+        QSharedPointer<DataFilterProgram> program = rootProgram();
         foreach(RideItem *item, context->athlete->rideCache->rides()) {
 
             // evaluate each ride...
-            Result result = treeRoot->eval(&rt, treeRoot, 0, item, NULL);
+            Result result = (program && program->usable(&rt, false)) ? Result(program->eval(&rt, item))
+                                                                      : treeRoot->eval(&rt, treeRoot, 0, item, NULL);
             if (result.isNumber && result.number)
                 filenames << item->fileName;
         }
@@ -1712,6 +1791,7 @@ DataFilter::dynamicParse()
 
 void DataFilter::clearFilter()
 {
+    clearPrograms();
     if (treeRoot) {
         treeRoot->clear(treeRoot);
         treeRoot = NULL;
@@ -1752,6 +1832,24 @@ void DataFilter::configChanged(qint32)
 
     // sample date series
     rt.dataSeriesSymbols = RideFile::symbols();
+
+    // symbols are resolved when compiled, so do them again. they may
+    // be running elsewhere so compile new ones and swap them in
+    QList<Leaf*> exprs;
+    programsLock.lock();
+    exprs = programs.keys();
+    programsLock.unlock();
+
+    QHash<Leaf*, QSharedPointer<DataFilterProgram> > recompiled;
+    foreach(Leaf *expr, exprs) {
+        QSharedPointer<DataFilterProgram> compiled(new DataFilterProgram);
+        compiled->compile(&rt, expr);
+        recompiled.insert(expr, compiled);
+    }
+
+    QMutexLocker locker(&programsLock);
+    programs = recompiled;
+    if (program) program = programs.value(treeRoot);
 }
 
 Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, RideFilePoint *p, const QHash<QString,RideMetric*> *c, Specification s)
@@ -1980,6 +2078,7 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, RideF
                     if (df->lookupType.value(*(leaf->lvalue.l->lvalue.n)) == true) {
                         // numeric
                         if (c) duration = RideMetric::getForSymbol(rename=df->lookupMap.value(*(leaf->lvalue.l->lvalue.n),""), c);
+                        else if (s.interval()) duration = s.interval()->getForSymbol(rename=df->lookupMap.value(*(leaf->lvalue.l->lvalue.n),""));
                         else duration = m->getForSymbol(rename=df->lookupMap.value(*(leaf->lvalue.l->lvalue.n),""));
                     } else if (*(leaf->lvalue.l->lvalue.n) == "x") {
                         duration = x;
@@ -2697,6 +2796,7 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, RideF
             QString meta = m->getText(rename=df->lookupMap.value(symbol,""), "unknown");
             if (meta == "unknown")
                 if (c) lhsdouble = RideMetric::getForSymbol(rename=df->lookupMap.value(symbol,""), c);
+                else if (s.interval()) lhsdouble = s.interval()->getForSymbol(rename=df->lookupMap.value(symbol,""));
                 else lhsdouble = m->getForSymbol(rename=df->lookupMap.value(symbol,""));
             else
                 lhsdouble = meta.toDouble();
@@ -27,8 +27,11 @@
 #include <QHash>
 #include <QStringList>
 #include <QTextDocument>
+#include <QMutex>
+#include <QSharedPointer>
 #include "RideCache.h"
 #include "RideFile.h" //for SeriesType
+#include "DataFilterProgram.h"
 
 class Context;
 class RideItem;
@@ -154,6 +157,7 @@ class DataFilter : public QObject
     public:
         DataFilter(QObject *parent, Context *context);
         DataFilter(QObject *parent, Context *context, QString formula);
+        ~DataFilter();
 
         // runtime passed by datafilter
         DataFilterRuntime rt;
@@ -168,6 +172,17 @@ class DataFilter : public QObject
 
         // RideItem always available and supplies th context
         Result evaluate(RideItem *rideItem, RideFilePoint *p);
+
+        // evaluate(rideItem, p) for every sample in the ride, it
+        // uses the compiled program a block of samples at a time
+        QVector<double> evaluateSamples(RideItem *rideItem);
+
+        // compile an expression in the tree (e.g. a user metric
+        // function) into a program, see DataFilterProgram. A config
+        // change swaps in a new one so ask for it each time and hold
+        // on to it while it runs, check it is usable() before each
+        // evaluation
+        QSharedPointer<DataFilterProgram> compile(Leaf *expr);
         QStringList getErrors() { return errors; };
         void colorSyntax(QTextDocument *content, int pos);
 
@@ -197,6 +212,16 @@ class DataFilter : public QObject
         Leaf *treeRoot;
         QStringList errors;
 
+        // compiled expressions, they go when the tree does. they may be
+        // running on other threads (user metrics) so are only swapped
+        // under the lock and an old one goes when the last user is done
+        QMutex programsLock;
+        QHash<Leaf*, QSharedPointer<DataFilterProgram> > programs;
+        QSharedPointer<DataFilterProgram> program; // treeRoot, null if there are functions
+        QSharedPointer<DataFilterProgram> rootProgram();
+        void compileRoot();
+        void clearPrograms();
+
         QStringList filenames;
         QStringList *list;
         QString sig;
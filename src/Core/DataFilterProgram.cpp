@@ -0,0 +1,525 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "DataFilterProgram.h"
+#include "DataFilter.h"
+#include "RideItem.h"
+#include "IntervalItem.h"
+#include "RideMetric.h"
+
+#include <QDate>
+#include <QVarLengthArray>
+#include <cmath>
+
+#include "DataFilter_yacc.h"
+
+// samples per block when evaluating a whole ride
+static const int BLOCK = 256;
+
+//
+// The math.h functions, in the same order as DataFilterFunctions[]
+// since that is what Leaf::eval switches on
+//
+static double fnCos(double v) { return cos(v); }
+static double fnTan(double v) { return tan(v); }
+static double fnSin(double v) { return sin(v); }
+static double fnAcos(double v) { return acos(v); }
+static double fnAtan(double v) { return atan(v); }
+static double fnAsin(double v) { return asin(v); }
+static double fnCosh(double v) { return cosh(v); }
+static double fnTanh(double v) { return tanh(v); }
+static double fnSinh(double v) { return sinh(v); }
+static double fnAcosh(double v) { return acosh(v); }
+static double fnAtanh(double v) { return atanh(v); }
+static double fnAsinh(double v) { return asinh(v); }
+static double fnExp(double v) { return exp(v); }
+static double fnLog(double v) { return log(v); }
+static double fnLog10(double v) { return log10(v); }
+static double fnCeil(double v) { return ceil(v); }
+static double fnFloor(double v) { return floor(v); }
+static double fnRound(double v) { return round(v); }
+static double fnFabs(double v) { return fabs(v); }
+static double fnIsinf(double v) { return std::isinf(v); }
+static double fnIsnan(double v) { return std::isnan(v); }
+
+static struct {
+    const char *name;
+    double (*fn)(double);
+} mathFunctions[] = {
+    { "cos", fnCos }, { "tan", fnTan }, { "sin", fnSin },
+    { "acos", fnAcos }, { "atan", fnAtan }, { "asin", fnAsin },
+    { "cosh", fnCosh }, { "tanh", fnTanh }, { "sinh", fnSinh },
+    { "acosh", fnAcosh }, { "atanh", fnAtanh }, { "asinh", fnAsinh },
+    { "exp", fnExp }, { "log", fnLog }, { "log10", fnLog10 },
+    { "ceil", fnCeil }, { "floor", fnFloor }, { "round", fnRound },
+    { "fabs", fnFabs }, { "isinf", fnIsinf }, { "isnan", fnIsnan },
+    { NULL, NULL }
+};
+
+static int
+mathFunction(QString name)
+{
+    for (int i=0; mathFunctions[i].name; i++)
+        if (name == mathFunctions[i].name) return i;
+    return -1;
+}
+
+//
+// Operators - the same rules as Leaf::eval for numbers, they are shared
+// by the single and block paths so the two can't drift apart
+//
+struct OpNeg { double operator()(double v) const { return v * -1; } };
+struct OpNot { double operator()(double v) const { return !v; } };
+
+struct OpAdd { double operator()(double l, double r) const { return l + r; } };
+struct OpSub { double operator()(double l, double r) const { return l - r; } };
+struct OpMul { double operator()(double l, double r) const { return l * r; } };
+struct OpDiv { double operator()(double l, double r) const { return r ? l / r : 0; } };
+struct OpPow { double operator()(double l, double r) const { return r ? pow(l, r) : 0; } };
+struct OpEq { double operator()(double l, double r) const { return l == r; } };
+struct OpNeq { double operator()(double l, double r) const { return l != r; } };
+struct OpLt { double operator()(double l, double r) const { return l < r; } };
+struct OpLte { double operator()(double l, double r) const { return l <= r; } };
+struct OpGt { double operator()(double l, double r) const { return l > r; } };
+struct OpGte { double operator()(double l, double r) const { return l >= r; } };
+struct OpAnd { double operator()(double l, double r) const { return (l && r) ? 1 : 0; } };
+struct OpOr { double operator()(double l, double r) const { return (l || r) ? 1 : 0; } };
+struct OpElvis { double operator()(double l, double r) const { return l ? l : r; } };
+
+template <typename F>
+static inline void
+apply(double *a, int n, F f)
+{
+    for (int i=0; i<n; i++) a[i] = f(a[i]);
+}
+
+template <typename F>
+static inline void
+apply(double *a, const double *b, int n, F f)
+{
+    for (int i=0; i<n; i++) a[i] = f(a[i], b[i]);
+}
+
+static inline void
+fill(double *a, int n, double value)
+{
+    for (int i=0; i<n; i++) a[i] = value;
+}
+
+//
+// Compile
+//
+void
+DataFilterProgram::clear()
+{
+    code.clear();
+    series.clear();
+    metrics.clear();
+    items.clear();
+    samples = valid = false;
+    depth = stack = 0;
+}
+
+bool
+DataFilterProgram::compile(DataFilterRuntime *df, Leaf *expr)
+{
+    clear();
+    if (expr && lower(df, expr)) valid = true;
+    else clear();
+    return valid;
+}
+
+void
+DataFilterProgram::append(OpCode op, int arg, double value, int pops)
+{
+    Instruction instruction;
+    instruction.op = op;
+    instruction.arg = arg;
+    instruction.value = value;
+    code << instruction;
+
+    // everything leaves one value on the stack
+    stack += 1 - pops;
+    if (stack > depth) depth = stack;
+}
+
+bool
+DataFilterProgram::lower(DataFilterRuntime *df, Leaf *leaf)
+{
+    if (!leaf) return false;
+
+    switch(leaf->type) {
+
+    case Leaf::Float :
+        append(Const, 0, leaf->lvalue.f);
+        return true;
+
+    case Leaf::Integer :
+        append(Const, 0, leaf->lvalue.i);
+        return true;
+
+    case Leaf::String :
+    {
+        // only dates, they are days since 1900
+        QDate date = QDate::fromString(*(leaf->lvalue.s), "yyyy/MM/dd");
+        if (!date.isValid()) return false;
+        append(Const, 0, QDate(1900,01,01).daysTo(date));
+        return true;
+    }
+
+    case Leaf::Symbol :
+    {
+        QString symbol = *(leaf->lvalue.n);
+
+        // sample series come first when there is a point
+        if (df->dataSeriesSymbols.contains(symbol)) {
+
+            samples = true;
+            RideFile::SeriesType type = RideFile::seriesForSymbol(symbol);
+            if (type == RideFile::index) {
+                append(Sample);
+            } else {
+                if (!series.contains(type)) series << type;
+                append(Series, series.indexOf(type));
+            }
+            return true;
+        }
+
+        if (symbol == "x") {
+            append(X);
+            return true;
+        }
+
+        // Device is a string
+        if (!symbol.compare("Device", Qt::CaseInsensitive)) return false;
+
+        // the rest of the builtins only change from ride to ride
+        // so leave them to Leaf::eval, once per ride
+        if (symbol == "isRun" || symbol == "isSwim" ||
+            !symbol.compare("NA", Qt::CaseInsensitive) ||
+            !symbol.compare("RECINTSECS", Qt::CaseInsensitive) ||
+            !symbol.compare("Current", Qt::CaseInsensitive) ||
+            !symbol.compare("Today", Qt::CaseInsensitive) ||
+            !symbol.compare("Date", Qt::CaseInsensitive) ||
+            !symbol.compare("ctl", Qt::CaseInsensitive) ||
+            !symbol.compare("atl", Qt::CaseInsensitive) ||
+            !symbol.compare("tsb", Qt::CaseInsensitive)) {
+
+            items << leaf;
+            append(Item, items.count()-1);
+            return true;
+        }
+
+        // numeric metrics and metadata, strings can't be compiled
+        if (!df->lookupType.value(symbol, false)) return false;
+
+        QString name = df->lookupMap.value(symbol, "");
+        for (int i=0; i<metrics.count(); i++) {
+            if (metrics[i].symbol == name) {
+                append(Metric, i);
+                return true;
+            }
+        }
+
+        MetricSlot slot;
+        slot.symbol = name;
+        const RideMetric *metric = RideMetricFactory::instance().rideMetric(name);
+        slot.index = metric ? metric->index() : -1;
+        metrics << slot;
+        append(Metric, metrics.count()-1);
+        return true;
+    }
+
+    case Leaf::Logical :
+    {
+        switch (leaf->op) {
+        case AND :
+        case OR :
+            if (!lower(df, leaf->lvalue.l) || !lower(df, leaf->rvalue.l)) return false;
+            append(leaf->op == AND ? And : Or, 0, 0, 2);
+            return true;
+
+        default : // parenthesis
+            return lower(df, leaf->lvalue.l);
+        }
+    }
+
+    case Leaf::Function :
+    {
+        // just math.h, user functions take precedence
+        if (df->functions.contains(leaf->function) || leaf->fparms.count() != 1) return false;
+
+        int fn = mathFunction(leaf->function);
+        if (fn < 0 || !lower(df, leaf->fparms[0])) return false;
+        append(Function, fn, 0, 1);
+        return true;
+    }
+
+    case Leaf::UnaryOperation :
+    {
+        if (leaf->op != '-' && leaf->op != '!') return false;
+        if (!lower(df, leaf->lvalue.l)) return false;
+        append(leaf->op == '-' ? Neg : Not, 0, 0, 1);
+        return true;
+    }
+
+    case Leaf::BinaryOperation :
+    case Leaf::Operation :
+    {
+        OpCode op;
+        switch (leaf->op) {
+        case ADD : op = Add; break;
+        case SUBTRACT : op = Sub; break;
+        case MULTIPLY : op = Mul; break;
+        case DIVIDE : op = Div; break;
+        case POW : op = Pow; break;
+        case EQ : op = Eq; break;
+        case NEQ : op = Neq; break;
+        case LT : op = Lt; break;
+        case LTE : op = Lte; break;
+        case GT : op = Gt; break;
+        case GTE : op = Gte; break;
+        case ELVIS : op = Elvis; break;
+        default : return false; // assignment and the string operators
+        }
+        if (!lower(df, leaf->lvalue.l) || !lower(df, leaf->rvalue.l)) return false;
+        append(op, 0, 0, 2);
+        return true;
+    }
+
+    case Leaf::Conditional :
+    {
+        // no while loops
+        if (leaf->op != IF_ && leaf->op != 0) return false;
+
+        // both sides are evaluated, they have no side effects
+        if (!lower(df, leaf->cond.l) || !lower(df, leaf->lvalue.l)) return false;
+        if (leaf->rvalue.l) {
+            if (!lower(df, leaf->rvalue.l)) return false;
+        } else {
+            append(Const, 0, 0);
+        }
+        append(Select, 0, 0, 3);
+        return true;
+    }
+
+    case Leaf::Compound :
+    {
+        // value of the last statement, the others must compile
+        // (so they have no side effects) but are dropped
+        QList<Leaf*> &statements = *(leaf->lvalue.b);
+        if (statements.isEmpty()) {
+            append(Const, 0, 0);
+            return true;
+        }
+        for (int i=0; i<statements.count(); i++) {
+            int mark = code.count(), was = stack;
+            if (!lower(df, statements[i])) return false;
+            if (i < statements.count()-1) {
+                code.resize(mark);
+                stack = was;
+            }
+        }
+        return true;
+    }
+
+    default : // vectors, indexes, scripts
+        return false;
+    }
+}
+
+//
+// Evaluate
+//
+bool
+DataFilterProgram::usable(DataFilterRuntime *df, bool point) const
+{
+    return valid && df->symbols.isEmpty() && (point || !samples);
+}
+
+void
+DataFilterProgram::rideValues(DataFilterRuntime *df, RideItem *m, const QHash<QString,RideMetric*> *c, float x,
+                              Specification spec, double *metricValues, double *itemValues) const
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+    bool computed = m->metrics().count() == factory.metricCount();
+
+    // an interval has its own values, computeMetrics() keeps them
+    // up to date for user metrics as it goes. Leaf::eval reads them
+    // the same way, never falling back to the ride's
+    IntervalItem *interval = spec.interval();
+    bool intervalComputed = interval && interval->metrics().count() == factory.metricCount();
+
+    for (int i=0; i<metrics.count(); i++) {
+
+        const MetricSlot &slot = metrics[i];
+
+        // metadata string to number first, as Leaf::eval does
+        QString meta = m->getText(slot.symbol, "unknown");
+        if (meta != "unknown") metricValues[i] = meta.toDouble();
+        else if (c) metricValues[i] = RideMetric::getForSymbol(slot.symbol, c);
+        else if (interval) metricValues[i] = (intervalComputed && slot.index >= 0) ? interval->metrics()[slot.index] : 0;
+        else if (computed && slot.index >= 0) metricValues[i] = m->metrics()[slot.index];
+        else metricValues[i] = 0;
+    }
+
+    for (int i=0; i<items.count(); i++) {
+        Leaf *leaf = items[i];
+        itemValues[i] = leaf->eval(df, leaf, x, m, NULL, c, spec).number;
+    }
+}
+
+void
+DataFilterProgram::run(double *registers, int stride, int n, int first, const double * const *columns,
+                       const double *metricValues, const double *itemValues, float x) const
+{
+    // next free register
+    double *top = registers;
+
+    for (int i=0; i<code.count(); i++) {
+
+        const Instruction &in = code[i];
+
+        // top of the stack and the one below, if there are any
+        int sp = (top - registers) / stride;
+        double *a = sp > 0 ? top - stride : top;
+        double *b = sp > 1 ? a - stride : a;
+
+        switch (in.op) {
+
+        // loads
+        case Const : fill(top, n, in.value); top += stride; break;
+        case X : fill(top, n, x); top += stride; break;
+        case Metric : fill(top, n, metricValues[in.arg]); top += stride; break;
+        case Item : fill(top, n, itemValues[in.arg]); top += stride; break;
+        case Series :
+            {
+                const double *column = columns[in.arg];
+                for (int j=0; j<n; j++) top[j] = column[j];
+                top += stride;
+            }
+            break;
+        case Sample :
+            for (int j=0; j<n; j++) top[j] = first + j;
+            top += stride;
+            break;
+
+        // unary
+        case Neg : apply(a, n, OpNeg()); break;
+        case Not : apply(a, n, OpNot()); break;
+        case Function :
+            {
+                double (*fn)(double) = mathFunctions[in.arg].fn;
+                for (int j=0; j<n; j++) a[j] = fn(a[j]);
+            }
+            break;
+
+        // binary, result replaces the lhs
+        case Add : apply(b, a, n, OpAdd()); top = a; break;
+        case Sub : apply(b, a, n, OpSub()); top = a; break;
+        case Mul : apply(b, a, n, OpMul()); top = a; break;
+        case Div : apply(b, a, n, OpDiv()); top = a; break;
+        case Pow : apply(b, a, n, OpPow()); top = a; break;
+        case Eq : apply(b, a, n, OpEq()); top = a; break;
+        case Neq : apply(b, a, n, OpNeq()); top = a; break;
+        case Lt : apply(b, a, n, OpLt()); top = a; break;
+        case Lte : apply(b, a, n, OpLte()); top = a; break;
+        case Gt : apply(b, a, n, OpGt()); top = a; break;
+        case Gte : apply(b, a, n, OpGte()); top = a; break;
+        case And : apply(b, a, n, OpAnd()); top = a; break;
+        case Or : apply(b, a, n, OpOr()); top = a; break;
+        case Elvis : apply(b, a, n, OpElvis()); top = a; break;
+
+        // cond, then, else
+        case Select :
+            {
+                double *cond = sp > 2 ? b - stride : b;
+                for (int j=0; j<n; j++) cond[j] = cond[j] ? b[j] : a[j];
+                top = b;
+            }
+            break;
+        }
+    }
+}
+
+double
+DataFilterProgram::eval(DataFilterRuntime *df, RideItem *m, RideFilePoint *p,
+                        const QHash<QString,RideMetric*> *c, float x, Specification spec) const
+{
+    if (!valid || !m) return 0;
+
+    QVarLengthArray<double, 16> metricValues(metrics.count()), itemValues(items.count());
+    rideValues(df, m, c, x, spec, metricValues.data(), itemValues.data());
+
+    // the sample as columns of one
+    QVarLengthArray<double, 16> values(series.count());
+    QVarLengthArray<const double*, 16> columns(series.count());
+    for (int i=0; i<series.count(); i++) {
+        values[i] = p ? p->value(series[i]) : 0;
+        columns[i] = &values[i];
+    }
+    int first = 0;
+    if (p && samples && m->ride()) first = m->ride()->dataPoints().indexOf(p);
+
+    QVarLengthArray<double, 32> registers(depth);
+    run(registers.data(), 1, 1, first, columns.data(), metricValues.data(), itemValues.data(), x);
+    return registers[0];
+}
+
+QVector<double>
+DataFilterProgram::evalSamples(DataFilterRuntime *df, RideItem *m, float x) const
+{
+    QVector<double> returning;
+
+    RideFile *ride = m ? m->ride() : NULL;
+    if (!valid || !ride || ride->dataPoints().isEmpty()) return returning;
+
+    int count = ride->dataPoints().count();
+    returning.resize(count);
+
+    QVarLengthArray<double, 16> metricValues(metrics.count()), itemValues(items.count());
+    rideValues(df, m, NULL, x, Specification(), metricValues.data(), itemValues.data());
+
+    // series that aren't present have no column, but the points
+    // may still have values, so take a copy of those
+    QVector<const double*> columns(series.count());
+    QVector<RideFileColumn> held(series.count()); // so they're ours till we're done
+    QVector<QVector<double> > copies(series.count());
+    for (int i=0; i<series.count(); i++) {
+        held[i] = ride->column(series[i]);
+        columns[i] = held[i];
+        if (columns[i] == NULL) {
+            copies[i].resize(count);
+            for (int j=0; j<count; j++) copies[i][j] = ride->dataPoints()[j]->value(series[i]);
+            columns[i] = copies[i].constData();
+        }
+    }
+
+    // a block at a time
+    QVector<double> registers(depth * BLOCK);
+    QVector<const double*> offset(series.count());
+    for (int start=0; start < count; start += BLOCK) {
+
+        int n = qMin(BLOCK, count - start);
+        for (int i=0; i<series.count(); i++) offset[i] = columns[i] + start;
+
+        run(registers.data(), BLOCK, n, start, offset.constData(), metricValues.data(), itemValues.data(), x);
+        for (int j=0; j<n; j++) returning[start+j] = registers[j];
+    }
+    return returning;
+}
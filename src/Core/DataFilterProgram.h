@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_DataFilterProgram_h
+#define _GC_DataFilterProgram_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QVector>
+#include "RideFile.h" // for SeriesType
+#include "Specification.h"
+
+class Leaf;
+class RideItem;
+class RideMetric;
+class DataFilterRuntime;
+
+// DataFilterProgram is a Leaf tree lowered into bytecode for a small
+// stack machine. Symbols are resolved when it is compiled; sample series
+// to a SeriesType, metrics to their index and the item symbols (isRun,
+// Date, ctl etc) to a slot that is evaluated once per ride, so there are
+// no string lookups left when it runs.
+//
+// Only pure numeric expressions are compiled, anything with assignment,
+// strings, vectors, user functions, scripts or the data functions (best,
+// estimate etc) fails to compile and the caller carries on with
+// Leaf::eval, which stays the reference implementation.
+//
+// Sample expressions can also be evaluated for the whole ride at once,
+// each instruction is applied to a block of samples read from the ride
+// columns so the inner loops are simple enough for the compiler to
+// vectorise.
+//
+class DataFilterProgram
+{
+    public:
+
+        DataFilterProgram() : samples(false), valid(false), depth(0), stack(0) {}
+
+        // lower the expression, false if it can't be compiled
+        bool compile(DataFilterRuntime *df, Leaf *expr);
+        void clear();
+
+        bool isValid() const { return valid; }
+
+        // it reads sample series so needs a point (or use evalSamples)
+        bool usesSamples() const { return samples; }
+
+        // can it stand in for Leaf::eval right now? user symbols that
+        // have been assigned override everything so they rule it out,
+        // point is true if there is a sample to read
+        bool usable(DataFilterRuntime *df, bool point) const;
+
+        // the same answer as Leaf::eval(df, expr, x, m, p, c, spec).number,
+        // for an interval its metrics are used when there is no c
+        double eval(DataFilterRuntime *df, RideItem *m, RideFilePoint *p=NULL,
+                    const QHash<QString,RideMetric*> *c=NULL, float x=0,
+                    Specification spec=Specification()) const;
+
+        // the same as eval() for every sample in the ride
+        QVector<double> evalSamples(DataFilterRuntime *df, RideItem *m, float x=0) const;
+
+    private:
+
+        // mixed case, the parser tokens (ADD, LT etc) are macros
+        enum OpCode { Const, X, Series, Sample, Metric, Item,
+                      Neg, Not, Function,
+                      Add, Sub, Mul, Div, Pow,
+                      Eq, Neq, Lt, Lte, Gt, Gte,
+                      And, Or, Elvis, Select };
+
+        struct Instruction {
+            OpCode op;
+            int arg;        // slot, series or function
+            double value;   // constants
+        };
+
+        struct MetricSlot {
+            QString symbol; // internal name, metric or metadata
+            int index;      // into RideItem::metrics(), -1 for metadata
+        };
+
+        bool lower(DataFilterRuntime *df, Leaf *leaf);
+        void append(OpCode op, int arg=0, double value=0, int pops=0);
+
+        // values that are the same for every sample in the ride
+        void rideValues(DataFilterRuntime *df, RideItem *m, const QHash<QString,RideMetric*> *c, float x,
+                        Specification spec, double *metricValues, double *itemValues) const;
+
+        // run the code for n samples starting at sample first, with the
+        // columns already offset to it. each register holds stride values
+        // and the answers are left in the first one
+        void run(double *registers, int stride, int n, int first, const double * const *columns,
+                 const double *metricValues, const double *itemValues, float x) const;
+
+        QVector<Instruction> code;
+        QList<RideFile::SeriesType> series;
+        QList<MetricSlot> metrics;
+        QList<Leaf*> items;
+        bool samples, valid;
+        int depth, stack; // max and current during compile
+};
+
+#endif // _GC_DataFilterProgram_h
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "OpenRideCache.h"
+#include "Context.h"
+#include "RideCache.h"
+#include "RideItem.h"
+#include "RideFile.h"
+#include "Settings.h"
+
+#include <QApplication>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+
+OpenRideCache::OpenRideCache(Context *context, RideCache *rideCache) :
+    QObject(rideCache), context(context), rideCache(rideCache),
+    size_(0), misses_(0), evictions_(0), scheduled(false), clock_(0), hits_(0)
+{
+}
+
+static bool
+guiThread()
+{
+    return qApp && QThread::currentThread() == qApp->thread();
+}
+
+void
+OpenRideCache::opened(RideItem *item)
+{
+    QMutexLocker locker(&lock);
+    misses_++;
+
+    // the worker threads close what they open
+    if (!guiThread() || sizes_.contains(item)) return;
+
+    qint64 size = estimate(item->ride(false));
+    item->lastUsed_.store(++clock_);
+    sizes_.insert(item, size);
+    size_ += size;
+
+    // close some once the caller is done with them
+    if (size_ > budget() && !scheduled) {
+        scheduled = true;
+        QTimer::singleShot(0, this, SLOT(evict()));
+    }
+}
+
+void
+OpenRideCache::used(RideItem *item)
+{
+    // no lock, it is called all the time
+    hits_++;
+    item->lastUsed_.store(++clock_);
+}
+
+void
+OpenRideCache::closed(RideItem *item)
+{
+    QMutexLocker locker(&lock);
+
+    QHash<RideItem*, qint64>::iterator it = sizes_.find(item);
+    if (it == sizes_.end()) return;
+
+    size_ -= it.value();
+    sizes_.erase(it);
+}
+
+static bool
+leastRecentlyUsed(const RideItem *a, const RideItem *b)
+{
+    return a->lastUsed() < b->lastUsed();
+}
+
+void
+OpenRideCache::evict()
+{
+    scheduled = false;
+
+    // refresh workers may be using rides we opened, try again later
+    if (rideCache->isRunning()) {
+        scheduled = true;
+        QTimer::singleShot(1000, this, SLOT(evict()));
+        return;
+    }
+
+    // pick them first, close() calls closed() which needs the lock
+    QList<RideItem*> victims;
+    lock.lock();
+    qint64 limit = budget();
+    qint64 size = size_;
+    if (size > limit) {
+        QList<RideItem*> open = sizes_.keys();
+        std::sort(open.begin(), open.end(), leastRecentlyUsed);
+
+        foreach(RideItem *item, open) {
+            if (size <= limit) break;
+            if (item == context->ride || item->isDirty() || item->isPinned()) continue;
+
+            victims << item;
+            size -= sizes_.value(item);
+        }
+    }
+    lock.unlock();
+
+    foreach(RideItem *item, victims) {
+        item->close();
+        lock.lock();
+        evictions_++;
+        lock.unlock();
+    }
+}
+
+qint64
+OpenRideCache::estimate(RideFile *ride)
+{
+    if (!ride) return 0;
+
+    // each sample is allocated on its own, 16 bytes is about what
+    // the allocator adds to each block
+    qint64 bytes = sizeof(RideFile);
+    bytes += ride->dataPoints().count() * qint64(sizeof(RideFilePoint) + sizeof(RideFilePoint*) + 16);
+
+    foreach(XDataSeries *series, ride->xdata()) {
+        foreach(XDataPoint *p, series->datapoints) {
+            bytes += sizeof(XDataPoint) + sizeof(XDataPoint*) + 16;
+            bytes += p->number.count() * sizeof(double);
+            bytes += p->string.count() * sizeof(QString);
+        }
+    }
+    return bytes;
+}
+
+int
+OpenRideCache::count()
+{
+    QMutexLocker locker(&lock);
+    return sizes_.count();
+}
+
+qint64
+OpenRideCache::size()
+{
+    QMutexLocker locker(&lock);
+    return size_;
+}
+
+qint64
+OpenRideCache::budget()
+{
+    return appsettings->value(NULL, GC_OPENRIDES_BUDGET, 512).toLongLong() * 1024 * 1024;
+}
+
+quint64
+OpenRideCache::hits()
+{
+    return hits_.load();
+}
+
+quint64
+OpenRideCache::misses()
+{
+    QMutexLocker locker(&lock);
+    return misses_;
+}
+
+quint64
+OpenRideCache::evictions()
+{
+    QMutexLocker locker(&lock);
+    return evictions_;
+}
+
+QString
+OpenRideCache::stats()
+{
+    QMutexLocker locker(&lock);
+    return QString(tr("%1 activities open using %2 of %3 MB, %4 hits, %5 misses, %6 closed to fit"))
+           .arg(sizes_.count())
+           .arg(size_ / (1024.0 * 1024.0), 0, 'f', 1)
+           .arg(budget() / (1024 * 1024))
+           .arg(hits_.load())
+           .arg(misses_)
+           .arg(evictions_);
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_OpenRideCache_h
+#define _GC_OpenRideCache_h 1
+#include "GoldenCheetah.h"
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QString>
+
+class Context;
+class RideCache;
+class RideItem;
+class RideFile;
+
+// OpenRideCache keeps track of the rides an athlete has open, that is
+// the RideItems with a RideFile loaded, and how much memory they take.
+// RideItem::ride() tells it when a ride is opened (a miss, it was read
+// from disk) or used when it was already open (a hit), and close()
+// when it is closed.
+//
+// When the rides open go over the budget (GC_OPENRIDES_BUDGET in MB) the
+// ones used least recently are closed until they fit. Never the selected
+// ride, one with unsaved changes or one that is pinned; charts pin the
+// ride they show and compare the rides it copies from. Others hold on
+// to the RideFile only while they work with it, so rides are only closed
+// once control is back in the event loop and never while the background
+// refresh is running, it is tried again every second until it is done.
+//
+// used() is on the hot path, every RideItem::ride(), so it just stamps
+// the item from an atomic clock and evict() sorts by the stamps.
+//
+// Rides opened by worker threads (e.g. the metric refresh) are counted
+// but not kept, they close them when they are done.
+class OpenRideCache : public QObject
+{
+    Q_OBJECT
+
+    public:
+
+        OpenRideCache(Context *context, RideCache *rideCache);
+
+        // RideItem telling us
+        void opened(RideItem *item);
+        void used(RideItem *item);
+        void closed(RideItem *item);
+
+        // memory a ride takes, roughly: the samples and xdata
+        static qint64 estimate(RideFile *ride);
+
+        // diagnostics
+        int count();
+        qint64 size();              // bytes, estimated
+        qint64 budget();            // bytes
+        quint64 hits();
+        quint64 misses();
+        quint64 evictions();
+        QString stats();
+
+    public slots:
+
+        // close the least recently used rides until we're in budget
+        void evict();
+
+    private:
+
+        Context *context;
+        RideCache *rideCache;
+
+        QMutex lock;
+        QHash<RideItem*, qint64> sizes_;
+        qint64 size_;
+        quint64 misses_, evictions_;
+        bool scheduled;
+
+        // no lock
+        QAtomicInteger<qint64> clock_;
+        QAtomicInteger<quint64> hits_;
+};
+
+#endif // _GC_OpenRideCache_h
@@ -17,11 +17,14 @@
  */
 
 #include "RideCache.h"
+#include "OpenRideCache.h"
+#include "RidePrefetcher.h"
 
 #include "Context.h"
 #include "Athlete.h"
 #include "RideFileCache.h"
 #include "RideCacheModel.h"
+#include "RideDBStore.h"
 #include "Specification.h"
 #include "DataProcessor.h"
 #include "Estimator.h"
@@ -68,7 +71,13 @@ RideCache::RideCache(Context *context) : context(context)
 
     progress_ = 100;
     exiting = false;
+    refreshCount = refreshDone = 0;
+    cancelled = false;
+    refreshAgain = false;
     estimator = new Estimator(context);
+    openRides_ = new OpenRideCache(context, this);
+    prefetcher_ = new RidePrefetcher(context, this);
+    store = new RideDBStore(RideDBStore::storeFileName(context->athlete->home->cache().canonicalPath()));
 
     // initial load of user defined metrics - do once we have an initial context
     // but before we refresh or check metrics for the first time
@@ -138,6 +147,7 @@ RideCache::RideCache(Context *context) : context(context)
 
     // now sort it - we need to use find on it
     qSort(rides_.begin(), rides_.end(), rideCacheLessThan);
+    foreach(RideItem *item, rides_) names_.insert(item->fileName, item);
 
     // load the store - will unstale once cache restored
     RideCacheLoader *rideCacheLoader = new RideCacheLoader(this);
@@ -168,10 +178,14 @@ RideCache::postLoad()
     connect(&watcher, SIGNAL(finished()), this, SLOT(save()));
     connect(&watcher, SIGNAL(finished()), context, SLOT(notifyRefreshEnd()));
     connect(&watcher, SIGNAL(started()), context, SLOT(notifyRefreshStart()));
-    connect(&watcher, SIGNAL(progressValueChanged(int)), this, SLOT(progressing(int)));
+    connect(&watcher, SIGNAL(finished()), this, SLOT(refreshFinished()));
+
+    // whatever the user is looking at gets refreshed first
+    connect(context, SIGNAL(rideSelected(RideItem*)), this, SLOT(prioritise(RideItem*)));
 }
 
 struct comparerideitem { bool operator()(const RideItem *p1, const RideItem *p2) { return p1->dateTime < p2->dateTime; } };
+struct comparerideitemdate { bool operator()(const RideItem *p, const QDateTime &d) { return p->dateTime < d; } };
 
 int
 RideCache::find(RideItem *dt)
@@ -185,6 +199,69 @@ RideCache::find(RideItem *dt)
     return index;
 }
 
+//
+// The ride list is kept in date order with an index by file name, so
+// adding, finding and removing a ride doesn't go through all of them
+//
+int
+RideCache::indexOf(const QVector<RideItem*> &rides, const RideItem *item)
+{
+    QVector<RideItem*>::const_iterator i = std::lower_bound(rides.constBegin(), rides.constEnd(), item, comparerideitem());
+    for (; i != rides.constEnd() && (*i)->dateTime == item->dateTime; ++i)
+        if (*i == item) return i - rides.constBegin();
+
+    // not where its date says it should be
+    return rides.indexOf(const_cast<RideItem*>(item));
+}
+
+int
+RideCache::position(const QVector<RideItem*> &rides, const RideItem *item)
+{
+    return std::upper_bound(rides.constBegin(), rides.constEnd(), item, comparerideitem()) - rides.constBegin();
+}
+
+void
+RideCache::merge(QVector<RideItem*> &rides, QHash<QString, RideItem*> &names, QList<RideItem*> items)
+{
+    // replace those already there, add the rest to the end
+    int sorted = rides.count();
+    foreach(RideItem *item, items) {
+        RideItem *there = names.value(item->fileName, NULL);
+        if (there) rides[indexOf(rides, there)] = item;
+        else rides << item;
+        names.insert(item->fileName, item);
+    }
+
+    // and merge them in, one sort of the new ones not of the whole list
+    std::stable_sort(rides.begin() + sorted, rides.end(), comparerideitem());
+    std::inplace_merge(rides.begin(), rides.begin() + sorted, rides.end(), comparerideitem());
+}
+
+// a ride item was renamed, e.g. saved with a new date
+void
+RideCache::renamed(RideItem *item, QString old)
+{
+    if (names_.value(old, NULL) != item) return; // not one of ours
+    names_.remove(old);
+    names_.insert(item->fileName, item);
+}
+
+// a ride item has a new date, move it if it is out of order
+void
+RideCache::moved(RideItem *item)
+{
+    if (names_.value(item->fileName, NULL) != item) return; // not one of ours
+
+    int index = rides_.indexOf(item);
+    if ((index == 0 || !(item->dateTime < rides_[index-1]->dateTime)) &&
+        (index == rides_.count()-1 || !(rides_[index+1]->dateTime < item->dateTime))) return;
+
+    if (model_) model_->beginReset();
+    rides_.remove(index);
+    rides_.insert(position(rides_, item), item);
+    if (model_) model_->endReset();
+}
+
 RideCache::~RideCache()
 {
     exiting = true;
@@ -194,6 +271,7 @@ RideCache::~RideCache()
 
     // save to store
     save();
+    delete store;
 }
 
 
@@ -267,8 +345,6 @@ RideCache::itemChanged()
 void
 RideCache::addRide(QString name, bool dosignal, bool select, bool useTempActivities, bool planned)
 {
-    RideItem *prior = context->ride;
-
     // ignore malformed names
     QDateTime dt;
     if (!RideFile::parseRideFileName(name, &dt)) return;
@@ -282,28 +358,32 @@ RideCache::addRide(QString name, bool dosignal, bool select, bool useTempActivit
     else
        last = new RideItem(directory.canonicalPath(), name, dt, context, planned);
 
+    addRide(last, dosignal, select);
+}
+
+void
+RideCache::addRide(RideItem *last, bool dosignal, bool select)
+{
+    RideItem *prior = context->ride;
+
     connect(last, SIGNAL(rideDataChanged()), this, SLOT(itemChanged()));
     connect(last, SIGNAL(rideMetadataChanged()), this, SLOT(itemChanged()));
 
     // now add to the list, or replace if already there
-    bool added = false;
-    for (int index=0; index < rides_.count(); index++) {
-        if (rides_[index]->fileName == last->fileName) {
-            rides_[index] = last;
-            added = true;
-            break;
-        }
-    }
-
-    // add and sort, model needs to know !
-    if (!added) {
-        model_->beginReset();
-        rides_ << last;
-        qSort(rides_.begin(), rides_.end(), rideCacheLessThan);
-        model_->endReset();
+    RideItem *there = names_.value(last->fileName, NULL);
+    if (there) {
+        rides_[indexOf(rides_, there)] = last;
+    } else {
+        // insert in date order, model needs to know !
+        int index = position(rides_, last);
+        model_->startInsert(index);
+        rides_.insert(index, last);
+        model_->endInsert(index);
     }
+    names_.insert(last->fileName, last);
 
-    // refresh metrics for *this ride only*
+    // refresh metrics for *this ride only*, unless it was
+    // refreshed before it was added (see RideImportWizard)
     last->refresh();
 
     if (dosignal) context->notifyRideAdded(last); // here so emitted BEFORE rideSelected is emitted!
@@ -326,6 +406,45 @@ RideCache::addRide(QString name, bool dosignal, bool select, bool useTempActivit
     estimator->refresh();
 }
 
+// add a batch of rides, e.g. when importing, with one model reset
+// and one sort rather than one for each
+void
+RideCache::addRides(QList<RideItem*> items, bool dosignal, bool select)
+{
+    if (items.isEmpty()) return;
+
+    RideItem *prior = context->ride;
+
+    foreach(RideItem *item, items) {
+        connect(item, SIGNAL(rideDataChanged()), this, SLOT(itemChanged()));
+        connect(item, SIGNAL(rideMetadataChanged()), this, SLOT(itemChanged()));
+    }
+
+    model_->beginReset();
+    merge(rides_, names_, items);
+    model_->endReset();
+
+    // any that weren't refreshed before they were added are
+    // refreshed in the background rather than one by one here
+    bool stale = false;
+    foreach(RideItem *item, items) stale |= item->isstale;
+    if (stale) refresh();
+
+    if (dosignal) foreach(RideItem *item, items) context->notifyRideAdded(item);
+
+    // notify everyone to select the last one
+    if (select) {
+        if (prior) prior->close();
+        context->ride = items.last();
+        context->notifyRideSelected(items.last());
+    } else {
+        context->notifyRideSelected(prior);
+    }
+
+    // model estimates (lazy refresh)
+    estimator->refresh();
+}
+
 
 void
 RideCache::removeRide(RideItem* todelete)
@@ -340,17 +459,14 @@ RideCache::removeRide(RideItem* todelete)
     // find ours in the list and select the one
     // immediately after it, but if it is the last
     // one on the list select the one before
-    for(index=0; index < rides_.count(); index++) {
-
-       if (rides_[index]->fileName == todelete->fileName) {
-
-          // bingo!
-          found = true;
-          if (rides_.count()-index > 1) select = rides_[index+1];
-          else if (index > 0) select = rides_[index-1];
-          break;
-
-       }
+    RideItem *there = names_.value(todelete->fileName, NULL);
+    if (there) {
+
+        // bingo!
+        found = true;
+        index = indexOf(rides_, there);
+        if (rides_.count()-index > 1) select = rides_[index+1];
+        else if (index > 0) select = rides_[index-1];
     }
 
     // WTAF!?
@@ -363,11 +479,15 @@ RideCache::removeRide(RideItem* todelete)
     // hand for add, update, delete
     DataProcessorFactory::instance().autoProcess(todelete->ride(), "Save", "DELETE");
 
+    // no point refreshing it now
+    cancel(todelete);
+
     // remove from the cache, before deleting it this is so
     // any aggregating functions no longer see it, when recalculating
     // during aride deleted operation
     // but model needs to know about this!
     model_->startRemove(index);
+    names_.remove(rides_[index]->fileName);
     rides_.remove(index, 1);
     delete_<<todelete;
     model_->endRemove(index);
@@ -429,17 +549,14 @@ RideCache::removeCurrentRide()
     // find ours in the list and select the one
     // immediately after it, but if it is the last
     // one on the list select the one before
-    for(index=0; index < rides_.count(); index++) {
-
-       if (rides_[index]->fileName == context->ride->fileName) {
-
-          // bingo!
-          found = true;
-          if (rides_.count()-index > 1) select = rides_[index+1];
-          else if (index > 0) select = rides_[index-1];
-          break;
-
-       }
+    RideItem *there = names_.value(todelete->fileName, NULL);
+    if (there) {
+
+        // bingo!
+        found = true;
+        index = indexOf(rides_, there);
+        if (rides_.count()-index > 1) select = rides_[index+1];
+        else if (index > 0) select = rides_[index-1];
     }
 
     // WTAF!?
@@ -457,6 +574,7 @@ RideCache::removeCurrentRide()
     // during aride deleted operation
     // but model needs to know about this!
     model_->startRemove(index);
+    names_.remove(rides_[index]->fileName);
     rides_.remove(index, 1);
     delete_<<todelete;
     model_->endRemove(index);
@@ -511,6 +629,7 @@ RideCache::removeCurrentRide()
 // We use a bison parser to reduce memory
 // overhead and (believe it or not) simplicity
 // RideCache::load() and save() -- see RideDB.y
+// the binary store used day to day is in RideDBStore.cpp
 
 // export metrics to csv, for users to play with R, Matlab, Excel etc
 void
@@ -584,50 +703,130 @@ itemRefresh(RideItem *&item)
     }
 }
 
+// a worker per core, they take the most important
+// stale ride off the queue until there are none left
+static void
+refreshWorker(RideCache *&cache)
+{
+    RideItem *item;
+    while ((item = cache->nextStale()) != NULL) {
+        itemRefresh(item);
+        cache->refreshed(item);
+    }
+}
+
+RideItem *
+RideCache::nextStale()
+{
+    QMutexLocker locker(&queueLock);
+    if (cancelled || queue_.isEmpty()) return NULL;
+    return queue_.takeFirst();
+}
+
 void
-RideCache::progressing(int value)
+RideCache::refreshed(RideItem *item)
+{
+    queueLock.lock();
+    int done = ++refreshDone;
+    refreshDate = item->dateTime.date();
+    queueLock.unlock();
+
+    // we're on a worker thread
+    QMetaObject::invokeMethod(this, "progressing", Qt::QueuedConnection, Q_ARG(int, done));
+}
+
+void
+RideCache::progressing(int done)
 {
     // we're working away, notfy everyone where we got
-    progress_ = 100.0f * (double(value) / double(watcher.progressMaximum()));
-    if (value) {
-        QDate here = reverse_.at(value-1)->dateTime.date();
+    progress_ = refreshCount ? 100.0f * (double(done) / double(refreshCount)) : 100.0f;
+    if (done) {
+        queueLock.lock();
+        QDate here = refreshDate;
+        queueLock.unlock();
         context->notifyRefreshUpdate(here);
     }
 }
 
-// cancel the refresh map, we're about to exit !
+// cancel the refresh, we're about to exit !
 void
 RideCache::cancel()
 {
     if (future.isRunning()) {
+
+        // workers stop after the ride they are on
+        queueLock.lock();
+        cancelled = true;
+        queueLock.unlock();
+
         future.cancel();
         future.waitForFinished();
     }
 }
 
+void
+RideCache::cancel(RideItem *item)
+{
+    QMutexLocker locker(&queueLock);
+    if (queue_.removeOne(item)) refreshCount--;
+}
+
+void
+RideCache::prioritise(RideItem *item)
+{
+    QMutexLocker locker(&queueLock);
+    if (item && queue_.removeOne(item)) queue_.prepend(item);
+}
+
 // check if we need to refresh the metrics then start the thread if needed
 void
 RideCache::refresh()
 {
-    // already on it !
-    if (future.isRunning()) return;
+    // already on it ! anything made stale since it started may
+    // not be queued, so look again when it finishes
+    if (future.isRunning()) {
+        refreshAgain = true;
+        return;
+    }
+    refreshAgain = false;
 
-    // how many need refreshing ?
-    int staleCount = 0;
+    // which need refreshing ? only the zone ranges etc that
+    // changed for the ride's date mark it stale
+    QVector<RideItem*> stale;
 
     foreach(RideItem *item, rides_) {
 
         // ok set stale so we refresh
         if (item->checkStale())
-            staleCount++;
+            stale << item;
     }
 
     // start if there is work to do
     // and future watcher can notify of updates
-    if (staleCount)  {
-        reverse_ = rides_;
-        qSort(reverse_.begin(), reverse_.end(), rideCacheGreaterThan);
-        future = QtConcurrent::map(reverse_, itemRefresh);
+    if (stale.count())  {
+
+        // newest first, but what's being looked at before that
+        qSort(stale.begin(), stale.end(), rideCacheGreaterThan);
+
+        RideItem *current = context->rideItem();
+        DateRange range = context->currentDateRange();
+        QList<RideItem*> selected, visible, rest;
+        foreach(RideItem *item, stale) {
+            if (item == current) selected << item;
+            else if (range.pass(item->dateTime.date())) visible << item;
+            else rest << item;
+        }
+
+        queueLock.lock();
+        queue_ = selected + visible + rest;
+        refreshCount = queue_.count();
+        refreshDone = 0;
+        cancelled = false;
+        queueLock.unlock();
+        progress_ = 0;
+
+        workers_.fill(this, qMax(1, QThread::idealThreadCount()));
+        future = QtConcurrent::map(workers_, refreshWorker);
         watcher.setFuture(future);
 
     } else {
@@ -640,6 +839,12 @@ RideCache::refresh()
     }
 }
 
+void
+RideCache::refreshFinished()
+{
+    if (refreshAgain && !cancelled && !exiting) refresh();
+}
+
 QString
 RideCache::getAggregate(QString name, Specification spec, bool useMetricUnits, bool nofmt)
 {
@@ -804,18 +1009,14 @@ RideCache::getAllFilenames()
 RideItem *
 RideCache::getRide(QString filename)
 {
-    foreach(RideItem *item, rides())
-        if (item->fileName == filename)
-            return item;
-    return NULL;
+    return names_.value(filename, NULL);
 }
 
 RideItem *
 RideCache::getRide(QDateTime dateTime)
 {
-    foreach(RideItem *item, rides())
-        if (item->dateTime == dateTime)
-            return item;
+    QVector<RideItem*>::const_iterator i = std::lower_bound(rides_.constBegin(), rides_.constEnd(), dateTime, comparerideitemdate());
+    if (i != rides_.constEnd() && (*i)->dateTime == dateTime) return *i;
     return NULL;
 }
 
@@ -26,7 +26,9 @@
 #include "PDModel.h"
 
 #include <QVector>
+#include <QHash>
 #include <QThread>
+#include <QMutex>
 
 #include <QFuture>
 #include <QFutureWatcher>
@@ -44,6 +46,10 @@ class AthleteBest;
 class RideCacheModel;
 class Estimator;
 class Banister;
+class RideDBStore;
+class OpenRideCache;
+class RidePrefetcher;
+class Benchmark;
 
 class RideCache : public QObject
 {
@@ -57,6 +63,12 @@ class RideCache : public QObject
         // table models
         RideCacheModel *model() { return model_; }
 
+        // the rides that are open, kept within a memory budget
+        OpenRideCache *openRides() { return openRides_; }
+
+        // reads the rides around the selected one in the background
+        RidePrefetcher *prefetcher() { return prefetcher_; }
+
         // query the cache
         int count() const { return rides_.count(); }
         RideItem *getRide(QString filename);
@@ -91,19 +103,32 @@ class RideCache : public QObject
 
         // add/remove a ride to the list
         void addRide(QString name, bool dosignal, bool select, bool useTempActivities, bool planned);
+        void addRide(RideItem *item, bool dosignal, bool select); // takes ownership
+        void addRides(QList<RideItem*> items, bool dosignal, bool select); // selects the last one
         void removeCurrentRide();
         void removeRide(RideItem* todelete);
 
         // export metrics in CSV format
         void writeAsCSV(QString filename);
 
-        // the background refresher !
+        // the background refresher ! it only works through the stale
+        // rides, most important first (selected ride, then the date
+        // range, then newest to oldest), with a worker per core taking
+        // the next one off the queue
         void refresh();
         double progress() { return progress_; }
 
+        // used by the refresh workers
+        RideItem *nextStale();
+        void refreshed(RideItem *);
+
+        // ride items telling us their name or date changed
+        void renamed(RideItem *item, QString old);
+        void moved(RideItem *item);
+
     public slots:
 
-        // restore / dump cache to disk (json)
+        // restore / dump cache to disk (binary store, or json for opendata)
         void load();
         void postLoad();
         void save(bool opendata=false, QString filename="");
@@ -117,9 +142,16 @@ class RideCache : public QObject
         // background refresh progress update
         void progressing(int);
 
+        // refresh finished, go again if asked to while it ran
+        void refreshFinished();
+
         // cancel background processing because about to exit
         void cancel();
 
+        // drop a ride from the refresh, or move it to the front
+        void cancel(RideItem *);
+        void prioritise(RideItem *);
+
         // item telling us it changed
         void itemChanged();
 
@@ -144,11 +176,18 @@ class RideCache : public QObject
         friend class ::RideCacheBackgroundRefresh;
         friend class ::LTMPlot; // get weekly performances
         friend class ::Banister; // get weekly performances
+        friend class ::Benchmark; // bulk adds
+
+        // the ride list is kept in date order with an index by file name
+        static int indexOf(const QVector<RideItem*> &rides, const RideItem *item);
+        static int position(const QVector<RideItem*> &rides, const RideItem *item); // where it goes
+        static void merge(QVector<RideItem*> &rides, QHash<QString, RideItem*> &names, QList<RideItem*> items);
 
         Context *context;
         QDir directory, plannedDirectory;
 
-        QVector<RideItem*> rides_, reverse_, delete_;
+        QVector<RideItem*> rides_, delete_;
+        QHash<QString, RideItem*> names_; // by file name
         RideCacheModel *model_;
         bool exiting;
 	    double progress_; // percent
@@ -156,8 +195,21 @@ class RideCache : public QObject
         QFuture<void> future;
         QFutureWatcher<void> watcher;
 
+        // refresh queue, shared by the workers
+        QMutex queueLock;
+        QList<RideItem*> queue_;
+        QVector<RideCache*> workers_;
+        int refreshCount, refreshDone;
+        QDate refreshDate; // last one done
+        bool cancelled;
+        bool refreshAgain; // refresh() was called while running
+
         Estimator *estimator;
         bool first; // updated when estimates are marked stale
+
+        RideDBStore *store; // binary rideDB, see RideDB.y
+        OpenRideCache *openRides_;
+        RidePrefetcher *prefetcher_;
 };
 
 class AthleteBest
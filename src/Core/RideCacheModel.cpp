@@ -145,6 +145,18 @@ RideCacheModel::itemAdded(RideItem*)
     // whilst it updated the ride list
 }
 
+void
+RideCacheModel::startInsert(int index)
+{
+    beginInsertRows(QModelIndex(), index, index);
+}
+
+void
+RideCacheModel::endInsert(int)
+{
+    endInsertRows();
+}
+
 void
 RideCacheModel::startRemove(int index)
 {
@@ -66,6 +66,10 @@ class RideCacheModel : public QAbstractTableModel
         void beginReset();
         void endReset();
 
+        // start / end insert
+        void startInsert(int);
+        void endInsert(int);
+
         // start / end remove
         void startRemove(int);
         void endRemove(int);
@@ -46,6 +46,7 @@
 #define RIDEDB_VERSION "1.9"
 
 class APIWebService;
+class APIRideIndex;
 class HttpResponse;
 class HttpRequest;
 
@@ -58,8 +59,7 @@ struct RideDBContext {
 
     // api parms
     APIWebService *api;
-    HttpRequest *request;
-    HttpResponse *response;
+    APIRideIndex *index;
 
     // the scanner
     void *scanner;
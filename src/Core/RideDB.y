@@ -18,12 +18,16 @@
  */
 
 #include "RideDB.h"
+#include "RideDBStore.h"
 #include "RideFileCache.h"
 #include "Settings.h"
 #ifdef GC_WANT_HTTP
 #include "APIWebService.h"
 #endif
 
+#include <QFileInfo>
+#include <algorithm>
+
 #define YYSTYPE QString
 
 // Lex scanner
@@ -78,8 +82,9 @@ ride: '{' rideelement_list '}'                                  {
                                                                     // a binary search, but suspect this ok < 10000 rides
                                                                     if (jc->api != NULL) {
                                                                     #ifdef GC_WANT_HTTP
-                                                                        // we're listing rides in the api
-                                                                        jc->api->writeRideLine(jc->item, jc->request, jc->response);
+                                                                        // we're indexing rides for the api
+                                                                        jc->index->add(jc->item);
+                                                                        qDeleteAll(jc->item.intervals());
                                                                     #endif
                                                                     } else {
 
@@ -317,6 +322,35 @@ string: STRING                                               { jc->JsonString =
 void 
 RideCache::load()
 {
+    // the binary store is mapped and just copied into the ride items
+    // so we use that unless an older version of GC wrote the json
+    if (RideDBStore::isCurrent(context->athlete->home->cache().canonicalPath()) && store->open(true)) {
+
+        // clean item
+        RideItem item;
+        item.path = context->athlete->home->activities().canonicalPath(); // TODO use plannedDirectory for planned
+        item.context = context;
+        item.isstale = item.isdirty = item.isedit = false;
+
+        // as for the json, force refresh after load if it changed
+        if (store->rideDBVersion() != RIDEDB_VERSION) item.isstale = true;
+
+        for (int i=0; i<store->count(); i++) {
+
+            store->read(i, item);
+
+            // find entry and update it, it takes the intervals
+            int index=find(&item);
+            if (index==-1) {
+                qDebug()<<"unable to load:"<<item.fileName<<item.dateTime<<item.weight;
+                qDeleteAll(item.intervals());
+            } else rides_.at(index)->setFrom(item);
+
+            item.clearIntervals();
+        }
+        return;
+    }
+
     // only load if it exists !
     QFile rideDB(QString("%1/%2").arg(context->athlete->home->cache().canonicalPath()).arg("rideDB.json"));
     if (rideDB.exists() && rideDB.open(QFile::ReadOnly)) {
@@ -339,6 +373,7 @@ RideCache::load()
         jc->context = context;
         jc->cache = this;
         jc->api = NULL;
+        jc->index = NULL;
         jc->old = false;
 
         // clean item
@@ -459,7 +494,7 @@ QString ConstructNameNumberNumberString(QString s0, QString name, QString s1, do
 //
 // if opendata is true then save in format for sending to the GC OpenData project
 // the filename may be supplied if exporting for other purposes, if empty then save
-// to ~athlete/cache/rideDB.json
+// to ~athlete/cache/rideDB.json and rideDB.bin (see below)
 //
 // When writing for opendata the file this doesn't (and must not) contain PII or
 // metadata, but does include some distributions for Heartrate, Power, Cadence
@@ -472,11 +507,22 @@ QString ConstructNameNumberNumberString(QString s0, QString name, QString s1, do
 //          d = json.load(json_data)
 //      print(len(d["RIDES"])
 //
+// Otherwise only the binary store is saved, it is what we read at startup
+// and mostly just has the metric values updated in place, see RideDBStore.cpp.
+// The json is only written when there isn't one (or the store could not be
+// saved), the API reads the store and exports pass a filename.
+//
 void RideCache::save(bool opendata, QString filename)
 {
+    QString cacheDir = context->athlete->home->cache().canonicalPath();
+    bool local = !opendata && filename == "";
+
+    // the store is enough when there is a json already
+    if (local && QFile::exists(RideDBStore::jsonFileName(cacheDir)) && store->save(rides(), RideDBStore::jsonFileName(cacheDir)))
+        return;
 
     // now save data away - use passed filename if set
-    QFile rideDB(QString("%1/%2").arg(context->athlete->home->cache().canonicalPath()).arg("rideDB.json"));
+    QFile rideDB(RideDBStore::jsonFileName(cacheDir));
     if (filename != "") rideDB.setFileName(filename);
 
     if (rideDB.open(QFile::WriteOnly)) {
@@ -837,26 +883,129 @@ void RideCache::save(bool opendata, QString filename)
         stream << "\n  ]\n}";
 
         rideDB.close();
+
+        // the store notes the json that was just written
+        if (local) store->save(rides(), rideDB.fileName());
     }
 }
 
 #ifdef GC_WANT_HTTP
 #include "RideMetadata.h"
 
+QSharedPointer<APIRideIndex>
+APIWebService::rideIndex(QString athlete)
+{
+    // which file are we going to read ?
+    QString cacheDir = QString("%1/%2/cache").arg(home.absolutePath()).arg(athlete);
+    bool useStore = RideDBStore::isCurrent(cacheDir);
+    QString source = useStore ? RideDBStore::storeFileName(cacheDir) : RideDBStore::jsonFileName(cacheDir);
+
+    QFileInfo info(source);
+    if (!info.exists()) return QSharedPointer<APIRideIndex>();
+
+    // the store is updated in place so timestamp and size are
+    // not enough, the generation is bumped on every save
+    quint32 generation = useStore ? RideDBStore::generation(source) : 0;
+
+    // still current ?
+    mutex.lock();
+    QSharedPointer<APIRideIndex> index = indexes.value(athlete);
+    mutex.unlock();
+
+    if (index && index->source == source && index->modified == info.lastModified() &&
+        index->size == info.size() && index->generation == generation)
+        return index;
+
+    // (re)build it, another request may be using the old one
+    index = QSharedPointer<APIRideIndex>(new APIRideIndex);
+    index->source = source;
+    index->modified = info.lastModified();
+    index->size = info.size();
+    index->generation = generation;
+
+    RideDBStore store(source);
+    if (useStore && store.open()) {
+
+        RideItem item;
+        item.context = NULL;
+        item.isstale = item.isdirty = item.isedit = false;
+
+        index->rides.reserve(store.count());
+        for (int i=0; i<store.count(); i++) {
+            store.read(i, item);
+            index->add(item);
+            qDeleteAll(item.intervals());
+            item.clearIntervals();
+        }
+
+    } else {
+
+        QFile rideDB(source);
+        if (!rideDB.open(QFile::ReadOnly)) return QSharedPointer<APIRideIndex>();
+
+        // ok, lets read it in
+        QTextStream stream(&rideDB);
+        stream.setCodec("UTF-8");
+
+        // Read the entire file into a QString -- we avoid using fopen since it
+        // doesn't handle foreign characters well. Instead we use QFile and parse
+        // from a QString
+        QString contents = stream.readAll();
+        rideDB.close();
+
+        // create scanner context for reentrant parsing
+        RideDBContext *jc = new RideDBContext;
+        jc->cache = NULL;
+        jc->api = this;
+        jc->index = index.data();
+        jc->old = false;
+
+        // clean item
+        jc->item.path = home.absolutePath() + "/activities";
+        jc->item.context = NULL;
+        jc->item.isstale = jc->item.isdirty = jc->item.isedit = false;
+
+        RideDBlex_init(&scanner);
+
+        // inform the parser/lexer we have a new file
+        RideDB_setString(contents, scanner);
+
+        // setup
+        jc->errors.clear();
+
+        // parse it
+        RideDBparse(jc);
+
+        // clean up
+        RideDBlex_destroy(scanner);
+
+        // regardless of errors we're done !
+        delete jc;
+    }
+
+    // the store is in date order, but the json may not be
+    qStableSort(index->rides.begin(), index->rides.end());
+
+    mutex.lock();
+    indexes.insert(athlete, index);
+    mutex.unlock();
+
+    return index;
+}
+
 void
 APIWebService::listRides(QString athlete, HttpRequest &request, HttpResponse &response)
 {
     listRideSettings settings;
 
     // the ride db
-    QString ridedb = QString("%1/%2/cache/rideDB.json").arg(home.absolutePath()).arg(athlete);
-    QFile rideDB(ridedb);
+    QString cacheDir = QString("%1/%2/cache").arg(home.absolutePath()).arg(athlete);
 
     // list activities and associated metrics
     response.setHeader("Content-Type", "text; charset=ISO-8859-1");
 
     // not known..
-    if (!rideDB.exists()) {
+    if (!QFile(RideDBStore::storeFileName(cacheDir)).exists() && !QFile(RideDBStore::jsonFileName(cacheDir)).exists()) {
         response.setStatus(404);
         response.write("malformed URL or unknown athlete.\n");
         return;
@@ -867,6 +1016,23 @@ APIWebService::listRides(QString athlete, HttpRequest &request, HttpResponse &re
     if (intervalsp.toUpper() == "TRUE") settings.intervals = true;
     else settings.intervals = false;
 
+    // honour the since parameter
+    QString sincep(request.getParameter("since"));
+    settings.since = QDate(1900,01,01);
+    if (sincep != "") settings.since = QDate::fromString(sincep,"yyyy/MM/dd");
+
+    // before parameter
+    QString beforep(request.getParameter("before"));
+    settings.before = QDate(3000,01,01);
+    if (beforep != "") settings.before = QDate::fromString(beforep,"yyyy/MM/dd");
+
+    // we can't search the index with an invalid date
+    if (!settings.since.isValid() || !settings.before.isValid()) {
+        response.setStatus(400);
+        response.write("malformed since or before date, expected yyyy/MM/dd.\n");
+        return;
+    }
+
     // set user data
     response.setUserData(&settings);
 
@@ -894,6 +1060,7 @@ APIWebService::listRides(QString athlete, HttpRequest &request, HttpResponse &re
 
     // don't want metrics, so do it fast by traversing the ride directory
     if (wantedNames.count() == 1 && wantedNames[0].toUpper() == "NONE") nometrics = true;
+    settings.nometrics = nometrics;
 
     // if intervals, add interval name
     if (settings.intervals == true) response.bwrite(", interval name, interval type");
@@ -950,7 +1117,7 @@ APIWebService::listRides(QString athlete, HttpRequest &request, HttpResponse &re
     }
 
     // list 'em by reading the ride cache from disk
-    if ((nometa == false || nometrics == false) && settings.intervals == false) {
+    if (nometa == false || nometrics == false || settings.intervals == true) {
 
         int i=0;
         foreach(const RideMetric *m, indexed) {
@@ -972,7 +1139,8 @@ APIWebService::listRides(QString athlete, HttpRequest &request, HttpResponse &re
             settings.wanted << (i-1);
         }
 
-        // do we want metadata too ?
+        // do we want metadata too ? not listed for intervals
+        if (settings.intervals == true) settings.metawanted.clear();
         foreach(QString meta, settings.metawanted) {
             meta.replace(" ", "_");
             response.bwrite(", \"");
@@ -981,62 +1149,48 @@ APIWebService::listRides(QString athlete, HttpRequest &request, HttpResponse &re
         }
         response.bwrite("\n");
 
-        // parse the rideDB and write a line for each entry
-        if (rideDB.exists() && rideDB.open(QFile::ReadOnly)) {
-
-            // ok, lets read it in
-            QTextStream stream(&rideDB);
-            stream.setCodec("UTF-8");
-
-            // Read the entire file into a QString -- we avoid using fopen since it
-            // doesn't handle foreign characters well. Instead we use QFile and parse
-            // from a QString
-            QString contents = stream.readAll();
-            rideDB.close();
-
-            // create scanner context for reentrant parsing
-            RideDBContext *jc = new RideDBContext;
-            jc->cache = NULL;
-            jc->api = this;
-            jc->response = &response;
-            jc->request = &request;
-            jc->old = false;
-
-            // clean item
-            jc->item.path = home.absolutePath() + "/activities";
-            jc->item.context = NULL;
-            jc->item.isstale = jc->item.isdirty = jc->item.isedit = false;
-
-            RideDBlex_init(&scanner);
-
-            // inform the parser/lexer we have a new file
-            RideDB_setString(contents, scanner);
-
-            // setup
-            jc->errors.clear();
-
-            // parse it
-            RideDBparse(jc);
+        // the index is only rebuilt if the ride db changed since the last
+        // request, the rides are in date order so we can find the range
+        QSharedPointer<APIRideIndex> index = rideIndex(athlete);
+        if (index) {
+
+            RideItem item;
+            item.path = home.absolutePath() + "/activities";
+            item.context = NULL;
+            item.isstale = item.isdirty = item.isedit = false;
+
+            APIRideIndexEntry from;
+            from.dateTime = QDateTime(settings.since, QTime(0,0,0));
+
+            QVector<APIRideIndexEntry>::const_iterator it = std::lower_bound(index->rides.constBegin(), index->rides.constEnd(), from);
+            for (; it != index->rides.constEnd() && it->dateTime.date() <= settings.before; ++it) {
+
+                // shared, so no copying
+                item.dateTime = it->dateTime;
+                item.fileName = it->fileName;
+                item.metrics() = it->metrics;
+                item.metadata() = it->metadata;
+
+                // the intervals only as they're listed, then let go
+                if (settings.intervals == true) {
+                    foreach(const APIRideIndexEntry::Interval &i, it->intervals) {
+                        IntervalItem interval;
+                        interval.name = i.name;
+                        interval.type = static_cast<RideFileInterval::intervaltype>(i.type);
+                        interval.metrics() = i.metrics;
+                        item.addInterval(interval);
+                    }
+                }
 
-            // clean up
-            RideDBlex_destroy(scanner);
+                writeRideLine(item, &request, &response);
 
-            // regardless of errors we're done !
-            delete jc;
+                qDeleteAll(item.intervals());
+                item.clearIntervals();
+            }
         }
 
     } else {
 
-        // honour the since parameter
-        QString sincep(request.getParameter("since"));
-        QDate since(1900,01,01);
-        if (sincep != "") since = QDate::fromString(sincep,"yyyy/MM/dd");
-
-        // before parameter
-        QString beforep(request.getParameter("before"));
-        QDate before(3000,01,01);
-        if (beforep != "") before = QDate::fromString(beforep,"yyyy/MM/dd");
-
         // fast list of rides by traversing the directory
         response.bwrite("\n"); // headings have no metric columns
 
@@ -1054,7 +1208,7 @@ APIWebService::listRides(QString athlete, HttpRequest &request, HttpResponse &re
             if (!RideFile::parseRideFileName(name, &dateTime)) continue; 
 
             // in range?
-            if (dateTime.date() < since || dateTime.date() > before) continue;
+            if (dateTime.date() < settings.since || dateTime.date() > settings.before) continue;
 
             // is it a backup ?
             if (name.endsWith(".bak")) continue;
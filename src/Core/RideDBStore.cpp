@@ -0,0 +1,580 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideDBStore.h"
+
+#include "RideDB.h"
+#include "RideItem.h"
+#include "IntervalItem.h"
+#include "RideMetric.h"
+
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QColor>
+#include <QUuid>
+#include <QDebug>
+#include <string.h>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+
+static const char RideDBStoreMagic[4] = { 'G', 'C', 'D', 'B' };
+
+// sections are aligned so the metric columns can be
+// referenced directly as doubles in the mapped file
+static quint64 align8(quint64 offset) { return (offset + 7) & ~quint64(7); }
+
+// Everything but the metric values, built in memory when saving
+// so we can check if the layout on disk is unchanged and only the
+// metric columns and row state need updating in place
+struct RideDBStoreImage {
+
+    QVector<RideDBStoreRow> rows;
+    QVector<RideItem*> items;
+    QVector<quint32> columns;
+    QByteArray strings;
+    QByteArray extras;
+
+    QStringList table;
+    QHash<QString, quint32> lookup;
+
+    quint32 intern(const QString &string) {
+        QHash<QString, quint32>::const_iterator it = lookup.find(string);
+        if (it != lookup.constEnd()) return it.value();
+        quint32 index = table.count();
+        lookup.insert(string, index);
+        table << string;
+        return index;
+    }
+};
+
+static void writeStd(QDataStream &out, const QMap<int, double> &map)
+{
+    out << quint32(map.count());
+    QMap<int,double>::const_iterator i;
+    for (i=map.constBegin(); i != map.constEnd(); i++) out << qint32(i.key()) << i.value();
+}
+
+static void readStd(QDataStream &in, QMap<int, double> &map, const QVector<int> &columnIndex)
+{
+    quint32 n;
+    in >> n;
+    for (quint32 i=0; i<n; i++) {
+        qint32 column;
+        double value;
+        in >> column >> value;
+        if (column >= 0 && column < columnIndex.count() && columnIndex[column] >= 0)
+            map.insert(columnIndex[column], value);
+    }
+}
+
+static void buildImage(const QVector<RideItem*> &rides, RideDBStoreImage &image)
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+
+    // column symbols in metric index order
+    QVector<QString> symbols(factory.metricCount());
+    foreach(QString name, factory.allMetrics()) symbols[factory.rideMetric(name)->index()] = name;
+    foreach(QString symbol, symbols) image.columns << image.intern(symbol);
+
+    foreach(RideItem *item, rides) {
+
+        // skip if not loaded/refreshed, a special case
+        // if saving during an initial refresh
+        if (item->metrics().count() == 0) continue;
+
+        // don't save files with discarded changes at exit
+        if (item->skipsave == true) continue;
+
+        RideDBStoreRow row;
+        memset(&row, 0, sizeof(row));
+
+        row.dateTime = item->dateTime.toMSecsSinceEpoch();
+        row.fingerprint = item->fingerprint;
+        row.crc = item->crc;
+        row.metacrc = item->metacrc;
+        row.timestamp = item->timestamp;
+        row.weight = item->weight;
+        row.dbversion = item->dbversion;
+        row.udbversion = item->udbversion;
+        row.zoneRange = item->zoneRange;
+        row.hrZoneRange = item->hrZoneRange;
+        row.paceZoneRange = item->paceZoneRange;
+        row.color = item->color.rgba();
+        row.fileName = image.intern(item->fileName);
+        row.present = image.intern(item->present);
+        row.isRun = item->isRun;
+        row.isSwim = item->isSwim;
+        row.samples = item->samples;
+
+        // variable length data
+        QByteArray extras;
+        QDataStream out(&extras, QIODevice::WriteOnly);
+
+        // metadata
+        out << quint32(item->metadata().count());
+        QMap<QString,QString>::const_iterator m;
+        for (m=item->metadata().constBegin(); m != item->metadata().constEnd(); m++)
+            out << image.intern(m.key()) << image.intern(m.value());
+
+        // xdata definitions
+        out << quint32(item->xdata().count());
+        QMap<QString,QStringList>::const_iterator x;
+        for (x=item->xdata().constBegin(); x != item->xdata().constEnd(); x++) {
+            out << image.intern(x.key()) << quint32(x.value().count());
+            foreach(QString series, x.value()) out << image.intern(series);
+        }
+
+        // overrides
+        out << quint32(item->overrides_.count());
+        foreach(QString name, item->overrides_) out << image.intern(name);
+
+        // std deviation aggregates
+        writeStd(out, item->stdmeans());
+        writeStd(out, item->stdvariances());
+
+        // intervals
+        out << quint32(item->intervals().count());
+        foreach(IntervalItem *interval, item->intervals()) {
+
+            out << image.intern(interval->name)
+                << interval->start << interval->stop
+                << interval->startKM << interval->stopKM
+                << qint32(interval->type)
+                << quint8(interval->test ? 1 : 0)
+                << quint32(interval->color.rgba())
+                << qint32(interval->displaySequence)
+                << image.intern(interval->type == RideFileInterval::ROUTE ? interval->route.toString() : QString());
+
+            // interval metrics are sparse, most are zero
+            quint32 nonzero = 0;
+            for (int i=0; i<interval->metrics().count(); i++)
+                if (interval->metrics()[i] || interval->counts()[i]) nonzero++;
+
+            out << nonzero;
+            for (int i=0; i<interval->metrics().count(); i++)
+                if (interval->metrics()[i] || interval->counts()[i])
+                    out << qint32(i) << interval->metrics()[i] << interval->counts()[i];
+
+            writeStd(out, interval->stdmeans());
+            writeStd(out, interval->stdvariances());
+        }
+
+        row.extras = image.extras.size();
+        row.extrasLength = extras.size();
+        image.extras.append(extras);
+
+        image.rows << row;
+        image.items << item;
+    }
+
+    // string table, offsets then utf-8 text
+    QVector<quint64> offsets;
+    QByteArray text;
+    foreach(QString string, image.table) {
+        offsets << text.size();
+        text.append(string.toUtf8());
+    }
+    offsets << text.size();
+
+    image.strings = QByteArray((const char*)offsets.constData(), offsets.count() * sizeof(quint64));
+    image.strings.append(text);
+}
+
+RideDBStore::RideDBStore(QString filename) : filename(filename), data(NULL), writable(false)
+{
+}
+
+RideDBStore::~RideDBStore()
+{
+    close();
+}
+
+bool
+RideDBStore::isCurrent(QString cacheDir)
+{
+    QFile store(storeFileName(cacheDir));
+    RideDBStoreHeader head;
+    if (!store.open(QFile::ReadOnly)) return false;
+    if (store.read((char*)&head, sizeof(head)) != sizeof(head)) return false;
+    if (memcmp(head.magic, RideDBStoreMagic, 4) || head.version != RideDBStoreVersion) return false;
+
+    // an older version of GC may have updated the json since
+    QFileInfo json(jsonFileName(cacheDir));
+    if (json.exists() && (json.lastModified().toMSecsSinceEpoch() != head.jsonModified || json.size() != head.jsonSize))
+        return false;
+
+    return true;
+}
+
+quint32
+RideDBStore::generation(QString filename)
+{
+    QFile store(filename);
+    RideDBStoreHeader head;
+    if (!store.open(QFile::ReadOnly)) return 0;
+    if (store.read((char*)&head, sizeof(head)) != sizeof(head)) return 0;
+    if (memcmp(head.magic, RideDBStoreMagic, 4) || head.version != RideDBStoreVersion) return 0;
+    return head.generation;
+}
+
+void
+RideDBStore::close()
+{
+    if (data) file.unmap(data);
+    if (file.isOpen()) file.close();
+    data = NULL;
+    strings.clear();
+    columnIndex.clear();
+}
+
+bool
+RideDBStore::open(bool writable)
+{
+    close();
+
+    this->writable = writable;
+    file.setFileName(filename);
+    if (!file.open(writable ? QFile::ReadWrite : QFile::ReadOnly)) return false;
+
+    quint64 size = file.size();
+    if (size < sizeof(RideDBStoreHeader)) {
+        close();
+        return false;
+    }
+
+    data = file.map(0, size);
+    if (data == NULL) {
+        close();
+        return false;
+    }
+
+    // sanity check before we trust any of the offsets
+    const RideDBStoreHeader *head = header();
+    if (memcmp(head->magic, RideDBStoreMagic, 4) || head->version != RideDBStoreVersion || head->size != size ||
+        head->rowsOffset + quint64(head->rideCount) * sizeof(RideDBStoreRow) > size ||
+        head->columnsOffset + quint64(head->columnCount) * sizeof(quint32) > size ||
+        head->valuesOffset + quint64(head->columnCount) * head->rideCount * sizeof(double) > size ||
+        head->countsOffset + quint64(head->columnCount) * head->rideCount * sizeof(double) > size ||
+        head->stringsOffset + quint64(head->stringCount + 1) * sizeof(quint64) > size ||
+        head->extrasOffset > size) {
+
+        qDebug()<<"rideDB.bin is not valid, will use rideDB.json";
+        close();
+        return false;
+    }
+
+    // decode the string table once
+    const quint64 *offsets = reinterpret_cast<const quint64*>(data + head->stringsOffset);
+    const char *text = reinterpret_cast<const char*>(offsets + head->stringCount + 1);
+    quint64 textSize = head->extrasOffset - (head->stringsOffset + (head->stringCount + 1) * sizeof(quint64));
+    for (quint32 i=0; i<head->stringCount; i++) {
+        if (offsets[i] > offsets[i+1] || offsets[i+1] > textSize) {
+            qDebug()<<"rideDB.bin string table corrupt, will use rideDB.json";
+            close();
+            return false;
+        }
+        strings << QString::fromUtf8(text + offsets[i], offsets[i+1] - offsets[i]);
+    }
+
+    mapColumns();
+    return true;
+}
+
+void
+RideDBStore::mapColumns()
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+    const quint32 *columns = reinterpret_cast<const quint32*>(data + header()->columnsOffset);
+
+    columnIndex.resize(header()->columnCount);
+    for (quint32 c=0; c<header()->columnCount; c++) {
+        const RideMetric *m = factory.rideMetric(string(columns[c]));
+        columnIndex[c] = m ? m->index() : -1;
+    }
+}
+
+QString
+RideDBStore::rideDBVersion() const
+{
+    if (!isOpen()) return QString();
+    return QString::fromLatin1(header()->ridedbVersion, qstrnlen(header()->ridedbVersion, sizeof(header()->ridedbVersion)));
+}
+
+QDateTime
+RideDBStore::dateTime(int i) const
+{
+    return QDateTime::fromMSecsSinceEpoch(row(i)->dateTime);
+}
+
+void
+RideDBStore::read(int i, RideItem &item)
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+    const RideDBStoreRow *r = row(i);
+
+    // reset, intervals are owned by whoever we pass them to
+    item.metadata().clear();
+    item.xdata().clear();
+    item.metrics().fill(0.0f, factory.metricCount());
+    item.counts().fill(0.0f, factory.metricCount());
+    item.stdmeans().clear();
+    item.stdvariances().clear();
+    item.clearIntervals();
+    item.overrides_.clear();
+
+    // fixed width state
+    item.dateTime = QDateTime::fromMSecsSinceEpoch(r->dateTime);
+    item.fileName = string(r->fileName);
+    item.present = string(r->present);
+    item.fingerprint = r->fingerprint;
+    item.crc = r->crc;
+    item.metacrc = r->metacrc;
+    item.timestamp = r->timestamp;
+    item.weight = r->weight;
+    item.dbversion = r->dbversion;
+    item.udbversion = r->udbversion;
+    item.zoneRange = r->zoneRange;
+    item.hrZoneRange = r->hrZoneRange;
+    item.paceZoneRange = r->paceZoneRange;
+    item.color = QColor::fromRgba(r->color);
+    item.isRun = r->isRun;
+    item.isSwim = r->isSwim;
+    item.samples = r->samples;
+
+    // gather the metric columns
+    for (int c=0; c<columnIndex.count(); c++) {
+        int index = columnIndex[c];
+        if (index < 0) continue;
+        item.metrics()[index] = values(c)[i];
+        item.counts()[index] = counts(c)[i];
+    }
+
+    // variable length data
+    if (header()->extrasOffset + r->extras + r->extrasLength > header()->size) return;
+    QByteArray extras = QByteArray::fromRawData(reinterpret_cast<const char*>(data + header()->extrasOffset + r->extras), r->extrasLength);
+    QDataStream in(extras);
+
+    quint32 n, key, value;
+
+    in >> n;
+    for (quint32 j=0; j<n; j++) {
+        in >> key >> value;
+        item.metadata().insert(string(key), string(value));
+    }
+
+    in >> n;
+    for (quint32 j=0; j<n; j++) {
+        quint32 count;
+        QStringList series;
+        in >> key >> count;
+        for (quint32 k=0; k<count; k++) {
+            in >> value;
+            series << string(value);
+        }
+        item.xdata().insert(string(key), series);
+    }
+
+    in >> n;
+    for (quint32 j=0; j<n; j++) {
+        in >> value;
+        item.overrides_ << string(value);
+    }
+
+    readStd(in, item.stdmeans(), columnIndex);
+    readStd(in, item.stdvariances(), columnIndex);
+
+    in >> n;
+    for (quint32 j=0; j<n && in.status() == QDataStream::Ok; j++) {
+
+        IntervalItem interval;
+        quint32 name, color, route, nonzero;
+        qint32 type, seq;
+        quint8 test;
+
+        in >> name >> interval.start >> interval.stop >> interval.startKM >> interval.stopKM
+           >> type >> test >> color >> seq >> route;
+
+        interval.name = string(name);
+        interval.type = static_cast<RideFileInterval::intervaltype>(type);
+        interval.test = test ? true : false;
+        interval.color = QColor::fromRgba(color);
+        interval.displaySequence = seq;
+        interval.route = QUuid(string(route));
+
+        in >> nonzero;
+        for (quint32 k=0; k<nonzero; k++) {
+            qint32 column;
+            double v, c;
+            in >> column >> v >> c;
+            if (column >= 0 && column < columnIndex.count() && columnIndex[column] >= 0) {
+                interval.metrics()[columnIndex[column]] = v;
+                interval.counts()[columnIndex[column]] = c;
+            }
+        }
+
+        readStd(in, interval.stdmeans(), columnIndex);
+        readStd(in, interval.stdvariances(), columnIndex);
+
+        item.addInterval(interval);
+    }
+}
+
+void
+RideDBStore::sync()
+{
+    if (!isOpen() || !writable) return;
+#ifdef Q_OS_WIN
+    FlushViewOfFile(data, 0);
+    FlushFileBuffers((HANDLE)_get_osfhandle(file.handle()));
+#else
+    msync(data, header()->size, MS_SYNC);
+#endif
+}
+
+bool
+RideDBStore::save(const QVector<RideItem*> &rides, QString json)
+{
+    RideDBStoreImage image;
+    buildImage(rides, image);
+
+    // so we can tell if anything else writes the json
+    QFileInfo jsonInfo(json);
+    qint64 jsonModified = jsonInfo.exists() ? jsonInfo.lastModified().toMSecsSinceEpoch() : 0;
+    qint64 jsonSize = jsonInfo.exists() ? jsonInfo.size() : 0;
+
+    // if only the metric values and row state have changed, which is the
+    // case after a refresh, we can just update the mapped file in place
+    if (isOpen() && writable &&
+        header()->rideCount == quint32(image.rows.count()) &&
+        header()->columnCount == quint32(image.columns.count()) &&
+        header()->stringCount == quint32(image.table.count()) &&
+        header()->extrasOffset - header()->stringsOffset >= quint64(image.strings.size()) &&
+        header()->size - header()->extrasOffset == quint64(image.extras.size()) &&
+        !memcmp(data + header()->columnsOffset, image.columns.constData(), image.columns.count() * sizeof(quint32)) &&
+        !memcmp(data + header()->stringsOffset, image.strings.constData(), image.strings.size()) &&
+        !memcmp(data + header()->extrasOffset, image.extras.constData(), image.extras.size())) {
+
+        RideDBStoreHeader *head = reinterpret_cast<RideDBStoreHeader*>(data);
+        head->generation++;
+        head->jsonModified = jsonModified;
+        head->jsonSize = jsonSize;
+        memset(head->ridedbVersion, 0, sizeof(head->ridedbVersion));
+        strncpy(head->ridedbVersion, RIDEDB_VERSION, sizeof(head->ridedbVersion));
+        memcpy(data + header()->rowsOffset, image.rows.constData(), image.rows.count() * sizeof(RideDBStoreRow));
+
+        double *values = reinterpret_cast<double*>(data + header()->valuesOffset);
+        double *counts = reinterpret_cast<double*>(data + header()->countsOffset);
+        int n = image.items.count();
+        for (int c=0; c<image.columns.count(); c++) {
+            for (int i=0; i<n; i++) {
+                RideItem *item = image.items[i];
+                double value = c < item->metrics().count() ? item->metrics()[c] : 0;
+                double count = c < item->counts().count() ? item->counts()[c] : 0;
+                if (values[c*n + i] != value) values[c*n + i] = value;
+                if (counts[c*n + i] != count) counts[c*n + i] = count;
+            }
+        }
+
+        // the os would write it back eventually, but not if we crash
+        sync();
+        return true;
+    }
+
+    // layout changed so rewrite the whole file, unmap first
+    // as we cannot replace a mapped file on some platforms
+    quint32 generation = isOpen() ? header()->generation + 1 : 1;
+    close();
+
+    // QSaveFile writes alongside and renames over the store when
+    // committed (MoveFileEx on Windows), so readers see old or new
+    QSaveFile out(filename);
+    if (!out.open(QFile::WriteOnly)) {
+        qDebug()<<"cannot write"<<filename;
+        return false;
+    }
+
+    int n = image.rows.count();
+    int columns = image.columns.count();
+
+    RideDBStoreHeader head;
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, RideDBStoreMagic, 4);
+    head.version = RideDBStoreVersion;
+    head.rideCount = n;
+    head.columnCount = columns;
+    head.stringCount = image.table.count();
+    head.generation = generation;
+    strncpy(head.ridedbVersion, RIDEDB_VERSION, sizeof(head.ridedbVersion));
+    head.jsonModified = jsonModified;
+    head.jsonSize = jsonSize;
+    head.rowsOffset = align8(sizeof(head));
+    head.columnsOffset = align8(head.rowsOffset + n * sizeof(RideDBStoreRow));
+    head.valuesOffset = align8(head.columnsOffset + columns * sizeof(quint32));
+    head.countsOffset = align8(head.valuesOffset + quint64(columns) * n * sizeof(double));
+    head.stringsOffset = align8(head.countsOffset + quint64(columns) * n * sizeof(double));
+    head.extrasOffset = align8(head.stringsOffset + image.strings.size());
+    head.size = head.extrasOffset + image.extras.size();
+
+    static const char padding[8] = { 0,0,0,0,0,0,0,0 };
+    #define PAD(to) out.write(padding, (to) - out.pos())
+
+    out.write((const char*)&head, sizeof(head));
+    PAD(head.rowsOffset);
+    out.write((const char*)image.rows.constData(), n * sizeof(RideDBStoreRow));
+    PAD(head.columnsOffset);
+    out.write((const char*)image.columns.constData(), columns * sizeof(quint32));
+    PAD(head.valuesOffset);
+
+    // one column at a time, gathered from the rows
+    QVector<double> column(n);
+    for (int c=0; c<columns; c++) {
+        for (int i=0; i<n; i++) column[i] = c < image.items[i]->metrics().count() ? image.items[i]->metrics()[c] : 0;
+        out.write((const char*)column.constData(), n * sizeof(double));
+    }
+    PAD(head.countsOffset);
+    for (int c=0; c<columns; c++) {
+        for (int i=0; i<n; i++) column[i] = c < image.items[i]->counts().count() ? image.items[i]->counts()[c] : 0;
+        out.write((const char*)column.constData(), n * sizeof(double));
+    }
+    PAD(head.stringsOffset);
+    out.write(image.strings);
+    PAD(head.extrasOffset);
+    out.write(image.extras);
+    #undef PAD
+
+    if (quint64(out.pos()) != head.size) {
+        qDebug()<<"failed writing"<<filename;
+        return false; // not committed, so the old store stays
+    }
+
+    // replace
+    if (!out.commit()) {
+        qDebug()<<"cannot replace"<<filename<<out.errorString();
+        return false;
+    }
+
+    // map again for in place updates next time
+    open(true);
+    return true;
+}
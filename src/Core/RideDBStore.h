@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideDBStore_h
+#define _GC_RideDBStore_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QFile>
+#include <QByteArray>
+#include <QDateTime>
+
+class RideItem;
+
+// RideDBStore is a binary replacement for cache/rideDB.json, it holds
+// exactly the same information but laid out so it can be mapped into
+// memory at startup and updated in place when metrics are refreshed.
+//
+// rideDB.json is only written when it is missing or for export, but it
+// is still read instead when the store is missing or the json has changed
+// since the store was saved (e.g. an older version of GC was used since).
+//
+static const quint32 RideDBStoreVersion = 2;
+// revision history:
+// version  date         description
+// 1        16-Oct-26    Initial - rows, metric columns, strings and extras
+// 2        17-Oct-26    RIDEDB_VERSION and the rideDB.json written with it
+
+// The store file (cache/rideDB.bin) has a binary format:
+// 1 x Header - version, counts and offsets of each section
+// n x Rows - fixed width RideItem state, one per ride
+// c x Column symbols - string table index for each metric column
+// c x Values - one column of n doubles per metric index
+// c x Counts - one column of n doubles per metric index
+// 1 x String table - (s+1) offsets followed by utf-8 text
+// n x Extras - variable length metadata, xdata, overrides and intervals
+//
+// Like the .cpx files the store is a local cache so everything is
+// written in local byte order and we do not worry about endianness.
+// Metric columns are stored by symbol so adding or removing metrics
+// (e.g. user metrics) just leaves columns unmatched, rides are then
+// marked stale by their dbversion/udbversion as before.
+struct RideDBStoreHeader {
+
+    char magic[4];          // "GCDB"
+    quint32 version;        // RideDBStoreVersion
+    quint32 rideCount;      // rows
+    quint32 columnCount;    // metric columns
+    quint32 stringCount;    // entries in string table
+    quint32 generation;     // incremented on every save, even in place
+
+    char ridedbVersion[8];  // RIDEDB_VERSION, rides are stale when it changes
+    qint64 jsonModified;    // rideDB.json when it was saved, msecs since epoch
+    qint64 jsonSize;
+
+    quint64 rowsOffset,
+            columnsOffset,
+            valuesOffset,
+            countsOffset,
+            stringsOffset,
+            extrasOffset,
+            size;           // whole file, truncated files are rejected
+};
+
+struct RideDBStoreRow {
+
+    qint64 dateTime;        // msecs since epoch
+    quint64 fingerprint, crc, metacrc, timestamp;
+    double weight;
+    quint64 extras, extrasLength; // relative to extrasOffset
+
+    qint32 dbversion, udbversion;
+    qint32 zoneRange, hrZoneRange, paceZoneRange;
+    quint32 color;          // QRgb
+
+    quint32 fileName, present; // string table index
+    quint8 isRun, isSwim, samples, spare8;
+    quint32 spare;
+};
+
+class RideDBStore
+{
+    public:
+
+        RideDBStore(QString filename);
+        ~RideDBStore();
+
+        // the store lives alongside rideDB.json
+        static QString storeFileName(QString cacheDir) { return cacheDir + "/rideDB.bin"; }
+        static QString jsonFileName(QString cacheDir) { return cacheDir + "/rideDB.json"; }
+
+        // is the store present and the rideDB.json unchanged since it was saved
+        static bool isCurrent(QString cacheDir);
+
+        // read just the header generation, 0 if not readable, so
+        // readers can tell if the store changed without mapping it
+        static quint32 generation(QString filename);
+
+        // map the store, returns false if it is missing or not valid
+        bool open(bool writable=false);
+        void close();
+        bool isOpen() const { return data != NULL; }
+
+        // rows are stored in the order they were written (date order)
+        int count() const { return isOpen() ? header()->rideCount : 0; }
+
+        // RIDEDB_VERSION when it was saved
+        QString rideDBVersion() const;
+        QDateTime dateTime(int row) const;
+
+        // set the item from the row, the item is reset first so it
+        // can be reused to iterate over all the rows cheaply
+        void read(int row, RideItem &item);
+
+        // write the rides, metric columns and row state are updated in
+        // place when nothing else has changed, otherwise the whole file
+        // is rewritten and replaced atomically. json is the rideDB.json,
+        // its timestamp and size are kept to notice others writing it
+        bool save(const QVector<RideItem*> &rides, QString json);
+
+    private:
+
+        const RideDBStoreHeader *header() const { return reinterpret_cast<const RideDBStoreHeader*>(data); }
+        const RideDBStoreRow *row(int i) const { return reinterpret_cast<const RideDBStoreRow*>(data + header()->rowsOffset) + i; }
+        const double *values(int column) const { return reinterpret_cast<const double*>(data + header()->valuesOffset) + (column * header()->rideCount); }
+        const double *counts(int column) const { return reinterpret_cast<const double*>(data + header()->countsOffset) + (column * header()->rideCount); }
+
+        void mapColumns();  // match stored columns to metric indexes
+        QString string(quint32 index) const { return index < (quint32)strings.count() ? strings.at(index) : QString(); }
+
+        void sync();        // in place updates to disk
+
+        QString filename;
+        QFile file;
+        uchar *data;
+        bool writable;
+
+        QStringList strings;       // decoded string table
+        QVector<int> columnIndex;  // column -> metric index or -1
+};
+
+#endif // _GC_RideDBStore_h
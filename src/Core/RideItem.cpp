@@ -24,6 +24,10 @@
 #include "IntervalItem.h"
 #include "Route.h"
 #include "Context.h"
+#include "Athlete.h"
+#include "RideCache.h"
+#include "OpenRideCache.h"
+#include "RidePrefetcher.h"
 #include "Zones.h"
 #include "HrZones.h"
 #include "PaceZones.h"
@@ -168,12 +172,27 @@ RideItem::metaCRC()
 
 RideFile *RideItem::ride(bool open)
 {
-    if (!open || ride_) return ride_;
+    if (!open) return ride_;
 
-    // open the ride file
-    QFile file(path + "/" + fileName);
-    ride_ = RideFileFactory::instance().openRideFile(context, file, errors_);
+    // already open, the cache likes to know it was used
+    OpenRideCache *cache = openRides();
+    if (ride_) {
+        if (cache) cache->used(this);
+        return ride_;
+    }
+
+    // take it from the prefetcher if it was read in the background
+    // (along with the .cpx), otherwise open the ride file
+    RidePrefetcher *prefetcher = (context && context->athlete && context->athlete->rideCache)
+                                 ? context->athlete->rideCache->prefetcher() : NULL;
+    RideFileCache *prefetched = NULL;
+    if (!prefetcher || !prefetcher->take(this, ride_, prefetched, errors_)) {
+        QFile file(path + "/" + fileName);
+        ride_ = RideFileFactory::instance().openRideFile(context, file, errors_);
+    }
     if (ride_ == NULL) return NULL; // failed to read ride
+    if (prefetched && !fileCache_) fileCache_ = prefetched;
+    else delete prefetched;
 
     // update the overrides
     overrides_.clear();
@@ -230,9 +249,20 @@ RideFile *RideItem::ride(bool open)
     connect(ride_, SIGNAL(saved()), this, SLOT(saved()));
     connect(ride_, SIGNAL(reverted()), this, SLOT(reverted()));
 
+    // account for it, the cache may close older rides to make room
+    if (cache) cache->opened(this);
+
     return ride_;
 }
 
+OpenRideCache *
+RideItem::openRides()
+{
+    if (context && context->athlete && context->athlete->rideCache)
+        return context->athlete->rideCache->openRides();
+    return NULL;
+}
+
 RideItem::~RideItem()
 {
     //qDebug()<<"deleting:"<<fileName;
@@ -274,6 +304,14 @@ RideItem::setRide(RideFile *overwrite)
     // don't bother with the old one any more
     if (old) disconnect(old);
 
+    // the open ride cache accounts for what we hold, so tell it
+    // the old one went and how big the new one is
+    OpenRideCache *cache = openRides();
+    if (cache && old != ride_) {
+        if (old) cache->closed(this);
+        if (ride_) cache->opened(this);
+    }
+
     //XXX SORRY ! memory leak XXX
     //XXX delete old; // now wipe it once referrers had chance to change
     //XXX this is only used by MergeActivityWizard and causes issues
@@ -420,8 +458,13 @@ RideItem::setDirty(bool val)
 void
 RideItem::setFileName(QString path, QString fileName)
 {
+    QString old = this->fileName;
     this->path = path;
     this->fileName = fileName;
+
+    // keep the ride cache index by name up to date
+    if (old != fileName && context && context->athlete && context->athlete->rideCache)
+        context->athlete->rideCache->renamed(this, old);
 }
 
 bool
@@ -439,6 +482,9 @@ RideItem::close()
         foreach(IntervalItem *x, intervals()) x->rideInterval = NULL;
         delete ride_;
         ride_ = NULL;
+
+        OpenRideCache *cache = openRides();
+        if (cache) cache->closed(this);
     }
 
     // and the cpx data
@@ -453,6 +499,10 @@ RideItem::setStartTime(QDateTime newDateTime)
 {
     dateTime = newDateTime;
     ride()->setStartTime(newDateTime);
+
+    // the ride cache is kept in date order
+    if (context && context->athlete && context->athlete->rideCache)
+        context->athlete->rideCache->moved(this);
 }
 
 // check if we need to be refreshed
@@ -680,6 +730,9 @@ RideItem::refresh()
 double
 RideItem::getWeight(int type)
 {
+    // metrics are computed in parallel and several use it
+    QMutexLocker locker(&weightLock);
+
     // get any body measurements first
     BodyMeasures* pBodyMeasures = dynamic_cast <BodyMeasures*>(context->athlete->measures->getGroup(Measures::Body));
     pBodyMeasures->getBodyMeasure(dateTime.date(), weightData);
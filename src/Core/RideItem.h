@@ -28,11 +28,13 @@
 #include <QString>
 #include <QMap>
 #include <QVector>
+#include <QAtomicInt>
 
 class RideFile;
 class RideFileCache;
 class RideCache;
 class RideCacheModel;
+class OpenRideCache;
 class IntervalItem;
 class IntervalSummaryWindow;
 class Context;
@@ -155,6 +157,7 @@ class RideItem : public QObject
         int dbversion; // metric version
         int udbversion; // user metric version
         double weight; // what weight was used ?
+        QMutex weightLock; // getWeight() is called by metrics in parallel
 
         // access to the cached data !
         BodyMeasure weightData;
@@ -193,6 +196,14 @@ class RideItem : public QObject
         void close();
         bool isOpen();
 
+        // a pinned ride is never closed to fit the open ride budget, take
+        // one while holding on to its RideFile past the event loop (charts
+        // showing it, compare etc). lastUsed() is when ride() was last asked
+        void pin() { pins_.ref(); }
+        void unpin() { pins_.deref(); }
+        bool isPinned() const { return pins_.load() > 0; }
+        qint64 lastUsed() const { return lastUsed_.load(); }
+
         // create and destroy
         RideItem();
         RideItem(RideFile *ride, Context *context);
@@ -220,7 +231,13 @@ class RideItem : public QObject
         bool operator>(RideItem right) const { return dateTime < right.dateTime; }
 
     private:
+        friend class ::OpenRideCache;
+
         void updateIntervals();
+        OpenRideCache *openRides(); // NULL if there isn't one
+
+        QAtomicInt pins_;
+        QAtomicInteger<qint64> lastUsed_; // OpenRideCache stamp
 };
 
 #endif // _GC_RideItem_h
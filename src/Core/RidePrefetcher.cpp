@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RidePrefetcher.h"
+#include "RideCache.h"
+#include "RideItem.h"
+#include "RideFile.h"
+#include "RideFileCache.h"
+
+#include <QApplication>
+#include <QRunnable>
+#include <QFile>
+#include <QThread>
+
+// runs a job on the pool
+class RidePrefetchJob : public QRunnable
+{
+    public:
+        RidePrefetchJob(RidePrefetcher *prefetcher, RidePrefetcher::Job *job) : prefetcher(prefetcher), job(job) {}
+        void run() { prefetcher->run(job); }
+
+    private:
+        RidePrefetcher *prefetcher;
+        RidePrefetcher::Job *job;
+};
+
+RidePrefetcher::RidePrefetcher(Context *context, RideCache *rideCache) :
+    QObject(rideCache), context(context), rideCache(rideCache), prefetched_(0), used_(0)
+{
+    // leave some cores for the metric refresh and the charts
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+}
+
+RidePrefetcher::~RidePrefetcher()
+{
+    // nothing is wanted any more
+    lock.lock();
+    foreach(Job *job, jobs) {
+        job->wanted = false;
+        if (job->state == Job::Pending) job->state = Job::Cancelled;
+    }
+    lock.unlock();
+
+    // the workers clear up the ones that were cancelled or running
+    pool.waitForDone();
+
+    lock.lock();
+    foreach(Job *job, jobs) discard(job);
+    lock.unlock();
+}
+
+void
+RidePrefetcher::prefetch(QList<RideItem*> items)
+{
+    QMutexLocker locker(&lock);
+
+    // drop what isn't wanted, the running ones are dropped when they finish
+    foreach(Job *job, jobs) {
+        job->wanted = items.contains(job->item);
+        if (job->wanted) {
+            if (job->state == Job::Cancelled) job->state = Job::Pending; // not started yet
+        } else {
+            if (job->state == Job::Pending) job->state = Job::Cancelled;
+            else if (job->state == Job::Done) discard(job);
+        }
+    }
+
+    foreach(RideItem *item, items) {
+
+        // already open or about to be refreshed (which opens it)
+        if (item->isOpen() || item->isStale()) continue;
+
+        bool have = false;
+        foreach(Job *job, jobs) if (job->item == item) have = true;
+        if (have) continue;
+
+        Job *job = new Job;
+        job->state = Job::Pending;
+        job->wanted = true;
+        job->item = item;
+        job->path = item->path;
+        job->fileName = item->fileName;
+        job->weight = item->getWeight();
+        job->ride = NULL;
+        job->cache = NULL;
+        jobs << job;
+
+        pool.start(new RidePrefetchJob(this, job));
+    }
+}
+
+void
+RidePrefetcher::run(Job *job)
+{
+    lock.lock();
+    if (job->state == Job::Cancelled) {
+        jobs.removeOne(job);
+        delete job;
+        lock.unlock();
+        return;
+    }
+    job->state = Job::Running;
+    QString path = job->path;
+    QString fileName = job->fileName;
+    double weight = job->weight;
+    lock.unlock();
+
+    // read it and warm up what the charts ask for first
+    QStringList errors;
+    QFile file(path + "/" + fileName);
+    RideFile *ride = RideFileFactory::instance().openRideFile(context, file, errors);
+    RideFileCache *cache = NULL;
+    if (ride) {
+        ride->recalculateDerivedSeries();
+        ride->wprimeData();
+        cache = new RideFileCache(context, fileName, weight, ride);
+    }
+
+    QMutexLocker locker(&lock);
+
+    // nobody wants it now, we still own it so clear up here
+    if (!job->wanted) {
+        delete cache;
+        delete ride;
+        jobs.removeOne(job);
+        delete job;
+        done.wakeAll();
+        return;
+    }
+
+    // it will be used on the gui thread
+    if (ride) ride->moveToThread(qApp->thread());
+
+    job->ride = ride;
+    job->cache = cache;
+    job->errors = errors;
+    job->state = Job::Done;
+    prefetched_++;
+    done.wakeAll();
+}
+
+bool
+RidePrefetcher::take(RideItem *item, RideFile *&ride, RideFileCache *&cache, QStringList &errors)
+{
+    // the rides are handed to the gui thread, the refresh workers read their own
+    if (QThread::currentThread() != qApp->thread()) return false;
+
+    QMutexLocker locker(&lock);
+
+    // the file name too, in case the item was deleted and another took its place
+    Job *job = NULL;
+    foreach(Job *j, jobs) if (j->item == item && j->fileName == item->fileName && j->state != Job::Cancelled) job = j;
+    if (job == NULL) return false;
+
+    // not started, quicker to read it now
+    if (job->state == Job::Pending) {
+        job->state = Job::Cancelled;
+        return false;
+    }
+
+    // nearly there, wait for it
+    job->wanted = true;
+    while (job->state == Job::Running) done.wait(&lock);
+
+    ride = job->ride;
+    cache = job->cache;
+    errors = job->errors;
+    jobs.removeOne(job);
+    delete job;
+    used_++;
+
+    return ride != NULL;
+}
+
+void
+RidePrefetcher::discard(Job *job)
+{
+    delete job->cache;
+    delete job->ride;
+    jobs.removeOne(job);
+    delete job;
+}
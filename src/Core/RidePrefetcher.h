@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RidePrefetcher_h
+#define _GC_RidePrefetcher_h 1
+#include "GoldenCheetah.h"
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+
+class Context;
+class RideCache;
+class RideItem;
+class RideFile;
+class RideFileCache;
+
+// RidePrefetcher reads the rides either side of the one selected in the
+// navigator while the user is looking at it, so stepping through them
+// doesn't wait on the file being parsed. Each is read on a worker thread
+// along with the things every chart asks for straight away; the derived
+// series, W' bal and the .cpx mean maximals.
+//
+// The rides are not opened, the results are held here until the ride
+// is asked for. RideItem::ride() calls take() and if the ride is still
+// being read it waits for it rather than reading it again. Asking for
+// different rides drops the ones that are no longer wanted.
+class RidePrefetcher : public QObject
+{
+    Q_OBJECT
+
+    public:
+
+        // how many rides either side of the selected one
+        static const int neighbours = 2;
+
+        RidePrefetcher(Context *context, RideCache *rideCache);
+        ~RidePrefetcher();
+
+        // read these in the background, in this order
+        void prefetch(QList<RideItem*> items);
+
+        // hand over what was read for the ride, false if we don't have it
+        bool take(RideItem *item, RideFile *&ride, RideFileCache *&cache, QStringList &errors);
+
+        // statistics
+        int prefetched() const { return prefetched_; }
+        int used() const { return used_; }
+
+    private:
+
+        friend class RidePrefetchJob;
+
+        struct Job {
+            enum { Pending, Running, Done, Cancelled } state;
+            bool wanted;
+
+            // the worker only ever uses the names, the item may be gone
+            RideItem *item;
+            QString path, fileName;
+            double weight;
+
+            // results
+            RideFile *ride;
+            RideFileCache *cache;
+            QStringList errors;
+        };
+
+        void run(Job *job); // on a worker thread
+        void discard(Job *job);
+
+        Context *context;
+        RideCache *rideCache;
+
+        QThreadPool pool;
+        QMutex lock;
+        QWaitCondition done;
+        QList<Job*> jobs;
+        int prefetched_, used_;
+};
+
+#endif // _GC_RidePrefetcher_h
@@ -161,6 +161,7 @@
 #define GC_PACE                         "<global-general>pace"
 #define GC_SWIMPACE                     "<global-general>swimpace"
 #define GC_ELEVATION_HYSTERESIS         "<global-general>elevationHysteresis"
+#define GC_OPENRIDES_BUDGET             "<global-general>openRidesBudget"                    // MB of open activities kept in memory
 #define GC_UNIT                         "<global-general>unit"
 #define GC_ALLOW_TELEMETRY              "<global-general>telemetryAllowed"
 #define GC_ALLOW_TELEMETRY_DATE         "<global-general>telemetryDecisionDate"
@@ -307,6 +308,7 @@
 #define GC_AUTOBACKUP_FOLDER            "<athlete-preferences>autobackup/folder"
 #define GC_AUTOBACKUP_PERIOD            "<athlete-preferences>autobackup/period"                  // how often is the Athlete Folder backuped up / 0 == never
 #define GC_AUTOBACKUP_COUNTER           "<athlete-preferences>autobackup/counter"                 // counts to the next backup
+#define GC_AUTOBACKUP_INCREMENTAL       "<athlete-preferences>autobackup/incremental"             // only back up what changed since the last backup
 
 #define GC_CLOUDDB_TC_ACCEPTANCE       "<athlete-preferences>clouddb/acceptance"                  // bool
 #define GC_CLOUDDB_TC_ACCEPTANCE_DATE  "<athlete-preferences>clouddb/acceptancedate"              // date/time string of acceptance
@@ -19,6 +19,7 @@
 #include "Context.h"
 #include "Athlete.h"
 #include "MainWindow.h"
+#include "Tab.h"
 #include "Settings.h"
 #include "CloudService.h"
 #include "TrainDB.h"
@@ -26,6 +27,7 @@
 #include "GcUpgrade.h"
 #include "IdleTimer.h"
 #include "PowerProfile.h"
+#include "Benchmark.h"
 
 #include <QApplication>
 #include <QDesktopWidget>
@@ -201,6 +203,7 @@ main(int argc, char *argv[])
     bool server = false;
     nogui = false;
     bool help = false;
+    bool benchmark = false;
 
     // honour command line switches
     foreach (QString arg, sargs) {
@@ -220,6 +223,9 @@ main(int argc, char *argv[])
             fprintf(stderr, "--debug             to direct diagnostic messages to the terminal instead of goldencheetah.log\n");
 #endif
             fprintf(stderr, "--development       to enable developpers only features.");
+            fprintf(stderr, "--benchmark [dir [athlete]] to run the developer benchmarks over the rides in dir (test/rides) and exit,\n"
+                            "                    metrics are only benchmarked when an athlete is given, an antlog.raw in dir\n"
+                            "                    is replayed to the ANT reader\n");
 #ifdef GC_HAS_CLOUD_DB
             fprintf(stderr, "--clouddbcurator    to add CloudDB curator specific functions to the menus\n");
 #endif
@@ -268,6 +274,11 @@ main(int argc, char *argv[])
 
             MainWindow::gc_devMode = true;
 
+        } else if (arg == "--benchmark") {
+
+            // results go to the terminal
+            nogui = benchmark = debug = true;
+
         } else if (arg == "--clouddbcurator") {
 #ifdef GC_HAS_CLOUD_DB
             CloudDBCommon::addCuratorFeatures = true;
@@ -556,6 +567,10 @@ main(int argc, char *argv[])
         // Initialize metrics once the translator is installed
         RideMetricFactory::instance().initialize();
 
+        // developer benchmarks, see Benchmark.h, when an athlete is
+        // given they are run once it has been opened below
+        if (benchmark && args.count() < 3) terminate(Benchmark::run(args.count() > 1 ? args.at(1) : QString()));
+
         // Initialize global registry once the translator is installed
         GcWindowRegistry::initialize();
 
@@ -573,7 +588,8 @@ main(int argc, char *argv[])
         } else if (args.count() == 3) { // $ ./GoldenCheetah ~/Athletes Mark
 
             // first parameter is a folder that exists?
-            if (QFileInfo(args.at(1)).isDir()) {
+            // (for benchmarks its the rides folder)
+            if (!benchmark && QFileInfo(args.at(1)).isDir()) {
                 home.cd(args.at(1));
             }
 
@@ -602,7 +618,7 @@ main(int argc, char *argv[])
 
         // The API server offers webservices (default port 12021, see httpserver.ini)
         // This is to enable integration with R and similar
-        if (appsettings->value(NULL, GC_START_HTTP, false).toBool() || server) {
+        if (!benchmark && (appsettings->value(NULL, GC_START_HTTP, false).toBool() || server)) {
 
             // notifications etc
             if (nogui) {
@@ -681,6 +697,7 @@ main(int argc, char *argv[])
                     GcUpgrade v3;
                     if (v3.upgradeConfirmedByUser(home)) {
                         MainWindow *mainWindow = new MainWindow(home);
+                        if (benchmark) terminate(Benchmark::run(args.at(1), mainWindow->athleteTab()->context));
                         mainWindow->show();
                         mainWindow->ridesAutoImport();
                         gc_opened++;
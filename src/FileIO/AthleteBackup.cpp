@@ -31,13 +31,163 @@
 #include "../qzip/zipwriter.h"
 #include "../qzip/zipreader.h"
 
+#include <QBuffer>
+#include <QTemporaryFile>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QTextStream>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QThread>
+#include <QHash>
+#include <QPair>
+#if QT_VERSION > 0x050000
+#include <QtConcurrent>
+#else
+#include <QtConcurrentMap>
+#endif
+
+//
+// Incremental backups
+//
+// A manifest in the backup folder lists every file backed up with its
+// size, modification time and a sha1 of its contents, and the backup
+// .zip it is stored in. An incremental backup only reads the files
+// whose size or time changed since, and only stores the ones whose
+// contents changed too. Contents already in one of the backups (a file
+// copied or renamed) are not stored again.
+//
+// With incremental backups on, the manifest is added to every backup so
+// a restore knows which .zip each file is in; the full backup first,
+// then the incrementals after it in order. A full backup is made every
+// so often, or if one of the earlier backups has gone, and a full backup
+// stores everything so it can still be restored on its own by unzipping
+// it. With them off there is no manifest, every backup is a full one.
+//
+// Files are read once, hashed and compressed a piece at a time by
+// worker threads, small ones into memory and big ones into a temporary
+// file, and then copied into the .zip in order.
+//
+static const int maxIncrementals = 10;              // then a full backup
+static const qint64 bigFile = 8 * 1024 * 1024;      // compressed into a temporary file
+static const qint64 batchBytes = 64 * 1024 * 1024;  // compressed in memory at once
+
+struct BackupEntry
+{
+    BackupEntry() : size(0), modified(0), crc(0), deflated(NULL), failed(false) {}
 
+    QString path;       // folder/name, as in the backup
+    qint64 size;
+    qint64 modified;    // msecs since epoch
+    QByteArray hash;    // sha1 of the contents, in hex
+    QString archive;    // the backup it is stored in
+    QString stored;     // and as, another path if its contents were already there
+
+    // backing it up
+    QString source;
+    uint crc;
+    QIODevice *deflated;
+    bool failed;
+};
+
+static const char *manifestHeader = "GoldenCheetah backup manifest 1";
+
+// the backups oldest (the full one) first, and the files
+static bool
+readManifest(QString fileName, QStringList &archives, QMap<QString, BackupEntry> &entries)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QTextStream in(&file);
+    in.setCodec("UTF-8");
+    if (in.readLine() != manifestHeader) return false;
+
+    while (!in.atEnd()) {
+        QStringList fields = in.readLine().split('\t');
+        if (fields.count() == 2 && fields[0] == "archive") {
+            archives << fields[1];
+        } else if (fields.count() == 7 && fields[0] == "file") {
+            int archive = fields[5].toInt();
+            if (archive < 0 || archive >= archives.count()) return false;
+
+            BackupEntry entry;
+            entry.path = fields[1];
+            entry.size = fields[2].toLongLong();
+            entry.modified = fields[3].toLongLong();
+            entry.hash = fields[4].toLatin1();
+            entry.archive = archives[archive];
+            entry.stored = fields[6];
+            entries.insert(entry.path, entry);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static QByteArray
+manifest(QStringList archives, const QMap<QString, BackupEntry> &entries)
+{
+    QByteArray returning;
+    QTextStream out(&returning);
+    out.setCodec("UTF-8");
+
+    out << manifestHeader << "\n";
+    foreach(QString archive, archives) out << "archive\t" << archive << "\n";
+    foreach(const BackupEntry &entry, entries) {
+        out << "file\t" << entry.path << "\t" << entry.size << "\t" << entry.modified << "\t" << entry.hash
+            << "\t" << archives.indexOf(entry.archive) << "\t" << entry.stored << "\n";
+    }
+    out.flush();
+    return returning;
+}
+
+// written whole before it replaces the last one, QSaveFile
+// renames over it so there is always a manifest to read
+static void
+writeManifest(QString fileName, QByteArray contents)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) return;
+    if (file.write(contents) == contents.size()) file.commit();
+}
+
+// hash and compress in one pass, runs in the worker threads
+static void
+backupWorker(BackupEntry *entry)
+{
+    QFile file(entry->source);
+    if (!file.open(QIODevice::ReadOnly) || !entry->deflated->open(QIODevice::ReadWrite)) {
+        entry->failed = true;
+        return;
+    }
+
+    ZipDeflater deflater;
+    QCryptographicHash sha1(QCryptographicHash::Sha1);
+    QByteArray in(256 * 1024, 0), out;
+    qint64 n = 0;
+    bool ok = true;
+    while (ok && (n = file.read(in.data(), in.size())) > 0) {
+        sha1.addData(in.constData(), n);
+        ok = deflater.add(in.constData(), n, out) && entry->deflated->write(out) == out.size();
+        out.clear();
+    }
+    ok = ok && n == 0 && deflater.finish(out) && entry->deflated->write(out) == out.size();
+
+    entry->failed = !ok;
+    entry->hash = sha1.result().toHex();
+    entry->crc = deflater.checksum();
+    entry->size = deflater.size();
+}
 
 AthleteBackup::AthleteBackup(QDir athleteHome)
 {
     this->athleteDirs = new AthleteDirectoryStructure(athleteHome);
     this->athlete = athleteHome.dirName();
     this->backupFolder = "";
+    this->incremental = false;
+    this->stored = 0;
 
     // set the directories to be backed up
     // for a FULL backup basically all data folders
@@ -62,6 +212,7 @@ AthleteBackup::backupOnClose()
 {
     int backupPeriod = appsettings->cvalue(athlete, GC_AUTOBACKUP_PERIOD, 0).toInt();
     backupFolder = appsettings->cvalue(athlete, GC_AUTOBACKUP_FOLDER, "").toString();
+    incremental = appsettings->cvalue(athlete, GC_AUTOBACKUP_INCREMENTAL, false).toBool();
     if (backupPeriod == 0 || backupFolder == "" ) return;
     int backupCounter = appsettings->cvalue(athlete, GC_AUTOBACKUP_COUNTER, 0).toInt();
     backupCounter++;
@@ -80,6 +231,7 @@ void
 AthleteBackup::backupImmediate()
 {
     backupFolder = appsettings->cvalue(athlete, GC_AUTOBACKUP_FOLDER, "").toString();
+    incremental = appsettings->cvalue(athlete, GC_AUTOBACKUP_INCREMENTAL, false).toBool();
     QString dir = QFileDialog::getExistingDirectory(NULL, tr("Select Backup Directory"),
                             backupFolder, QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
     if (dir == "") {
@@ -104,7 +256,8 @@ AthleteBackup::backupImmediate()
         break;
     }
     if (backup(tr("Abort Backup"))) {
-       QMessageBox::information(NULL, tr("Athlete Backup"), tr("Backup successfully stored in \n%1").arg(backupFolder));
+       if (stored) QMessageBox::information(NULL, tr("Athlete Backup"), tr("Backup successfully stored in \n%1").arg(backupFolder));
+       else QMessageBox::information(NULL, tr("Athlete Backup"), tr("No files have changed since the last backup in \n%1").arg(backupFolder));
     }
 
 }
@@ -114,17 +267,45 @@ AthleteBackup::backupImmediate()
 bool
 AthleteBackup::backup(QString progressText)
 {
+    stored = 0;
+
+    // what was backed up last time, an incremental backup needs all the
+    // backups before it back to the full one
+    QString manifestName = backupFolder + "/GC_Notio_" + athlete + ".manifest";
+    QStringList archives;
+    QMap<QString, BackupEntry> previous;
+    bool full = !incremental || !readManifest(manifestName, archives, previous) ||
+                archives.isEmpty() || archives.count() > maxIncrementals;
+    foreach(QString archive, archives) if (!QFile::exists(backupFolder + "/" + archive)) full = true;
+    if (full) {
+        archives.clear();
+        previous.clear();
+    }
 
     // backup requested so lets see if we have something to backup and if yes, how much
+    // anything the same size and time as last time is still in the same backup
     int fileCount = 0;
     qint64 fileSize = 0;
-    // count the files for the progress bar and the calculate the overall size
+    QMap<QString, BackupEntry> entries;
+    QVector<BackupEntry> changed;
     foreach (QDir folder, sourceFolderList) {
         // get all files
         foreach (QFileInfo fileName, folder.entryInfoList(QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks)) {
            fileCount++;
-           fileSize += fileName.size();
 
+           BackupEntry entry;
+           entry.path = folder.dirName() + "/" + fileName.fileName();
+           entry.source = fileName.canonicalFilePath();
+           entry.size = fileName.size();
+           entry.modified = fileName.lastModified().toMSecsSinceEpoch();
+
+           QMap<QString, BackupEntry>::const_iterator last = previous.constFind(entry.path);
+           if (last != previous.constEnd() && last.value().size == entry.size && last.value().modified == entry.modified) {
+               entries.insert(entry.path, last.value());
+           } else {
+               changed << entry;
+               fileSize += entry.size;
+           }
         }
     }
 
@@ -133,6 +314,12 @@ AthleteBackup::backup(QString progressText)
        return false;
     }
 
+    // nothing changed, but some may have been deleted
+    if (changed.isEmpty()) {
+        if (incremental) writeManifest(manifestName, manifest(archives, entries));
+        return true;
+    }
+
 #if QT_VERSION > 0x050400
     // if if there is enough space available for the backup
     QStorageInfo storage(backupFolder);
@@ -156,7 +343,7 @@ AthleteBackup::backup(QString progressText)
 
     // Update Notio backup filename.
     QChar zero = QLatin1Char('0');
-    QString targetFileName = QString( "GC_Notio_%1_%2_%3_%4_%5_%6_%7_%8.zip" )
+    QString targetFileName = QString( "GC_Notio_%1_%2_%3_%4_%5_%6_%7_%8%9.zip" )
                        .arg ( NK_VERSION_LATEST )
                        .arg ( athlete )
                        .arg ( QDate::currentDate().year(), 4, 10, zero )
@@ -164,7 +351,8 @@ AthleteBackup::backup(QString progressText)
                        .arg ( QDate::currentDate().day(), 2, 10, zero )
                        .arg ( QTime::currentTime().hour(), 2, 10, zero )
                        .arg ( QTime::currentTime().minute(), 2, 10, zero )
-                       .arg ( QTime::currentTime().second(), 2, 10, zero );
+                       .arg ( QTime::currentTime().second(), 2, 10, zero )
+                       .arg ( full ? "" : "_incremental" );
 
 
     // add files using zip writer
@@ -176,44 +364,114 @@ AthleteBackup::backup(QString progressText)
     zipFile.close();
     ZipWriter writer(zipFile.fileName());
 
-    QProgressDialog progress(tr("Adding files to backup %1 for athlete %2 ...").arg(targetFileName).arg(athlete), progressText, 0, fileCount, NULL);
+    QProgressDialog progress(tr("Adding files to backup %1 for athlete %2 ...").arg(targetFileName).arg(athlete), progressText, 0, changed.count(), NULL);
     progress.setWindowModality(Qt::WindowModal);
 
-    // now do the Zipping
+    foreach (QDir folder, sourceFolderList) writer.addDirectory(folder.dirName());
+
+    // contents already backed up, by hash
+    QHash<QByteArray, QPair<QString, QString> > contents;
+    foreach(const BackupEntry &entry, previous) contents.insert(entry.hash, qMakePair(entry.archive, entry.stored));
+
+    // now do the Zipping, the workers compress a batch at a time
     bool userCanceled = false;
+    bool writeFailed = false;
     int fileCounter = 0;
-    foreach (QDir folder, sourceFolderList) {
-        // get all files
-        writer.addDirectory(folder.dirName());
-        foreach (QFileInfo fileName, folder.entryInfoList(QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks)) {
-            QFile file(fileName.canonicalFilePath());
-            if (file.open(QIODevice::ReadOnly)) {
-                if (progress.wasCanceled()) {
-                    userCanceled = true;
-                    break;
+    int threads = QThread::idealThreadCount();
+    for (int next = 0; next < changed.count() && !userCanceled && !writeFailed; ) {
+
+        QList<BackupEntry*> batch;
+        qint64 bytes = 0;
+        while (next < changed.count() && batch.count() < 4 * threads &&
+               (changed[next].size >= bigFile || bytes + changed[next].size <= batchBytes)) {
+            BackupEntry *entry = &changed[next++];
+            if (entry->size >= bigFile) {
+                entry->deflated = new QTemporaryFile(backupFolder + "/.gcbackup.XXXXXX");
+            } else {
+                entry->deflated = new QBuffer;
+                bytes += entry->size;
+            }
+            batch << entry;
+        }
+
+        // keep the progress dialog alive while they work
+        QFutureWatcher<void> watcher;
+        QEventLoop loop;
+        connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+        watcher.setFuture(QtConcurrent::map(batch, backupWorker));
+        if (!watcher.isFinished()) loop.exec();
+
+        foreach(BackupEntry *entry, batch) {
+
+            QMap<QString, BackupEntry>::const_iterator last = previous.constFind(entry->path);
+            if (entry->failed) {
+
+                // can't read it, the last backup of it will have to do
+                if (last != previous.constEnd()) entries.insert(entry->path, last.value());
+
+            } else {
+
+                if (last != previous.constEnd() && last.value().hash == entry->hash) {
+
+                    // only touched, still in the same backup
+                    entry->archive = last.value().archive;
+                    entry->stored = last.value().stored;
+
+                } else if (!full && contents.contains(entry->hash)) {
+
+                    // copied or renamed, the contents are already backed up
+                    entry->archive = contents.value(entry->hash).first;
+                    entry->stored = contents.value(entry->hash).second;
+
+                } else {
+
+                    entry->deflated->seek(0);
+                    writer.addDeflatedFile(entry->path, entry->deflated, entry->crc, entry->size,
+                                           QDateTime::fromMSecsSinceEpoch(entry->modified));
+
+                    // a backup missing a file is no backup, it is thrown away below
+                    if (writer.status() != ZipWriter::NoError) writeFailed = true;
+
+                    entry->archive = targetFileName;
+                    entry->stored = entry->path;
+                    if (!full) contents.insert(entry->hash, qMakePair(entry->archive, entry->stored));
+                    stored++;
                 }
-                writer.addFile(folder.dirName()+"/"+fileName.fileName(), file.readAll());
-                progress.setValue(fileCounter);
-                fileCounter++;
-                file.close();
             }
+
+            // temporary files are removed when deleted
+            delete entry->deflated;
+            entry->deflated = NULL;
+            if (!entry->failed) entries.insert(entry->path, *entry);
+
+            progress.setValue(fileCounter);
+            fileCounter++;
         }
-        if (userCanceled) break;
+
+        if (progress.wasCanceled()) userCanceled = true;
     }
 
-    // final processing
+    // final processing, the manifest goes in an incremental backup too
+    if (!userCanceled && !writeFailed && stored) {
+        archives << targetFileName;
+        if (incremental) writer.addFile("backup.manifest", manifest(archives, entries));
+        if (writer.status() != ZipWriter::NoError) writeFailed = true;
+    }
     writer.close();
 
-    // delete the .ZIP file if the user canceled the backup
-    if (userCanceled) {
-        zipFile.remove();
+    // delete the .ZIP file if the user canceled the backup, it failed or it's empty
+    if (userCanceled || writeFailed || !stored) zipFile.remove();
+    if (writeFailed) {
+        QMessageBox::warning(NULL, tr("Athlete Backup"), tr("Backup file %1 could not be written, no backup created.").arg(zipFile.fileName()));
         return false;
     }
+    if (userCanceled) return false;
+
+    // and in the backup folder for next time
+    if (incremental) writeManifest(manifestName, manifest(archives, entries));
 
     // we are done, full progress
-    progress.setValue(fileCount);
+    progress.setValue(changed.count());
     return true;
 
 }
-
-
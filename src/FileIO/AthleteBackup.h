@@ -39,6 +39,8 @@ class AthleteBackup : public QObject
         QString athlete;
         QString backupFolder;
         QList<QDir> sourceFolderList;
+        bool incremental;   // only store what changed since the last backup
+        int stored;         // files stored by the last backup
         bool backup(QString progressText);
 
 };
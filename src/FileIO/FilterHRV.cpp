@@ -50,11 +50,11 @@ void FilterHrv(XDataSeries *rr, double rr_min, double rr_max, double filt, int h
             if (rr_min < rr->datapoints[idx]->number[0] &&
                 rr_max > rr->datapoints[idx]->number[0])
                 {
-                    rr->datapoints[idx]->number[1] = 1;
+                    rr->datapoints[idx]->number.set(1, 1);
                 }
             else
                 {
-                    rr->datapoints[idx]->number[1] = -1;
+                    rr->datapoints[idx]->number.set(1, -1);
                 }
         }
 
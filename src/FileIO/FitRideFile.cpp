@@ -29,6 +29,7 @@
 #include <QDebug>
 #include <QTime>
 #include <cstdio>
+#include <cstring>
 #include <stdint.h>
 #include <time.h>
 #include <limits>
@@ -88,10 +89,26 @@ struct FitDeveField {
     fit_string_value unit;
 };
 
+// how each field of a message is decoded, worked out once when the
+// definition is read so data messages are decoded straight from the
+// buffer without walking the base types again
+enum FitDecode { FitUint8, FitSint8, FitUint8z, FitSint16, FitUint16, FitUint16z,
+                 FitSint32, FitUint32, FitUint32z, FitFloat32, FitString, FitBytes, FitSkip };
+
+struct FitFieldPlan {
+    FitDecode decode;
+    int offset; // from the start of the message
+    int count;  // values in a list (or characters)
+    bool list;
+};
+
 struct FitDefinition {
+    FitDefinition() : global_msg_num(0), is_big_endian(false), length(0) {}
     int global_msg_num;
     bool is_big_endian;
     std::vector<FitField> fields;
+    std::vector<FitFieldPlan> plan;
+    int length; // bytes in each data message
 };
 
 enum fitValueType { SingleValue, ListValue, FloatValue, StringValue };
@@ -111,6 +128,10 @@ struct FitFileReaderState
 {
     QFile &file;
     QStringList &errors;
+    const uchar *buffer; // the whole file, mapped or read in one go
+    qint64 length, pos;
+    QByteArray bytes;    // if it couldn't be mapped
+    std::vector<FitValue> values; // reused for every message
     RideFile *rideFile;
     time_t start_time;
     time_t last_time;
@@ -148,7 +169,7 @@ struct FitFileReaderState
     QList<QString> dataInfos;
 
     FitFileReaderState(QFile &file, QStringList &errors) :
-        file(file), errors(errors), rideFile(NULL), start_time(0),
+        file(file), errors(errors), buffer(NULL), length(0), pos(0), rideFile(NULL), start_time(0),
         last_time(0), last_distance(0.00f), interval(0), calibration(0),
         devices(0), stopped(true), isLapSwim(false), pool_length(0.0),
         last_event_type(-1), last_event(-1), last_msg_type(-1), frac_time(0.0),
@@ -157,150 +178,182 @@ struct FitFileReaderState
 
     struct TruncatedRead {};
 
-    void read_unknown( int size, int *count = NULL ) {
-        if (!file.seek(file.pos() + size))
+    // the next size bytes of the buffer
+    const uchar *take(int size, int *count = NULL) {
+        if (size < 0 || pos + size > length)
             throw TruncatedRead();
+        const uchar *p = buffer + pos;
+        pos += size;
         if (count)
             (*count) += size;
+        return p;
     }
 
-    fit_string_value read_text(int len, int *count = NULL) {
-        char c;
-        fit_string_value res = "";
-        for (int i = 0; i < len; ++i) {
-            if (file.read(&c, 1) != 1)
-                throw TruncatedRead();
-            if (count)
-                *count += 1;
-
-            if (c != 0)
-                res += c;
-        }
-        return res;
-    }
-
-    fit_value_t read_int8(int *count = NULL) {
-        qint8 i;
-        if (file.read(reinterpret_cast<char*>( &i), 1) != 1)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 1;
-
-        return i == 0x7f ? NA_VALUE : i;
+    void read_unknown( int size, int *count = NULL ) {
+        take(size, count);
     }
 
     fit_value_t read_uint8(int *count = NULL) {
-        quint8 i;
-        if (file.read(reinterpret_cast<char*>( &i), 1) != 1)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 1;
-
-        return i == 0xff ? NA_VALUE : i;
+        return decodeValue(FitUint8, take(1, count), false);
     }
 
-    fit_value_t read_uint8z(int *count = NULL) {
-        quint8 i;
-        if (file.read(reinterpret_cast<char*>( &i), 1) != 1)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 1;
-
-        return i == 0x00 ? NA_VALUE : i;
+    fit_value_t read_uint16(bool is_big_endian, int *count = NULL) {
+        return decodeValue(FitUint16, take(2, count), is_big_endian);
     }
 
-    fit_value_t read_int16(bool is_big_endian, int *count = NULL) {
-        qint16 i;
-        if (file.read(reinterpret_cast<char*>(&i), 2) != 2)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 2;
-
-        i = is_big_endian
-            ? qFromBigEndian<qint16>( i )
-            : qFromLittleEndian<qint16>( i );
-
-        return i == 0x7fff ? NA_VALUE : i;
+    fit_value_t read_uint32(bool is_big_endian, int *count = NULL) {
+        return decodeValue(FitUint32, take(4, count), is_big_endian);
     }
 
-    fit_value_t read_uint16(bool is_big_endian, int *count = NULL) {
-        quint16 i;
-        if (file.read(reinterpret_cast<char*>(&i), 2) != 2)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 2;
-
-        i = is_big_endian
-            ? qFromBigEndian<quint16>( i )
-            : qFromLittleEndian<quint16>( i );
-
-        return i == 0xffff ? NA_VALUE : i;
+    // a single integer value, NA for the invalid value of the base type
+    static fit_value_t decodeValue(FitDecode decode, const uchar *p, bool is_big_endian) {
+        switch (decode) {
+        case FitUint8: return p[0] == 0xff ? NA_VALUE : p[0];
+        case FitSint8: { qint8 i = qint8(p[0]); return i == 0x7f ? NA_VALUE : i; }
+        case FitUint8z: return p[0] == 0x00 ? NA_VALUE : p[0];
+        case FitSint16: {
+            qint16 i = is_big_endian ? qFromBigEndian<qint16>(p) : qFromLittleEndian<qint16>(p);
+            return i == 0x7fff ? NA_VALUE : i;
+        }
+        case FitUint16: {
+            quint16 i = is_big_endian ? qFromBigEndian<quint16>(p) : qFromLittleEndian<quint16>(p);
+            return i == 0xffff ? NA_VALUE : i;
+        }
+        case FitUint16z: {
+            quint16 i = is_big_endian ? qFromBigEndian<quint16>(p) : qFromLittleEndian<quint16>(p);
+            return i == 0x0000 ? NA_VALUE : i;
+        }
+        case FitSint32: {
+            qint32 i = is_big_endian ? qFromBigEndian<qint32>(p) : qFromLittleEndian<qint32>(p);
+            return i == 0x7fffffff ? NA_VALUE : i;
+        }
+        case FitUint32: {
+            quint32 i = is_big_endian ? qFromBigEndian<quint32>(p) : qFromLittleEndian<quint32>(p);
+            return i == 0xffffffff ? NA_VALUE : i;
+        }
+        case FitUint32z: {
+            quint32 i = is_big_endian ? qFromBigEndian<quint32>(p) : qFromLittleEndian<quint32>(p);
+            return i == 0x00000000 ? NA_VALUE : i;
+        }
+        default: return NA_VALUE;
+        }
     }
 
-    fit_value_t read_uint16z(bool is_big_endian, int *count = NULL) {
-        quint16 i;
-        if (file.read(reinterpret_cast<char*>(&i), 2) != 2)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 2;
-
-        i = is_big_endian
-            ? qFromBigEndian<quint16>( i )
-            : qFromLittleEndian<quint16>( i );
-
-        return i == 0x0000 ? NA_VALUE : i;
+    // float32 is always read as native
+    static fit_float_value decodeFloat(const uchar *p) {
+        float f;
+        memcpy(&f, p, 4);
+        return f;
     }
 
-    fit_value_t read_int32(bool is_big_endian, int *count = NULL) {
-        qint32 i;
-        if (file.read(reinterpret_cast<char*>(&i), 4) != 4)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 4;
+    // work out how each field of a definition is decoded
+    void compile(FitDefinition &def) {
+        def.plan.clear();
+        def.plan.reserve(def.fields.size());
+        def.length = 0;
 
-        i = is_big_endian
-            ? qFromBigEndian<qint32>( i )
-            : qFromLittleEndian<qint32>( i );
+        foreach(const FitField &field, def.fields) {
 
-        return i == 0x7fffffff ? NA_VALUE : i;
-    }
+            FitFieldPlan plan;
+            plan.offset = def.length;
+            plan.list = false;
+            plan.count = 1;
+
+            // base type, its size and whether it can be a list
+            int size = 1;
+            bool lists = true;
+            switch (field.type) {
+            case 0: // enum
+            case 2: plan.decode = FitUint8; break;
+            case 1: plan.decode = FitSint8; lists = false; break;
+            case 3: plan.decode = FitSint16; size = 2; lists = false; break;
+            case 4: plan.decode = FitUint16; size = 2; break;
+            case 5: plan.decode = FitSint32; size = 4; lists = false; break;
+            case 6: plan.decode = FitUint32; size = 4; break;
+            case 7: plan.decode = FitString; lists = false; break;
+            case 8: plan.decode = FitFloat32; size = 4; break;
+            //case 9: // FLOAT64
+            case 10: plan.decode = FitUint8z; break;
+            case 11: plan.decode = FitUint16z; size = 2; lists = false; break;
+            case 12: plan.decode = FitUint32z; size = 4; lists = false; break;
+            case 13: plan.decode = FitBytes; lists = false; break;
+
+            // we may need to add support for float64 etc here
+            default:
+                plan.decode = FitSkip;
+                unknown_base_type.insert(field.type);
+                break;
+            }
 
-    fit_value_t read_uint32(bool is_big_endian, int *count = NULL) {
-        quint32 i;
-        if (file.read(reinterpret_cast<char*>(&i), 4) != 4)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 4;
+            if (plan.decode == FitString || plan.decode == FitBytes) {
+                plan.count = field.size;
+            } else if (plan.decode != FitSkip) {
+                if (lists && field.size != size) {
+                    plan.list = true;
+                    plan.count = field.size / size;
+                } else if (field.size < size) {
+                    plan.decode = FitSkip; // too short to hold a value
+                }
+            }
 
-        i = is_big_endian
-            ? qFromBigEndian<quint32>( i )
-            : qFromLittleEndian<quint32>( i );
+            if (FIT_DEBUG && FIT_DEBUG_LEVEL>1 && field.size > size && !plan.list && plan.decode != FitString && plan.decode != FitBytes)  {
+                printf( "   warning : size=%d for type=%d (num=%d)\n", field.size, field.type, field.num);
+            }
 
-        return i == 0xffffffff ? NA_VALUE : i;
+            def.plan.push_back(plan);
+            def.length += field.size;
+        }
     }
 
-    fit_value_t read_uint32z(bool is_big_endian, int *count = NULL) {
-        quint32 i;
-        if (file.read(reinterpret_cast<char*>(&i), 4) != 4)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 4;
-
-        i = is_big_endian
-            ? qFromBigEndian<quint32>( i )
-            : qFromLittleEndian<quint32>( i );
-
-        return i == 0x00000000 ? NA_VALUE : i;
-    }
+    // decode a data message already in the buffer into values
+    void decode(const FitDefinition &def, const uchar *message) {
+        values.resize(def.plan.size());
+
+        for (size_t n = 0; n < def.plan.size(); ++n) {
+
+            const FitFieldPlan &plan = def.plan[n];
+            const uchar *p = message + plan.offset;
+            FitValue &value = values[n];
+
+            value.v = NA_VALUE;
+            value.f = 0;
+            value.s.clear();
+            value.list.clear();
+            value.size = def.fields[n].size;
+
+            if (plan.decode == FitString) {
+                value.type = StringValue;
+                for (int i = 0; i < plan.count; ++i)
+                    if (p[i] != 0) value.s += char(p[i]);
+
+            } else if (plan.decode == FitBytes) {
+                value.type = ListValue;
+                for (int i = 0; i < plan.count; ++i)
+                    value.list.append(decodeValue(FitUint8, p + i, false));
+
+            } else if (plan.decode == FitFloat32) {
+                if (plan.list) {
+                    value.type = ListValue;
+                    for (int i = 0; i < plan.count; ++i)
+                        value.list.append(decodeFloat(p + i * 4));
+                } else {
+                    value.type = FloatValue;
+                    value.f = decodeFloat(p);
+                    if (value.f != value.f) // No NAN
+                        value.f = 0;
+                }
 
-    fit_float_value read_float32(int *count = NULL) {
-        float f;
-        if (file.read(reinterpret_cast<char*>(&f), 4) != 4)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 4;
+            } else if (plan.list) {
+                int size = plan.decode == FitUint16 ? 2 : (plan.decode == FitUint32 ? 4 : 1);
+                value.type = ListValue;
+                for (int i = 0; i < plan.count; ++i)
+                    value.list.append(decodeValue(plan.decode, p + i * size, def.is_big_endian));
 
-        return f;
+            } else {
+                value.type = SingleValue;
+                value.v = decodeValue(plan.decode, p, def.is_big_endian);
+            }
+        }
     }
 
     void DumpFitValue(const FitValue& v) {
@@ -1846,9 +1899,9 @@ struct FitFileReaderState
                             offset = 0;
 
                         switch (_values.type) {
-                            case SingleValue: p_deve->number[idx]=_values.v/(float)scale+offset; break;
-                            case FloatValue: p_deve->number[idx]=_values.f/(float)scale+offset; break;
-                            case StringValue: p_deve->string[idx]=_values.s.c_str(); break;
+                            case SingleValue: p_deve->number.set(idx, _values.v/(float)scale+offset); break;
+                            case FloatValue: p_deve->number.set(idx, _values.f/(float)scale+offset); break;
+                            case StringValue: p_deve->string.set(idx, _values.s.c_str()); break;
                             default: break;
                         }
                     }
@@ -1881,9 +1934,9 @@ struct FitFileReaderState
                            p_extra = new XDataPoint();
 
                         switch (_values.type) {
-                            case SingleValue: p_extra->number[idx]=_values.v/scale+offset; break;
-                            case FloatValue: p_extra->number[idx]=_values.f/scale+offset; break;
-                            case StringValue: p_extra->string[idx]=_values.s.c_str(); break;
+                            case SingleValue: p_extra->number.set(idx, _values.v/scale+offset); break;
+                            case FloatValue: p_extra->number.set(idx, _values.f/scale+offset); break;
+                            case StringValue: p_extra->string.set(idx, _values.s.c_str()); break;
                             default: break;
                         }
                     }
@@ -2653,10 +2706,7 @@ struct FitFileReaderState
 
             data_size = read_uint32(false); // always littleEndian
             char fit_str[5];
-            if (file.read(fit_str, 4) != 4) {
-                errors << "truncated header";
-                stop = true;
-            }
+            memcpy(fit_str, take(4), 4);
             fit_str[4] = '\0';
             if (strcmp(fit_str, ".FIT") != 0) {
                 errors << QString("bad header, expected \".FIT\" but got \"%1\"").arg(fit_str);
@@ -2700,9 +2750,11 @@ struct FitFileReaderState
                 def.fields.push_back(FitField());
                 FitField &field = def.fields.back();
 
-                field.num = read_uint8(&count);
-                field.size = read_uint8(&count);
-                int base_type = read_uint8(&count);
+                // raw bytes, 255 is a valid size
+                const uchar *p = take(3, &count);
+                field.num = p[0];
+                field.size = p[1];
+                int base_type = p[2];
                 field.type = base_type & 0x1f;
                 field.deve_idx = -1;
 
@@ -2720,9 +2772,10 @@ struct FitFileReaderState
                     def.fields.push_back(FitField());
                     FitField &field = def.fields.back();
 
-                    field.num = read_uint8(&count);
-                    field.size = read_uint8(&count);
-                    field.deve_idx = read_uint8(&count);
+                    const uchar *p = take(3, &count);
+                    field.num = p[0];
+                    field.size = p[1];
+                    field.deve_idx = p[2];
 
                     QString key = QString("%1.%2").arg(field.deve_idx).arg(field.num);
                     FitDeveField devField = local_deve_fields[key];
@@ -2736,6 +2789,8 @@ struct FitFileReaderState
                     }
                 }
             }
+
+            compile(def);
         }
         else {
             // Data record
@@ -2750,150 +2805,27 @@ struct FitFileReaderState
                 local_msg_type = header_byte & 0xf;
             }
 
-            if (!local_msg_types.contains(local_msg_type)) {
+            QMap<int, FitDefinition>::const_iterator it = local_msg_types.constFind(local_msg_type);
+            if (it == local_msg_types.constEnd()) {
                 printf( "local type %d without previous definition\n", local_msg_type );
                 errors << QString("local type %1 without previous definition").arg(local_msg_type);
                 stop = true;
                 return count;
             }
-            const FitDefinition &def = local_msg_types[local_msg_type];
+            const FitDefinition &def = it.value();
 
             if (FIT_DEBUG && FIT_DEBUG_LEVEL>1)  {
                 printf( "read_record message local=%d global=%d offset=%d\n", local_msg_type,
                     def.global_msg_num, time_offset );
             }
 
-            std::vector<FitValue> values;
-            foreach(const FitField &field, def.fields) {
-                FitValue value;
-                int size;
-
-                switch (field.type) {
-                    case 0: size = 1;
-                            if (field.size==size) {
-                                value.type = SingleValue; value.v = read_uint8(&count);;
-                             } else { // Multi-values
-                                value.type = ListValue;
-                                value.list.clear();
-                                for (int i=0;i<field.size/size;i++) {
-                                    value.list.append(read_uint8(&count));
-                                }
-                                size = field.size;
-                            }
-                            break;
-                    case 1: value.type = SingleValue; value.v = read_int8(&count); size = 1;  break;
-                    case 2: size = 1;
-                            if (field.size==size) {
-                                value.type = SingleValue; value.v = read_uint8(&count);
-                            } else { // Multi-values
-                                value.type = ListValue;
-                                value.list.clear();
-                                for (int i=0;i<field.size/size;i++) {
-                                    value.list.append(read_uint8(&count));
-                                }
-                                size = field.size;
-                            }
-                            break;
-                    case 3: value.type = SingleValue; value.v = read_int16(def.is_big_endian, &count); size = 2;  break;
-                    case 4: size = 2;
-                            if (field.size==size) {
-                                value.type = SingleValue; value.v = read_uint16(def.is_big_endian, &count);
-                            } else { // Multi-values
-                                value.type = ListValue;
-                                value.list.clear();
-                                for (int i=0;i<field.size/size;i++) {
-                                    value.list.append(read_uint16(def.is_big_endian, &count));
-                                }
-                                size = field.size;
-                            }
-                            break;
-                    case 5: value.type = SingleValue; value.v = read_int32(def.is_big_endian, &count); size = 4;  break;
-                    case 6: size = 4;
-                            if (field.size==size) {
-                                value.type = SingleValue; value.v = read_uint32(def.is_big_endian, &count);
-                            } else { // Multi-values
-                                value.type = ListValue;
-                                value.list.clear();
-                                for (int i=0;i<field.size/size;i++) {
-                                    value.list.append(read_uint32(def.is_big_endian, &count));
-                                }
-                                size = field.size;
-                            }
-                            break;
-                    case 7:
-                        value.type = StringValue;
-                        value.s = read_text(field.size, &count);
-                        size = field.size;
-                        break;
-
-                    case 8: // FLOAT32
-                        size = 4;
-                        if (field.size==size) {
-                            value.type = FloatValue;
-                            value.f = read_float32(&count);
-                            if (value.f != value.f) // No NAN
-                                value.f = 0;
-                        } else { // Multi-values
-                            value.type = ListValue;
-                            value.list.clear();
-                            for (int i=0;i<field.size/size;i++) {
-                                value.list.append(read_float32(&count));
-                            }
-                            size = field.size;
-                        }
-                        break;
-
-                    //case 9: // FLOAT64
-
-                    case 10: size = 1;
-                             if (field.size==size) {
-                                value.type = SingleValue; value.v = read_uint8z(&count); size = 1;
-                             } else { // Multi-values
-                                 value.type = ListValue;
-                                 value.list.clear();
-                                 for (int i=0;i<field.size/size;i++) {
-                                     value.list.append(read_uint8z(&count));
-                                 }
-                                 size = field.size;
-                             }
-                             break;
-                    case 11: value.type = SingleValue; value.v = read_uint16z(def.is_big_endian, &count); size = 2; break;
-                    case 12: value.type = SingleValue; value.v = read_uint32z(def.is_big_endian, &count); size = 4; break;
-                    case 13: // BYTE
-                             value.type = ListValue;
-                             value.list.clear();
-                             for (int i=0;i<field.size;i++) {
-                                value.list.append(read_uint8(&count));
-                             }
-                             size = value.list.size();
-                             break;
-
-                    // we may need to add support for float, string + byte base types here
-                    default:
-                        if (FIT_DEBUG && FIT_DEBUG_LEVEL>1)  {
-                            // TODO: Dump raw data.
-                            printf("unknown type: %d size: %d \n", field.type,
-                                   field.size);
+            // the whole message is decoded from the buffer in one go
+            decode(def, take(def.length, &count));
 
-                        }
-                        if (field.size > 0) read_unknown( field.size, &count );
-                        value.type = SingleValue;
-                        value.v = NA_VALUE;
-                        unknown_base_type.insert(field.type);
-                        size = field.size;
-                }
-                // Size is greater than expected
-                if (size < field.size) {
-                    if (FIT_DEBUG && FIT_DEBUG_LEVEL>1)  {
-                         printf( "   warning : size=%d for type=%d (num=%d)\n",
-                                 field.size, field.type, field.num);
-                    }
-                    read_unknown( field.size-size, &count );
-                }
-
-                values.push_back(value);
-
-                if (FIT_DEBUG && ((FIT_DEBUG_LEVEL>2 && def.global_msg_num!=RECORD_MSG_NUM) || FIT_DEBUG_LEVEL>3 )) {
+            if (FIT_DEBUG && ((FIT_DEBUG_LEVEL>2 && def.global_msg_num!=RECORD_MSG_NUM) || FIT_DEBUG_LEVEL>3 )) {
+                for (size_t n = 0; n < def.fields.size(); ++n) {
+                    const FitField &field = def.fields[n];
+                    const FitValue &value = values[n];
                     QString nativeName = "";
                     if (def.global_msg_num == RECORD_MSG_NUM) {
                         RideFile::SeriesType series = getSeriesForNative(field.num);
@@ -2904,8 +2836,8 @@ struct FitFileReaderState
                         FitDeveField deveField = local_deve_fields[key];
                         nativeName = deveField.name.c_str();
                     }
-                    printf( " field: type=%d num=%d %s size=%d(%d) ",
-                        field.type, field.num, nativeName.toStdString().c_str(), field.size, size);
+                    printf( " field: type=%d num=%d %s size=%d ",
+                        field.type, field.num, nativeName.toStdString().c_str(), field.size);
                     if (value.type == SingleValue) {
                         if (value.v == NA_VALUE)
                             printf( "value=NA\n");
@@ -2919,7 +2851,7 @@ struct FitFileReaderState
                     else if (value.type == ListValue) {
                         printf( "values=");
                         for (int i=0;i<value.list.count();i++) {
-                            if (value.v == NA_VALUE)
+                            if (value.list.at(i) == NA_VALUE)
                                 printf( "NA,");
                             else
                                 printf( "%lld,", value.list.at(i) );
@@ -3060,6 +2992,17 @@ struct FitFileReaderState
             return NULL;
         }
 
+        // decode straight from the file mapped into memory, or
+        // read it all in one go if it can't be, closing unmaps it
+        length = file.size();
+        buffer = length > 0 ? file.map(0, length) : NULL;
+        if (buffer == NULL) {
+            bytes = file.readAll();
+            buffer = reinterpret_cast<const uchar*>(bytes.constData());
+            length = bytes.size();
+        }
+        pos = 0;
+
         int data_size = 0;
         weatherXdata = new XDataSeries();
         weatherXdata->name = "WEATHER";
@@ -3144,7 +3087,7 @@ struct FitFileReaderState
 
                 // second file ?
                 try {
-                    while (file.canReadLine()) {
+                    while (length - pos >= 12 && memcmp(buffer + pos + 8, ".FIT", 4) == 0) {
                         read_header(stop, errors, data_size);
                         if (!stop) {
 
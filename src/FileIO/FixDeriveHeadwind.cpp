@@ -123,7 +123,7 @@ FixDeriveHeadwind::postProcess(RideFile *ride, DataProcessorConfig *config=0, QS
 
     int b=0;
     double windspeed = 0.0, windheading = 0.0;
-    ride->dataPoints().at(0)->headwind = ride->dataPoints().at(0)->kph;
+    ride->setPointValue(0, RideFile::headwind, ride->dataPoints().at(0)->kph);
 
     for (int i=1; i<ride->dataPoints().count(); i++) {
         RideFilePoint *point = ride->dataPoints()[i];
@@ -151,7 +151,7 @@ FixDeriveHeadwind::postProcess(RideFile *ride, DataProcessorConfig *config=0, QS
         double headwind = cos(bearing - (windheading/ 180.0 * PI)) * (windspeed) + point->kph;
         //qDebug() << point->kph << headwind  << "(" << windspeed << windheading << ")";
 
-        point->headwind = headwind;
+        ride->setPointValue(i, RideFile::headwind, headwind);
     }
 
     ride->setDataPresent(ride->headwind, true);
@@ -324,8 +324,7 @@ FixDerivePower::postProcess(RideFile *ride, DataProcessorConfig *config=0, QStri
         // now run backwards setting the rolling average
         for (int i=ride->dataPoints().count()-1; i>=smoothPoints; i--) {
             double here = ride->dataPoints()[i]->watts;
-            ride->dataPoints()[i]->watts = rtot / smoothPoints;
-            if (ride->dataPoints()[i]->watts<0) ride->dataPoints()[i]->watts = 0;
+            ride->setPointValue(i, RideFile::watts, qMax(0.0, rtot / smoothPoints));
                 rtot -= here;
                 rtot += ride->dataPoints()[i-smoothPoints]->watts;
         }
@@ -94,9 +94,9 @@ FixRunningCadence::postProcess(RideFile *ride, DataProcessorConfig *config=0, QS
         RideFilePoint *p = ride->dataPoints()[i];
 
         if (p->cad > 0)
-            p->cad = p->cad / 2;
+            ride->setPointValue(i, RideFile::cad, p->cad / 2);
         if (p->rcad > 0)
-            p->rcad = p->rcad / 2;
+            ride->setPointValue(i, RideFile::rcad, p->rcad / 2);
     }
     ride->command->endLUW();
 
@@ -38,6 +38,10 @@ struct JsonFileReader : public RideFileReader {
     QByteArray toByteArray(Context *context, const RideFile *ride, bool withAlt, bool withWatts, bool withHr, bool withCad) const;
     bool writeRideFile(Context *context, const RideFile *ride, QFile &file) const;
     bool hasWrite() const { return true; }
+
+    // the flex/bison parser on its own, openRideFile() only uses it when
+    // JsonRideFileStream can't read the file
+    static RideFile *parseGrammar(QString contents, QStringList &errors);
 };
 
 #endif // _JsonRideFile_h
@@ -35,6 +35,7 @@
 // in writeRideFile below, this is NOT a generic json parser.
 
 #include "JsonRideFile.h"
+#include "JsonRideFileStream.h"
 
 // now we have a reentrant parser we save context data
 // in a structure rather than in global variables -- so
@@ -101,6 +102,15 @@ static QString protect(const QString string)
     return s;
 }
 
+// , "KEY":value
+static inline void field(QByteArray &out, const char *key, double value, char format='g', int precision=6)
+{
+    out += ", \"";
+    out += key;
+    out += "\":";
+    JsonRideFileStream::number(out, value, format, precision);
+}
+
 // extract scanner from the context
 #define scanner jc->scanner
 
@@ -300,7 +310,8 @@ xdata_value:
         SECS ':' number                         { jc->xdatapoint.secs = jc->JsonNumber; }
         | KM ':' number                         { jc->xdatapoint.km = jc->JsonNumber; }
         | VALUE ':' number                      { jc->xdatapoint.number[0] = jc->JsonNumber; }
-        | VALUES ':' '[' number_list ']'        { for(int i=0; i<jc->numberlist.count() && i<XDATA_MAXVALUES; i++)
+        | VALUES ':' '[' number_list ']'        { jc->xdatapoint.number.resize(qMin(jc->numberlist.count(), XDATA_MAXVALUES));
+                                                  for(int i=0; i<jc->numberlist.count() && i<XDATA_MAXVALUES; i++)
                                                       jc->xdatapoint.number[i]= jc->numberlist[i];
                                                   jc->numberlist.clear(); }
         | string ':' number                     { /* ignored for future compatibility */ }
@@ -398,6 +409,28 @@ static int jsonFileReaderRegistered =
 RideFile *
 JsonFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
 {
+    // Nearly all files are as we wrote them, so read them straight from
+    // the bytes (mapped if we can) with the streaming reader first
+    if (file.exists() && file.open(QFile::ReadOnly)) {
+
+        RideFile *returning = NULL;
+        qint64 size = file.size();
+        uchar *mapped = size > 0 ? file.map(0, size) : NULL;
+        if (mapped) {
+            returning = JsonRideFileStream::read(reinterpret_cast<const char*>(mapped), size);
+            file.unmap(mapped);
+        } else {
+            QByteArray bytes = file.readAll();
+            returning = JsonRideFileStream::read(bytes.constData(), bytes.size());
+        }
+        file.close();
+
+        if (returning) return returning;
+    }
+
+    // Anything it doesn't understand, old Latin-1 files, hand edited files
+    // and the like, goes through the grammar as it always has.
+    //
     // Read the entire file into a QString -- we avoid using fopen since it
     // doesn't handle foreign characters well. Instead we use QFile and parse
     // from a QString
@@ -428,6 +461,12 @@ JsonFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*
         return NULL; 
     }
 
+    return parseGrammar(contents, errors);
+}
+
+RideFile *
+JsonFileReader::parseGrammar(QString contents, QStringList &errors)
+{
     // create scanner context for reentrant parsing
     JsonContext *jc = new JsonContext;
     JsonRideFilelex_init(&scanner);
@@ -611,6 +650,7 @@ JsonFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool
         out += ",\n\t\t\"SAMPLES\":[\n";
         bool first = true;
 
+        const RideFileDataPresent *present = ride->areDataPresent();
         foreach (RideFilePoint *p, ride->dataPoints()) {
 
             if (first) first=false;
@@ -619,42 +659,41 @@ JsonFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool
             out += "\t\t\t{ ";
 
             // always store time
-            out += "\"SECS\":" + QString("%1").arg(p->secs);
-
-            if (ride->areDataPresent()->km) out += ", \"KM\":" + QString("%1").arg(p->km);
-            if (ride->areDataPresent()->watts && withWatts) out += ", \"WATTS\":" + QString("%1").arg(p->watts);
-            if (ride->areDataPresent()->nm) out += ", \"NM\":" + QString("%1").arg(p->nm);
-            if (ride->areDataPresent()->cad && withCad) out += ", \"CAD\":" + QString("%1").arg(p->cad);
-            if (ride->areDataPresent()->kph) out += ", \"KPH\":" + QString("%1").arg(p->kph);
-            if (ride->areDataPresent()->hr && withHr) out += ", \"HR\":"  + QString("%1").arg(p->hr);
-            if (ride->areDataPresent()->alt && withAlt) out += ", \"ALT\":" + QString("%1").arg(p->alt);
-            if (ride->areDataPresent()->lat)
-                out += ", \"LAT\":" + QString("%1").arg(p->lat, 0, 'g', 11);
-            if (ride->areDataPresent()->lon)
-                out += ", \"LON\":" + QString("%1").arg(p->lon, 0, 'g', 11);
-            if (ride->areDataPresent()->headwind) out += ", \"HEADWIND\":" + QString("%1").arg(p->headwind);
-            if (ride->areDataPresent()->slope) out += ", \"SLOPE\":" + QString("%1").arg(p->slope);
-            if (ride->areDataPresent()->temp && p->temp != RideFile::NA) out += ", \"TEMP\":" + QString("%1").arg(p->temp);
-            if (ride->areDataPresent()->lrbalance && p->lrbalance != RideFile::NA) out += ", \"LRBALANCE\":" + QString("%1").arg(p->lrbalance);
-            if (ride->areDataPresent()->lte) out += ", \"LTE\":" + QString("%1").arg(p->lte);
-            if (ride->areDataPresent()->rte) out += ", \"RTE\":" + QString("%1").arg(p->rte);
-            if (ride->areDataPresent()->lps) out += ", \"LPS\":" + QString("%1").arg(p->lps);
-            if (ride->areDataPresent()->rps) out += ", \"RPS\":" + QString("%1").arg(p->rps);
-            if (ride->areDataPresent()->lpco) out += ", \"LPCO\":" + QString("%1").arg(p->lpco);
-            if (ride->areDataPresent()->rpco) out += ", \"RPCO\":" + QString("%1").arg(p->rpco);
-            if (ride->areDataPresent()->lppb) out += ", \"LPPB\":" + QString("%1").arg(p->lppb);
-            if (ride->areDataPresent()->rppb) out += ", \"RPPB\":" + QString("%1").arg(p->rppb);
-            if (ride->areDataPresent()->lppe) out += ", \"LPPE\":" + QString("%1").arg(p->lppe);
-            if (ride->areDataPresent()->rppe) out += ", \"RPPE\":" + QString("%1").arg(p->rppe);
-            if (ride->areDataPresent()->lpppb) out += ", \"LPPPB\":" + QString("%1").arg(p->lpppb);
-            if (ride->areDataPresent()->rpppb) out += ", \"RPPPB\":" + QString("%1").arg(p->rpppb);
-            if (ride->areDataPresent()->lpppe) out += ", \"LPPPE\":" + QString("%1").arg(p->lpppe);
-            if (ride->areDataPresent()->rpppe) out += ", \"RPPPE\":" + QString("%1").arg(p->rpppe);
-            if (ride->areDataPresent()->smo2) out += ", \"SMO2\":" + QString("%1").arg(p->smo2);
-            if (ride->areDataPresent()->thb) out += ", \"THB\":" + QString("%1").arg(p->thb);
-            if (ride->areDataPresent()->rcad) out += ", \"RCAD\":" + QString("%1").arg(p->rcad);
-            if (ride->areDataPresent()->rvert) out += ", \"RVERT\":" + QString("%1").arg(p->rvert);
-            if (ride->areDataPresent()->rcontact) out += ", \"RCON\":" + QString("%1").arg(p->rcontact);
+            out += "\"SECS\":";
+            JsonRideFileStream::number(out, p->secs);
+
+            if (present->km) field(out, "KM", p->km);
+            if (present->watts && withWatts) field(out, "WATTS", p->watts);
+            if (present->nm) field(out, "NM", p->nm);
+            if (present->cad && withCad) field(out, "CAD", p->cad);
+            if (present->kph) field(out, "KPH", p->kph);
+            if (present->hr && withHr) field(out, "HR", p->hr);
+            if (present->alt && withAlt) field(out, "ALT", p->alt);
+            if (present->lat) field(out, "LAT", p->lat, 'g', 11);
+            if (present->lon) field(out, "LON", p->lon, 'g', 11);
+            if (present->headwind) field(out, "HEADWIND", p->headwind);
+            if (present->slope) field(out, "SLOPE", p->slope);
+            if (present->temp && p->temp != RideFile::NA) field(out, "TEMP", p->temp);
+            if (present->lrbalance && p->lrbalance != RideFile::NA) field(out, "LRBALANCE", p->lrbalance);
+            if (present->lte) field(out, "LTE", p->lte);
+            if (present->rte) field(out, "RTE", p->rte);
+            if (present->lps) field(out, "LPS", p->lps);
+            if (present->rps) field(out, "RPS", p->rps);
+            if (present->lpco) field(out, "LPCO", p->lpco);
+            if (present->rpco) field(out, "RPCO", p->rpco);
+            if (present->lppb) field(out, "LPPB", p->lppb);
+            if (present->rppb) field(out, "RPPB", p->rppb);
+            if (present->lppe) field(out, "LPPE", p->lppe);
+            if (present->rppe) field(out, "RPPE", p->rppe);
+            if (present->lpppb) field(out, "LPPPB", p->lpppb);
+            if (present->rpppb) field(out, "RPPPB", p->rpppb);
+            if (present->lpppe) field(out, "LPPPE", p->lpppe);
+            if (present->rpppe) field(out, "RPPPE", p->rpppe);
+            if (present->smo2) field(out, "SMO2", p->smo2);
+            if (present->thb) field(out, "THB", p->thb);
+            if (present->rcad) field(out, "RCAD", p->rcad);
+            if (present->rvert) field(out, "RVERT", p->rvert);
+            if (present->rcontact) field(out, "RCON", p->rcontact);
 
             // sample points in here!
             out += " }";
@@ -720,38 +759,44 @@ JsonFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool
             if (series->datapoints.count()) {
                 out += ",\n\t\t\t\"SAMPLES\" : [\n";
 
+                // how each value is written, the gps values have fixed decimals
+                QVector<char> formats(series->valuename.count(), 'g');
+                QVector<int> precisions(series->valuename.count(), 6);
+                for(int i=0; i<series->valuename.count(); i++) {
+                    if (series->valuename[i].contains("gpsAltitude", Qt::CaseSensitive)) {
+                        formats[i] = 'f'; precisions[i] = 1;
+                    } else if (series->valuename[i].contains("gpsSpeed", Qt::CaseSensitive)) {
+                        formats[i] = 'f'; precisions[i] = 3;
+                    } else if (series->valuename[i].contains("gpsLatitude", Qt::CaseSensitive) ||
+                               series->valuename[i].contains("gpsLongitude", Qt::CaseSensitive)) {
+                        formats[i] = 'f'; precisions[i] = 11;
+                    }
+                }
+
                 bool firsts=true;
                 foreach(XDataPoint *p, series->datapoints) {
                     if (!firsts) out += ",\n";
 
+                    out += "\t\t\t\t{ \"SECS\":";
+                    JsonRideFileStream::number(out, p->secs);
+                    out += ", \"KM\":";
+                    JsonRideFileStream::number(out, p->km);
+
                     // multi value sample
                     if (series->valuename.count()>1) {
 
-                        out += "\t\t\t\t{ \"SECS\":"+QString("%1").arg(p->secs) +", "
-                            + "\"KM\":"+QString("%1").arg(p->km) + ", "
-                            + "\"VALUES\":[ ";
-
-                        bool firstvv=true;
+                        out += ", \"VALUES\":[ ";
                         for(int i=0; i<series->valuename.count(); i++) {
-                            if (!firstvv) out += ", ";
-                            if (series->valuename[i].contains("gpsAltitude", Qt::CaseSensitive))
-                                out += QString("%1").arg(p->number[i], 0, 'f', 1);
-                            else if (series->valuename[i].contains("gpsSpeed", Qt::CaseSensitive))
-                                out += QString("%1").arg(p->number[i], 0, 'f', 3);
-                            else if (series->valuename[i].contains("gpsLatitude", Qt::CaseSensitive) ||
-                                    series->valuename[i].contains("gpsLongitude", Qt::CaseSensitive))
-                                out += QString("%1").arg(p->number[i], 0, 'f', 11);
-                            else
-                                out += QString("%1").arg(p->number[i]);
-                            firstvv=false;
+                            if (i) out += ", ";
+                            JsonRideFileStream::number(out, p->number[i], formats[i], precisions[i]);
                          }
                          out += " ] }";
 
                     } else {
 
-                        out += "\t\t\t\t{ \"SECS\":"+QString("%1").arg(p->secs) + ", "
-                            + "\"KM\":"+QString("%1").arg(p->km) + ", "
-                            + "\"VALUE\":" + QString("%1").arg(p->number[0]) + " }";
+                        out += ", \"VALUE\":";
+                        JsonRideFileStream::number(out, p->number[0]);
+                        out += " }";
                     }
                     firsts = false;
                 }
@@ -0,0 +1,790 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "JsonRideFileStream.h"
+#include "JsonRideFile.h" // DATETIME_FORMAT and unescaping
+#include "RideFile.h"
+
+#include <QHash>
+#include <QMap>
+#include <QDateTime>
+#include <QColor>
+#include <QVarLengthArray>
+#include <cmath>
+#include <string.h>
+
+// the quoted names the lexer returns as tokens, anything from
+// KeySeries on is a sample series in seriesKeys[] below
+enum JsonKey { KeyRide, KeyStartTime, KeyRecIntSecs, KeyDeviceType, KeyIdentifier,
+               KeyOverrides, KeyTags, KeyIntervals, KeyName, KeyStart, KeyStop,
+               KeyTest, KeyColor, KeyCalibrations, KeyValue, KeyValues, KeyUnit,
+               KeyUnits, KeyXData, KeyReferences, KeySamples, KeySeries };
+
+static const char *keyNames[] = { "RIDE", "STARTTIME", "RECINTSECS", "DEVICETYPE", "IDENTIFIER",
+                                  "OVERRIDES", "TAGS", "INTERVALS", "NAME", "START", "STOP",
+                                  "PTEST", "COLOR", "CALIBRATIONS", "VALUE", "VALUES", "UNIT",
+                                  "UNITS", "XDATA", "REFERENCES", "SAMPLES" };
+
+static const struct {
+    const char *name;
+    double RideFilePoint::*value;
+} seriesKeys[] = {
+    { "SECS", &RideFilePoint::secs },
+    { "KM", &RideFilePoint::km },
+    { "WATTS", &RideFilePoint::watts },
+    { "NM", &RideFilePoint::nm },
+    { "CAD", &RideFilePoint::cad },
+    { "KPH", &RideFilePoint::kph },
+    { "HR", &RideFilePoint::hr },
+    { "ALT", &RideFilePoint::alt },
+    { "LAT", &RideFilePoint::lat },
+    { "LON", &RideFilePoint::lon },
+    { "HEADWIND", &RideFilePoint::headwind },
+    { "SLOPE", &RideFilePoint::slope },
+    { "TEMP", &RideFilePoint::temp },
+    { "LRBALANCE", &RideFilePoint::lrbalance },
+    { "LTE", &RideFilePoint::lte },
+    { "RTE", &RideFilePoint::rte },
+    { "LPS", &RideFilePoint::lps },
+    { "RPS", &RideFilePoint::rps },
+    { "LPCO", &RideFilePoint::lpco },
+    { "RPCO", &RideFilePoint::rpco },
+    { "LPPB", &RideFilePoint::lppb },
+    { "RPPB", &RideFilePoint::rppb },
+    { "LPPE", &RideFilePoint::lppe },
+    { "RPPE", &RideFilePoint::rppe },
+    { "LPPPB", &RideFilePoint::lpppb },
+    { "RPPPB", &RideFilePoint::rpppb },
+    { "LPPPE", &RideFilePoint::lpppe },
+    { "RPPPE", &RideFilePoint::rpppe },
+    { "SMO2", &RideFilePoint::smo2 },
+    { "THB", &RideFilePoint::thb },
+    { "RCON", &RideFilePoint::rcontact },
+    { "RVERT", &RideFilePoint::rvert },
+    { "RCAD", &RideFilePoint::rcad }
+};
+static const int seriesCount = sizeof(seriesKeys) / sizeof(seriesKeys[0]);
+
+static QHash<QByteArray, int>
+keywordTable()
+{
+    QHash<QByteArray, int> returning;
+    for (int i=0; i<KeySeries; i++) returning.insert(keyNames[i], i);
+    for (int i=0; i<seriesCount; i++) returning.insert(seriesKeys[i].name, KeySeries + i);
+    return returning;
+}
+
+// rides are read on several threads at once when refreshing
+static const QHash<QByteArray, int> &
+keywords()
+{
+    static const QHash<QByteArray, int> returning = keywordTable();
+    return returning;
+}
+
+static inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+//
+// Numbers - the lexer passes integers to QString::toInt() and floats
+// to QString::toDouble(). Floats that fit in a double exactly, up to
+// 15 digits and a power of ten up to 22, give the same correctly
+// rounded answer with a single multiply or divide, the rest go through
+// Qt as before.
+//
+static bool
+fastDouble(const char *s, const char *e, double &value)
+{
+    bool negative = false;
+    if (s < e && *s == '-') {
+        negative = true;
+        s++;
+    }
+
+    quint64 mantissa = 0;
+    int digits = 0, exponent = 0;
+    const char *start = s;
+    for (; s < e && isDigit(*s); s++) {
+        mantissa = mantissa * 10 + (*s - '0');
+        if (mantissa) digits++;
+        if (digits > 15) return false;
+    }
+    if (s == start) return false;
+
+    if (s < e && *s == '.') {
+        const char *fraction = ++s;
+        for (; s < e && isDigit(*s); s++) {
+            mantissa = mantissa * 10 + (*s - '0');
+            if (mantissa) digits++;
+            if (digits > 15) return false;
+            exponent--;
+        }
+        if (s == fraction) return false;
+    }
+
+    if (s < e && *s == 'e') {
+        s++;
+        bool negativeExponent = false;
+        if (s < e && (*s == '-' || *s == '+')) negativeExponent = *s++ == '-';
+        const char *power = s;
+        int x = 0;
+        for (; s < e && isDigit(*s); s++) {
+            x = x * 10 + (*s - '0');
+            if (x > 400) return false;
+        }
+        if (s == power) return false;
+        exponent += negativeExponent ? -x : x;
+    }
+    if (s != e) return false;
+
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    double d = double(mantissa);
+    if (exponent > 22 || exponent < -22) return false;
+    if (exponent > 0) d *= powers[exponent];
+    else if (exponent < 0) d /= powers[-exponent];
+
+    value = negative ? -d : d;
+    return true;
+}
+
+JsonRideFileStream::JsonRideFileStream(const char *data, qint64 length) :
+    p(data), end(data + length), rideFile(NULL), token(End), text(NULL), length(0),
+    keyword(-1), punctuation(0), escaped(false), ascii(true)
+{
+    // GC .JSON is stored in UTF-8 with BOM(Byte order mark) for identification
+    if (length >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0) p += 3;
+}
+
+RideFile *
+JsonRideFileStream::read(const char *data, qint64 length)
+{
+    JsonRideFileStream stream(data, length);
+    stream.rideFile = new RideFile;
+
+    if (stream.document()) return stream.rideFile;
+
+    delete stream.rideFile;
+    return NULL;
+}
+
+//
+// SCANNER
+//
+// the same tokens as the lexer, except that strings end at the first
+// unescaped quote as they do in json
+//
+void
+JsonRideFileStream::advance()
+{
+    while (p < end && (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r')) p++;
+    if (p >= end) {
+        token = End;
+        return;
+    }
+
+    char c = *p;
+    switch (c) {
+
+    case '"':
+    {
+        const char *start = ++p;
+        escaped = false;
+        ascii = true;
+        while (p < end && *p != '"') {
+            if (*p == '\\') {
+                escaped = true;
+                if (++p >= end) break;
+            } else if (uchar(*p) >= 0x80) {
+                ascii = false;
+            } else if (*p == '\r') {
+                // the grammar reads in text mode, leave it to that
+                break;
+            }
+            p++;
+        }
+        if (p >= end || *p != '"') {
+            token = Bad;
+            return;
+        }
+        text = start;
+        length = p++ - start;
+
+        keyword = -1;
+        if (!escaped && ascii && length <= 12)
+            keyword = keywords().value(QByteArray::fromRawData(text, length), -1);
+        token = keyword >= 0 ? Keyword : String;
+        return;
+    }
+
+    case '{': case '}': case '[': case ']': case ':': case ',':
+        token = Punctuation;
+        punctuation = c;
+        p++;
+        return;
+
+    default:
+        if (c == '-' || c == '+' || isDigit(c)) {
+            text = p;
+            if (c == '-' || c == '+') p++;
+            const char *digits = p;
+            while (p < end && isDigit(*p)) p++;
+            if (p == digits) {
+                token = Bad;
+                return;
+            }
+
+            token = Integer;
+            if (p < end && *p == '.') {
+                // [-+]?[0-9]+\.[-+e0-9]*
+                for (p++; p < end && (isDigit(*p) || *p == '-' || *p == '+' || *p == 'e'); p++) ;
+                token = Float;
+            } else if (end - p > 2 && p[0] == 'e' && p[1] == '-' && isDigit(p[2])) {
+                // [-+]?[0-9]+e-[0-9]+
+                for (p += 2; p < end && isDigit(*p); p++) ;
+                token = Float;
+            }
+            length = p - text;
+            return;
+        }
+        token = Bad;
+        return;
+    }
+}
+
+bool
+JsonRideFileStream::peek(char c)
+{
+    return token == Punctuation && punctuation == c;
+}
+
+bool
+JsonRideFileStream::expect(char c)
+{
+    if (!peek(c)) return false;
+    advance();
+    return true;
+}
+
+bool
+JsonRideFileStream::number(double &value)
+{
+    if (token == Integer) {
+
+        // toInt() is 0 if it doesn't fit
+        const char *s = text, *e = text + length;
+        bool negative = *s == '-';
+        if (*s == '-' || *s == '+') s++;
+        qint64 n = 0;
+        for (; s < e && n <= 0x80000000LL; s++) n = n * 10 + (*s - '0');
+        if (negative) n = -n;
+        value = (n >= -2147483647LL - 1 && n <= 2147483647LL) ? double(n) : 0;
+
+    } else if (token == Float) {
+
+        if (!fastDouble(text, text + length, value))
+            value = QByteArray::fromRawData(text, length).toDouble();
+
+    } else return false;
+
+    advance();
+    return true;
+}
+
+bool
+JsonRideFileStream::string(QString &value)
+{
+    if (token != String && token != Keyword) return false;
+
+    int n = length;
+
+    // strings are written with a trailing space to avoid
+    // conflicting with the tokens, see protect()
+    if (n && text[n-1] == ' ') n--;
+
+    if (ascii) {
+        value = QString::fromLatin1(text, n);
+    } else {
+        // old files were Latin-1, the grammar works those out
+        value = QString::fromUtf8(text, n);
+        if (value.contains(QChar::ReplacementCharacter)) return false;
+    }
+    if (escaped) value = Utils::RidefileUnEscape(value.midRef(0));
+
+    advance();
+    return true;
+}
+
+//
+// GRAMMAR
+//
+// follows JsonRideFile.y, but lists can be empty and fields can come
+// in any order, anything else gives up
+//
+bool
+JsonRideFileStream::document()
+{
+    advance();
+
+    // We allow a .json file to be encapsulated within optional braces
+    bool braces = expect('{');
+
+    // multiple rides in a single file are supported, rides will be joined
+    do {
+        if (!ride()) return false;
+    } while (expect(','));
+
+    if (braces && !expect('}')) return false;
+    return token == End;
+}
+
+bool
+JsonRideFileStream::ride()
+{
+    if (token != Keyword || keyword != KeyRide) return false;
+    advance();
+    if (!expect(':') || !expect('{')) return false;
+
+    do {
+        if (!element()) return false;
+    } while (expect(','));
+
+    return expect('}');
+}
+
+bool
+JsonRideFileStream::element()
+{
+    if (token != Keyword) return false;
+    int key = keyword;
+    advance();
+    if (!expect(':')) return false;
+
+    QString value;
+    double number;
+    switch (key) {
+
+    case KeyStartTime:
+    {
+        if (!string(value)) return false;
+        QDateTime aslocal = QDateTime::fromString(value, DATETIME_FORMAT);
+        QDateTime asUTC = QDateTime(aslocal.date(), aslocal.time(), Qt::UTC);
+        rideFile->setStartTime(asUTC.toLocalTime());
+        return true;
+    }
+    case KeyRecIntSecs:
+        if (!this->number(number)) return false;
+        rideFile->setRecIntSecs(number);
+        return true;
+
+    case KeyDeviceType:
+        if (!string(value)) return false;
+        rideFile->setDeviceType(value);
+        return true;
+
+    case KeyIdentifier:
+        if (!string(value)) return false;
+        rideFile->setId(value);
+        return true;
+
+    case KeyOverrides: return overrides();
+    case KeyTags: return tags();
+    case KeyIntervals: return intervals();
+    case KeyCalibrations: return calibrations();
+    case KeyReferences: return references();
+    case KeySamples: return samples();
+    case KeyXData: return xdata();
+    default: return false;
+    }
+}
+
+bool
+JsonRideFileStream::overrides()
+{
+    if (!expect('[')) return false;
+    while (!peek(']')) {
+
+        QString name;
+        QMap<QString, QString> values;
+        if (!expect('{') || !string(name) || !expect(':') || !expect('{')) return false;
+        while (!peek('}')) {
+            QString key, value;
+            if (!string(key) || !expect(':') || !string(value)) return false;
+            values.insert(key, value);
+            if (!expect(',')) break;
+        }
+        if (!expect('}') || !expect('}')) return false;
+
+        // we renamed time riding to time moving ...
+        if (name == "Time Riding") name = "Time Moving";
+        rideFile->metricOverrides.insert(name, values);
+
+        if (!expect(',')) break;
+    }
+    return expect(']');
+}
+
+bool
+JsonRideFileStream::tags()
+{
+    if (!expect('{')) return false;
+    while (!peek('}')) {
+        QString key, value;
+        if (!string(key) || !expect(':') || !string(value)) return false;
+
+        // we renamed time riding to time moving ...
+        if (key == "Time Riding") key = "Time Moving";
+        rideFile->setTag(key, value);
+
+        if (!expect(',')) break;
+    }
+    return expect('}');
+}
+
+bool
+JsonRideFileStream::intervals()
+{
+    if (!expect('[')) return false;
+    while (!peek(']')) {
+
+        RideFileInterval interval;
+        QString value;
+        if (!expect('{')) return false;
+        while (!peek('}')) {
+            if (token != Keyword) return false;
+            int key = keyword;
+            advance();
+            if (!expect(':')) return false;
+
+            switch (key) {
+            case KeyName: if (!string(interval.name)) return false; break;
+            case KeyStart: if (!number(interval.start)) return false; break;
+            case KeyStop: if (!number(interval.stop)) return false; break;
+            case KeyColor: if (!string(value)) return false; interval.color.setNamedColor(value); break;
+            case KeyTest: if (!string(value)) return false; interval.test = (value == "true"); break;
+            default: return false;
+            }
+            if (!expect(',')) break;
+        }
+        if (!expect('}')) return false;
+
+        rideFile->addInterval(RideFileInterval::USER, interval.start, interval.stop,
+                              interval.name, interval.color, interval.test);
+
+        if (!expect(',')) break;
+    }
+    return expect(']');
+}
+
+bool
+JsonRideFileStream::calibrations()
+{
+    if (!expect('[')) return false;
+    while (!peek(']')) {
+
+        RideFileCalibration calibration;
+        double value;
+        if (!expect('{')) return false;
+        while (!peek('}')) {
+            if (token != Keyword) return false;
+            int key = keyword;
+            advance();
+            if (!expect(':')) return false;
+
+            switch (key) {
+            case KeyName: if (!string(calibration.name)) return false; break;
+            case KeyStart: if (!number(calibration.start)) return false; break;
+            case KeyValue: if (!number(value)) return false; calibration.value = value; break;
+            default: return false;
+            }
+            if (!expect(',')) break;
+        }
+        if (!expect('}')) return false;
+
+        rideFile->addCalibration(calibration.start, calibration.value, calibration.name);
+
+        if (!expect(',')) break;
+    }
+    return expect(']');
+}
+
+// the fields of a sample, unknown fields are ignored for future compatibility
+// references are written without commas between the fields
+bool
+JsonRideFileStream::series(RideFilePoint &point, bool commas)
+{
+    while (!peek('}')) {
+
+        if (token == Keyword && keyword >= KeySeries) {
+            double RideFilePoint::*value = seriesKeys[keyword - KeySeries].value;
+            advance();
+            if (!expect(':') || !number(point.*value)) return false;
+
+        } else if (token == String) {
+            advance();
+            if (!expect(':')) return false;
+            double number;
+            QString string;
+            if (!this->number(number) && !this->string(string)) return false;
+
+        } else return false;
+
+        if (!expect(',') && commas) break;
+    }
+    return true;
+}
+
+bool
+JsonRideFileStream::references()
+{
+    if (!expect('[')) return false;
+    while (!peek(']')) {
+        RideFilePoint point;
+        if (!expect('{') || !series(point, false) || !expect('}')) return false;
+        rideFile->appendReference(point);
+        if (!expect(',')) break;
+    }
+    return expect(']');
+}
+
+bool
+JsonRideFileStream::samples()
+{
+    if (!expect('[')) return false;
+
+    // count the samples to make room for them, they are all
+    // objects without arrays so it ends at the first ]
+    const char *close = static_cast<const char*>(memchr(p, ']', end - p));
+    if (close) {
+        int count = 1;
+        for (const char *brace = p; (brace = static_cast<const char*>(memchr(brace, '{', close - brace))); brace++)
+            count++;
+        rideFile->reservePoints(rideFile->dataPoints().count() + count);
+    }
+
+    while (!peek(']')) {
+        RideFilePoint point;
+        if (!expect('{') || !series(point, true) || !expect('}')) return false;
+        rideFile->appendPoint(point);
+        if (!expect(',')) break;
+    }
+    return expect(']');
+}
+
+bool
+JsonRideFileStream::xdata()
+{
+    if (!expect('[')) return false;
+    while (!peek(']')) {
+        if (!xdataSeries()) return false;
+        if (!expect(',')) break;
+    }
+    return expect(']');
+}
+
+bool
+JsonRideFileStream::xdataSeries()
+{
+    if (!expect('{')) return false;
+
+    XDataSeries *series = new XDataSeries;
+    while (!peek('}')) {
+
+        bool ok = token == Keyword;
+        int key = keyword;
+        if (ok) advance();
+        ok = ok && expect(':');
+
+        if (ok) {
+            QString value;
+            switch (key) {
+            case KeyName: ok = string(series->name); break;
+            case KeyValue: ok = string(value); series->valuename << value; break;
+            case KeyUnit: ok = string(value); series->unitname << value; break;
+
+            case KeyValues:
+            case KeyUnits:
+            {
+                QStringList list;
+                ok = expect('[');
+                while (ok && !peek(']')) {
+                    ok = string(value);
+                    list << value;
+                    if (!expect(',')) break;
+                }
+                ok = ok && expect(']');
+                if (key == KeyValues) series->valuename = list;
+                else series->unitname = list;
+                break;
+            }
+
+            case KeySamples:
+                ok = expect('[');
+                while (ok && !peek(']')) {
+                    ok = xdataSample(series);
+                    if (!expect(',')) break;
+                }
+                ok = ok && expect(']');
+                break;
+
+            default: ok = false;
+            }
+        }
+
+        if (!ok) {
+            delete series;
+            return false;
+        }
+        if (!expect(',')) break;
+    }
+
+    if (!expect('}')) {
+        delete series;
+        return false;
+    }
+    rideFile->addXData(series->name, series);
+    return true;
+}
+
+bool
+JsonRideFileStream::xdataSample(XDataSeries *series)
+{
+    if (!expect('{')) return false;
+
+    XDataPoint *point = series->newPoint();
+    bool ok = true;
+    while (ok && !peek('}')) {
+
+        if (token == Keyword) {
+            int key = keyword;
+            advance();
+            ok = expect(':');
+
+            switch (key) {
+            case KeySeries + 0: ok = ok && number(point->secs); break; // SECS
+            case KeySeries + 1: ok = ok && number(point->km); break; // KM
+            case KeyValue:
+            {
+                double value;
+                ok = ok && number(value);
+                if (ok) point->number.set(0, value);
+                break;
+            }
+            case KeyValues:
+            {
+                QVarLengthArray<double, 16> values;
+                ok = ok && expect('[');
+                while (ok && !peek(']')) {
+                    double value;
+                    ok = number(value);
+                    values.append(value);
+                    if (!expect(',')) break;
+                }
+                ok = ok && expect(']');
+                if (ok) {
+                    int n = qMin(values.count(), XDATA_MAXVALUES);
+                    point->number.resize(n);
+                    for (int i=0; i<n; i++) point->number[i] = values[i];
+                }
+                break;
+            }
+            default: ok = false;
+            }
+
+        } else if (token == String) {
+
+            // ignored for future compatibility
+            advance();
+            double number;
+            QString string;
+            ok = expect(':') && (this->number(number) || this->string(string));
+
+        } else ok = false;
+
+        if (ok && !expect(',')) break;
+    }
+
+    if (!ok || !expect('}')) {
+        delete point;
+        return false;
+    }
+    series->datapoints.append(point);
+    return true;
+}
+
+//
+// WRITER
+//
+// Nearly every sample is a whole number or a short decimal, a double
+// that reads back from a decimal of at most 15 digits is that decimal
+// when rounded to as many digits, so it can be spelt out directly and
+// the text is the same as formatting it. Anything else, or that would
+// need rounding, goes through QString::arg() as it did before.
+//
+static const double powers10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                                   1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+
+// the decimal places that give this double back exactly, -1 if none do
+static int
+places(double magnitude, int most, qint64 &digits)
+{
+    for (int d=0; d <= most; d++) {
+        double scaled = magnitude * powers10[d];
+        if (scaled >= 1e15) break;
+        digits = qint64(scaled + 0.5);
+        if (double(digits) / powers10[d] == magnitude) return d;
+    }
+    return -1;
+}
+
+void
+JsonRideFileStream::number(QByteArray &out, double value, char format, int precision)
+{
+    double magnitude = std::fabs(value);
+    if (precision > 0 && precision <= 15 && magnitude < 1e6 && !(value == 0 && std::signbit(value))) {
+
+        qint64 digits = 0;
+        int d = -1;
+        if (format == 'g' && (magnitude == 0 || (magnitude >= 1e-4 && magnitude < powers10[precision]))) {
+            d = places(magnitude, 15, digits);
+        } else if (format == 'f' && magnitude * powers10[precision] < 1e15) {
+            d = places(magnitude, precision, digits);
+            if (d >= 0 && d != precision) {
+                // 'f' always has all the decimals
+                digits *= qint64(powers10[precision - d]);
+                d = precision;
+            }
+        }
+
+        // the digits, least significant first
+        char buffer[32];
+        int n = 0;
+        for (qint64 u = digits; n == 0 || u; u /= 10) buffer[n++] = '0' + u % 10;
+
+        if (d >= 0 && (format == 'f' || n <= precision)) {
+            while (n <= d) buffer[n++] = '0'; // 0.0..
+            if (value < 0) out += '-';
+            for (int i=n-1; i>=0; i--) {
+                out += buffer[i];
+                if (i == d && d) out += '.';
+            }
+            return;
+        }
+    }
+
+    out += QString("%1").arg(value, 0, format, precision).toLatin1();
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_JsonRideFileStream_h
+#define _GC_JsonRideFileStream_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QByteArray>
+
+class RideFile;
+class XDataSeries;
+struct RideFilePoint;
+
+// JsonRideFileStream reads a GoldenCheetah .json ride straight from the
+// UTF-8 bytes of the file (usually mapped into memory) in a single pass,
+// the samples and xdata are decoded into the points as they are met and
+// nothing is converted to a QString unless it is a string value.
+//
+// It reads what JsonFileReader::toByteArray() writes. Anything it is not
+// sure about; a token it doesn't expect, a string that is not valid UTF-8
+// (old files were Latin-1), makes it give up and return NULL so the
+// caller can fall back to the flex/bison grammar, which remains the
+// reference for the format.
+//
+// The writer side is number(), locale independent formatting with the
+// same text as QString::arg() but without a QString for every value.
+class JsonRideFileStream
+{
+    public:
+
+        // NULL if it couldn't be read, try the grammar instead
+        static RideFile *read(const char *data, qint64 length);
+
+        // append the same text as QString("%1").arg(value, 0, format, precision)
+        static void number(QByteArray &out, double value, char format = 'g', int precision = 6);
+
+    private:
+
+        enum Token { End, Bad, String, Integer, Float, Keyword, Punctuation };
+
+        JsonRideFileStream(const char *data, qint64 length);
+
+        // scanner, the current token is always scanned ahead
+        void advance();
+        bool expect(char c);
+        bool peek(char c);
+
+        // values, false if the token isn't one
+        bool number(double &value);
+        bool string(QString &value);
+
+        // the grammar
+        bool document();
+        bool ride();
+        bool element();
+        bool overrides();
+        bool tags();
+        bool intervals();
+        bool calibrations();
+        bool references();
+        bool samples();
+        bool series(RideFilePoint &point, bool commas);
+        bool xdata();
+        bool xdataSeries();
+        bool xdataSample(XDataSeries *series);
+
+        const char *p, *end;
+        RideFile *rideFile;
+
+        // the current token
+        Token token;
+        const char *text;
+        int length, keyword;
+        char punctuation;
+        bool escaped, ascii;
+};
+
+#endif // _GC_JsonRideFileStream_h
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MeanMaxEngine.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define GC_MEANMAX_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// msvc lets us use any intrinsic, we just need to check the cpu at runtime
+#define GC_TARGET(x)
+#else
+#define GC_TARGET(x) __attribute__((target(x)))
+#endif
+#endif
+
+// entries of the integral per block, the bounds are checked
+// per block so smaller blocks skip more but cost more to check
+static const int BLOCK = 128;
+
+// too small to bother checking bounds
+static const int MINBLOCKS = 4;
+
+//
+// Kernels - max(best, I[i+duration] - I[i]) for i in from..to
+//
+static double
+kernelScalar(const double *integrated, int from, int to, int duration, double best)
+{
+    for (int i=from; i<=to; i++) {
+        double total = integrated[i+duration] - integrated[i];
+        if (total > best) best = total;
+    }
+    return best;
+}
+
+#ifdef GC_MEANMAX_X86
+GC_TARGET("sse2")
+static double
+kernelSSE2(const double *integrated, int from, int to, int duration, double best)
+{
+    // two accumulators to keep the pipeline busy
+    __m128d best0 = _mm_set1_pd(best);
+    __m128d best1 = best0;
+
+    int i=from;
+    for (; i+3 <= to; i += 4) {
+        const double *start = integrated + i;
+        const double *end = integrated + i + duration;
+        best0 = _mm_max_pd(best0, _mm_sub_pd(_mm_loadu_pd(end), _mm_loadu_pd(start)));
+        best1 = _mm_max_pd(best1, _mm_sub_pd(_mm_loadu_pd(end+2), _mm_loadu_pd(start+2)));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_max_pd(best0, best1));
+    best = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+
+    // and the stragglers
+    return kernelScalar(integrated, i, to, duration, best);
+}
+
+GC_TARGET("avx2")
+static double
+kernelAVX2(const double *integrated, int from, int to, int duration, double best)
+{
+    __m256d best0 = _mm256_set1_pd(best);
+    __m256d best1 = best0;
+
+    int i=from;
+    for (; i+7 <= to; i += 8) {
+        const double *start = integrated + i;
+        const double *end = integrated + i + duration;
+        best0 = _mm256_max_pd(best0, _mm256_sub_pd(_mm256_loadu_pd(end), _mm256_loadu_pd(start)));
+        best1 = _mm256_max_pd(best1, _mm256_sub_pd(_mm256_loadu_pd(end+4), _mm256_loadu_pd(start+4)));
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_max_pd(best0, best1));
+    for (int j=0; j<4; j++) if (lanes[j] > best) best = lanes[j];
+
+    return kernelScalar(integrated, i, to, duration, best);
+}
+
+enum { CPU_SSE2, CPU_AVX2 };
+
+static bool
+cpuHas(int feature)
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int ids = info[0];
+
+    __cpuid(info, 1);
+    if (feature == CPU_SSE2) return (info[3] & (1<<26)) != 0;
+
+    // avx2 needs the os to save the ymm registers too
+    if (ids < 7) return false;
+    if (!(info[2] & (1<<27)) || !(info[2] & (1<<28))) return false;
+    if ((_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1<<5)) != 0;
+#else
+    __builtin_cpu_init();
+    if (feature == CPU_SSE2) return __builtin_cpu_supports("sse2");
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+static QStringList
+detectKernels()
+{
+    QStringList names;
+#ifdef GC_MEANMAX_X86
+    if (cpuHas(CPU_AVX2)) names << "avx2";
+    if (cpuHas(CPU_SSE2)) names << "sse2";
+#endif
+    names << "scalar";
+    return names;
+}
+
+QStringList
+MeanMaxEngine::kernels()
+{
+    static const QStringList available = detectKernels();
+    return available;
+}
+
+bool
+MeanMaxEngine::setKernel(QString name)
+{
+    if (!kernels().contains(name)) return false;
+
+    fn = kernelScalar;
+#ifdef GC_MEANMAX_X86
+    if (name == "avx2") fn = kernelAVX2;
+    if (name == "sse2") fn = kernelSSE2;
+#endif
+    kernelName = name;
+    return true;
+}
+
+MeanMaxEngine::MeanMaxEngine(int maxDuration) : maxDuration(maxDuration), fn(kernelScalar), kernelName("scalar")
+{
+    setKernel(kernels().first());
+}
+
+void
+MeanMaxEngine::clear()
+{
+    integrated.clear();
+    bests.clear();
+    blockMin.clear();
+    blockMax.clear();
+}
+
+double
+MeanMaxEngine::best(int duration) const
+{
+    if (duration < 1 || duration >= bests.count()) return 0;
+    return bests[duration] / double(duration);
+}
+
+int
+MeanMaxEngine::offset(int duration) const
+{
+    if (duration < 1 || duration >= bests.count() || duration > count()) return -1;
+
+    // first window that matches, same as the old search
+    for (int i=0; i+duration <= count(); i++)
+        if (integrated[i+duration] - integrated[i] == bests[duration]) return i;
+    return 0;
+}
+
+void
+MeanMaxEngine::append(const double *samples, int n)
+{
+    if (n <= 0) return;
+
+    // integrate
+    if (integrated.isEmpty()) integrated << 0;
+    int had = count();
+    int total = had + n;
+
+    integrated.resize(total + 1);
+    double acc = integrated[had];
+    for (int i=0; i<n; i++) {
+        acc += samples[i];
+        integrated[had+i+1] = acc;
+    }
+    updateBlocks(had);
+
+    // only the windows that end in the new samples need searching
+    int durations = maxDuration > 0 && maxDuration < total ? maxDuration : total;
+    if (bests.count() < durations+1) bests.resize(durations+1);
+
+    for (int d=1; d <= durations; d++) {
+        int from = d > had ? 0 : had - d + 1;
+        bests[d] = search(from, total - d, d, bests[d]);
+    }
+}
+
+void
+MeanMaxEngine::updateBlocks(int from)
+{
+    int blocks = (integrated.count() + BLOCK - 1) / BLOCK;
+    blockMin.resize(blocks);
+    blockMax.resize(blocks);
+
+    for (int b = from / BLOCK; b < blocks; b++) {
+        int start = b * BLOCK;
+        int stop = qMin(start + BLOCK, integrated.count());
+
+        double min = integrated[start], max = integrated[start];
+        for (int i=start+1; i<stop; i++) {
+            if (integrated[i] < min) min = integrated[i];
+            if (integrated[i] > max) max = integrated[i];
+        }
+        blockMin[b] = min;
+        blockMax[b] = max;
+    }
+}
+
+double
+MeanMaxEngine::search(int from, int to, int duration, double best)
+{
+    if (to < from) return best;
+
+    const double *I = integrated.constData();
+
+    if (to - from < MINBLOCKS * BLOCK) return fn(I, from, to, duration, best);
+
+    // upper bound for windows starting in each block, the ends fall
+    // in at most two blocks and are no bigger than their max. rounding
+    // is monotonic so the bound holds for the computed totals too.
+    int first = from / BLOCK, last = to / BLOCK;
+    bound.resize(last - first + 1);
+
+    int top = first;
+    for (int b = first; b <= last; b++) {
+        int lo = qMax(from, b * BLOCK);
+        int hi = qMin(to, b * BLOCK + BLOCK - 1);
+
+        double end = blockMax[(lo + duration) / BLOCK];
+        if (blockMax[(hi + duration) / BLOCK] > end) end = blockMax[(hi + duration) / BLOCK];
+
+        bound[b - first] = end - blockMin[b];
+        if (bound[b - first] > bound[top - first]) top = b;
+    }
+
+    // most promising block first to get a good candidate early
+    // then only scan the blocks that might beat it
+    for (int pass=0; pass < 2; pass++) {
+        for (int b = (pass ? first : top); b <= (pass ? last : top); b++) {
+
+            if (pass && b == top) continue;
+            if (bound[b - first] <= best) continue;
+
+            int lo = qMax(from, b * BLOCK);
+            int hi = qMin(to, b * BLOCK + BLOCK - 1);
+            best = fn(I, lo, hi, duration, best);
+        }
+    }
+    return best;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_MeanMaxEngine_h
+#define _GC_MeanMaxEngine_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// MeanMaxEngine computes the exact mean maximal for every duration of
+// an equally spaced series of samples, it replaces the stepped search
+// that used Mark Rages' algorithm and back-filled the gaps.
+//
+// The samples are integrated once and the best window for a duration d
+// is then max(I[i+d] - I[i]) over all i. The integral is split into
+// blocks and the min/max of each block gives an upper bound for any
+// window starting in it, so most blocks can be skipped once a good
+// candidate is found. The blocks that are left are scanned with a
+// kernel that uses AVX2 or SSE2 when the cpu has it, with a scalar
+// fallback. Every kernel does the same subtract and compare so the
+// results are identical whichever one is used.
+//
+// Samples can be appended, only the windows that end in the new
+// samples are searched, so it can be kept up to date for live data.
+//
+class MeanMaxEngine
+{
+    public:
+
+        // maxDuration limits the durations computed (in samples)
+        // e.g. delta series only need 3 minutes, 0 means all of them
+        MeanMaxEngine(int maxDuration=0);
+
+        void clear();
+
+        // add samples and update the bests
+        void append(const double *samples, int count);
+        void append(const QVector<double> &samples) { append(samples.constData(), samples.count()); }
+
+        int count() const { return integrated.count() - 1; }
+
+        // total for the best window of each duration, indexed by duration
+        // in samples, [0] is always 0 and durations that are not computed
+        // are 0 too
+        const QVector<double> &totals() const { return bests; }
+
+        // mean for the duration, or 0 if not computed
+        double best(int duration) const;
+
+        // sample offset where the best window starts, found on demand
+        // since most callers never need it, -1 if not computed
+        int offset(int duration) const;
+
+        // kernels are "avx2", "sse2" and "scalar" - only the ones that the
+        // cpu supports are listed and the best is used by default
+        static QStringList kernels();
+        bool setKernel(QString name);
+        QString kernel() const { return kernelName; }
+
+    private:
+
+        typedef double (*Kernel)(const double *integrated, int from, int to, int duration, double best);
+
+        void updateBlocks(int from);
+        double search(int from, int to, int duration, double best);
+
+        int maxDuration;
+        QVector<double> integrated; // (count+1) running totals
+        QVector<double> bests;      // best total per duration
+        QVector<double> blockMin, blockMax; // of the integral per block
+        QVector<double> bound;      // scratch for search
+
+        Kernel fn;
+        QString kernelName;
+};
+
+#endif // _GC_MeanMaxEngine_h
@@ -10,6 +10,7 @@
 #include "RideFile.h"
 #include "MainWindow.h"
 #include <QGroupBox>
+#include <algorithm>
 
 using namespace NotioComputeFunctions;
 using namespace NotioData;
@@ -609,7 +610,7 @@ bool NotioComputeProcessor::loadNotioData(RideFile *iRide)
         wGarminAltIndex = wGarminSeries->valuename.indexOf("gpsAltitude");
         if (wGarminAltIndex > -1)
         {
-            XDataPoint* xpoint = wGarminSeries->datapoints.at(0);
+            const XDataPoint *xpoint = wGarminSeries->datapoints.at(0);
             double wInitialAltitude = (wAltitudeIndex > -1) ? wBcvxSeries->datapoints[0]->number[wAltitudeIndex] : 0;
             wGarminbaseAltitude = xpoint->number[wGarminAltIndex] - wInitialAltitude;
         }
@@ -624,10 +625,10 @@ bool NotioComputeProcessor::loadNotioData(RideFile *iRide)
 
     for (int i = 0; i < numPoints; i++)
     {
-        XDataPoint* wBcvxPoint = wBcvxSeries->datapoints.at(i);
+        const XDataPoint *wBcvxPoint = wBcvxSeries->datapoints.at(i);
 
         // Get xdata point at a position determined by user defined speed sensor delay.
-        XDataPoint *xPointSpeedOffset = nullptr;
+        const XDataPoint *xPointSpeedOffset = nullptr;
         if (i < (wBcvxSeries->datapoints.count() - wNbSamplesOffset))
             xPointSpeedOffset = wBcvxSeries->datapoints.at(i + wNbSamplesOffset);
 
@@ -718,7 +719,7 @@ bool NotioComputeProcessor::loadNotioData(RideFile *iRide)
         }
 
         // Add data points.
-        XDataPoint *wRideDataPoint = new XDataPoint();
+        XDataPoint *wRideDataPoint = wRideDataSeries->newPoint();
         wRideDataPoint->secs = wBcvxPoint->secs;
         wRideDataPoint->km = wCalculatedDistance[i] / 1000;
 
@@ -826,7 +827,7 @@ QVector<double> NotioComputeProcessor::preCalculateDist(XDataSeries *iXdataSerie
     for (int i = 0; i < numPoints; i++)
     {
         // Get xdata point at a position determined by user defined speed sensor delay.
-        XDataPoint *xPointSpeedOffset = nullptr;
+        const XDataPoint *xPointSpeedOffset = nullptr;
         if (i < (iXdataSeries->datapoints.count() - iSampleOffset))
             xPointSpeedOffset = iXdataSeries->datapoints.at(i + iSampleOffset);
 
@@ -901,7 +902,7 @@ void NotioComputeProcessor::loadDisplayData(RideFile *iRide)
     double wRiderFactor = iRide->getTag("customRiderFactor", iRide->getTag("notio.riderFactor", "1.39")).toDouble();
     double wRiderExponent = iRide->getTag("customExponent", iRide->getTag("notio.riderExponent", "-0.05")).toDouble();
 
-    XDataPoint* wFirstPoint = wRideDataSeries->datapoints[0];
+    const XDataPoint *wFirstPoint = wRideDataSeries->datapoints[0];
     double wPrevSpeed = wFirstPoint->number[wSpeedIndex];
     double wPrevAlt = wFirstPoint->number[wAltIndex];
     double wPrevAltCorrect = wFirstPoint->number[wAltComputeIndex];
@@ -918,7 +919,7 @@ void NotioComputeProcessor::loadDisplayData(RideFile *iRide)
     wEnergyVectors.m_potentialEnergy.push_back(0);
 
     QVector<XDataPoint *> wRows;
-    XDataPoint *p = new XDataPoint();
+    XDataPoint *p = wCdaSeries->newPoint();
     p->secs = 0;
     p->km = 0.0;
     p->number[0] = 0;
@@ -999,7 +1000,7 @@ void NotioComputeProcessor::loadDisplayData(RideFile *iRide)
         for (int j = 0 ; (j < wNbSamples) && (((wNbSamples * i) + j + 1) < wRideDataCount) ; j++)
         {
             int index = (wNbSamples * i) + j + 1;
-            XDataPoint* xpoint = wRideDataSeries->datapoints.at(index);
+            const XDataPoint *xpoint = wRideDataSeries->datapoints.at(index);
 
             wDistance = xpoint->km;
 
@@ -1062,7 +1063,7 @@ void NotioComputeProcessor::loadDisplayData(RideFile *iRide)
         wChainPwrLoss = NotioFuncCompute::findGearPowerLost(wFrontGearIndex, wRearGearIndex);
 
         // Fill CDAData series.
-        XDataPoint *p = new XDataPoint();
+        XDataPoint *p = wCdaSeries->newPoint();
         p->secs = i + 1;
         p->km = wDistance * 1000;
         p->number[cdaDataIdx::eBcvAlt] = wAlt;
@@ -1125,6 +1126,9 @@ void NotioComputeProcessor::computeCda2Display(RideFile *iRide, GcAlgo::AeroAlgo
 
         int wTimeWindow = static_cast<int>(iRide->getTag("notio.cdaWindow","60").toInt() / NotioFuncCompute::estimateRecInterval(wCdaSeries) / 2);
 
+        // Computed columns, saved in one command each.
+        QVector<double> wRawCdas(dataPoints), wEkfCdas(dataPoints);
+
         for (int i = 0; i < dataPoints; i++)
         {
             // Calcute time window boundaries around a sample.
@@ -1141,10 +1145,13 @@ void NotioComputeProcessor::computeCda2Display(RideFile *iRide, GcAlgo::AeroAlgo
 
             wPrevEkfCda = wEkfCda;
 
-            iRide->command->setXDataPointValue("CDAData", i, wRawCdaIndex + 2, wCda);
-            iRide->command->setXDataPointValue("CDAData", i, wEkfCdaIndex + 2, wEkfCda);
+            wRawCdas[i] = wCda;
+            wEkfCdas[i] = wEkfCda;
         }
 
+        iRide->command->setXDataColumn("CDAData", wRawCdaIndex + 2, wRawCdas);
+        iRide->command->setXDataColumn("CDAData", wEkfCdaIndex + 2, wEkfCdas);
+
         // Compute values for window.
         if (iRide->getTag("notio.calcWindow", "60.00").toDouble() < 1) {
             iRide->setTag("notio.calcWindow", "1");
@@ -1211,13 +1218,12 @@ void NotioComputeProcessor::smoothSpeedCurve(RideFile *iRide)
                         // Interpolate speed.
                         if (wNbPoints > 0)
                         {
+                            QVector<double> wNewSpeeds(wNbPoints);
                             for (int k = 0; k < wNbPoints; k++)
-                            {
-                                double wNewSpeed = GcAlgo::MiscAlgo::interpolateSpeedSample(k, wNbPoints, wPreviousSpeed, wCurrentSpeed);
+                                wNewSpeeds[k] = GcAlgo::MiscAlgo::interpolateSpeedSample(k, wNbPoints, wPreviousSpeed, wCurrentSpeed);
 
-                                iRide->command->setXDataPointValue("RideData", (i - wNbPoints + k), wSpeedIndex + 2, wNewSpeed);
-                                iRide->command->setPointValue((i - wNbPoints + k), RideFile::kph, wNewSpeed);
-                            }
+                            iRide->command->setXDataPointValues("RideData", i - wNbPoints, wSpeedIndex + 2, wNewSpeeds);
+                            iRide->command->setPointValues(i - wNbPoints, RideFile::kph, wNewSpeeds);
                         }
                     }
 
@@ -1300,7 +1306,7 @@ void NotioComputeProcessor::restoreGpsData(RideFile *iRide)
                     continue;
 
                 // Get Garmin series data point.
-                XDataPoint *wXdataPoint = wGarminSeries->datapoints[wTimeIndex];
+                const XDataPoint *wXdataPoint = wGarminSeries->datapoints[wTimeIndex];
 
                 // Get and save GPS latitude.
                 if ((wLatitudeIndex > -1) && (wRideDataLatIndex > -1) && wLatMissing)
@@ -1385,15 +1391,18 @@ void NotioComputeProcessor::getMissingDflyData(RideFile *iRide)
             // Save front gear and rear gear values.
             if ((wFrontGearIndex > -1) && (wRearGearIndex > -1))
             {
+                QVector<double> wFrontGears(wRideDataSeries->datapoints.count());
+                QVector<double> wRearGears(wRideDataSeries->datapoints.count());
+
                 for (int i = 0; i < wRideDataSeries->datapoints.count(); i++)
                 {
                     int wIndex = wGearsSeries->timeIndex(wRideDataSeries->datapoints[i]->secs);
-                    double wFrontGear = wGearsSeries->datapoints[wIndex]->number[wFrontGearIndex];
-                    double wRearGear = wGearsSeries->datapoints[wIndex]->number[wRearGearIndex];
-
-                    iRide->command->setXDataPointValue("RideData", i, rideDataIdx::eFrontGear + 2, wFrontGear);
-                    iRide->command->setXDataPointValue("RideData", i, rideDataIdx::eRearGear + 2, wRearGear);
+                    wFrontGears[i] = wGearsSeries->datapoints[wIndex]->number[wFrontGearIndex];
+                    wRearGears[i] = wGearsSeries->datapoints[wIndex]->number[wRearGearIndex];
                 }
+
+                iRide->command->setXDataColumn("RideData", rideDataIdx::eFrontGear + 2, wFrontGears);
+                iRide->command->setXDataColumn("RideData", rideDataIdx::eRearGear + 2, wRearGears);
             }
         }
     }
@@ -1436,7 +1445,7 @@ bool NotioComputeProcessor::adjustAlt(RideFile *ride)
 
     for ( int j = 0 ; j < numPoints ; j++ )
     {
-        XDataPoint* xpoint = wRideDataSeries->datapoints.at(j);
+        const XDataPoint *xpoint = wRideDataSeries->datapoints.at(j);
         double xalt = xpoint->number[wAltIndex];;
         inArray[j] = xalt;
     }
@@ -1445,8 +1454,9 @@ bool NotioComputeProcessor::adjustAlt(RideFile *ride)
     pre_process(numPoints, inArray, outArray);
 
     // Save processed data into computed altitude column.
-    for (int j = 0 ; j < numPoints ; j++)
-        ride->command->setXDataPointValue("RideData", j, wAltComputeIndex + 2, outArray[j] );
+    QVector<double> wAltitudes(numPoints);
+    std::copy(outArray, outArray + numPoints, wAltitudes.begin());
+    ride->command->setXDataColumn("RideData", wAltComputeIndex + 2, wAltitudes);
 
     // Free inArray.
     if (inArray)
@@ -1469,9 +1479,12 @@ bool NotioComputeProcessor::adjustAlt(RideFile *ride)
 
     slope_estimation_init(&slope_estimation_state, error_phi, error_theta);
 
+    // Each sample only depends on the ones before, so save them all at the end.
+    wAltitudes.resize(wRideDataSeries->datapoints.count());
+
     for ( int j = 0 ; j < wRideDataSeries->datapoints.count() ; j++ )
     {
-        XDataPoint* xpoint = wRideDataSeries->datapoints.at(j);
+        const XDataPoint *xpoint = wRideDataSeries->datapoints.at(j);
 
         double xalt = xpoint->number[wAltComputeIndex];
         double wSpeed = xpoint->number[wSpeedIndex];
@@ -1488,15 +1501,12 @@ bool NotioComputeProcessor::adjustAlt(RideFile *ride)
 
         // Adjust altitude.
         if (isnan(slope_estimation_state.h))
-        {
-            ride->command->setXDataPointValue("RideData", j, wAltComputeIndex + 2, 0.0);
-            ride->command->setPointValue(j, RideFile::alt, 0.0);
-        }
+            wAltitudes[j] = 0.0;
         else
-        {
-            ride->command->setXDataPointValue("RideData", j, wAltComputeIndex + 2, slope_estimation_state.h);
-            ride->command->setPointValue(j, RideFile::alt, slope_estimation_state.h);
-        }
+            wAltitudes[j] = slope_estimation_state.h;
     }
+
+    ride->command->setXDataColumn("RideData", wAltComputeIndex + 2, wAltitudes);
+    ride->command->setPointValues(0, RideFile::alt, wAltitudes);
     return true;
 }
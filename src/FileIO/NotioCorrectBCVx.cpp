@@ -13,6 +13,7 @@
 #include <QVector>
 #include <iostream>
 #include "IntervalItem.h"
+#include "XDataAlignment.h"
 
 #include <QTime>
 
@@ -190,9 +191,16 @@ public:
     static int constexpr cPowerStatus = 0b00000000000000000000000000100000;
     static int constexpr cSpeedStatus = 0b00000000000000000000000000010000;
 
+    // Cross correlation alignment, in seconds.
+    static constexpr double cAlignWindow = 300.0;
+    static constexpr double cAlignStep = 60.0;
+    static constexpr double cAlignMaxOffset = 120.0;
+    static constexpr double cAlignMinConfidence = 0.5;
+
 private:
     int fixBCVx(RideFile *ride, int iStart, int iEnd, int &ioOffset, const bool iAuto, const unsigned int iFlag);
     int estimateGarminOffset(XDataSeries *iSource1, XDataSeries *iSource2, const int iIntervalStart, const int iIntervalEnd);
+    QVector<XDataAlignment::Lag> estimateGarminLags(XDataSeries *iBCVxSeries, XDataSeries *iGarminSeries, const int iIntervalStart, const int iIntervalEnd);
     double averageValue(QVector<XDataPoint *> &iSource, int iIndex);
     double maxValue(QVector<XDataPoint *> &iSource, int iIndex);
     double minValue(QVector<XDataPoint *> &iSource, int iIndex);
@@ -272,8 +280,8 @@ int CorrectBCVx::fixBCVx(RideFile *ride, int iStart, int iEnd, int &ioOffset, co
     int garminPoints = wGarminSeries->datapoints.count();
 
     // Dertermine BCVx sample rate.
-    XDataPoint* xpoint1 = wBCVxSeries->datapoints.at(0);
-    XDataPoint* xpoint2 = wBCVxSeries->datapoints.at(1);
+    const XDataPoint *xpoint1 = wBCVxSeries->datapoints.at(0);
+    const XDataPoint *xpoint2 = wBCVxSeries->datapoints.at(1);
     double BCVxSampleRate = (xpoint2->secs - xpoint1->secs);
 
     cout << "SampleRate " << BCVxSampleRate << endl;
@@ -291,8 +299,27 @@ int CorrectBCVx::fixBCVx(RideFile *ride, int iStart, int iEnd, int &ioOffset, co
     if ((GarminSampleRate > 0) == false)
         GarminSampleRate = 1.0;
 
-    // Estimate automatically the time offset.
-    int wEstOffset = (iAuto == true) ? estimateGarminOffset(wGarminSeries, wBCVxSeries, iStart, iEnd) : cErrorOffset;
+    // Estimate automatically the time offset, following its drift through the interval.
+    // Fall back on matching peaks when the correlation can't be trusted.
+    QVector<XDataAlignment::Lag> wLags;
+    int wEstOffset = cErrorOffset;
+    if (iAuto == true)
+    {
+        wLags = estimateGarminLags(wBCVxSeries, wGarminSeries, iStart, iEnd);
+        if (wLags.isEmpty())
+            wEstOffset = estimateGarminOffset(wGarminSeries, wBCVxSeries, iStart, iEnd);
+        else
+            wEstOffset = static_cast<int>(round(XDataAlignment::lagAt(wLags, (iStart + iEnd) / 2.0)));
+    }
+
+    // Garmin sample to use for a BCVx sample.
+    auto garminIndex = [&](int i) {
+        if (wLags.isEmpty())
+            return static_cast<int>((i * BCVxSampleRate / GarminSampleRate) + ioOffset);
+
+        double wSecs = i * BCVxSampleRate;
+        return static_cast<int>(round((wSecs + XDataAlignment::lagAt(wLags, wSecs)) / GarminSampleRate));
+    };
 
     // Apply the estimated offset or the user defined offset.
     if (wEstOffset != cErrorOffset)
@@ -305,16 +332,16 @@ int CorrectBCVx::fixBCVx(RideFile *ride, int iStart, int iEnd, int &ioOffset, co
     // Fix power drops.
     if (((iFlag & eFlagType::Power) > 0) && (BCVxPowerIndex >= 0) && (GarminPowerIndex >= 0)) {
         for (int i = startPoint; (i < endPoint) && (i < wBCVxSeries->datapoints.count()); i++) {
-            XDataPoint* xpoint = wBCVxSeries->datapoints.at(i);
+            const XDataPoint *xpoint = wBCVxSeries->datapoints.at(i);
             double power = xpoint->number[BCVxPowerIndex];
             uint16_t statusByte  = static_cast<uint16_t>(xpoint->number[statusByteIndex]);
 
             // Check if there is no power value and if the power meter connection status is disconnected.
             if (((power > 0.0) == false) && ((statusByte & cPowerStatus) == 0)) {
                 cout << "Power = 0 at " << i << endl;
-                int use = static_cast<int>((i * BCVxSampleRate / GarminSampleRate) + ioOffset);
+                int use = garminIndex(i);
                 if ( use >= 0 && use < garminPoints ) {
-                    XDataPoint* xpoint2 = wGarminSeries->datapoints.at(use);
+                    const XDataPoint *xpoint2 = wGarminSeries->datapoints.at(use);
                     double garminPower = xpoint2->number[GarminPowerIndex];
                     cout << "Replace with " << garminPower << " at " << use << endl;
                     ride->command->setXDataPointValue("BCVX", i, BCVxPowerIndex + 2, garminPower );
@@ -332,7 +359,7 @@ int CorrectBCVx::fixBCVx(RideFile *ride, int iStart, int iEnd, int &ioOffset, co
         int needToCorrect = 0;
         for (int i = startPoint; (i < endPoint) && (i < wBCVxSeries->datapoints.count()); i++) {
 
-            XDataPoint* xpoint = wBCVxSeries->datapoints.at(i);
+            const XDataPoint *xpoint = wBCVxSeries->datapoints.at(i);
             uint16_t statusByte  = static_cast<uint16_t>(xpoint->number[statusByteIndex]);
 
             needToCorrect--;
@@ -343,9 +370,9 @@ int CorrectBCVx::fixBCVx(RideFile *ride, int iStart, int iEnd, int &ioOffset, co
             }
 
             if ( needToCorrect > 0 ) {
-                int use = static_cast<int>((i  * BCVxSampleRate / GarminSampleRate) + ioOffset);
+                int use = garminIndex(i);
                 if ( use >= 0 && use < garminPoints ) {
-                    XDataPoint* xpoint2 = wGarminSeries->datapoints.at(use);
+                    const XDataPoint *xpoint2 = wGarminSeries->datapoints.at(use);
 
                     // Get and convert Garmin speed in km/h.
                     double garminSpeed = xpoint2->number[GarminSpeedIndex] * 3.6;   // Garmin have its speed in m/s.
@@ -514,6 +541,43 @@ int CorrectBCVx::estimateGarminOffset(XDataSeries *iSource1, XDataSeries *iSourc
     return wReturning;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief CorrectBCVx::estimateGarminLags
+///        This method estimates the time offset of Garmin data relative to
+///        BCVx data through an interval, by cross correlating speed and power
+///        over sliding windows. On long rides the clocks drift so the offset
+///        is found for each window.
+///
+/// \param[in]  iBCVxSeries     BCVx XDataSeries.
+/// \param[in]  iGarminSeries   Garmin XDataSeries.
+/// \param[in]  iIntervalStart  Interval start time.
+/// \param[in]  iIntervalEnd    Interval stop time.
+///
+/// \return The offsets of the windows that could be trusted, empty if none.
+///////////////////////////////////////////////////////////////////////////////
+QVector<XDataAlignment::Lag> CorrectBCVx::estimateGarminLags(XDataSeries *iBCVxSeries, XDataSeries *iGarminSeries, const int iIntervalStart, const int iIntervalEnd)
+{
+    QVector<XDataAlignment::Lag> wReturning;
+
+    // Garmin speed is in m/s, the correlation doesn't mind.
+    XDataAlignment wAlignment(iBCVxSeries, iGarminSeries);
+    wAlignment.addChannel("speed");
+    wAlignment.addChannel("power");
+
+    if (wAlignment.channelCount() == 0)
+        return wReturning;
+
+    for (auto &wLag : wAlignment.lags(iIntervalStart, iIntervalEnd, cAlignWindow, cAlignStep, cAlignMaxOffset))
+    {
+        qDebug() << "Window at" << secsToString(wLag.secs) << "offset" << wLag.lag << "confidence" << wLag.confidence;
+
+        if (wLag.confidence >= cAlignMinConfidence)
+            wReturning.append(wLag);
+    }
+
+    return wReturning;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief CorrectBCVx::averageValue
 ///        This method finds the average value for a metric in a XDataPoint
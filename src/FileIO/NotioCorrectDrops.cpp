@@ -146,8 +146,8 @@ int CorrectPowerDrops::fixDrops(RideFile *ride, int iStart, int iEnd)
     }
 
     // Determine sample rate.
-    XDataPoint* xpoint1 = series->datapoints.at(0);
-    XDataPoint* xpoint2 = series->datapoints.at(1);
+    const XDataPoint *xpoint1 = series->datapoints.at(0);
+    const XDataPoint *xpoint2 = series->datapoints.at(1);
     double BCVxSampleRate = (xpoint2->secs - xpoint1->secs);
 
     cout << "SampleRate " << BCVxSampleRate << endl;
@@ -161,7 +161,7 @@ int CorrectPowerDrops::fixDrops(RideFile *ride, int iStart, int iEnd)
     // Fix power drops.
     double lastPower = 0;
     for (int i = startPoint; i < endPoint ; i++) {
-        XDataPoint* xpoint = series->datapoints.at(i);
+        const XDataPoint *xpoint = series->datapoints.at(i);
         double power = xpoint->number[BCVxPowerIndex];
         uint16_t statusByte = static_cast<uint16_t>(xpoint->number[statusByteIndex]);
 
@@ -170,7 +170,7 @@ int CorrectPowerDrops::fixDrops(RideFile *ride, int iStart, int iEnd)
             // Get the index of the next valid power value.
             int j;
             for (j=i+1; ((power > 0.0) == false) && ((statusByte & NotioData::cPowerStatus) == 0) && (j < endPoint) ; j++) {
-                XDataPoint* xpoint = series->datapoints.at(j);
+                const XDataPoint *xpoint = series->datapoints.at(j);
                 power = xpoint->number[BCVxPowerIndex];
                 statusByte = static_cast<uint16_t>(xpoint->number[statusByteIndex]);
             }
@@ -180,8 +180,7 @@ int CorrectPowerDrops::fixDrops(RideFile *ride, int iStart, int iEnd)
                 cout << "Drop from " << i << " to " << j << " seconds " << (j-i)*BCVxSampleRate << endl;
                 if ( ((j-i)*BCVxSampleRate) < 10.0 ) {
                     cout << "Correct " << endl;
-                    for ( int k = i ; k < j ; k++ )
-                        ride->command->setXDataPointValue("BCVX", k, BCVxPowerIndex + 2, lastPower );
+                    ride->command->setXDataPointValues("BCVX", i, BCVxPowerIndex + 2, QVector<double>(j - i, lastPower));
                 }
             }
             i = j;
@@ -383,8 +382,8 @@ int CorrectSpeedDrops::fixDrops(RideFile *iRide, int iStart, int iEnd)
         return -1;
 
     // Determine sample rate.
-    XDataPoint* wPoint1 = wDataSeries->datapoints.at(0);
-    XDataPoint* wPoint2 = wDataSeries->datapoints.at(1);
+    const XDataPoint *wPoint1 = wDataSeries->datapoints.at(0);
+    const XDataPoint *wPoint2 = wDataSeries->datapoints.at(1);
     double wBCVxSampleRate = (wPoint2->secs - wPoint1->secs);
 
     if ((wBCVxSampleRate > 0) == false)
@@ -400,7 +399,7 @@ int CorrectSpeedDrops::fixDrops(RideFile *iRide, int iStart, int iEnd)
     for (int i = wStartPoint; i < wEndPoint; i++)
     {
         // Get the speed value and the speed status bit.
-        XDataPoint* wCurrentPoint = wDataSeries->datapoints.at(i);
+        const XDataPoint *wCurrentPoint = wDataSeries->datapoints.at(i);
         double wSpeed = wCurrentPoint->number[wBCVxSpeedIndex];
         bool wSpeedStatusBit = static_cast<uint16_t>(wCurrentPoint->number[wStatusByteIndex]) & (NotioData::cSpeedStatus | NotioData::cSpeedCadStatus);
 
@@ -414,7 +413,7 @@ int CorrectSpeedDrops::fixDrops(RideFile *iRide, int iStart, int iEnd)
                 int j = i + 1;
                 for (; j < wEndPoint; j++)
                 {
-                    XDataPoint* wNextValidPoint = wDataSeries->datapoints.at(j);
+                    const XDataPoint *wNextValidPoint = wDataSeries->datapoints.at(j);
                     wSpeed = wNextValidPoint->number[wBCVxSpeedIndex];
                     wSpeedStatusBit = static_cast<uint16_t>(wNextValidPoint->number[wStatusByteIndex]) & (NotioData::cSpeedStatus | NotioData::cSpeedCadStatus);
 
@@ -449,15 +448,16 @@ int CorrectSpeedDrops::fixDrops(RideFile *iRide, int iStart, int iEnd)
                 if (wTimeElapsed < cMaxDropDuration)
                 {
                     // Interpolate speed.
+                    QVector<double> wNewSpeeds(j - i);
                     for (int k = 0; k < (j - i); k++)
                     {
 #ifdef GC_HAVE_NOTIOALGO
-                        double wNewSpeed = GcAlgo::MiscAlgo::interpolateSpeedSample(k, j - i, wLastValidSpeed, wSpeed);
+                        wNewSpeeds[k] = GcAlgo::MiscAlgo::interpolateSpeedSample(k, j - i, wLastValidSpeed, wSpeed);
 #else
-                        double wNewSpeed = wLastValidSpeed + (k + 1) * (wSpeed - wLastValidSpeed) / (j - i);
+                        wNewSpeeds[k] = wLastValidSpeed + (k + 1) * (wSpeed - wLastValidSpeed) / (j - i);
 #endif
-                        iRide->command->setXDataPointValue("BCVX", i + k, wBCVxSpeedIndex + 2, wNewSpeed);
                     }
+                    iRide->command->setXDataPointValues("BCVX", i, wBCVxSpeedIndex + 2, wNewSpeeds);
                 }
                 // Get ready for the next detection.
                 i = j;
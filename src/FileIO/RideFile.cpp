@@ -65,7 +65,7 @@ const QChar deltaChar(0x0394);
 RideFile::RideFile(const QDateTime &startTime, double recIntSecs) :
             wstale(true), startTime_(startTime), recIntSecs_(recIntSecs),
             deviceType_("unknown"), data(NULL), wprime_(NULL), 
-            weight_(0), totalCount(0), totalTemp(0), dstale(true)
+            weight_(0), totalCount(0), totalTemp(0), dstale(true), columnsCount(0), cstale(true)
 {
     command = new RideFileCommand(this);
 
@@ -80,7 +80,7 @@ RideFile::RideFile(const QDateTime &startTime, double recIntSecs) :
 // and we want to get special fields and ESPECIALLY "CP" and "Weight"
 RideFile::RideFile(RideFile *p) :
     wstale(true), recIntSecs_(p->recIntSecs_), deviceType_(p->deviceType_), data(NULL), wprime_(NULL), 
-    weight_(p->weight_), totalCount(0), dstale(true)
+    weight_(p->weight_), totalCount(0), dstale(true), columnsCount(0), cstale(true)
 {
     startTime_ = p->startTime_;
     tags_ = p->tags_;
@@ -101,7 +101,7 @@ RideFile::RideFile(RideFile *p) :
 
 RideFile::RideFile() : 
     wstale(true), recIntSecs_(0.0), deviceType_("unknown"), data(NULL), wprime_(NULL), 
-    weight_(0), totalCount(0), dstale(true)
+    weight_(0), totalCount(0), dstale(true), columnsCount(0), cstale(true)
 {
     command = new RideFileCommand(this);
 
@@ -204,6 +204,8 @@ RideFile::updateDataTag()
 WPrime *
 RideFile::wprimeData()
 {
+    // metrics are computed in parallel and several use it
+    QMutexLocker locker(&wprimeLock);
     if (wprime_ == NULL || wstale) {
         if (!wprime_) wprime_ = new WPrime();
         wprime_->setRide(const_cast<RideFile*>(this)); // recompute
@@ -1005,6 +1007,8 @@ RideFile *RideFileFactory::openRideFile(Context *context, QFile &file,
 void
 RideFile::addXData(QString name, XDataSeries *series)
 {
+    // readers fill points without knowing how many values there are
+    series->squeeze();
     xdata_.insert(name, series);
 }
 
@@ -1041,13 +1045,14 @@ RideFile::xdataValue(RideFilePoint *p, int &idx, QString sxdata, QString series,
     double secs = p->secs;
 
     // do we need to move on?
-    while (idx < s->datapoints.count() && s->datapoints[idx]->secs < secs)
+    const int count = s->datapoints.count();
+    while (idx < count && s->datapoints[idx]->secs < secs)
         idx++;
 
     // so at this point we are looking at a point that is either
     // the same point as us or is ahead of us
 
-    if (idx >= s->datapoints.count()) {
+    if (idx >= count) {
         //
         // PAST LAST XDATA
         //
@@ -1061,7 +1066,7 @@ RideFile::xdataValue(RideFilePoint *p, int &idx, QString sxdata, QString series,
             break;
 
         case REPEAT:
-            if (idx) returning = s->datapoints[idx-1]->number[vindex];
+            if (idx) returning = s->value(idx-1, vindex);
             else  returning = RideFile::NIL;
             break;
         }
@@ -1071,7 +1076,7 @@ RideFile::xdataValue(RideFilePoint *p, int &idx, QString sxdata, QString series,
         // ITS THE SAME AS US!
         //
         // if its a match we always take the value
-        returning = s->datapoints[idx]->number[vindex];
+        returning = s->value(idx, vindex);
     } else {
         //
         // ITS IN THE FUTURE
@@ -1084,8 +1089,8 @@ RideFile::xdataValue(RideFilePoint *p, int &idx, QString sxdata, QString series,
                 double gap = s->datapoints[idx]->secs - s->datapoints[idx-1]->secs;
                 double diff = secs - s->datapoints[idx-1]->secs;
                 double ratio = diff/gap;
-                double vgap = s->datapoints[idx]->number[vindex] - s->datapoints[idx-1]->number[vindex];
-                returning = s->datapoints[idx-1]->number[vindex] + (vgap * ratio);
+                double vgap = s->value(idx, vindex) - s->value(idx-1, vindex);
+                returning = s->value(idx-1, vindex) + (vgap * ratio);
             }
             break;
 
@@ -1099,7 +1104,7 @@ RideFile::xdataValue(RideFilePoint *p, int &idx, QString sxdata, QString series,
 
         case REPEAT:
             // for now, just return the last value we saw
-            if (idx) returning = s->datapoints[idx-1]->number[vindex];
+            if (idx) returning = s->value(idx-1, vindex);
             else  returning = RideFile::NA;
             break;
         }
@@ -1478,20 +1483,7 @@ void RideFile::appendOrUpdatePoint(double secs, double cad, double hr, double km
            forceAppend = true;
     }
 
-    if (forceAppend) {
-        RideFilePoint* point = new RideFilePoint(secs, cad, hr, km, kph, nm, watts, alt, lon, lat,
-                                                 headwind, slope, temp,
-                                                 lrbalance,
-                                                 lte, rte, lps, rps,
-                                                 lpco, rpco,
-                                                 lppb, rppb, lppe, rppe,
-                                                 lpppb, rpppb, lpppe, rpppe,
-                                                 smo2, thb,
-                                                 rvert, rcad, rcontact, tcore,
-                                                 interval);
-
-        dataPoints_.append(point);
-    }
+    if (forceAppend) dataPoints_.append(point);
 
     dataPresent.secs     |= (secs != 0);
     dataPresent.cad      |= (cad != 0);
@@ -1532,6 +1524,8 @@ void RideFile::appendOrUpdatePoint(double secs, double cad, double hr, double km
     updateMin(point);
     updateMax(point);
     updateAvg(point);
+
+    cstale = true;
 }
 
 void RideFile::appendPoint(const RideFilePoint &point)
@@ -1551,6 +1545,7 @@ void RideFile::appendPoint(const RideFilePoint &point)
 
 void
 RideFile::updatePoint(RideFilePoint *point, const RideFilePoint *oldPoint){
+    cstale = true;
     if (point->cad == 0 && oldPoint->cad != 0)
         point->cad = oldPoint->cad;
     if (point->hr == 0 && oldPoint->hr != 0)
@@ -1633,6 +1628,7 @@ RideFile::updatePoint(RideFilePoint *point, const RideFilePoint *oldPoint){
 void
 RideFile::setDataPresent(SeriesType series, bool value)
 {
+    cstale = true;
     switch (series) {
         case secs : dataPresent.secs = value; break;
         case cad : dataPresent.cad = value; break;
@@ -1735,9 +1731,43 @@ RideFile::isDataPresent(SeriesType series)
     }
     return false;
 }
+RideFileColumn
+RideFile::column(SeriesType series)
+{
+    if (series < 0 || series >= none) return RideFileColumn();
+
+    QMutexLocker locker(&columnsLock);
+
+    // throw away after changes, or if points were added or removed
+    // directly without telling us. anyone still using the old ones
+    // shares them, so they go when the last of them is done
+    if (cstale.fetchAndStoreOrdered(0) || columnsCount != dataPoints_.count()) {
+        columns_.clear();
+        columnsCount = dataPoints_.count();
+    }
+    if (columnsCount == 0) return RideFileColumn();
+
+    // only allocate for series that are present, derived
+    // series are present once they have been calculated
+    if (series != secs && !isDataPresent(series)
+        && !(series == IsoPower && dataPresent.np)
+        && !(series == xPower && dataPresent.xp)) return RideFileColumn();
+
+    if (columns_.isEmpty()) columns_.resize(none);
+
+    QVector<double> &values = columns_[series];
+    if (values.isEmpty()) {
+        values.resize(columnsCount);
+        double *data = values.data();
+        for (int i=0; i<columnsCount; i++) data[i] = dataPoints_[i]->value(series);
+    }
+    return RideFileColumn(values);
+}
+
 void
 RideFile::setPointValue(int index, SeriesType series, double value)
 {
+    cstale = true;
     switch (series) {
         case secs : dataPoints_[index]->secs = value; break;
         case cad : dataPoints_[index]->cad = value; break;
@@ -2114,6 +2144,7 @@ RideFile::deletePoint(int index)
 {
     delete dataPoints_[index];
     dataPoints_.remove(index);
+    cstale = true;
 }
 
 void
@@ -2121,19 +2152,24 @@ RideFile::deletePoints(int index, int count)
 {
     for(int i=index; i<(index+count); i++) delete dataPoints_[i];
     dataPoints_.remove(index, count);
+    cstale = true;
 }
 
 void
 RideFile::insertPoint(int index, RideFilePoint *point)
 {
     dataPoints_.insert(index, point);
+    cstale = true;
 }
 
 void
 RideFile::insertXDataPoint(QString _xdata, int index, XDataPoint *point)
 {
     XDataSeries *series = xdata(_xdata);
-    if (series)  series->datapoints.insert(index, point);
+    if (series) {
+        point->squeeze(series->valuename.count());
+        series->datapoints.insert(index, point);
+    }
 }
 
 void
@@ -2147,20 +2183,24 @@ void
 RideFile::appendPoints(QVector <struct RideFilePoint *> newRows)
 {
     dataPoints_ += newRows;
+    cstale = true;
 }
 
 void
 RideFile::appendXDataPoints(QString _xdata, QVector<XDataPoint *> points)
 {
     XDataSeries *series = xdata(_xdata);
-    if (series) series->datapoints << points;
+    if (series) {
+        foreach(XDataPoint *p, points) p->squeeze(series->valuename.count());
+        series->datapoints << points;
+    }
 }
 
 void
 RideFile::emitSaved()
 {
     weight_ = 0;
-    wstale = dstale = true;
+    wstale = dstale = cstale = true;
     emit saved();
 }
 
@@ -2168,7 +2208,7 @@ void
 RideFile::emitReverted()
 {
     weight_ = 0;
-    wstale = dstale = true;
+    wstale = dstale = cstale = true;
     emit reverted();
 }
 
@@ -2176,7 +2216,7 @@ void
 RideFile::emitModified()
 {
     weight_ = 0;
-    wstale = dstale = true;
+    wstale = dstale = cstale = true;
     emit modified();
 }
 
@@ -2814,8 +2854,9 @@ RideFile::recalculateDerivedSeries(bool force)
     avgPoint->apower = APcount ? (APtotal / APcount) : 0;
     totalPoint->apower = APtotal;
 
-    // and we're done
+    // and we're done, derived columns need rebuilding
     dstale=false;
+    cstale=true;
 }
 
 #ifdef GC_HAVE_SAMPLERATE
@@ -3374,6 +3415,19 @@ RideFileIterator::next()
     else return NULL;
 }
 
+int
+RideFileIterator::nextIndex()
+{
+    if (index >= 0 && index <= stop) return index++;
+    else return -1;
+}
+
+RideFileColumn
+RideFileIterator::column(RideFile::SeriesType series)
+{
+    return f ? f->column(series) : RideFileColumn();
+}
+
 struct RideFilePoint *
 RideFileIterator::previous()
 {
@@ -3488,6 +3542,13 @@ struct CompareXDataPointSecs {
     }
 };
 
+void
+XDataSeries::squeeze()
+{
+    int values = valuename.count();
+    foreach(XDataPoint *p, datapoints) p->squeeze(values);
+}
+
 int
 XDataSeries::timeIndex(double secs) const
 {
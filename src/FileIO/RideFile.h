@@ -27,6 +27,8 @@
 #include <QMap>
 #include <QVector>
 #include <QObject>
+#include <QMutex>
+#include <QAtomicInt>
 
 class RideItem;
 class RideCache;
@@ -153,6 +155,23 @@ struct RideFileCalibration
     bool operator< (RideFileCalibration right) const { return start < right.start; }
 };
 
+// A column of a ride, see RideFile::column(). It shares the values with
+// the ride so holding one is cheap, and when the ride rebuilds its columns
+// after a change the values we hold are left alone until we let them go.
+// It reads like the const double * it replaced, NULL if there isn't one
+class RideFileColumn
+{
+    public:
+        RideFileColumn() {}
+        RideFileColumn(const QVector<double> &values) : values(values) {}
+
+        const double *data() const { return values.isEmpty() ? NULL : values.constData(); }
+        operator const double *() const { return data(); }
+
+    private:
+        QVector<double> values;
+};
+
 class RideFile : public QObject // QObject to emit signals
 {
     Q_OBJECT
@@ -278,10 +297,25 @@ class RideFile : public QObject // QObject to emit signals
 
         void appendPoint(const RideFilePoint &);
 
+        // make room for the points a reader is about to append
+        void reservePoints(int count) { dataPoints_.reserve(count); }
+
         void updatePoint(RideFilePoint *point, const RideFilePoint *oldPoint);
 
         const QVector<RideFilePoint*> &dataPoints() const { return dataPoints_; }
 
+        // Working with COLUMNS -- the same samples as dataPoints() but held as
+        // one contiguous array of doubles per series (structure of arrays)
+        // for the hot loops in metrics, mean-max and plotting. They are only
+        // allocated for series that are present (NULL if not), built on first
+        // use and rebuilt after the ride is modified. Hold on to the column
+        // while you use it, not a pointer into it, it stays as it was even
+        // if the ride is changed meanwhile. It is read only, setPointValue(),
+        // appendPoint(), deletePoint() etc and the commands that use them
+        // invalidate the columns, so change the points through them and not
+        // by writing to a RideFilePoint directly
+        RideFileColumn column(SeriesType series);
+
         // recalculate all the derived data series
         // might want to move to a factory for these
         // at some point, but for now hard coded
@@ -439,6 +473,13 @@ class RideFile : public QObject // QObject to emit signals
 
         bool dstale; // is derived data up to date?
 
+        // columns built from dataPoints_ on demand, see column()
+        QVector<QVector<double> > columns_;
+        int columnsCount; // dataPoints_ when built
+        QAtomicInt cstale; // set from anywhere, reset under columnsLock
+        QMutex columnsLock;
+        QMutex wprimeLock;
+
         // data required to compute headwind based on weather broadcast
         double windSpeed_, windHeading_;
 };
@@ -540,6 +581,13 @@ class RideFileIterator {
         struct RideFilePoint *next();
         struct RideFilePoint *previous();
 
+        // for the hot loops use the columns and step through the
+        // indexes instead of the points, nextIndex() is -1 at the end
+        //     RideFileColumn watts = it.column(RideFile::watts);
+        //     while (it.hasNext()) total += watts[it.nextIndex()];
+        int nextIndex();
+        RideFileColumn column(RideFile::SeriesType series);
+
     private:
         RideFile *f;
         int start, stop, index;
@@ -575,27 +623,88 @@ class DataSeriesIterator {
 };
 #define XDATA_MAXVALUES 40
 
-class XDataPoint {
+// XDataPoint values used to be fixed arrays of XDATA_MAXVALUES doubles
+// and QStrings, ~700 bytes a sample even when the series only has a
+// couple of values and most never use strings. They are now allocated
+// to fit, RideFile::addXData() trims the points to the series valuenames.
+//
+// Indexing never reallocates, so a reference from operator[] stays valid
+// while other values are read or written; writing past the end is a bug,
+// use set() or resize() first, in a release build it goes to a scratch
+// value. Reading past the end with value() or on a const point returns
+// 0 or "".
+template <typename T>
+class XDataValues {
 public:
-    XDataPoint() {
-        secs=km=0;
-        for(int i=0; i<XDATA_MAXVALUES; i++) {
-            number[i]=0;
-            string[i]="";
-        }
+    XDataValues() : d(NULL), n(0) {}
+    XDataValues(const XDataValues &other) : d(NULL), n(0) { *this = other; }
+    ~XDataValues() { delete[] d; }
+
+    XDataValues &operator=(const XDataValues &other) {
+        if (this == &other) return *this;
+        resize(other.n);
+        for(int i=0; i<n; i++) d[i] = other.d[i];
+        return *this;
     }
-    XDataPoint (const XDataPoint &other) {
-        this->secs=other.secs;
-        this->km=other.km;
-        for(int i=0; i<XDATA_MAXVALUES; i++) {
-            this->number[i]= other.number[i];
-            this->string[i]= other.string[i];
+
+    // out of range gets a scratch value, so a release build never
+    // writes outside the array, the write is just lost
+    T &operator[](int i) {
+        Q_ASSERT(i >= 0 && i < n);
+        if (i < 0 || i >= n) {
+            static thread_local T scratch;
+            scratch = T();
+            return scratch;
         }
+        return d[i];
+    }
+    T operator[](int i) const { return (i >= 0 && i < n) ? d[i] : T(); }
+    T value(int i) const { return (i >= 0 && i < n) ? d[i] : T(); }
+
+    // grows to fit when needed, in chunks since values are mostly
+    // filled in index order
+    void set(int i, const T &value) {
+        if (i < 0 || i >= XDATA_MAXVALUES) return;
+        if (i >= n) resize(qMax(i+1, qMin((n/8+1)*8, XDATA_MAXVALUES)));
+        d[i] = value;
+    }
+
+    int count() const { return n; }
+    void resize(int count) {
+        if (count == n) return;
+        T *nd = count > 0 ? new T[count] : NULL;
+        for(int i=0; i<count; i++) nd[i] = i < n ? d[i] : T();
+        delete[] d;
+        d = nd;
+        n = count;
+    }
+
+private:
+    T *d;
+    int n;
+};
+
+class XDataPoint {
+public:
+    // the readers fill in values by index before the series knows how
+    // many there are, so numbers start at the most there can be and are
+    // trimmed by squeeze() when the series is added to the ride
+    XDataPoint() : secs(0), km(0) { number.resize(XDATA_MAXVALUES); }
+
+    // sized up front when the number of values is known
+    XDataPoint(int values) : secs(0), km(0) { number.resize(values); }
+
+    // fit to the series, strings are dropped if none are set
+    void squeeze(int values) {
+        number.resize(values);
+        bool used = false;
+        for(int i=0; i<string.count() && !used; i++) used = !string[i].isEmpty();
+        string.resize(used ? qMin(values, string.count()) : 0);
     }
 
     double secs, km;
-    double number[XDATA_MAXVALUES];
-    QString string[XDATA_MAXVALUES];
+    XDataValues<double> number;
+    XDataValues<QString> string;
 };
 
 class XDataSeries {
@@ -608,6 +717,7 @@ public:
         valuetype = other.valuetype;
         // we need to create new objects since we are holding pointers to objects
         // otherwise we would end up w/ multiple frees or dangling ptrs!
+        datapoints.reserve(other.datapoints.count());
         foreach (XDataPoint *p, other.datapoints) {
             datapoints.push_back(new XDataPoint(*p));
         }
@@ -617,6 +727,15 @@ public:
 
     int timeIndex(double) const;          // get index offset for time in secs
 
+    // a new point sized for the series
+    XDataPoint *newPoint() const { return new XDataPoint(valuename.count()); }
+
+    // read a value without growing the point
+    double value(int row, int index) const { return datapoints[row]->number.value(index); }
+
+    // trim every point to the valuenames
+    void squeeze();
+
     QString name;
     QStringList valuename;
     QStringList unitname;
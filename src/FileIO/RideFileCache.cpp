@@ -17,6 +17,8 @@
  */
 
 #include "RideFileCache.h"
+#include "RideFileCacheTree.h"
+#include "MeanMaxEngine.h"
 #include "MainWindow.h"
 #include "Context.h"
 #include "Athlete.h"
@@ -32,6 +34,12 @@
 #include <QFileInfo>
 #include <QMessageBox>
 #include <QtAlgorithms> // for qStableSort
+#include <QScopedPointer>
+#if QT_VERSION > 0x050000
+#include <QtConcurrent>
+#else
+#include <QtConcurrentMap>
+#endif
 
 static const int maxcache = 25; // lets max out at 25 caches
 
@@ -873,6 +881,7 @@ RideFileCache::refreshCache()
                 context->athlete->cpxCache.removeAt(i);
             } else i++;
         }
+        context->athlete->cpxTree->invalidate(date);
 
 
     } else if (writeerror == false) {
@@ -906,63 +915,91 @@ void RideFileCache::refresh(RideFile *file)
     compute();
 }
 
-// this function is a candidate for supporting
-// threaded calculations, each of the computes
-// in here could go in its own thread. Users
-// with many cores would benefit enormously
+// compute() runs each mean-max and distribution as a task
+struct RideFileCacheTask {
+
+    RideFileCacheTask() : cache(NULL), array(NULL), series(RideFile::none), meanmax(false), samples(NULL) {}
+    RideFileCacheTask(RideFileCache *cache, QVector<float> *array, RideFile::SeriesType series,
+                      bool meanmax, const RideFileCacheSamples *samples)
+    : cache(cache), array(array), series(series), meanmax(meanmax), samples(samples) {}
+
+    RideFileCache *cache;
+    QVector<float> *array;
+    RideFile::SeriesType series;
+    bool meanmax;
+    const RideFileCacheSamples *samples;
+};
+
+void
+RideFileCache::computeTask(RideFileCacheTask &task)
+{
+    if (task.meanmax) {
+        MeanMaxComputer computer(task.cache->ride, *task.array, task.series, task.samples);
+        computer.run();
+    } else {
+        task.cache->computeDistribution(*task.array, task.series, *task.samples);
+    }
+}
+
+// the series are picked up once from the ride columns
+// and then each of the computes runs as a task in parallel,
+// users with many cores benefit enormously
 void RideFileCache::RideFileCache::compute()
 {
     if (ride == NULL) {
         return;
     }
 
+    // every series the mean-max and distributions are computed from
+    QList<RideFile::SeriesType> base;
+    base << RideFile::watts << RideFile::hr << RideFile::cad << RideFile::nm << RideFile::kph
+         << RideFile::alt << RideFile::aPower << RideFile::gear << RideFile::smo2
+         << RideFile::kphd << RideFile::wattsd << RideFile::cadd << RideFile::nmd << RideFile::hrd;
+
+    QList<RideFile::SeriesType> gather;
+    foreach (RideFile::SeriesType type, base)
+        if (ride->isDataPresent(type)) gather << type;
+
+    RideFileCacheSamples samples(ride, gather);
+
+    // zones only need looking up once
+    setupZones();
+
+    QVector<RideFileCacheTask> tasks;
+
     // all the mean maxes
-    MeanMaxComputer thread1(ride, wattsMeanMax, RideFile::watts); thread1.start();
-    MeanMaxComputer thread2(ride, hrMeanMax, RideFile::hr); thread2.start();
-    MeanMaxComputer thread3(ride, cadMeanMax, RideFile::cad); thread3.start();
-    MeanMaxComputer thread4(ride, nmMeanMax, RideFile::nm); thread4.start();
-    MeanMaxComputer thread5(ride, kphMeanMax, RideFile::kph); thread5.start();
-    MeanMaxComputer thread6(ride, xPowerMeanMax, RideFile::xPower); thread6.start();
-    MeanMaxComputer thread7(ride, npMeanMax, RideFile::IsoPower); thread7.start();
-    MeanMaxComputer thread8(ride, vamMeanMax, RideFile::vam); thread8.start();
-    MeanMaxComputer thread9(ride, wattsKgMeanMax, RideFile::wattsKg); thread9.start();
-    MeanMaxComputer thread10(ride, aPowerMeanMax, RideFile::aPower); thread10.start();
-    MeanMaxComputer thread11(ride, kphdMeanMax, RideFile::kphd); thread11.start();
-    MeanMaxComputer thread12(ride, wattsdMeanMax, RideFile::wattsd); thread12.start();
-    MeanMaxComputer thread13(ride, caddMeanMax, RideFile::cadd); thread13.start();
-    MeanMaxComputer thread14(ride, nmdMeanMax, RideFile::nmd); thread14.start();
-    MeanMaxComputer thread15(ride, hrdMeanMax, RideFile::hrd); thread15.start();
-    MeanMaxComputer thread16(ride, aPowerKgMeanMax, RideFile::aPowerKg); thread16.start();
+    tasks << RideFileCacheTask(this, &wattsMeanMax, RideFile::watts, true, &samples)
+          << RideFileCacheTask(this, &hrMeanMax, RideFile::hr, true, &samples)
+          << RideFileCacheTask(this, &cadMeanMax, RideFile::cad, true, &samples)
+          << RideFileCacheTask(this, &nmMeanMax, RideFile::nm, true, &samples)
+          << RideFileCacheTask(this, &kphMeanMax, RideFile::kph, true, &samples)
+          << RideFileCacheTask(this, &xPowerMeanMax, RideFile::xPower, true, &samples)
+          << RideFileCacheTask(this, &npMeanMax, RideFile::IsoPower, true, &samples)
+          << RideFileCacheTask(this, &vamMeanMax, RideFile::vam, true, &samples)
+          << RideFileCacheTask(this, &wattsKgMeanMax, RideFile::wattsKg, true, &samples)
+          << RideFileCacheTask(this, &aPowerMeanMax, RideFile::aPower, true, &samples)
+          << RideFileCacheTask(this, &kphdMeanMax, RideFile::kphd, true, &samples)
+          << RideFileCacheTask(this, &wattsdMeanMax, RideFile::wattsd, true, &samples)
+          << RideFileCacheTask(this, &caddMeanMax, RideFile::cadd, true, &samples)
+          << RideFileCacheTask(this, &nmdMeanMax, RideFile::nmd, true, &samples)
+          << RideFileCacheTask(this, &hrdMeanMax, RideFile::hrd, true, &samples)
+          << RideFileCacheTask(this, &aPowerKgMeanMax, RideFile::aPowerKg, true, &samples);
 
     // all the different distributions
-    computeDistribution(wattsDistribution, RideFile::watts);
-    computeDistribution(hrDistribution, RideFile::hr);
-    computeDistribution(cadDistribution, RideFile::cad);
-    computeDistribution(gearDistribution, RideFile::gear);
-    computeDistribution(nmDistribution, RideFile::nm);
-    computeDistribution(kphDistribution, RideFile::kph);
-    computeDistribution(wattsKgDistribution, RideFile::wattsKg);
-    computeDistribution(aPowerDistribution, RideFile::aPower);
-    computeDistribution(smo2Distribution, RideFile::smo2);
-    computeDistribution(wbalDistribution, RideFile::wbal);
-
-    // wait for them threads
-    thread1.wait();
-    thread2.wait();
-    thread3.wait();
-    thread4.wait();
-    thread5.wait();
-    thread6.wait();
-    thread7.wait();
-    thread8.wait();
-    thread9.wait();
-    thread10.wait();
-    thread11.wait();
-    thread12.wait();
-    thread13.wait();
-    thread14.wait();
-    thread15.wait();
-    thread16.wait();
+    tasks << RideFileCacheTask(this, &wattsDistribution, RideFile::watts, false, &samples)
+          << RideFileCacheTask(this, &hrDistribution, RideFile::hr, false, &samples)
+          << RideFileCacheTask(this, &cadDistribution, RideFile::cad, false, &samples)
+          << RideFileCacheTask(this, &gearDistribution, RideFile::gear, false, &samples)
+          << RideFileCacheTask(this, &nmDistribution, RideFile::nm, false, &samples)
+          << RideFileCacheTask(this, &kphDistribution, RideFile::kph, false, &samples)
+          << RideFileCacheTask(this, &wattsKgDistribution, RideFile::wattsKg, false, &samples)
+          << RideFileCacheTask(this, &aPowerDistribution, RideFile::aPower, false, &samples)
+          << RideFileCacheTask(this, &smo2Distribution, RideFile::smo2, false, &samples)
+          << RideFileCacheTask(this, &wbalDistribution, RideFile::wbal, false, &samples);
+
+    // the calling thread joins in, so this is fine when we are
+    // already running in the thread pool (e.g. RideCache refresh)
+    QtConcurrent::blockingMap(tasks, computeTask);
 
     // setup the doubles the users use
     doubleArray(wattsMeanMaxDouble, wattsMeanMax, RideFile::watts);
@@ -1117,23 +1154,6 @@ void RideFileCache::RideFileCache::compute()
 
 */
 
-static data_t *
-integrate_series(cpintdata &data)
-{
-    // would be better to do pure QT and use QVector -- but no memory leak
-    data_t *integrated= (data_t *)malloc(sizeof(data_t)*(data.points.size()+1)); 
-    int i;
-    data_t acc=0;
-
-    for (i=0; i<data.points.size(); i++) {
-        integrated[i]=acc;
-        acc+=data.points[i].value;
-    }
-    integrated[i]=acc;
-
-    return integrated;
-}
-
 static data_t
 partial_max_mean(data_t *dataseries_i, int start, int end, int length, int *offset)
 {
@@ -1213,6 +1233,56 @@ divided_max_mean(data_t *dataseries_i, int datalength, int length, int *offset)
 }
 
 
+RideFileCacheSamples::RideFileCacheSamples(RideFile *ride, QList<RideFile::SeriesType> series) :
+    count(ride->dataPoints().count()), slots(0), lastSecs(0), slot(count, -1), columns(RideFile::none+1)
+{
+    // the ride holds each series as a column already, we just pick them
+    // up here so the computers don't build them concurrently, and hold
+    // them so they're there for the computers even if the ride changes
+    foreach (RideFile::SeriesType type, series) columns[type] = ride->column(type);
+
+    // same time base the mean-max has always used, pulled back to start at
+    // recIntSecs with any gaps in recording filled in
+    RideFileColumn time = ride->column(RideFile::secs);
+    double recint = ride->recIntSecs();
+    double lastsecs = 0;
+    double offset = 0;
+
+    for (int i=0; time && i<count; i++) {
+
+        // get offset to apply on all samples if first sample
+        if (i == 0) offset = time[i];
+
+        // drag back to start at 1s or whatever recIntSecs() is !
+        double psecs = time[i] - offset + recint;
+
+        // fill in any gaps in recording - use same dodgy rounding as before
+        int gap = (psecs - lastsecs - recint) / recint;
+
+        // gap more than an hour, damn that ride file is a mess
+        if (gap > 3600) gap = 1;
+
+        if (gap > 0) {
+            slots += gap;
+            lastSecs = round(lastsecs + (gap * recint));
+        }
+        lastsecs = psecs;
+
+        double secs = round(psecs * 1000.0) / 1000;
+        if (secs > 0) {
+            slot[i] = slots++;
+            lastSecs = secs;
+        }
+    }
+}
+
+const double *
+RideFileCacheSamples::column(RideFile::SeriesType series) const
+{
+    if (series < 0 || series >= columns.count()) return NULL;
+    return columns[series].data();
+}
+
 void
 MeanMaxComputer::run()
 {
@@ -1255,41 +1325,26 @@ MeanMaxComputer::run()
     // zero, since some files have a very large start time
     // that creates work for nil effect (but increases compute
     // time drastically).
-    cpintdata data;
-    data.rec_int_ms = (int) round(ride->recIntSecs() * 1000.0);
-    double lastsecs = 0;
-    bool first = true;
-    double offset = 0;
-    foreach (const RideFilePoint *p, ride->dataPoints()) {
-
-        // get offset to apply on all samples if first sample
-        if (first == true) {
-            offset = p->secs;
-            first = false;
-        }
-
-        // drag back to start at 1s or whatever recIntSecs() is !
-        double psecs = p->secs - offset + ride->recIntSecs();
-
-        // fill in any gaps in recording - use same dodgy rounding as before
-        int count = (psecs - lastsecs - ride->recIntSecs()) / ride->recIntSecs();
-
-        // gap more than an hour, damn that ride file is a mess
-        if (count > 3600) count = 1;
-
-        for(int i=0; i<count; i++)
-            data.points.append(cpintpoint(round(lastsecs+((i+1)*ride->recIntSecs() *1000.0)/1000), 0));
-        lastsecs = psecs;
-
-        double secs = round(psecs * 1000.0) / 1000;
-        if (secs > 0) data.points.append(cpintpoint(secs, (int) round(p->value(baseSeries)*double(decimals))));
+    // the time base is worked out once for all series by
+    // RideFileCacheSamples, when run on our own we gather
+    // just the one series we need
+    QScopedPointer<RideFileCacheSamples> own;
+    const RideFileCacheSamples *gathered = samples;
+    if (gathered == NULL) {
+        own.reset(new RideFileCacheSamples(ride, QList<RideFile::SeriesType>() << baseSeries));
+        gathered = own.data();
     }
 
-
     // don't bother with insufficient data
-    if (!data.points.count()) return;
+    const double *raw = gathered->column(baseSeries);
+    if (raw == NULL || gathered->slots == 0) return;
+
+    // gaps are left as zero
+    QVector<double> data(gathered->slots);
+    for (int i=0; i<gathered->count; i++)
+        if (gathered->slot[i] >= 0) data[gathered->slot[i]] = (int) round(raw[i] * double(decimals));
 
-    int total_secs = (int) ceil(data.points.back().secs);
+    int total_secs = (int) ceil(gathered->lastSecs);
 
     // don't allow data more than two days
     // was one week, but no single ride is longer
@@ -1308,19 +1363,19 @@ MeanMaxComputer::run()
 
         double lastAlt=0;
 
-        for (int i=0; i<data.points.size(); i++) {
+        for (int i=0; i<data.count(); i++) {
 
             // handle drops gracefully (and first sample too)
             // if you manage to rise >5m in a second thats a data error too!
-            if (!lastAlt || (data.points[i].value - lastAlt) > 5) lastAlt=data.points[i].value;
+            if (!lastAlt || (data[i] - lastAlt) > 5) lastAlt=data[i];
 
             // NOTE: It is 360 not 3600 because Altitude is factored for decimal places
             //       since it is the base data series, but we are calculating VAM
             //       And we multiply by 10 at the end!
-            double vam = (((data.points[i].value - lastAlt) * 360)/ride->recIntSecs()) * 10;
+            double vam = (((data[i] - lastAlt) * 360)/ride->recIntSecs()) * 10;
             if (vam < 0) vam = 0;
-            lastAlt = data.points[i].value;
-            data.points[i].value = vam;
+            lastAlt = data[i];
+            data[i] = vam;
         }
     }
 
@@ -1340,13 +1395,13 @@ MeanMaxComputer::run()
 
             // loop over the data and convert to a rolling
             // average for the given windowsize
-            for (int i=0; i<data.points.size(); i++) {
+            for (int i=0; i<data.count(); i++) {
 
-                sum += data.points[i].value;
+                sum += data[i];
                 sum -= rolling[index];
 
-                rolling[index] = data.points[i].value;
-                data.points[i].value = pow(sum/(double)rollingwindowsize,4.0f); // raise rolling average to 4th power
+                rolling[index] = data[i];
+                data[i] = pow(sum/(double)rollingwindowsize,4.0f); // raise rolling average to 4th power
 
                 // move index on/round
                 index = (index >= rollingwindowsize-1) ? 0 : index+1;
@@ -1370,29 +1425,29 @@ MeanMaxComputer::run()
         if (rollingwindowsize > 1) {
 
             // loop over the data and convert to a EWMA
-            for (int i=0; i<data.points.size(); i++) {
+            for (int i=0; i<data.count(); i++) {
 
                 // dgr : BikeScore has weighting value from first point
                 if (false && i < rollingwindowsize) {
 
                     // get up to speed
-                    sum += data.points[i].value;
+                    sum += data[i];
                     ewma = sum / (i+1);
 
                 } else {
 
                     // we're up to speed
-                    ewma = (data.points[i].value * exp) + (ewma * rem);
+                    ewma = (data[i] * exp) + (ewma * rem);
                 }
-                data.points[i].value = pow(ewma, 4.0f);
+                data[i] = pow(ewma, 4.0f);
             }
         }
     }
 
     if (series == RideFile::wattsKg || series == RideFile::aPowerKg) {
-        for (int i=0; i<data.points.size(); i++) {
-            double wattsKg = data.points[i].value / ride->getWeight();
-            data.points[i].value = wattsKg;
+        for (int i=0; i<data.count(); i++) {
+            double wattsKg = data[i] / ride->getWeight();
+            data[i] = wattsKg;
         }
     }
 
@@ -1400,16 +1455,20 @@ MeanMaxComputer::run()
     // the bests go in here...
     QVector <double> ride_bests(total_secs + 1);
 
-    data_t *dataseries_i = integrate_series(data);
+    // exact bests for every duration, this used to be a stepped search
+    // using divided_max_mean() with the gaps filled in afterwards
+    // delta series only keep the first 3 minutes so don't look further
+    bool delta = (series == RideFile::kphd  || series == RideFile::wattsd || series == RideFile::cadd ||
+                  series == RideFile::nmd  || series == RideFile::hrd);
 
-    for (int i=1; i<data.points.size();) {
+    MeanMaxEngine engine(delta ? int(180 / ride->recIntSecs()) + 1 : 0);
+    engine.append(data);
 
-        int offset;
-        data_t c=divided_max_mean(dataseries_i,data.points.size(),i,&offset);
+    for (int i=1; i<data.count() && i<engine.totals().count(); i++) {
 
         // snaffle it away
         int sec = i*ride->recIntSecs();
-        data_t val = c / (data_t)i;
+        data_t val = engine.totals()[i] / (data_t)i;
 
         if (sec < ride_bests.size()) {
             if (series == RideFile::IsoPower || series == RideFile::xPower)
@@ -1417,17 +1476,7 @@ MeanMaxComputer::run()
             else
                 ride_bests[sec] = val;
         }
-
-
-        // increments to limit search scope
-        if (i<120) i++;
-        else if (i<600) i+= 2;
-        else if (i<1200) i += 5;
-        else if (i<3600) i += 20;
-        else if (i<7200) i += 120;
-        else i += 300;
     }
-    free(dataseries_i);
 
     //
     // FILL IN THE GAPS AND FILL TARGET ARRAY
@@ -1447,8 +1496,7 @@ MeanMaxComputer::run()
     double last = 0;
 
     // only care about first 3 minutes MAX for delta series
-    if ((series == RideFile::kphd  || series == RideFile::wattsd || series == RideFile::cadd ||
-        series == RideFile::nmd  || series == RideFile::hrd) && ride_bests.count() > 180) {
+    if (delta && ride_bests.count() > 180) {
         ride_bests.resize(180);
         array.resize(180);
     } else {
@@ -1529,7 +1577,28 @@ void RideFileCache::fastSearch(QVector<int>&input, QVector<int>&ride_bests, QVec
 }
 
 void
-RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType series)
+RideFileCache::setupZones()
+{
+    // get zones that apply, if any
+    zoneRange = context->athlete->zones(ride->isRun()) ? context->athlete->zones(ride->isRun())->whichRange(ride->startTime().date()) : -1;
+    hrZoneRange = context->athlete->hrZones(ride->isRun()) ? context->athlete->hrZones(ride->isRun())->whichRange(ride->startTime().date()) : -1;
+    paceZoneRange = context->athlete->paceZones(ride->isSwim()) ? context->athlete->paceZones(ride->isSwim())->whichRange(ride->startTime().date()) : -1;
+
+    if (zoneRange != -1) CP=context->athlete->zones(ride->isRun())->getCP(zoneRange);
+    else CP=0;
+
+    if (zoneRange != -1) WPRIME=context->athlete->zones(ride->isRun())->getWprime(zoneRange);
+    else WPRIME=0;
+
+    if (hrZoneRange != -1) LTHR=context->athlete->hrZones(ride->isRun())->getLT(hrZoneRange);
+    else LTHR=0;
+
+    if (paceZoneRange != -1) CV=context->athlete->paceZones(ride->isSwim())->getCV(paceZoneRange);
+    else CV=0;
+}
+
+void
+RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType series, const RideFileCacheSamples &samples)
 {
     RideFile::SeriesType baseSeries = series;
 
@@ -1550,23 +1619,6 @@ RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType s
     // only bother if the data series is actually present
     if (ride->isDataPresent(needSeries) == false) return;
 
-    // get zones that apply, if any
-    int zoneRange = context->athlete->zones(ride->isRun()) ? context->athlete->zones(ride->isRun())->whichRange(ride->startTime().date()) : -1;
-    int hrZoneRange = context->athlete->hrZones(ride->isRun()) ? context->athlete->hrZones(ride->isRun())->whichRange(ride->startTime().date()) : -1;
-    int paceZoneRange = context->athlete->paceZones(ride->isSwim()) ? context->athlete->paceZones(ride->isSwim())->whichRange(ride->startTime().date()) : -1;
-
-    if (zoneRange != -1) CP=context->athlete->zones(ride->isRun())->getCP(zoneRange);
-    else CP=0;
-
-    if (zoneRange != -1) WPRIME=context->athlete->zones(ride->isRun())->getWprime(zoneRange);
-    else WPRIME=0;
-
-    if (hrZoneRange != -1) LTHR=context->athlete->hrZones(ride->isRun())->getLT(hrZoneRange);
-    else LTHR=0;
-
-    if (paceZoneRange != -1) CV=context->athlete->paceZones(ride->isSwim())->getCV(paceZoneRange);
-    else CV=0;
-
     // setup the array based upon the ride
     int decimals = decimalsFor(series); //RideFile::decimalsFor(series) ? 1 : 0;
     double min = RideFile::minimumFor(series) * pow(10, decimals);
@@ -1607,27 +1659,37 @@ RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType s
 
     } else {
 
-        foreach(RideFilePoint *dp, ride->dataPoints()) {
-            double value = dp->value(baseSeries);
+        // gathered by compute() in one pass over the ride
+        const double *column = samples.column(baseSeries);
+        if (column == NULL) return;
+
+        double factor = pow(10, decimals);
+
+        for (int i=0; i<samples.count; i++) {
+
+            // zones are on the sample, not the value
+            double point = column[i];
+
+            double value = point;
             if (series == RideFile::wattsKg || series == RideFile::aPowerKg) {
                 value /= ride->getWeight();
             }
 
-            float lvalue = value * pow(10, decimals);
+            float lvalue = value * factor;
 
             // watts time in zone
             if (series == RideFile::watts && zoneRange != -1) {
-                int index = context->athlete->zones(ride->isRun())->whichZone(zoneRange, dp->value(series));
+                int index = context->athlete->zones(ride->isRun())->whichZone(zoneRange, point);
                 if (index >=0) wattsTimeInZone[index] += ride->recIntSecs();
             }
 
             // Polarized zones :- I(<0.85*CP), II (<CP and >0.85*CP), III (>CP)
             if (series == RideFile::watts && zoneRange != -1 && CP) {
-                if (dp->value(series) < 1) // I zero watts
+                if (point < 1) // I zero watts
                     wattsCPTimeInZone[0] += ride->recIntSecs();
-                else if (dp->value(series) < (CP*0.85f)) // I
+                else if (point < (CP*0.85f)) // I
                     wattsCPTimeInZone[1] += ride->recIntSecs();
-                else if (dp->value(series) < CP) // II
+                else if (point < CP) // II
                     wattsCPTimeInZone[2] += ride->recIntSecs();
                 else // III
                     wattsCPTimeInZone[3] += ride->recIntSecs();
@@ -1635,17 +1697,17 @@ RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType s
 
             // hr time in zone
             if (series == RideFile::hr && hrZoneRange != -1) {
-                int index = context->athlete->hrZones(ride->isRun())->whichZone(hrZoneRange, dp->value(series));
+                int index = context->athlete->hrZones(ride->isRun())->whichZone(hrZoneRange, point);
                 if (index >= 0) hrTimeInZone[index] += ride->recIntSecs();
             }
 
             // Polarized zones :- I(<0.9*LTHR), II (<LTHR and >0.9*LTHR), III (>LTHR)
             if (series == RideFile::hr && hrZoneRange != -1 && LTHR) {
-                if (dp->value(series) < 1) // I zero
+                if (point < 1) // I zero
                     hrCPTimeInZone[0] += ride->recIntSecs();
-                else if (dp->value(series) < (LTHR*0.9f)) // I
+                else if (point < (LTHR*0.9f)) // I
                     hrCPTimeInZone[1] += ride->recIntSecs();
-                else if (dp->value(series) < LTHR) // II
+                else if (point < LTHR) // II
                     hrCPTimeInZone[2] += ride->recIntSecs();
                 else // III
                     hrCPTimeInZone[3] += ride->recIntSecs();
@@ -1653,20 +1715,20 @@ RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType s
 
             // pace time in zone, only for running and swimming activities
             if (series == RideFile::kph && paceZoneRange != -1 && (ride->isRun() || ride->isSwim())) {
-                int index = context->athlete->paceZones(ride->isSwim())->whichZone(paceZoneRange, dp->value(series));
+                int index = context->athlete->paceZones(ride->isSwim())->whichZone(paceZoneRange, point);
                 if (index >= 0) paceTimeInZone[index] += ride->recIntSecs();
             }
 
             // Polarized zones Run:- I(<0.9*CV), II (<CV and >0.9*CV), III (>CV)
             // Polarized zones Swim:- I(<0.975*CV), II (<CV and >0.975*CV), III (>CV)
             if (series == RideFile::kph && paceZoneRange != -1 && CV && (ride->isRun() || ride->isSwim())) {
-                if (dp->value(series) < 0.1) // I zero
+                if (point < 0.1) // I zero
                     paceCPTimeInZone[0] += ride->recIntSecs();
-                else if (ride->isRun() && dp->value(series) < (CV*0.9f)) // I for run
+                else if (ride->isRun() && point < (CV*0.9f)) // I for run
                     paceCPTimeInZone[1] += ride->recIntSecs();
-                else if (ride->isSwim() && dp->value(series) < (CV*0.975f)) // I for swim
+                else if (ride->isSwim() && point < (CV*0.975f)) // I for swim
                     paceCPTimeInZone[1] += ride->recIntSecs();
-                else if (dp->value(series) < CV) // II
+                else if (point < CV) // II
                     paceCPTimeInZone[2] += ride->recIntSecs();
                 else // III
                     paceCPTimeInZone[3] += ride->recIntSecs();
@@ -1682,8 +1744,10 @@ RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType s
 // AGGREGATE FOR A GIVEN DATE RANGE
 //
 
-// select and update bests
-static void meanMaxAggregate(QVector<double> &into, QVector<double> &other, QVector<QDate>&dates, QDate rideDate)
+// select and update bests, a ride's are all on rideDate
+// but an aggregate has its own dates
+static void meanMaxAggregate(QVector<double> &into, QVector<double> &other, QVector<QDate>&dates,
+                             QVector<QDate> &otherDates, QDate rideDate)
 {
     if (into.size() < other.size()) {
         into.resize(other.size());
@@ -1693,7 +1757,7 @@ static void meanMaxAggregate(QVector<double> &into, QVector<double> &other, QVec
     for (int i=0; i<other.size(); i++)
         if (other[i] > into[i]) {
             into[i] = other[i];
-            dates[i] = rideDate;
+            dates[i] = rideDate.isValid() || i >= otherDates.size() ? rideDate : otherDates[i];
         }
 }
 
@@ -1705,6 +1769,69 @@ static void distAggregate(QVector<double> &into, QVector<double> &other)
 
 }
 
+void
+RideFileCache::aggregate(RideFileCache &other, QDate date)
+{
+    meanMaxAggregate(wattsMeanMaxDouble, other.wattsMeanMaxDouble, wattsMeanMaxDate, other.wattsMeanMaxDate, date);
+    meanMaxAggregate(hrMeanMaxDouble, other.hrMeanMaxDouble, hrMeanMaxDate, other.hrMeanMaxDate, date);
+    meanMaxAggregate(cadMeanMaxDouble, other.cadMeanMaxDouble, cadMeanMaxDate, other.cadMeanMaxDate, date);
+    meanMaxAggregate(nmMeanMaxDouble, other.nmMeanMaxDouble, nmMeanMaxDate, other.nmMeanMaxDate, date);
+    meanMaxAggregate(kphMeanMaxDouble, other.kphMeanMaxDouble, kphMeanMaxDate, other.kphMeanMaxDate, date);
+    meanMaxAggregate(kphdMeanMaxDouble, other.kphdMeanMaxDouble, kphdMeanMaxDate, other.kphdMeanMaxDate, date);
+    meanMaxAggregate(wattsdMeanMaxDouble, other.wattsdMeanMaxDouble, wattsdMeanMaxDate, other.wattsdMeanMaxDate, date);
+    meanMaxAggregate(caddMeanMaxDouble, other.caddMeanMaxDouble, caddMeanMaxDate, other.caddMeanMaxDate, date);
+    meanMaxAggregate(nmdMeanMaxDouble, other.nmdMeanMaxDouble, nmdMeanMaxDate, other.nmdMeanMaxDate, date);
+    meanMaxAggregate(hrdMeanMaxDouble, other.hrdMeanMaxDouble, hrdMeanMaxDate, other.hrdMeanMaxDate, date);
+    meanMaxAggregate(xPowerMeanMaxDouble, other.xPowerMeanMaxDouble, xPowerMeanMaxDate, other.xPowerMeanMaxDate, date);
+    meanMaxAggregate(npMeanMaxDouble, other.npMeanMaxDouble, npMeanMaxDate, other.npMeanMaxDate, date);
+    meanMaxAggregate(vamMeanMaxDouble, other.vamMeanMaxDouble, vamMeanMaxDate, other.vamMeanMaxDate, date);
+    meanMaxAggregate(wattsKgMeanMaxDouble, other.wattsKgMeanMaxDouble, wattsKgMeanMaxDate, other.wattsKgMeanMaxDate, date);
+    meanMaxAggregate(aPowerMeanMaxDouble, other.aPowerMeanMaxDouble, aPowerMeanMaxDate, other.aPowerMeanMaxDate, date);
+    meanMaxAggregate(aPowerKgMeanMaxDouble, other.aPowerKgMeanMaxDouble, aPowerKgMeanMaxDate, other.aPowerKgMeanMaxDate, date);
+
+    distAggregate(wattsDistributionDouble, other.wattsDistributionDouble);
+    distAggregate(hrDistributionDouble, other.hrDistributionDouble);
+    distAggregate(cadDistributionDouble, other.cadDistributionDouble);
+    distAggregate(gearDistributionDouble, other.gearDistributionDouble);
+    distAggregate(nmDistributionDouble, other.nmDistributionDouble);
+    distAggregate(kphDistributionDouble, other.kphDistributionDouble);
+    distAggregate(xPowerDistributionDouble, other.xPowerDistributionDouble);
+    distAggregate(npDistributionDouble, other.npDistributionDouble);
+    distAggregate(wattsKgDistributionDouble, other.wattsKgDistributionDouble);
+    distAggregate(aPowerDistributionDouble, other.aPowerDistributionDouble);
+    distAggregate(smo2DistributionDouble, other.smo2DistributionDouble);
+    distAggregate(wbalDistributionDouble, other.wbalDistributionDouble);
+
+    // cumulate timeinzones
+    for (int i=0; i<10; i++) {
+        paceTimeInZone[i] += other.paceTimeInZone[i];
+        hrTimeInZone[i] += other.hrTimeInZone[i];
+        wattsTimeInZone[i] += other.wattsTimeInZone[i];
+        if (i<4) {
+            paceCPTimeInZone[i] += other.paceCPTimeInZone[i];
+            hrCPTimeInZone[i] += other.hrCPTimeInZone[i];
+            wattsCPTimeInZone[i] += other.wattsCPTimeInZone[i];
+            wbalTimeInZone[i] += other.wbalTimeInZone[i];
+        }
+    }
+}
+
+RideFileCache::RideFileCache(Context *context)
+               : incomplete(false), context(context), rideFileName(""), ride(0)
+{
+    filter = false;
+    onhome = true;
+
+    // time in zone are fixed to 10 zone max
+    wattsTimeInZone.resize(10);
+    wattsCPTimeInZone.resize(4);
+    hrTimeInZone.resize(10);
+    hrCPTimeInZone.resize(4);
+    paceTimeInZone.resize(10);
+    paceCPTimeInZone.resize(4);
+    wbalTimeInZone.resize(4);
+}
+
 RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filter, QStringList files, bool onhome, RideItem *rideItem)
                : start(start), end(end), incomplete(false), context(context), rideFileName(""), ride(0)
 {
@@ -1715,15 +1842,12 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
     this->onhome = onhome;
 
     // Oh lets get from the cache if we can -- but not if filtered
-    if (!filter && !context->isfiltered && !rideItem) {
-
-        // oh and not if we're onhome and homefiltered
-        if ((onhome && !context->ishomefiltered) || !onhome) {
-            foreach(RideFileCache *p, context->athlete->cpxCache) {
-                if (p->start == start && p->end == end) {
-                    *this = *p;
-                    return;
-                }
+    bool unfiltered = !filter && !context->isfiltered && !rideItem && (!onhome || !context->ishomefiltered);
+    if (unfiltered) {
+        foreach(RideFileCache *p, context->athlete->cpxCache) {
+            if (p->start == start && p->end == end) {
+                *this = *p;
+                return;
             }
         }
     }
@@ -1773,71 +1897,37 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
     // and less intrusive than a popup box
     context->mainWindow->setCursor(Qt::WaitCursor);
 
-    // Iterate over the ride files (not the cpx files since they /might/ not
-    // exist, or /might/ be out of date.
-    foreach (RideItem *item, context->athlete->rideCache->rides()) {
+    // unfiltered ranges are merged from the bests tree, which only
+    // needs to read the odd days at either end of the range
+    if (unfiltered) {
+        incomplete = !context->athlete->cpxTree->aggregate(this, start, end);
+    } else {
 
-        QDate rideDate = item->dateTime.date();
+        // Iterate over the ride files (not the cpx files since they /might/ not
+        // exist, or /might/ be out of date.
+        foreach (RideItem *item, context->athlete->rideCache->rides()) {
 
-        if (((filter == true && files.contains(item->fileName)) || filter == false) &&
-            rideDate >= start && rideDate <= end) {
+            QDate rideDate = item->dateTime.date();
 
-            // skip globally filtered values
-            if (context->isfiltered && !context->filters.contains(item->fileName)) continue;
-            if (onhome && context->ishomefiltered && !context->homeFilters.contains(item->fileName)) continue;
-            // skip other sports if rideItem is given
-            if (rideItem && ((rideItem->isRun != item->isRun) || (rideItem->isSwim != item->isSwim))) continue;
-
-            // get its cached values (will NOT! refresh if needed...)
-            // the true means it will check only
-            RideFileCache rideCache(context, context->athlete->home->activities().canonicalPath() + "/" + item->fileName, item->getWeight(), NULL, false, false);
-            if (rideCache.incomplete == true) {
-                // ack, data not available !
-                incomplete = true;
-            } else {
-
-                // lets aggregate
-                meanMaxAggregate(wattsMeanMaxDouble, rideCache.wattsMeanMaxDouble, wattsMeanMaxDate, rideDate);
-                meanMaxAggregate(hrMeanMaxDouble, rideCache.hrMeanMaxDouble, hrMeanMaxDate, rideDate);
-                meanMaxAggregate(cadMeanMaxDouble, rideCache.cadMeanMaxDouble, cadMeanMaxDate, rideDate);
-                meanMaxAggregate(nmMeanMaxDouble, rideCache.nmMeanMaxDouble, nmMeanMaxDate, rideDate);
-                meanMaxAggregate(kphMeanMaxDouble, rideCache.kphMeanMaxDouble, kphMeanMaxDate, rideDate);
-                meanMaxAggregate(kphdMeanMaxDouble, rideCache.kphdMeanMaxDouble, kphdMeanMaxDate, rideDate);
-                meanMaxAggregate(wattsdMeanMaxDouble, rideCache.wattsdMeanMaxDouble, wattsdMeanMaxDate, rideDate);
-                meanMaxAggregate(caddMeanMaxDouble, rideCache.caddMeanMaxDouble, caddMeanMaxDate, rideDate);
-                meanMaxAggregate(nmdMeanMaxDouble, rideCache.nmdMeanMaxDouble, nmdMeanMaxDate, rideDate);
-                meanMaxAggregate(hrdMeanMaxDouble, rideCache.hrdMeanMaxDouble, hrdMeanMaxDate, rideDate);
-                meanMaxAggregate(xPowerMeanMaxDouble, rideCache.xPowerMeanMaxDouble, xPowerMeanMaxDate, rideDate);
-                meanMaxAggregate(npMeanMaxDouble, rideCache.npMeanMaxDouble, npMeanMaxDate, rideDate);
-                meanMaxAggregate(vamMeanMaxDouble, rideCache.vamMeanMaxDouble, vamMeanMaxDate, rideDate);
-                meanMaxAggregate(wattsKgMeanMaxDouble, rideCache.wattsKgMeanMaxDouble, wattsKgMeanMaxDate, rideDate);
-                meanMaxAggregate(aPowerMeanMaxDouble, rideCache.aPowerMeanMaxDouble, aPowerMeanMaxDate, rideDate);
-                meanMaxAggregate(aPowerKgMeanMaxDouble, rideCache.aPowerKgMeanMaxDouble, aPowerKgMeanMaxDate, rideDate);
-
-                distAggregate(wattsDistributionDouble, rideCache.wattsDistributionDouble);
-                distAggregate(hrDistributionDouble, rideCache.hrDistributionDouble);
-                distAggregate(cadDistributionDouble, rideCache.cadDistributionDouble);
-                distAggregate(gearDistributionDouble, rideCache.gearDistributionDouble);
-                distAggregate(nmDistributionDouble, rideCache.nmDistributionDouble);
-                distAggregate(kphDistributionDouble, rideCache.kphDistributionDouble);
-                distAggregate(xPowerDistributionDouble, rideCache.xPowerDistributionDouble);
-                distAggregate(npDistributionDouble, rideCache.npDistributionDouble);
-                distAggregate(wattsKgDistributionDouble, rideCache.wattsKgDistributionDouble);
-                distAggregate(aPowerDistributionDouble, rideCache.aPowerDistributionDouble);
-                distAggregate(smo2DistributionDouble, rideCache.smo2DistributionDouble);
-                distAggregate(wbalDistributionDouble, rideCache.wbalDistributionDouble);
-
-                // cumulate timeinzones
-                for (int i=0; i<10; i++) {
-                    paceTimeInZone[i] += rideCache.paceTimeInZone[i];
-                    hrTimeInZone[i] += rideCache.hrTimeInZone[i];
-                    wattsTimeInZone[i] += rideCache.wattsTimeInZone[i];
-                    if (i<4) {
-                        paceCPTimeInZone[i] += rideCache.paceCPTimeInZone[i];
-                        hrCPTimeInZone[i] += rideCache.hrCPTimeInZone[i];
-                        wattsCPTimeInZone[i] += rideCache.wattsCPTimeInZone[i];
-                        wbalTimeInZone[i] += rideCache.wbalTimeInZone[i];
-                    }
+            if (((filter == true && files.contains(item->fileName)) || filter == false) &&
+                rideDate >= start && rideDate <= end) {
+
+                // skip globally filtered values
+                if (context->isfiltered && !context->filters.contains(item->fileName)) continue;
+                if (onhome && context->ishomefiltered && !context->homeFilters.contains(item->fileName)) continue;
+                // skip other sports if rideItem is given
+                if (rideItem && ((rideItem->isRun != item->isRun) || (rideItem->isSwim != item->isSwim))) continue;
+
+                // get its cached values (will NOT! refresh if needed...)
+                // the true means it will check only
+                RideFileCache rideCache(context, context->athlete->home->activities().canonicalPath() + "/" + item->fileName, item->getWeight(), NULL, false, false);
+                if (rideCache.incomplete == true) {
+                    // ack, data not available !
+                    incomplete = true;
+                } else {
+
+                    // lets aggregate
+                    aggregate(rideCache, rideDate);
                 }
             }
         }
@@ -1847,7 +1937,7 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
     context->mainWindow->setCursor(Qt::ArrowCursor);
 
     // lets add to the cache for others to re-use -- but not if filtered or incomplete
-    if (incomplete == false && !context->isfiltered && (!context->ishomefiltered || !onhome) && !filter) {
+    if (incomplete == false && unfiltered) {
 
         if (context->athlete->cpxCache.count() > maxcache) {
             delete(context->athlete->cpxCache.at(0));
@@ -26,6 +26,8 @@
 
 class Context;
 class RideFile;
+class RideFileCacheSamples;
+struct RideFileCacheTask;
 class RideBest;
 class MetricDetail;
 class Specification;
@@ -41,7 +43,7 @@ typedef double data_t;
 // arrays when plotting CP curves and histograms. It is precoputed
 // to save time and cached in a file .cpx
 //
-static const unsigned int RideFileCacheVersion = 25;
+static const unsigned int RideFileCacheVersion = 26;
 // revision history:
 // version  date         description
 // 1        29-Apr-11    Initial - header, mean-max & distribution data blocks
@@ -68,6 +70,7 @@ static const unsigned int RideFileCacheVersion = 25;
 // 23       14-Jun-15    Added W'bal TiZ and Distribution
 // 24       15-Jun-15    Fix percentify error on W'bal Distribution
 // 25       19-Dec-16    Added aPower
+// 26       16-Oct-26    Exact mean-max for every duration (MeanMaxEngine)
 
 // The cache file (.cpx) has a binary format:
 // 1 x Header data - describing the version and contents of the cache
@@ -143,6 +146,8 @@ struct RideFileCacheHeader {
 // This is the main user entry to the ridefile cached data.
 class RideFileCache
 {
+    friend class RideFileCacheTree;
+
     public:
         enum cachetype { meanmax, distribution, none };
         typedef enum cachetype CacheType;
@@ -239,7 +244,17 @@ class RideFileCache
 
         // NOW replaced computeMeanMax with MeanMaxComputer class see bottom of file
         //void computeMeanMax(QVector<float>&, RideFile::SeriesType);      // compute mean max arrays
-        void computeDistribution(QVector<float>&, RideFile::SeriesType); // compute the distributions
+        void computeDistribution(QVector<float>&, RideFile::SeriesType, const RideFileCacheSamples &); // compute the distributions
+
+        void setupZones();          // zone ranges, CP, LTHR et al for the distributions
+        static void computeTask(RideFileCacheTask &); // runs a mean-max or distribution for compute()
+
+        // an empty aggregate, RideFileCacheTree fills it
+        RideFileCache(Context *context);
+
+        // add the bests, distributions and time in zone of another ride or
+        // aggregate, a ride's bests are dated date, an aggregate keeps its own
+        void aggregate(RideFileCache &other, QDate date = QDate());
 
 
     private:
@@ -250,6 +265,7 @@ class RideFileCache
         RideFile *ride;
 
         // used for zoning
+        int zoneRange, hrZoneRange, paceZoneRange;
         int CP;
         int WPRIME;
         int LTHR;
@@ -404,20 +420,44 @@ struct cpintdata {
     cpintdata() : rec_int_ms(0) {}
 };
 
-// the mean-max computer ... runs in a thread
-class MeanMaxComputer : public QThread
+// The samples for every series the cache needs, taken from the ride
+// columns (see RideFile::column) up front so the mean-max and
+// distribution computers can each walk a flat array in parallel.
+// The mean-max fills in gaps in recording so slot maps each sample
+// to its place on that time base, -1 if dropped
+class RideFileCacheSamples
+{
+    public:
+        RideFileCacheSamples(RideFile *ride, QList<RideFile::SeriesType> series);
+
+        // values for every sample, NULL if the series wasn't gathered
+        const double *column(RideFile::SeriesType series) const;
+
+        int count;          // samples in the ride
+        int slots;          // samples once gaps have been filled
+        double lastSecs;    // time of the last slot
+        QVector<int> slot;  // sample -> slot
+
+    private:
+        QVector<RideFileColumn> columns; // by series, shared with the ride
+};
+
+// the mean-max computer ... runs as a task in compute() or can be
+// run directly for a single series (e.g. CriticalPowerWindow)
+class MeanMaxComputer
 {
     public:
-        MeanMaxComputer(RideFile *ride, QVector<float>&array, RideFile::SeriesType series)
-        : ride(ride), array(array), series(series) {}
+        MeanMaxComputer(RideFile *ride, QVector<float>&array, RideFile::SeriesType series,
+                        const RideFileCacheSamples *samples = NULL)
+        : ride(ride), array(array), series(series), samples(samples) {}
         void run();
 
     private:
 
         RideFile *ride;
         QVector<float> &array;
-        QVector<data_t> integratedArray;
 
         RideFile::SeriesType series;
+        const RideFileCacheSamples *samples;
 };
 #endif // _GC_RideFileCache_h
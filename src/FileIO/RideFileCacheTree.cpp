@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideFileCacheTree.h"
+#include "RideFileCache.h"
+#include "Context.h"
+#include "Athlete.h"
+#include "RideCache.h"
+#include "RideItem.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QDataStream>
+
+// the nodes kept in memory, at any level. a node can hold several MB of
+// arrays so enough for a couple of years of months and years and the
+// weeks either side, the rest are read back from disk when needed
+static const int maxnodes = 64;
+
+// bump when the layout changes, the .cpx version is saved too
+static const quint32 treeVersion = 2;
+
+RideFileCacheTree::RideFileCacheTree(Context *context) : context(context), indexed(false)
+{
+}
+
+RideFileCacheTree::~RideFileCacheTree()
+{
+    foreach(Node node, nodes) delete node.bests;
+}
+
+QDate
+RideFileCacheTree::lastDay(Level level, QDate begin)
+{
+    switch(level) {
+    case Week: return begin.addDays(6);
+    case Month: return begin.addMonths(1).addDays(-1);
+    default:
+    case Year: return begin.addYears(1).addDays(-1);
+    }
+}
+
+//
+// AGGREGATE A DATE RANGE
+//
+// The range is covered left to right by whole years, months and weeks
+// where they fit and single days where they don't. A week is not used
+// when it would straddle the start of a month the range covers, so
+// the months are still picked up, which leaves at most a few weeks and
+// days at either end.
+//
+bool
+RideFileCacheTree::aggregate(RideFileCache *into, QDate from, QDate to)
+{
+    QMutexLocker locker(&lock);
+
+    // no need to go back before the first ride or after the last
+    const QVector<RideItem*> &all = context->athlete->rideCache->rides();
+    if (all.isEmpty() || !from.isValid() || !to.isValid()) return true;
+    if (from < all.first()->dateTime.date()) from = all.first()->dateTime.date();
+    if (to > all.last()->dateTime.date()) to = all.last()->dateTime.date();
+
+    // only index the rides if we need to read some
+    indexed = false;
+    byDate.clear();
+
+    bool complete = true;
+    QDate date = from;
+    while (date <= to) {
+
+        QDate nextMonth = QDate(date.year(), date.month(), 1).addMonths(1);
+
+        if (date.dayOfYear() == 1 && lastDay(Year, date) <= to) {
+
+            complete &= part(Year, date, into);
+            date = date.addYears(1);
+
+        } else if (date.day() == 1 && lastDay(Month, date) <= to) {
+
+            complete &= part(Month, date, into);
+            date = nextMonth;
+
+        } else if (date.dayOfWeek() == 1 && lastDay(Week, date) <= to &&
+                   (lastDay(Week, date) < nextMonth || lastDay(Month, nextMonth) > to)) {
+
+            complete &= part(Week, date, into);
+            date = date.addDays(7);
+
+        } else {
+
+            // run of odd days up to the next week, month or the end
+            QDate last = date;
+            while (last < to && last.addDays(1).dayOfWeek() != 1 && last.addDays(1).day() != 1)
+                last = last.addDays(1);
+
+            complete &= rides(into, date, last);
+            date = last.addDays(1);
+        }
+    }
+
+    byDate.clear();
+    return complete;
+}
+
+bool
+RideFileCacheTree::part(Level level, QDate begin, RideFileCache *into)
+{
+    Key key(level, begin);
+    QDate end = lastDay(level, begin);
+
+    // read back from disk, is it still current?
+    if (!nodes.contains(key)) {
+        Node node;
+        if (read(key, node)) {
+            if (node.signature == signature(begin, end)) {
+                nodes.insert(key, node);
+            } else {
+                delete node.bests;
+                QFile::remove(fileName(key));
+            }
+        }
+    }
+
+    if (nodes.contains(key)) {
+        into->aggregate(*nodes[key].bests);
+        used(key);
+        return true;
+    }
+
+    // build it, a year from its months
+    Node node;
+    node.dirty = true;
+    node.bests = new RideFileCache(context);
+    node.bests->start = begin;
+    node.bests->end = end;
+
+    bool complete = true;
+    if (level == Year) {
+        for (QDate month = begin; month <= end; month = month.addMonths(1)) {
+            complete &= part(Month, month, node.bests);
+            if (nodes.contains(Key(Month, month))) node.signature << nodes[Key(Month, month)].signature;
+        }
+    } else {
+        complete = rides(node.bests, begin, end);
+        node.signature = signature(begin, end);
+    }
+
+    into->aggregate(*node.bests);
+
+    // don't keep it if some rides were missing, try again next time
+    if (complete) {
+        nodes.insert(key, node);
+        used(key);
+    } else {
+        delete node.bests;
+    }
+    return complete;
+}
+
+bool
+RideFileCacheTree::rides(RideFileCache *into, QDate from, QDate to)
+{
+    index();
+
+    bool complete = true;
+    QMap<QDate, QList<RideItem*> >::const_iterator it = byDate.lowerBound(from);
+    for (; it != byDate.constEnd() && it.key() <= to; ++it) {
+        foreach(RideItem *item, it.value()) {
+
+            // get its cached values (will NOT! refresh if needed...)
+            RideFileCache rideCache(context, context->athlete->home->activities().canonicalPath() + "/" + item->fileName,
+                                    item->getWeight(), NULL, false, false);
+
+            if (rideCache.incomplete == true) complete = false; // ack, data not available !
+            else into->aggregate(rideCache, it.key());
+        }
+    }
+    return complete;
+}
+
+// what went into a node, checked against a node read back from disk
+QStringList
+RideFileCacheTree::signature(QDate from, QDate to)
+{
+    index();
+
+    QStringList returning;
+    QString cache = context->athlete->home->cache().canonicalPath() + "/";
+    QMap<QDate, QList<RideItem*> >::const_iterator it = byDate.lowerBound(from);
+    for (; it != byDate.constEnd() && it.key() <= to; ++it) {
+        foreach(RideItem *item, it.value()) {
+            QFileInfo cpx(cache + QFileInfo(item->fileName).baseName() + ".cpx");
+            returning << item->fileName + "@" + QString::number(cpx.lastModified().toMSecsSinceEpoch());
+        }
+    }
+    return returning;
+}
+
+void
+RideFileCacheTree::index()
+{
+    if (indexed) return;
+    indexed = true;
+
+    // rides are sorted by date so they stay in order within a day
+    foreach(RideItem *item, context->athlete->rideCache->rides())
+        if (!item->planned) byDate[item->dateTime.date()] << item;
+}
+
+void
+RideFileCacheTree::drop(Key key)
+{
+    if (nodes.contains(key)) {
+        if (nodes[key].dirty) write(key, nodes[key]);
+        delete nodes[key].bests;
+        nodes.remove(key);
+    }
+    recent.removeAll(key);
+}
+
+void
+RideFileCacheTree::remove(Key key)
+{
+    delete nodes.value(key).bests;
+    nodes.remove(key);
+    recent.removeAll(key);
+    QFile::remove(fileName(key));
+}
+
+void
+RideFileCacheTree::used(Key key)
+{
+    recent.removeAll(key);
+    recent.append(key);
+    while (recent.count() > maxnodes) drop(recent.first());
+}
+
+void
+RideFileCacheTree::invalidate(QDate date)
+{
+    QMutexLocker locker(&lock);
+
+    remove(Key(Week, date.addDays(1 - date.dayOfWeek())));
+    remove(Key(Month, QDate(date.year(), date.month(), 1)));
+    remove(Key(Year, QDate(date.year(), 1, 1)));
+}
+
+//
+// PERSISTANCE
+//
+// the aggregate arrays of a node, in the order they are saved
+void
+RideFileCacheTree::arrays(RideFileCache *c, QList<QVector<double>*> &doubles, QList<QVector<QDate>*> &dates, QList<QVector<float>*> &zones)
+{
+    doubles << &c->wattsMeanMaxDouble << &c->hrMeanMaxDouble << &c->cadMeanMaxDouble << &c->nmMeanMaxDouble
+            << &c->kphMeanMaxDouble << &c->kphdMeanMaxDouble << &c->wattsdMeanMaxDouble << &c->caddMeanMaxDouble
+            << &c->nmdMeanMaxDouble << &c->hrdMeanMaxDouble << &c->xPowerMeanMaxDouble << &c->npMeanMaxDouble
+            << &c->vamMeanMaxDouble << &c->wattsKgMeanMaxDouble << &c->aPowerMeanMaxDouble << &c->aPowerKgMeanMaxDouble
+            << &c->wattsDistributionDouble << &c->hrDistributionDouble << &c->gearDistributionDouble
+            << &c->cadDistributionDouble << &c->nmDistributionDouble << &c->kphDistributionDouble
+            << &c->xPowerDistributionDouble << &c->npDistributionDouble << &c->wattsKgDistributionDouble
+            << &c->aPowerDistributionDouble << &c->smo2DistributionDouble << &c->wbalDistributionDouble;
+
+    dates << &c->wattsMeanMaxDate << &c->hrMeanMaxDate << &c->cadMeanMaxDate << &c->nmMeanMaxDate
+          << &c->kphMeanMaxDate << &c->kphdMeanMaxDate << &c->wattsdMeanMaxDate << &c->caddMeanMaxDate
+          << &c->nmdMeanMaxDate << &c->hrdMeanMaxDate << &c->xPowerMeanMaxDate << &c->npMeanMaxDate
+          << &c->vamMeanMaxDate << &c->wattsKgMeanMaxDate << &c->aPowerMeanMaxDate << &c->aPowerKgMeanMaxDate;
+
+    zones << &c->wattsTimeInZone << &c->wattsCPTimeInZone << &c->hrTimeInZone << &c->hrCPTimeInZone
+          << &c->paceTimeInZone << &c->paceCPTimeInZone << &c->wbalTimeInZone;
+}
+
+QString
+RideFileCacheTree::fileName(Key key) const
+{
+    static const char *levels[] = { "week", "month", "year" };
+    return QString("%1/bests/%2-%3.node").arg(context->athlete->home->cache().canonicalPath())
+                                         .arg(levels[key.first])
+                                         .arg(key.second.toString("yyyyMMdd"));
+}
+
+bool
+RideFileCacheTree::read(Key key, Node &node)
+{
+    QFile file(fileName(key));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 version, cpxVersion;
+    qint32 level;
+    QDate begin;
+    in >> version >> cpxVersion >> level >> begin;
+
+    // an older layout or .cpx version, or not the node we think it is
+    bool valid = in.status() == QDataStream::Ok && version == treeVersion && cpxVersion == RideFileCacheVersion &&
+                 level == key.first && begin == key.second;
+
+    if (valid) {
+        in >> node.signature;
+
+        node.bests = new RideFileCache(context);
+        node.bests->start = begin;
+        node.bests->end = lastDay(Level(level), begin);
+
+        QList<QVector<double>*> doubles;
+        QList<QVector<QDate>*> dates;
+        QList<QVector<float>*> zones;
+        arrays(node.bests, doubles, dates, zones);
+        foreach(QVector<double> *array, doubles) in >> *array;
+        foreach(QVector<QDate> *array, dates) in >> *array;
+        foreach(QVector<float> *array, zones) in >> *array;
+
+        // truncated or trailing junk, it was not written whole
+        valid = in.status() == QDataStream::Ok && in.atEnd();
+        if (!valid) {
+            delete node.bests;
+            node.bests = NULL;
+        }
+    }
+
+    // it will be built again and rewritten
+    if (!valid) {
+        file.close();
+        file.remove();
+    }
+    node.dirty = false;
+    return valid;
+}
+
+bool
+RideFileCacheTree::write(Key key, const Node &node)
+{
+    QDir().mkpath(context->athlete->home->cache().canonicalPath() + "/bests");
+
+    // written whole or not at all
+    QSaveFile file(fileName(key));
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << treeVersion << quint32(RideFileCacheVersion) << qint32(key.first) << key.second << node.signature;
+
+    QList<QVector<double>*> doubles;
+    QList<QVector<QDate>*> dates;
+    QList<QVector<float>*> zones;
+    arrays(node.bests, doubles, dates, zones);
+    foreach(QVector<double> *array, doubles) out << *array;
+    foreach(QVector<QDate> *array, dates) out << *array;
+    foreach(QVector<float> *array, zones) out << *array;
+
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+void
+RideFileCacheTree::save()
+{
+    QMutexLocker locker(&lock);
+
+    QMap<Key, Node>::iterator it = nodes.begin();
+    for (; it != nodes.end(); ++it)
+        if (it.value().dirty && write(it.key(), it.value())) it.value().dirty = false;
+
+    // the whole tree used to go in one file
+    QFile::remove(context->athlete->home->cache().canonicalPath() + "/bests.tree");
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideFileCacheTree_h
+#define _GC_RideFileCacheTree_h 1
+#include "GoldenCheetah.h"
+
+#include <QDate>
+#include <QMap>
+#include <QList>
+#include <QVector>
+#include <QPair>
+#include <QMutex>
+#include <QStringList>
+
+class Context;
+class RideItem;
+class RideFileCache;
+
+// RideFileCacheTree keeps the mean-max, distribution and time in zone
+// arrays of the athlete's rides already aggregated by calendar week,
+// month and year. A date range is answered by merging the few nodes
+// that cover it, and only the odd days at either end are read from
+// the ride .cpx files, rather than reading every ride in the range.
+//
+// Nodes are built when they are first needed, a year from its months,
+// and dropped when a ride in their period is added, deleted or has
+// its .cpx refreshed. Each is kept in its own file in cache/bests, read
+// when it is first needed and checked against the .cpx files then.
+// Only the most recently used are kept in memory, whatever the level,
+// and only nodes that were built are written, when they are dropped
+// from memory or the athlete is closed.
+//
+// Only unfiltered ranges can use it, anything filtered still goes
+// through the rides one by one in RideFileCache.
+class RideFileCacheTree
+{
+    public:
+
+        RideFileCacheTree(Context *context);
+        ~RideFileCacheTree();
+
+        // aggregate every ride from - to into the (empty) cache
+        // returns false if some of the .cpx files were not available
+        bool aggregate(RideFileCache *into, QDate from, QDate to);
+
+        // a ride on this date has changed, been added or deleted
+        void invalidate(QDate date);
+
+        // write the nodes built since they were last written
+        void save();
+
+    private:
+
+        enum Level { Week, Month, Year };
+        typedef QPair<int, QDate> Key; // level and first day
+
+        struct Node {
+            Node() : bests(NULL), dirty(false) {}
+            RideFileCache *bests;
+            QStringList signature;  // fileName@cpx-mtime for every ride
+            bool dirty;             // built, not written yet
+        };
+
+        static QDate lastDay(Level level, QDate begin);
+
+        // the aggregate arrays of a node, in the order they are saved
+        static void arrays(RideFileCache *c, QList<QVector<double>*> &doubles,
+                           QList<QVector<QDate>*> &dates, QList<QVector<float>*> &zones);
+
+        // merge the node into the cache, building it if needed
+        bool part(Level level, QDate begin, RideFileCache *into);
+
+        // aggregate rides from the .cpx files directly
+        bool rides(RideFileCache *into, QDate from, QDate to);
+
+        QStringList signature(QDate from, QDate to);
+        void index();
+        void drop(Key key);     // from memory, written first if dirty
+        void remove(Key key);   // from memory and disk
+        void used(Key key);
+
+        // a node file, read() removes it if it isn't valid
+        QString fileName(Key key) const;
+        bool read(Key key, Node &node);
+        bool write(Key key, const Node &node);
+
+        Context *context;
+        QMutex lock;
+        QMap<Key, Node> nodes;  // in memory
+        QList<Key> recent;      // least recently used first
+
+        // the rides by date, built per aggregate and only if needed
+        QMap<QDate, QList<RideItem*> > byDate;
+        bool indexed;
+};
+
+#endif // _GC_RideFileCacheTree_h
@@ -28,6 +28,33 @@ static bool doubles_equal(double a, double b)
     double errorB = b * DBL_EPSILON;
     return (a >= b - errorB) && (a <= b + errorB);
 }
+
+// xdata columns are secs, km and then the values
+static void
+getXDataValues(const XDataSeries *series, int row, int col, double *values, int count)
+{
+    for (int i=0; i<count; i++) {
+        const XDataPoint *p = series->datapoints[row+i];
+        switch(col) {
+        case 0: values[i] = p->secs; break;
+        case 1: values[i] = p->km; break;
+        default: values[i] = p->number[col-2]; break;
+        }
+    }
+}
+
+static void
+setXDataValues(XDataSeries *series, int row, int col, const double *values, int count)
+{
+    for (int i=0; i<count; i++) {
+        XDataPoint *p = series->datapoints[row+i];
+        switch(col) {
+        case 0: p->secs = values[i]; break;
+        case 1: p->km = values[i]; break;
+        default: p->number.set(col-2, values[i]); break;
+        }
+    }
+}
 //----------------------------------------------------------------------
 // The public interface to the commands
 //----------------------------------------------------------------------
@@ -178,6 +205,66 @@ RideFileCommand::appendXDataPoints(QString _xdata, QVector <XDataPoint *> newRow
     doCommand(cmd);
 }
 
+void
+RideFileCommand::setPointValues(int index, RideFile::SeriesType series, QVector<double> values)
+{
+    if (index < 0 || values.isEmpty() || index + values.count() > ride->dataPoints().count()) return;
+
+    // get current values
+    QVector<double> current(values.count());
+    for (int i=0; i<values.count(); i++) current[i] = ride->getPointValue(index+i, series);
+
+    // don't fill the undo stack with nothing
+    if (current == values) return;
+
+    SetPointValuesCommand *cmd = new SetPointValuesCommand(ride, index, series, current, values);
+    doCommand(cmd);
+}
+
+void
+RideFileCommand::setXDataPointValues(QString xdata, int index, int column, QVector<double> values)
+{
+    XDataSeries *series = ride->xdata(xdata);
+    if (!series || column < 0 || column >= series->valuename.count() + 2) return;
+    if (index < 0 || values.isEmpty() || index + values.count() > series->datapoints.count()) return;
+
+    // get current values
+    QVector<double> current(values.count());
+    getXDataValues(series, index, column, current.data(), current.count());
+
+    if (current == values) return;
+
+    SetXDataPointValuesCommand *cmd = new SetXDataPointValuesCommand(ride, xdata, index, column, current, values);
+    doCommand(cmd);
+}
+
+void
+RideFileCommand::setXDataColumn(QString xdata, int column, QVector<double> values)
+{
+    setXDataPointValues(xdata, 0, column, values);
+}
+
+void
+RideFileCommand::appendXDataColumns(QString xdata, QVector<double> secs, QVector<double> km,
+                                    QVector<QVector<double> > columns)
+{
+    XDataSeries *series = ride->xdata(xdata);
+    if (!series) return;
+
+    // build the rows from the columns, anything missing is zero
+    int values = series->valuename.count();
+    QVector<XDataPoint*> rows(secs.count());
+    for (int i=0; i<rows.count(); i++) {
+        XDataPoint *p = new XDataPoint(values);
+        p->secs = secs[i];
+        if (i < km.count()) p->km = km[i];
+        for (int c=0; c<values && c<columns.count(); c++)
+            if (i < columns[c].count()) p->number[c] = columns[c][i];
+        rows[i] = p;
+    }
+    appendXDataPoints(xdata, rows);
+}
+
 //----------------------------------------------------------------------
 // Manage the Command Stack
 //----------------------------------------------------------------------
@@ -205,6 +292,12 @@ RideFileCommand::endLUW()
 
     // add to the stack if it isn't empty
     if (luw->worklist.count()) doCommand(luw, true);
+    else {
+        // close it for those that saw it start
+        endCommand(false, luw);
+        delete luw;
+    }
+    luw = NULL;
 }
 
 void
@@ -544,14 +637,12 @@ RemoveXDataSeriesCommand::doCommand()
     // snaffle away the data and clear
     values.resize(series->datapoints.count());
     for(int i=0; i<series->datapoints.count(); i++) {
-        values[i] = series->datapoints[i]->number[index];
-        series->datapoints[i]->number[index] = 0;
+        XDataPoint *p = series->datapoints[i];
+        values[i] = p->number.value(index);
 
         // shift the values down
-        for(int j=index+1; j<8; j++) {
-            series->datapoints[i]->number[j-1] =
-            series->datapoints[i]->number[j];
-        }
+        for(int j=index+1; j<p->number.count(); j++) p->number[j-1] = p->number[j];
+        if (index < p->number.count()) p->number.resize(p->number.count()-1);
     }
 
     // remove the name
@@ -573,12 +664,12 @@ RemoveXDataSeriesCommand::undoCommand()
 
     // put data back
     for(int i=0; i<series->datapoints.count(); i++) {
+        XDataPoint *p = series->datapoints[i];
+        p->number.resize(series->valuename.count());
+
         // shift the values right
-        for(int j=index; j<7; j++) {
-            series->datapoints[i]->number[j+1] =
-            series->datapoints[i]->number[j];
-        }
-        series->datapoints[i]->number[index] = values[i];
+        for(int j=p->number.count()-1; j>index; j--) p->number[j] = p->number[j-1];
+        p->number[index] = values[i];
     }
     return true;
 }
@@ -602,8 +693,9 @@ AddXDataSeriesCommand::doCommand()
     int index = series->valuename.indexOf(name);
     if (index == -1) return false;
 
-    // Clear the value
+    // Make room for the value
     for(int i=0; i<series->datapoints.count(); i++) {
+        series->datapoints[i]->number.resize(series->valuename.count());
         series->datapoints[i]->number[index] = 0;
     }
 
@@ -620,6 +712,7 @@ AddXDataSeriesCommand::undoCommand()
     int index = series->valuename.count()-1;
     if (index == -1) return false;
     series->valuename.removeAt(index);
+    foreach(XDataPoint *p, series->datapoints) p->number.resize(series->valuename.count());
 
     return true;
 }
@@ -644,7 +737,7 @@ SetXDataPointValueCommand::doCommand()
             series->datapoints[row]->km = newvalue;
             break;
         default:
-            series->datapoints[row]->number[col-2] = newvalue;
+            series->datapoints[row]->number.set(col-2, newvalue);
         }
     }
     return true;
@@ -662,12 +755,65 @@ SetXDataPointValueCommand::undoCommand()
             series->datapoints[row]->km = oldvalue;
             break;
         default:
-            series->datapoints[row]->number[col-2] = oldvalue;
+            series->datapoints[row]->number.set(col-2, oldvalue);
         }
     }
     return true;
 }
 
+// Set a range of values
+SetPointValuesCommand::SetPointValuesCommand(RideFile *ride, int row, RideFile::SeriesType series,
+            QVector<double> oldvalues, QVector<double> newvalues) :
+            RideCommand(ride), // base class looks after these
+            row(row), count(newvalues.count()), series(series), oldvalues(oldvalues), newvalues(newvalues)
+{
+    type = RideCommand::SetPointValues;
+    description = tr("Set Values");
+}
+
+bool
+SetPointValuesCommand::doCommand()
+{
+    for (int i=0; i<count; i++) ride->setPointValue(row+i, series, newvalues[i]);
+    return true;
+}
+
+bool
+SetPointValuesCommand::undoCommand()
+{
+    for (int i=0; i<count; i++) ride->setPointValue(row+i, series, oldvalues[i]);
+    return true;
+}
+
+SetXDataPointValuesCommand::SetXDataPointValuesCommand(RideFile *ride, QString xdata, int row, int col,
+            QVector<double> oldvalues, QVector<double> newvalues) :
+            RideCommand(ride), // base class looks after these
+            row(row), col(col), count(newvalues.count()), xdata(xdata), oldvalues(oldvalues), newvalues(newvalues)
+{
+    type = RideCommand::SetXDataPointValues;
+    description = tr("Set XData point values");
+}
+
+bool
+SetXDataPointValuesCommand::doCommand()
+{
+    XDataSeries *series = ride->xdata(xdata);
+    if (!series) return false;
+
+    setXDataValues(series, row, col, newvalues.constData(), count);
+    return true;
+}
+
+bool
+SetXDataPointValuesCommand::undoCommand()
+{
+    XDataSeries *series = ride->xdata(xdata);
+    if (!series) return false;
+
+    setXDataValues(series, row, col, oldvalues.constData(), count);
+    return true;
+}
+
 // Remove points
 DeleteXDataPointsCommand::DeleteXDataPointsCommand(RideFile *ride, QString xdata, int row, int count,
                      QVector<XDataPoint *> current) :
@@ -65,6 +65,14 @@ class RideFileCommand : public QObject
         void insertXDataPoint(QString xdata, int index, XDataPoint *point);
         void appendXDataPoints(QString xdata, QVector<XDataPoint*> rows);
 
+        // bulk edits, a whole range in one command so there is one undo
+        // entry and one pair of signals rather than one for each value
+        void setPointValues(int index, RideFile::SeriesType series, QVector<double> values);
+        void setXDataPointValues(QString xdata, int index, int column, QVector<double> values);
+        void setXDataColumn(QString xdata, int column, QVector<double> values); // all the rows
+        void appendXDataColumns(QString xdata, QVector<double> secs, QVector<double> km,
+                                QVector<QVector<double> > columns);
+
         // execute atomic actions
         void doCommand(RideCommand*, bool noexec=false);
         void undoCommand();
@@ -106,7 +114,8 @@ class RideCommand
         // supported command types
         enum commandtype { NoOp, LUW, SetPointValue, DeletePoint, DeletePoints, InsertPoint, AppendPoints, SetDataPresent,
                            removeXData, addXData, RemoveXDataSeries, AddXDataSeries,
-                           SetXDataPointValue, DeleteXDataPoints, InsertXDataPoint, AppendXDataPoints };
+                           SetXDataPointValue, DeleteXDataPoints, InsertXDataPoint, AppendXDataPoints,
+                           SetPointValues, SetXDataPointValues };
         typedef enum commandtype CommandType;
 
 
@@ -224,6 +233,38 @@ class SetXDataPointValueCommand : public RideCommand
         double oldvalue, newvalue;
 };
 
+class SetPointValuesCommand : public RideCommand
+{
+    Q_DECLARE_TR_FUNCTIONS(SetPointValuesCommand)
+
+    public:
+        SetPointValuesCommand(RideFile *ride, int row, RideFile::SeriesType series,
+                              QVector<double> oldvalues, QVector<double> newvalues);
+        bool doCommand();
+        bool undoCommand();
+
+        // state
+        int row, count;
+        RideFile::SeriesType series;
+        QVector<double> oldvalues, newvalues;
+};
+
+class SetXDataPointValuesCommand : public RideCommand
+{
+    Q_DECLARE_TR_FUNCTIONS(SetXDataPointValuesCommand)
+
+    public:
+        SetXDataPointValuesCommand(RideFile *ride, QString xdata, int row, int col,
+                                   QVector<double> oldvalues, QVector<double> newvalues);
+        bool doCommand();
+        bool undoCommand();
+
+        // state
+        int row, col, count;
+        QString xdata;
+        QVector<double> oldvalues, newvalues;
+};
+
 class DeleteXDataPointsCommand : public RideCommand
 {
     Q_DECLARE_TR_FUNCTIONS(DeletePointsCommand)
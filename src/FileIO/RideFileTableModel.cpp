@@ -428,6 +428,13 @@ RideFileTableModel::endCommand(bool undo, RideCommand *cmd)
             dataChanged(cell, cell);
             break;
         }
+        case RideCommand::SetPointValues:
+        {
+            SetPointValuesCommand *spv = (SetPointValuesCommand*)cmd;
+            int column = headingsType.indexOf(spv->series);
+            dataChanged(index(spv->row, column), index(spv->row + spv->count - 1, column));
+            break;
+        }
         case RideCommand::InsertPoint:
             if (!undo) endInsertRows();
             else endRemoveRows();
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TrainJournalRideFile.h"
+#include "TrainJournal.h"
+
+#include <string.h>
+
+static int trainJournalFileReaderRegistered =
+    RideFileFactory::instance().registerReader(
+        "gcj", "GoldenCheetah Train Journal", new TrainJournalFileReader());
+
+RideFile *
+TrainJournalFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
+{
+    if (!file.open(QFile::ReadOnly)) {
+        errors << ("Could not open ride file: \"" + file.fileName() + "\"");
+        return NULL;
+    }
+
+    // it is small, an hour is a few mb
+    QByteArray bytes = file.readAll();
+    file.close();
+
+    TrainJournalHeader header;
+    if (bytes.size() < int(sizeof(header))) {
+        errors << "Not a train journal: \"" + file.fileName() + "\"";
+        return NULL;
+    }
+    memcpy(&header, bytes.constData(), sizeof(header));
+
+    if (memcmp(header.magic, "GCTJ", 4) || header.version == 0 || header.version > TrainJournalVersion
+        || header.recordSize < sizeof(TrainJournalRecord) || header.sampleMsecs == 0) {
+        errors << "Not a train journal or from a newer version of GoldenCheetah: \"" + file.fileName() + "\"";
+        return NULL;
+    }
+
+    // a record cut short when we went down is just left off
+    const char *records = bytes.constData() + sizeof(header);
+    int count = (bytes.size() - sizeof(header)) / header.recordSize;
+
+    RideFile *rideFile = new RideFile();
+    rideFile->setDeviceType("GoldenCheetah");
+    rideFile->setFileFormat("GoldenCheetah Train Journal (gcj)");
+    rideFile->setStartTime(QDateTime::fromMSecsSinceEpoch(header.startTime));
+    rideFile->setRecIntSecs(header.sampleMsecs / 1000.0);
+    rideFile->reservePoints(count);
+
+    XDataSeries *trainSeries = NULL, *rrSeries = NULL;
+    qint64 last = -1;
+    int damaged = 0;
+
+    for (int i=0; i<count; i++) {
+
+        const char *at = records + i * header.recordSize;
+
+        TrainJournalRecord record;
+        memcpy(&record, at, sizeof(record));
+        if (record.checksum != qChecksum(at + sizeof(record.checksum), header.recordSize - sizeof(record.checksum))) {
+            damaged++;
+            continue;
+        }
+
+        switch (record.type) {
+
+        case TrainJournalRecord::Sample:
+            {
+                // polls are near enough sampleMsecs apart, put them on the
+                // recording interval and keep the first if two land together
+                qint64 sample = qRound64(double(record.msecs) / header.sampleMsecs);
+                if (sample <= last) break;
+                last = sample;
+
+                double secs = sample * rideFile->recIntSecs();
+
+                rideFile->appendPoint(secs, record.cad, record.hr, record.km,
+                                      record.kph, 0.0, record.watts, record.alt,
+                                      record.lon, record.lat, 0.0, record.slope,
+                                      RideFile::NA, record.lrbalance,
+                                      record.lte, record.rte, record.lps, record.rps,
+                                      0.0, 0.0,
+                                      0.0, 0.0, 0.0, 0.0,
+                                      0.0, 0.0, 0.0, 0.0,
+                                      record.smo2, record.thb,
+                                      0.0, 0.0, 0.0, 0.0, record.lap);
+
+                // the erg target, as the .csv had it
+                if (record.load > 0) {
+                    if (trainSeries == NULL) {
+                        trainSeries = new XDataSeries();
+                        trainSeries->name = "TRAIN";
+                        trainSeries->valuename << "TARGET";
+                        trainSeries->unitname << "Watts";
+                    }
+
+                    XDataPoint *p = trainSeries->newPoint();
+                    p->secs = secs;
+                    p->km = record.km;
+                    p->number[0] = long(record.load);
+                    trainSeries->datapoints.append(p);
+                }
+            }
+            break;
+
+        case TrainJournalRecord::RR:
+            {
+                if (rrSeries == NULL) {
+                    rrSeries = new XDataSeries();
+                    rrSeries->name = "HRV"; // using same format as Polar HRV imports
+                    rrSeries->valuename << "R-R";
+                    rrSeries->unitname << "msecs";
+                }
+
+                XDataPoint *p = rrSeries->newPoint();
+                p->secs = record.msecs / 1000.0;
+                p->km = 0;
+                p->number[0] = record.rr;
+                rrSeries->datapoints.append(p);
+            }
+            break;
+
+        default: // from a later version
+            break;
+        }
+    }
+
+    if (damaged) errors << QString("%1 damaged records were skipped").arg(damaged);
+
+    if (trainSeries) rideFile->addXData("TRAIN", trainSeries);
+    if (rrSeries) rideFile->addXData("HRV", rrSeries);
+
+    // did we actually read any samples?
+    if (rideFile->dataPoints().count() == 0) {
+        errors << "No samples present.";
+        delete rideFile;
+        return NULL;
+    }
+
+    return rideFile;
+}
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "XDataAlignment.h"
+#include "RideFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+XDataAlignment::XDataAlignment(const XDataSeries *first, const XDataSeries *second, double interval) :
+    first(first), second(second), interval(interval > 0 ? interval : 1.0)
+{
+}
+
+bool
+XDataAlignment::addChannel(QString firstName, QString secondName)
+{
+    int a = first ? first->valuename.indexOf(firstName) : -1;
+    int b = second ? second->valuename.indexOf(secondName) : -1;
+    if (a < 0 || b < 0) return false;
+
+    channels << QPair<int, int>(a, b);
+    return true;
+}
+
+XDataAlignment::Lag
+XDataAlignment::lag(double start, double end, double maxLag) const
+{
+    int count = qMax(2, static_cast<int>((end - start) / interval));
+    return window(start, count, static_cast<int>(ceil(maxLag / interval)));
+}
+
+QVector<XDataAlignment::Lag>
+XDataAlignment::lags(double start, double end, double window, double step, double maxLag) const
+{
+    QVector<Lag> returning;
+
+    // not long enough for more than one
+    if (end - start <= window || step <= 0) {
+        returning << lag(start, end, maxLag);
+        return returning;
+    }
+
+    int count = static_cast<int>(window / interval);
+    int most = static_cast<int>(ceil(maxLag / interval));
+    for (double from = start; from + window <= end; from += step)
+        returning << this->window(from, count, most);
+
+    return returning;
+}
+
+double
+XDataAlignment::lagAt(const QVector<Lag> &lags, double secs)
+{
+    if (lags.isEmpty()) return 0;
+    if (secs <= lags.first().secs) return lags.first().lag;
+    if (secs >= lags.last().secs) return lags.last().lag;
+
+    int i = 1;
+    while (lags[i].secs < secs) i++;
+
+    const Lag &a = lags[i-1], &b = lags[i];
+    return a.lag + (b.lag - a.lag) * (secs - a.secs) / (b.secs - a.secs);
+}
+
+XDataAlignment::Lag
+XDataAlignment::window(double start, int count, int maxLag) const
+{
+    Lag returning;
+    returning.secs = start + count * interval / 2.0;
+    returning.lag = 0;
+    returning.confidence = 0;
+
+    // the first for the window, the second for the window and as far
+    // as it can be out either side
+    QVector<double> a(count), b(count + 2 * maxLag), ncc;
+    QVector<double> sum(2 * maxLag + 1, 0.0);
+    int used = 0;
+
+    for (int c=0; c<channels.count(); c++) {
+        resample(first, channels[c].first, start, a);
+        resample(second, channels[c].second, start - maxLag * interval, b);
+
+        if (correlate(a, b, ncc)) {
+            for (int j=0; j<sum.count(); j++) sum[j] += ncc[j];
+            used++;
+        }
+    }
+    if (!used) return returning;
+
+    int peak = static_cast<int>(std::max_element(sum.begin(), sum.end()) - sum.begin());
+
+    // fit a parabola through the peak for part of a sample
+    double part = 0;
+    if (peak > 0 && peak < sum.count() - 1) {
+        double curve = sum[peak-1] - 2 * sum[peak] + sum[peak+1];
+        if (curve < 0) part = 0.5 * (sum[peak-1] - sum[peak+1]) / curve;
+    }
+
+    returning.lag = (peak - maxLag + part) * interval;
+    returning.confidence = qBound(0.0, sum[peak] / used, 1.0);
+    return returning;
+}
+
+void
+XDataAlignment::resample(const XDataSeries *series, int column, double start, QVector<double> &values) const
+{
+    const QVector<XDataPoint*> &points = series->datapoints;
+    const int n = points.count();
+
+    // first sample at or after the start
+    int i = static_cast<int>(std::lower_bound(points.begin(), points.end(), start,
+                             [](const XDataPoint *p, double secs) { return p->secs < secs; }) - points.begin());
+
+    for (int k=0; k<values.count(); k++) {
+        double secs = start + k * interval;
+        while (i < n && points[i]->secs < secs) i++;
+
+        // NAN before and after the series, correlate() fills it
+        if (i == n) values[k] = NAN;
+        else if (points[i]->secs == secs) values[k] = points[i]->number[column];
+        else if (i == 0) values[k] = NAN;
+        else {
+            const XDataPoint *p0 = points[i-1], *p1 = points[i];
+            double v0 = p0->number[column], v1 = p1->number[column];
+            values[k] = v0 + (v1 - v0) * (secs - p0->secs) / (p1->secs - p0->secs);
+        }
+    }
+}
+
+// normalised cross correlation of a with b at each offset of a along b,
+// false if either has too little data or is flat
+bool
+XDataAlignment::correlate(QVector<double> &a, QVector<double> &b, QVector<double> &ncc) const
+{
+    const int n = a.count(), m = b.count();
+    if (n < 2 || m < n) return false;
+
+    // missing samples are set to the mean so they add nothing
+    QVector<double> *both[] = { &a, &b };
+    for (QVector<double> *values : both) {
+        double total = 0;
+        int valid = 0;
+        for (double v : *values) if (!std::isnan(v)) { total += v; valid++; }
+        if (valid < values->count() / 2) return false;
+
+        double mean = total / valid;
+        for (double &v : *values) if (std::isnan(v)) v = mean;
+    }
+
+    // a less its mean, so each offset only needs the sum of a * b
+    double mean = std::accumulate(a.begin(), a.end(), 0.0) / n;
+    double norm = 0;
+    for (double &v : a) { v -= mean; norm += v * v; }
+    if (norm <= 0) return false;
+    norm = sqrt(norm);
+
+    // a * b at every offset at once
+    int size = 1;
+    while (size < m) size <<= 1;
+
+    QVector<std::complex<double> > fa(size), fb(size);
+    for (int i=0; i<n; i++) fa[i] = a[i];
+    for (int i=0; i<m; i++) fb[i] = b[i];
+    fft(fa, false);
+    fft(fb, false);
+    for (int i=0; i<size; i++) fa[i] = std::conj(fa[i]) * fb[i];
+    fft(fa, true);
+
+    // the spread of b under a at each offset, from running sums
+    QVector<double> sum(m + 1), squares(m + 1);
+    sum[0] = squares[0] = 0;
+    for (int i=0; i<m; i++) {
+        sum[i+1] = sum[i] + b[i];
+        squares[i+1] = squares[i] + b[i] * b[i];
+    }
+
+    ncc.resize(m - n + 1);
+    for (int j=0; j<ncc.count(); j++) {
+        double s = sum[j+n] - sum[j];
+        double spread = squares[j+n] - squares[j] - s * s / n;
+
+        // flat, nothing to match
+        ncc[j] = spread > 1e-9 * n ? fa[j].real() / (norm * sqrt(spread)) : 0;
+    }
+    return true;
+}
+
+void
+XDataAlignment::fft(QVector<std::complex<double> > &data, bool inverse)
+{
+    const int n = data.count();
+    std::complex<double> *x = data.data();
+
+    // bit reverse the order
+    for (int i=1, j=0; i<n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(x[i], x[j]);
+    }
+
+    // then the butterflies
+    for (int length=2; length<=n; length <<= 1) {
+        double angle = (inverse ? 2 : -2) * M_PI / length;
+        std::complex<double> step(cos(angle), sin(angle));
+
+        for (int i=0; i<n; i+=length) {
+            std::complex<double> w(1, 0);
+            for (int k=0; k<length/2; k++) {
+                std::complex<double> u = x[i+k], v = x[i+k+length/2] * w;
+                x[i+k] = u + v;
+                x[i+k+length/2] = u - v;
+                w *= step;
+            }
+        }
+    }
+
+    if (inverse) for (int i=0; i<n; i++) x[i] /= n;
+}
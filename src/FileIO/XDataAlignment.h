@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_XDataAlignment_h
+#define _GC_XDataAlignment_h 1
+#include "GoldenCheetah.h"
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <complex>
+
+class XDataSeries;
+
+// XDataAlignment finds the time offset between two recordings of the same
+// ride, e.g. the Notio BCVX and the head unit GARMIN xdata, and how it
+// drifts over a long ride.
+//
+// Both are resampled onto a common grid and for a window of the first the
+// normalised cross correlation with the second is found for every lag at
+// once with an FFT, so a window of n samples costs O(n log n). When more
+// than one channel is correlated (speed and power) the correlations are
+// averaged. The lag is where they peak and the peak (0-1) is how much we
+// can trust it; a flat or noisy window peaks low.
+//
+// A lag is how far behind the first the second is, in seconds, so the
+// second at t + lag matches the first at t.
+class XDataAlignment
+{
+    public:
+
+        struct Lag {
+            double secs;        // middle of the window
+            double lag;         // secs
+            double confidence;  // peak correlation, 0-1
+        };
+
+        XDataAlignment(const XDataSeries *first, const XDataSeries *second, double interval = 1.0);
+
+        // correlate these columns (valuename) of each, false if either is missing
+        bool addChannel(QString first, QString second);
+        bool addChannel(QString name) { return addChannel(name, name); }
+        int channelCount() const { return channels.count(); }
+
+        // one lag for start-end (secs), the most it can be is maxLag either way
+        Lag lag(double start, double end, double maxLag) const;
+
+        // lags for windows across start-end, a window every step secs
+        QVector<Lag> lags(double start, double end, double window, double step, double maxLag) const;
+
+        // the lag at a time, interpolated between the windows either side
+        static double lagAt(const QVector<Lag> &lags, double secs);
+
+        // in place, the size must be a power of 2
+        static void fft(QVector<std::complex<double> > &data, bool inverse);
+
+    private:
+
+        Lag window(double start, int count, int maxLag) const;
+        void resample(const XDataSeries *series, int column, double start, QVector<double> &values) const;
+        bool correlate(QVector<double> &a, QVector<double> &b, QVector<double> &ncc) const;
+
+        const XDataSeries *first, *second;
+        double interval;
+        QList<QPair<int, int> > channels; // number[] index in each
+};
+
+#endif // _GC_XDataAlignment_h
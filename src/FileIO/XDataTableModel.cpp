@@ -284,6 +284,12 @@ XDataTableModel::endCommand(bool undo, RideCommand *cmd)
             dataChanged(cell, cell);
             break;
         }
+        case RideCommand::SetXDataPointValues:
+        {
+            SetXDataPointValuesCommand *spv = (SetXDataPointValuesCommand*)cmd;
+            dataChanged(index(spv->row, spv->col), index(spv->row + spv->count - 1, spv->col));
+            break;
+        }
         case RideCommand::InsertXDataPoint:
             if (!undo) endInsertRows();
             else endRemoveRows();
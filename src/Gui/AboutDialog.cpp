@@ -19,6 +19,10 @@
 #include "AboutDialog.h"
 #include "GcUpgrade.h"
 #include "GcCrashDialog.h"
+#include "Context.h"
+#include "Athlete.h"
+#include "RideCache.h"
+#include "OpenRideCache.h"
 
 AboutDialog::AboutDialog(Context *context) : context(context)
 {
@@ -102,10 +106,17 @@ VersionPage::VersionPage(Context *context) : context(context)
     text=new QLabel(this);
     text->setContentsMargins(0,0,0,0);
     text->setText(GcCrashDialog::versionHTML());
+
+    // how the open activities are doing, for diagnostics
+    QLabel *openRides = new QLabel(this);
+    openRides->setAlignment(Qt::AlignHCenter);
+    if (context->athlete->rideCache) openRides->setText(context->athlete->rideCache->openRides()->stats());
+
     QVBoxLayout *mainLayout = new QVBoxLayout;
     mainLayout->setSpacing(0);
     mainLayout->setContentsMargins(0,0,0,0);
     mainLayout->addWidget(text);
+    mainLayout->addWidget(openRides);
 
     setLayout(mainLayout);
 }
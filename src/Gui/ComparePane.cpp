@@ -685,6 +685,7 @@ ComparePane::dropEvent(QDropEvent *event)
             stream >> ridep;
             RideItem *rideItem = (RideItem*)ridep;
             RideFile *ride = rideItem->ride();
+            rideItem->pin(); // open until we've copied it
 
             // index into ridefile
             stream >> start;
@@ -769,10 +770,8 @@ ComparePane::dropEvent(QDropEvent *event)
                         addp->km = p->km - offsetKM;
                         addp->secs = p->secs - offset;
 
-                        for(int i=0; i< XDATA_MAXVALUES; i++) {
-                            addp->number[i] = p->number[i];
-                            addp->string[i] = p->string[i];
-                        }
+                        addp->number = p->number;
+                        addp->string = p->string;
 
                         x->datapoints.append(addp);
                     }
@@ -780,6 +779,7 @@ ComparePane::dropEvent(QDropEvent *event)
             }
 
             add.data->recalculateDerivedSeries();
+            rideItem->unpin();
 
             // just use standard colors and cycle round
             // we will of course repeat, but the user can
@@ -889,6 +889,7 @@ ComparePane::dropEvent(QDropEvent *event)
                             add.sourceContext = newOnes[0].sourceContext;      // UPDATE COMPARE INTERVAL
 
                             RideFile *ride = matched->rideItem()->ride();
+                            matched->rideItem()->pin(); // open until we've copied it
 
                             add.name = QString("%1/%2 %3").arg(matched->rideItem()->dateTime.date().day())
                                                           .arg(matched->rideItem()->dateTime.date().month())
@@ -932,6 +933,7 @@ ComparePane::dropEvent(QDropEvent *event)
                                 }
                             }
                             add.data->recalculateDerivedSeries();
+                            matched->rideItem()->unpin();
 
                             // construct a fake RideItem, slightly hacky need to fix this later XXX fixme
                             //                            mostly cut and paste from RideItem::refresh
@@ -474,12 +474,13 @@ MergeActivityWizard::combine()
 
                 // finally copy the data
                 foreach (XDataPoint *point, xdata->datapoints) {
-                    XDataPoint *pt = new XDataPoint();
+                    XDataPoint *pt = new XDataPoint(indexMap.count());
                     pt->secs = point->secs + timeOffset;
                     pt->km = point->km + distanceOffset;
                     for (int i=0; i<indexMap.count(); i++) {
-                        pt->number[i] = point->number[indexMap[i]];
-                        pt->string[i] = point->string[indexMap[i]];
+                        pt->number[i] = point->number.value(indexMap[i]);
+                        QString string = point->string.value(indexMap[i]);
+                        if (!string.isEmpty()) pt->string.set(i, string);
                     }
                     combined->xdata(xdata->name)->datapoints.append(pt);
                 }
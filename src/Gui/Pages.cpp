@@ -284,6 +284,21 @@ GeneralPage::GeneralPage(Context *context) : context(context)
     connect(pythonBrowseButton, SIGNAL(clicked()), this, SLOT(browsePythonDir()));
 #endif
 
+    //
+    // Memory for open activities, the least recently used
+    // are closed when they need more than this
+    //
+    QLabel *openRidesLabel = new QLabel(tr("Memory for open activities (MB)"));
+    openRidesBudget = new QSpinBox(this);
+    openRidesBudget->setMinimum(64);
+    openRidesBudget->setMaximum(65536);
+    openRidesBudget->setSingleStep(64);
+    openRidesBudget->setValue(appsettings->value(NULL, GC_OPENRIDES_BUDGET, 512).toInt());
+
+    configLayout->addWidget(openRidesLabel, 7 + offset,0, Qt::AlignRight);
+    configLayout->addWidget(openRidesBudget, 7 + offset,1, Qt::AlignLeft);
+    offset++;
+
     // save away initial values
     b4.unit = unitCombo->currentIndex();
     b4.hyst = elevationHysteresis.toFloat();
@@ -348,6 +363,9 @@ GeneralPage::saveClicked()
     // Elevation
     appsettings->setValue(GC_ELEVATION_HYSTERESIS, hystedit->text());
 
+    // Open activities
+    appsettings->setValue(GC_OPENRIDES_BUDGET, openRidesBudget->value());
+
     // wbal formula
     appsettings->setValue(GC_WBALFORM, wbalForm->currentIndex() ? "int" : "diff");
 
@@ -920,6 +938,9 @@ BackupPage::BackupPage(Context *context) : context(context)
     //backupInput->addStretch();
     backupInput->addWidget(autoBackupUnitLabel);
 
+    autoBackupIncremental = new QCheckBox(tr("Incremental backups, only store files changed since the last backup"), this);
+    autoBackupIncremental->setChecked(appsettings->cvalue(context->athlete->cyclist, GC_AUTOBACKUP_INCREMENTAL, false).toBool());
+
     Qt::Alignment alignment = Qt::AlignLeft|Qt::AlignVCenter;
 
     grid->addWidget(autoBackupFolderLabel, 7,0, alignment);
@@ -927,6 +948,7 @@ BackupPage::BackupPage(Context *context) : context(context)
     grid->addWidget(autoBackupFolderBrowse, 7, 2, alignment);
     grid->addWidget(autoBackupPeriodLabel, 8, 0,alignment);
     grid->addLayout(backupInput, 8, 1, alignment);
+    grid->addWidget(autoBackupIncremental, 9, 1, alignment);
 
     all->addLayout(grid);
     all->addStretch();
@@ -949,6 +971,7 @@ BackupPage::saveClicked()
     // Auto Backup
     appsettings->setCValue(context->athlete->cyclist, GC_AUTOBACKUP_FOLDER, autoBackupFolder->text());
     appsettings->setCValue(context->athlete->cyclist, GC_AUTOBACKUP_PERIOD, autoBackupPeriod->value());
+    appsettings->setCValue(context->athlete->cyclist, GC_AUTOBACKUP_INCREMENTAL, autoBackupIncremental->isChecked());
     return 0;
 }
 
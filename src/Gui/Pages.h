@@ -118,6 +118,7 @@ class GeneralPage : public QWidget
 #endif
         QLineEdit *garminHWMarkedit;
         QLineEdit *hystedit;
+        QSpinBox *openRidesBudget;
         QLineEdit *athleteDirectory;
         QLineEdit *workoutDirectory;
         QPushButton *workoutBrowseButton;
@@ -342,6 +343,7 @@ class BackupPage : public QWidget
         QSpinBox *autoBackupPeriod;
         QLineEdit *autoBackupFolder;
         QPushButton *autoBackupFolderBrowse;
+        QCheckBox *autoBackupIncremental;
 
     private slots:
 
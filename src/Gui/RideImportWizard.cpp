@@ -42,6 +42,15 @@
 #include <QDebug>
 #include <QWaitCondition>
 #include <QMessageBox>
+#include <QMutex>
+#include <QThread>
+#include <QSet>
+#include <QFuture>
+#if QT_VERSION > 0x050000
+#include <QtConcurrent>
+#else
+#include <QtConcurrentMap>
+#endif
 
 enum WizardTable {
     FILENAME_COLUMN = 0,
@@ -951,6 +960,256 @@ struct cpi_file_info {
 };
 
 
+//
+// SAVE PIPELINE
+//
+// Saving is done a few rides at a time on worker threads, each ride
+// goes through
+//
+//   parse   - worker, copy the source to /imports and read it
+//   process - GUI thread, the import data processors (some show dialogs)
+//   save    - worker, derived series, write the .json to /tmpActivities
+//             and compute the metrics so the ride cache doesn't have to
+//   commit  - GUI thread, add to the ride cache and move to /activities
+//
+// Rides are committed in date order, and workers only parse so far
+// ahead of the next one to commit, so a big import only has a handful
+// of rides in memory at any time.
+//
+struct RideImportJob {
+
+    enum Stage { Waiting, Parsing, Parsed, Processed, Saving, Saved, Failed };
+
+    RideImportJob() : row(0), stage(Waiting), ride(NULL), item(NULL) {}
+
+    int row; // in the table
+    QDateTime ridedatetime;
+    QString source, importsTarget, importsFulltarget, activitiesTarget,
+            tmpActivitiesFulltarget, finalActivitiesFulltarget;
+
+    Stage stage;
+    RideFile *ride;
+    RideItem *item;     // refreshed and ready for the ride cache
+    QStringList errors; // from the reader
+    QString status;     // why it failed
+};
+
+static bool rideImportJobLessThan(const RideImportJob *a, const RideImportJob *b)
+{
+    return a->ridedatetime < b->ridedatetime;
+}
+
+class RideImportPipeline
+{
+    public:
+
+        RideImportPipeline(Context *context, QList<RideImportJob*> jobs);
+        ~RideImportPipeline(); // stops the workers and drops anything not committed
+
+        void start();
+
+        // GUI thread, wait a little for a worker to move a job on
+        void wait(int ms);
+
+        // GUI thread, a job ready for the data processors
+        RideImportJob *parsed();
+        void processed(RideImportJob *job);
+
+        // GUI thread, the next job in date order once it is saved (or failed)
+        RideImportJob *next();
+
+        // the workers
+        void work();
+
+    private:
+
+        bool parse(RideImportJob *job);
+        bool save(RideImportJob *job);
+
+        Context *context;
+        QList<RideImportJob*> jobs;
+        QVector<RideImportPipeline*> workers;
+        QFuture<void> future;
+
+        QMutex lock;
+        QWaitCondition moved;   // for the GUI thread
+        QWaitCondition ready;   // for the workers
+        int committed, window;
+        bool stopping;
+};
+
+static void
+rideImportWorker(RideImportPipeline *&pipeline)
+{
+    pipeline->work();
+}
+
+RideImportPipeline::RideImportPipeline(Context *context, QList<RideImportJob*> jobs) :
+    context(context), jobs(jobs), committed(0), stopping(false)
+{
+    workers.fill(this, qMax(1, QThread::idealThreadCount()));
+    window = 2 * workers.count();
+}
+
+RideImportPipeline::~RideImportPipeline()
+{
+    lock.lock();
+    stopping = true;
+    ready.wakeAll();
+    lock.unlock();
+    future.waitForFinished();
+
+    // aborted, throw away what was done for the rides not committed
+    for (int i=committed; i<jobs.count(); i++) {
+        if (jobs[i]->stage == RideImportJob::Saved) QFile(jobs[i]->tmpActivitiesFulltarget).remove();
+        delete jobs[i]->item;
+        delete jobs[i]->ride;
+    }
+    qDeleteAll(jobs);
+}
+
+void
+RideImportPipeline::start()
+{
+    future = QtConcurrent::map(workers, rideImportWorker);
+}
+
+void
+RideImportPipeline::wait(int ms)
+{
+    QMutexLocker locker(&lock);
+    moved.wait(&lock, ms);
+}
+
+RideImportJob *
+RideImportPipeline::parsed()
+{
+    QMutexLocker locker(&lock);
+    for (int i=committed; i<jobs.count(); i++)
+        if (jobs[i]->stage == RideImportJob::Parsed) return jobs[i];
+    return NULL;
+}
+
+void
+RideImportPipeline::processed(RideImportJob *job)
+{
+    QMutexLocker locker(&lock);
+    job->stage = RideImportJob::Processed;
+    ready.wakeOne();
+}
+
+RideImportJob *
+RideImportPipeline::next()
+{
+    QMutexLocker locker(&lock);
+    if (committed == jobs.count()) return NULL;
+
+    RideImportJob *job = jobs[committed];
+    if (job->stage != RideImportJob::Saved && job->stage != RideImportJob::Failed) return NULL;
+
+    // the window moves on
+    committed++;
+    ready.wakeAll();
+    return job;
+}
+
+void
+RideImportPipeline::work()
+{
+    QMutexLocker locker(&lock);
+    while (!stopping) {
+
+        // finish rides before starting new ones
+        RideImportJob *job = NULL;
+        for (int i=committed; i<jobs.count() && !job; i++)
+            if (jobs[i]->stage == RideImportJob::Processed) job = jobs[i];
+        for (int i=committed; i<jobs.count() && i<committed+window && !job; i++)
+            if (jobs[i]->stage == RideImportJob::Waiting) job = jobs[i];
+
+        if (!job) {
+            // anything left for us to do, now or later ?
+            bool more = false;
+            for (int i=committed; i<jobs.count() && !more; i++)
+                more = jobs[i]->stage == RideImportJob::Waiting || jobs[i]->stage == RideImportJob::Parsed ||
+                       jobs[i]->stage == RideImportJob::Processed;
+            if (!more) return;
+
+            ready.wait(&lock);
+            continue;
+        }
+
+        bool ok;
+        if (job->stage == RideImportJob::Waiting) {
+            job->stage = RideImportJob::Parsing;
+            locker.unlock();
+            ok = parse(job);
+            locker.relock();
+            job->stage = ok ? RideImportJob::Parsed : RideImportJob::Failed;
+        } else {
+            job->stage = RideImportJob::Saving;
+            locker.unlock();
+            ok = save(job);
+            locker.relock();
+            job->stage = ok ? RideImportJob::Saved : RideImportJob::Failed;
+        }
+        moved.wakeAll();
+    }
+}
+
+bool
+RideImportPipeline::parse(RideImportJob *job)
+{
+    // copy the source file to /imports with adjusted name, if it isn't from there already
+    if (job->importsFulltarget != "") {
+        QFile source(job->source);
+        if (!source.copy(job->importsFulltarget))
+            job->status = RideImportWizard::tr("Error - copy of %1 to import directory failed").arg(job->importsTarget);
+    }
+
+    QFile thisfile(job->source);
+    job->ride = RideFileFactory::instance().openRideFile(context, thisfile, job->errors);
+
+    // did the input file parse ok ? (should be fine here - since it was alrady checked before - but just in case)
+    if (!job->ride) {
+        job->status = RideImportWizard::tr("Error - Import of activitiy file failed");
+        return false;
+    }
+
+    // update ridedatetime and set the Source File name
+    job->ride->setStartTime(job->ridedatetime);
+    job->ride->setTag("Source Filename", job->importsTarget);
+    job->ride->setTag("Filename", job->activitiesTarget);
+    if (job->errors.count() > 0)
+        job->ride->setTag("Import errors", job->errors.join("\n"));
+
+    return true;
+}
+
+bool
+RideImportPipeline::save(RideImportJob *job)
+{
+    job->ride->recalculateDerivedSeries();
+
+    // serialize, the ride cache entry is created from /tmpActivities
+    // so we know which file caused the problem if it fails
+    JsonFileReader reader;
+    QFile target(job->tmpActivitiesFulltarget);
+    if (!reader.writeRideFile(context, job->ride, target)) {
+        job->status = RideImportWizard::tr("Error - .JSON creation failed");
+        return false;
+    }
+
+    // compute the metrics here rather than when it is added to the cache
+    QDateTime dt;
+    RideFile::parseRideFileName(job->activitiesTarget, &dt);
+    job->item = new RideItem(context->athlete->home->tmpActivities().canonicalPath(), job->activitiesTarget,
+                             dt, context, false);
+    job->item->refresh();
+    job->item->moveToThread(QApplication::instance()->thread());
+
+    return true;
+}
+
 void
 RideImportWizard::abortClicked()
 {
@@ -1000,18 +1259,14 @@ RideImportWizard::abortClicked()
     QChar zero = QLatin1Char ( '0' );
 
 
-    // Saving now - process the files one-by-one
+    // Saving now - work out the targets and check for duplicates here, the
+    // rest is done in the pipeline above
+    QList<RideImportJob*> jobs;
+    QSet<QString> targets;
     for (int i=0; i< filenames.count(); i++) {
 
         if (tableWidget->item(i,STATUS_COLUMN)->text().startsWith(tr("Error"))) continue; // skip errors
 
-        tableWidget->item(i,STATUS_COLUMN)->setText(tr("Saving..."));
-        tableWidget->setCurrentCell(i,5);
-        QApplication::processEvents();
-        if (aborted) { done(0); return; }
-        this->repaint();
-
-
         // SAVE STEP 3 - prepare the new file names for the next steps - basic name and .JSON in GC format
 
         QDateTime ridedatetime = QDateTime(QDate().fromString(tableWidget->item(i,DATE_COLUMN)->text(), Qt::ISODate),
@@ -1029,8 +1284,8 @@ RideImportWizard::abortClicked()
         QString tmpActivitiesFulltarget = tmpActivities.canonicalPath() + "/" + activitiesTarget;
         QString finalActivitiesFulltarget = homeActivities.canonicalPath() + "/" + activitiesTarget;
 
-        // check if a ride at this point of time already exists in /activities - if yes, skip import
-        if (QFileInfo(finalActivitiesFulltarget).exists()) { tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Activity file exists")); continue; }
+        // check if a ride at this point of time already exists in /activities, or earlier in this import - if yes, skip import
+        if (QFileInfo(finalActivitiesFulltarget).exists() || targets.contains(activitiesTarget)) { tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Activity file exists")); continue; }
 
         // in addition, also check the RideCache for a Ride with the same point in Time in UTC, which also indicates
         // that there was already a ride imported - reason is that RideCache start time is in UTC, while the file Name is in "localTime"
@@ -1038,98 +1293,118 @@ RideImportWizard::abortClicked()
         // while the computer has been set to a different time zone
         if (context->athlete->rideCache->getRide(ridedatetime.toUTC())) { tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Activity file with same start date/time exists")); continue; };
 
+        RideImportJob *job = new RideImportJob;
+        job->row = i;
+        job->ridedatetime = ridedatetime;
+        job->source = filenames[i];
+        job->activitiesTarget = activitiesTarget;
+        job->tmpActivitiesFulltarget = tmpActivitiesFulltarget;
+        job->finalActivitiesFulltarget = finalActivitiesFulltarget;
+
         // SAVE STEP 4 - copy the source file to "/imports" directory (if it's not taken from there as source)
         // add the date/time of the target to the source file name (for identification)
-
-        // copy the sourceFile to /imports ONLY if the source is NOT coming from /imports itself
         QFileInfo sourceFileInfo (filenames[i]);
-        QString importsTarget;
         if (sourceFileInfo.canonicalPath() != homeImports.canonicalPath()) {
 
             // add the GC file base name to create unique file names during import
             // there should not be 2 ride files with exactly the same time stamp (as this is also not foreseen for the .json)
-            importsTarget = sourceFileInfo.baseName() + "_" + targetnosuffix + "." + sourceFileInfo.suffix();
-            QString importsFulltarget = homeImports.canonicalPath() + "/" + importsTarget;
-            // copy the source file to /imports with adjusted name
-            QFile source(filenames[i]);
-            if (!source.copy(importsFulltarget)) {
-                tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - copy of %1 to import directory failed").arg(importsTarget));
-            }
+            job->importsTarget = sourceFileInfo.baseName() + "_" + targetnosuffix + "." + sourceFileInfo.suffix();
+            job->importsFulltarget = homeImports.canonicalPath() + "/" + job->importsTarget;
         } else {
             // file is re-imported from /imports - keep the name for .JSON Source File Tag
-            importsTarget = sourceFileInfo.fileName();
+            job->importsTarget = sourceFileInfo.fileName();
         }
 
+        jobs << job;
+        targets << activitiesTarget;
+        tableWidget->item(i,STATUS_COLUMN)->setText(tr("Saving..."));
+    }
 
-        // SAVE STEP 5 - open the file with the respective format reader and export as .JSON
-        // to track if addRideCache() has caused an error due to bad data we work with a interim directory for the activities
-        // -- first   export to /tmpactivities
-        // -- second  create RideCache() entry
-        // -- third   move file from /tmpactivities to /activities
+    // SAVE STEP 5 - open the file with the respective format reader and export as .JSON
+    // to track if addRideCache() has caused an error due to bad data we work with a interim directory for the activities
+    // -- first   export to /tmpactivities
+    // -- second  create RideCache() entry
+    // -- third   move file from /tmpactivities to /activities
+    //
+    // they are committed in date order so the ride cache only ever appends
+    qStableSort(jobs.begin(), jobs.end(), rideImportJobLessThan);
 
-        // serialize the file to .JSON
-        QStringList errors;
-        QFile thisfile(filenames[i]);
-        RideFile *ride(RideFileFactory::instance().openRideFile(context, thisfile, errors));
+    RideImportPipeline pipeline(context, jobs);
+    pipeline.start();
 
-        // did the input file parse ok ? (should be fine here - since it was alrady checked before - but just in case)
-        if (ride) {
+    int remaining = jobs.count();
+    while (remaining) {
 
-            // update ridedatetime and set the Source File name
-            ride->setStartTime(ridedatetime);
-            ride->setTag("Source Filename", importsTarget);
-            ride->setTag("Filename", activitiesTarget);
-            if (errors.count() > 0)
-                ride->setTag("Import errors", errors.join("\n"));
+        QApplication::processEvents();
+        if (aborted) { done(0); return; }
+
+        // run the processor first... import
+        RideImportJob *job;
+        while ((job = pipeline.parsed()) != NULL) {
+
+            tableWidget->item(job->row,STATUS_COLUMN)->setText(tr("Processing..."));
+            tableWidget->setCurrentCell(job->row,5);
 
             // process linked defaults
-            context->athlete->rideMetadata()->setLinkedDefaults(ride);
-
-            // run the processor first... import
-            tableWidget->item(i,STATUS_COLUMN)->setText(tr("Processing..."));
-            DataProcessorFactory::instance().autoProcess(ride, "Auto", "Import");
-            ride->recalculateDerivedSeries();
-
-            tableWidget->item(i,STATUS_COLUMN)->setText(tr("Saving file..."));
-
-            // serialize
-            JsonFileReader reader;
-            QFile target(tmpActivitiesFulltarget);
-            if (reader.writeRideFile(context, ride, target)) {
-
-                // now try adding the Ride to the RideCache - since this may fail due to various reason, the activity file
-                // is stored in tmpActivities during this process to understand which file has create the problem when restarting GC
-                // - only after the step was successful the file is moved
-                // to the "clean" activities folder
-                context->athlete->addRide(QFileInfo(tmpActivitiesFulltarget).fileName(),
-                                          tableWidget->rowCount() < 20 ? true : false, // don't signal if mass importing
-                                          true, true);                                       // file is available only in /tmpActivities, so use this one please
+            context->athlete->rideMetadata()->setLinkedDefaults(job->ride);
+            DataProcessorFactory::instance().autoProcess(job->ride, "Auto", "Import");
+
+            tableWidget->item(job->row,STATUS_COLUMN)->setText(tr("Saving file..."));
+            pipeline.processed(job);
+        }
+
+        // commit those that are ready, in order
+        QList<RideImportJob*> ready;
+        QList<RideItem*> items;
+        while ((job = pipeline.next()) != NULL) {
+            ready << job;
+            if (job->stage == RideImportJob::Saved) items << job->item;
+        }
+
+        // now try adding the Rides to the RideCache - since this may fail due to various reason, the activity file
+        // is stored in tmpActivities during this process to understand which file has create the problem when restarting GC
+        // - only after the step was successful the file is moved
+        // to the "clean" activities folder. They are added together so the ride list is only
+        // sorted and reset once for all of them
+        if (items.count())
+            context->athlete->rideCache->addRides(items, tableWidget->rowCount() < 20 ? true : false, // don't signal if mass importing
+                                                  true);
+
+        foreach(job, ready) {
+
+            int i = job->row;
+            remaining--;
+
+            if (job->stage == RideImportJob::Saved) {
+
+                RideItem *item = job->item;
+                job->item = NULL; // the ride cache owns it now
+
                 // rideCache is successfully updated, let's move the file to the real /activities
-                if (moveFile(tmpActivitiesFulltarget, finalActivitiesFulltarget)) {
+                if (moveFile(job->tmpActivitiesFulltarget, job->finalActivitiesFulltarget)) {
                     tableWidget->item(i,STATUS_COLUMN)->setText(tr("File Saved"));
                     // and correct the path locally stored in Ride Item
-                    context->ride->setFileName(homeActivities.canonicalPath(), activitiesTarget);
+                    item->setFileName(homeActivities.canonicalPath(), job->activitiesTarget);
                 }  else {
-                    tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Moving %1 to activities folder").arg(activitiesTarget));
+                    tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Moving %1 to activities folder").arg(job->activitiesTarget));
                 }
 
-            }  else {
-                tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - .JSON creation failed"));
+            } else {
+                tableWidget->item(i,STATUS_COLUMN)->setText(job->status);
             }
-        } else {
-            tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Import of activitiy file failed"));
-        }
 
-        // now metrics have been calculated
-        DataProcessorFactory::instance().autoProcess(ride, "Save", "ADD");
+            // now metrics have been calculated
+            DataProcessorFactory::instance().autoProcess(job->ride, "Save", "ADD");
 
-        // clear
-        delete ride;
+            // clear
+            delete job->ride;
+            job->ride = NULL;
 
-        QApplication::processEvents();
-        if (aborted) { done(0); return; }
-        progressBar->setValue(progressBar->value()+1);
+            progressBar->setValue(progressBar->value()+1);
+        }
         this->repaint();
+
+        if (remaining) pipeline.wait(50);
     }
 
     // how did we get on in the end then ...
@@ -20,6 +20,7 @@
 #include "Context.h"
 #include "Colors.h"
 #include "RideCache.h"
+#include "RidePrefetcher.h"
 #include "RideCacheModel.h"
 #include "RideItem.h"
 #include "RideNavigator.h"
@@ -999,6 +1000,40 @@ RideNavigator::selectionChanged(QItemSelection selected)
     // lets notify others
     context->athlete->selectRideFile(filename);
 
+    // and get the ones either side ready
+    prefetchNeighbours(ref);
+}
+
+// read the rides either side of the selected one in the background,
+// in the order they are listed, so stepping through them is quick
+void
+RideNavigator::prefetchNeighbours(QModelIndex selected)
+{
+    QAbstractItemModel *model = tableView->model();
+
+    // the file names as listed, across the groups
+    QStringList files;
+    int current = -1;
+    for (int i=0; i<model->rowCount(); i++) {
+
+        QModelIndex group = model->index(i,0,QModelIndex());
+        for (int j=0; j<model->rowCount(group); j++) {
+            if (group == selected.parent() && j == selected.row()) current = files.count();
+            files << model->data(model->index(j,3, group), Qt::DisplayRole).toString();
+        }
+    }
+    if (current < 0) return;
+
+    // nearest first, the next one before the previous one
+    QList<RideItem*> items;
+    for (int n=1; n<=RidePrefetcher::neighbours; n++) {
+        foreach(int k, QList<int>() << current + n << current - n) {
+            if (k < 0 || k >= files.count()) continue;
+            RideItem *item = context->athlete->rideCache->getRide(files[k]);
+            if (item && !item->planned) items << item;
+        }
+    }
+    context->athlete->rideCache->prefetcher()->prefetch(items);
 }
 
 void
@@ -200,6 +200,7 @@ class RideNavigator : public GcChartWindow
         SearchFilterBox *searchFilterBox;
 
         // support functions
+        void prefetchNeighbours(QModelIndex selected);
         void calcColumnsChanged(bool, int logicalIndex=0, int oldWidth=0, int newWidth=0);
         void setColumnWidth(int, bool, int logicalIndex=0, int oldWidth=0, int newWidth=0);
 };
@@ -946,11 +946,12 @@ class TotalWork : public RideMetric {
         joules = 0;
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
+        RideFileColumn watts = it.column(RideFile::watts);
+        while (watts && it.hasNext()) {
+            int i = it.nextIndex();
 
-            if (point->watts >= 0.0)
-                joules += point->watts * item->ride()->recIntSecs();
+            if (watts[i] >= 0.0)
+                joules += watts[i] * item->ride()->recIntSecs();
         }
         setValue(joules/1000);
     }
@@ -999,9 +1000,10 @@ class AvgSpeed : public RideMetric {
             secsMoving = 0;
 
             RideFileIterator it(item->ride(), spec);
-            while (it.hasNext()) {
-                struct RideFilePoint *point = it.next();
-                if (point->kph > 0.0) secsMoving += item->ride()->recIntSecs();
+            RideFileColumn kph = it.column(RideFile::kph);
+            while (kph && it.hasNext()) {
+                int i = it.nextIndex();
+                if (kph[i] > 0.0) secsMoving += item->ride()->recIntSecs();
             }
 
             setValue(secsMoving ? km / secsMoving * 3600.0 : 0.0);
@@ -1060,11 +1062,12 @@ struct AvgPower : public RideMetric {
         total = count = 0;
     
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
+        RideFileColumn watts = it.column(RideFile::watts);
+        while (watts && it.hasNext()) {
+            int i = it.nextIndex();
 
-            if (point->watts >= 0.0) {
-                total += point->watts;
+            if (watts[i] >= 0.0) {
+                total += watts[i];
                 ++count;
             }
         }
@@ -1115,11 +1118,12 @@ struct AvgSmO2 : public RideMetric {
         total = count = 0;
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
+        RideFileColumn smo2 = it.column(RideFile::smo2);
+        while (smo2 && it.hasNext()) {
+            int i = it.nextIndex();
 
-            if (point->smo2 > 0.0f) {  // SmO2 should always be > 0.0f
-                total += point->smo2;
+            if (smo2[i] > 0.0f) {  // SmO2 should always be > 0.0f
+                total += smo2[i];
                 ++count;
             }
         }
@@ -1171,10 +1175,11 @@ struct AvgtHb : public RideMetric {
         total = count = 0.0f;
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->thb > 0.0f) {
-                total += point->thb;
+        RideFileColumn thb = it.column(RideFile::thb);
+        while (thb && it.hasNext()) {
+            int i = it.nextIndex();
+            if (thb[i] > 0.0f) {
+                total += thb[i];
                 ++count;
             }
         }
@@ -1281,10 +1286,11 @@ struct NonZeroPower : public RideMetric {
         total = count = 0;
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->watts > 0.0) {
-                total += point->watts;
+        RideFileColumn watts = it.column(RideFile::watts);
+        while (watts && it.hasNext()) {
+            int i = it.nextIndex();
+            if (watts[i] > 0.0) {
+                total += watts[i];
                 ++count;
             }
         }
@@ -1335,10 +1341,11 @@ struct AvgHeartRate : public RideMetric {
 
         total = count = 0;
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->hr > 0) {
-                total += point->hr;
+        RideFileColumn hr = it.column(RideFile::hr);
+        while (hr && it.hasNext()) {
+            int i = it.nextIndex();
+            if (hr[i] > 0) {
+                total += hr[i];
                 ++count;
             }
         }
@@ -1390,11 +1397,12 @@ struct AvgCoreTemp : public RideMetric {
         total = count = 0;
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
+        RideFileColumn tcore = it.column(RideFile::tcore);
+        while (tcore && it.hasNext()) {
+            int i = it.nextIndex();
 
-            if (point->tcore > 0) {
-                total += point->tcore;
+            if (tcore[i] > 0) {
+                total += tcore[i];
                 ++count;
             }
         }
@@ -1446,9 +1454,10 @@ struct HeartBeats : public RideMetric {
         total = 0;
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            total += (point->hr / 60) * item->ride()->recIntSecs();
+        RideFileColumn hr = it.column(RideFile::hr);
+        while (hr && it.hasNext()) {
+            int i = it.nextIndex();
+            total += (hr[i] / 60) * item->ride()->recIntSecs();
         }
         setValue(total);
     }
@@ -1744,10 +1753,11 @@ struct AvgCadence : public RideMetric {
         total = count = 0;
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->cad > 0) {
-                total += point->cad;
+        RideFileColumn cad = it.column(RideFile::cad);
+        while (cad && it.hasNext()) {
+            int i = it.nextIndex();
+            if (cad[i] > 0) {
+                total += cad[i];
                 ++count;
             }
         }
@@ -1813,10 +1823,11 @@ struct AvgTemp : public RideMetric {
         total = count = 0;
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->temp != RideFile::NA) {
-                total += point->temp;
+        RideFileColumn temp = it.column(RideFile::temp);
+        while (temp && it.hasNext()) {
+            int i = it.nextIndex();
+            if (temp[i] != RideFile::NA) {
+                total += temp[i];
                 ++count;
             }
         }
@@ -1863,10 +1874,11 @@ class MaxPower : public RideMetric {
         }
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->watts >= max)
-                max = point->watts;
+        RideFileColumn watts = it.column(RideFile::watts);
+        while (watts && it.hasNext()) {
+            int i = it.nextIndex();
+            if (watts[i] >= max)
+                max = watts[i];
         }
         setValue(max);
     }
@@ -1909,10 +1921,11 @@ class MaxSmO2 : public RideMetric {
         }
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->smo2 >= max)
-                max = point->smo2;
+        RideFileColumn smo2 = it.column(RideFile::smo2);
+        while (smo2 && it.hasNext()) {
+            int i = it.nextIndex();
+            if (smo2[i] >= max)
+                max = smo2[i];
         }
         setValue(max);
     }
@@ -1956,11 +1969,12 @@ class MaxtHb : public RideMetric {
         }
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
+        RideFileColumn thb = it.column(RideFile::thb);
+        while (thb && it.hasNext()) {
+            int i = it.nextIndex();
 
-            if (point->thb >= max)
-                max = point->thb;
+            if (thb[i] >= max)
+                max = thb[i];
         }
         setValue(max);
     }
@@ -2057,10 +2071,11 @@ class MintHb : public RideMetric {
         bool notset = true;
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->thb > 0.0f && (notset || point->thb < min)) {
-                min = point->thb;
+        RideFileColumn thb = it.column(RideFile::thb);
+        while (thb && it.hasNext()) {
+            int i = it.nextIndex();
+            if (thb[i] > 0.0f && (notset || thb[i] < min)) {
+                min = thb[i];
                 notset = false;
             }
         }
@@ -2104,10 +2119,11 @@ class MaxHr : public RideMetric {
         }
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->hr >= max)
-                max = point->hr;
+        RideFileColumn hr = it.column(RideFile::hr);
+        while (hr && it.hasNext()) {
+            int i = it.nextIndex();
+            if (hr[i] >= max)
+                max = hr[i];
         }
         setValue(max);
     }
@@ -2207,11 +2223,12 @@ class MaxCT : public RideMetric {
         }
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
+        RideFileColumn tcore = it.column(RideFile::tcore);
+        while (tcore && it.hasNext()) {
+            int i = it.nextIndex();
 
-            if (point->tcore >= max)
-                max = point->tcore;
+            if (tcore[i] >= max)
+                max = tcore[i];
         }
         setValue(max);
     }
@@ -2263,9 +2280,10 @@ class MaxSpeed : public RideMetric {
         if (item->ride()->areDataPresent()->kph) {
 
             RideFileIterator it(item->ride(), spec);
-            while (it.hasNext()) {
-                struct RideFilePoint *point = it.next();
-                    if (point->kph > max) max = point->kph;
+            RideFileColumn kph = it.column(RideFile::kph);
+            while (kph && it.hasNext()) {
+                int i = it.nextIndex();
+                    if (kph[i] > max) max = kph[i];
             }
         }
         setValue(max);
@@ -2311,9 +2329,10 @@ class MaxCadence : public RideMetric {
         double max = 0.0;
 
         RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->cad > max) max = point->cad;
+        RideFileColumn cad = it.column(RideFile::cad);
+        while (cad && it.hasNext()) {
+            int i = it.nextIndex();
+            if (cad[i] > max) max = cad[i];
         }
 
         setValue(max);
@@ -26,6 +26,13 @@
 
 #include "Banister.h"
 
+#include <QFileInfo>
+#if QT_VERSION > 0x050000
+#include <QtConcurrent>
+#else
+#include <QtConcurrentMap>
+#endif
+
 #ifndef ESTIMATOR_DEBUG
 #define ESTIMATOR_DEBUG false
 #endif
@@ -48,56 +55,111 @@
     } while(0)
 #endif
 
-class RollingBests {
-    private:
+// weeks of bests the models are fitted to
+static const int ROLLINGWEEKS = 6;
+
+// fitting the models for one week, they run in parallel
+struct EstimatorFit {
+    Context *context;
+    bool run;
+    QDate begin, end;
+    QVector<float> bests, wpk; // rolling bests
+    QList<PDEstimate> estimates;
+    bool *abort;
+};
 
-        // buffer of best values; Watts or Watts/KG
-        // is a double to handle both use cases
-        QVector<QVector<float> > buffer;
+static void
+fitModels(EstimatorFit &fit)
+{
+    if (*fit.abort) return;
 
-        // current location in circular buffer
-        int index;
+    // set up the models we support
+    CP2Model p2model(fit.context);
+    CP3Model p3model(fit.context);
+    ExtendedModel extmodel(fit.context);
+#if 0 // disable until model fitting errors are fixed (!!!)
+    WSModel wsmodel(fit.context);
+    MultiModel multimodel(fit.context);
+#endif
 
-    public:
+    QList <PDModel *> models;
+    models << &p2model;
+    models << &p3model;
+    models << &extmodel;
+#if 0 // disable until model fitting errors are fixed (!!!)
+    models << &multimodel;
+    models << &wsmodel;
+#endif
 
-        // iniitalise with circular buffer size
-        RollingBests(int size) {
-            index=1;
-            buffer.resize(size);
-        }
+    foreach(PDModel *model, models) {
 
-        // add a new weeks worth of data, losing
-        // whatever is at the back of the buffer
-        void addBests(QVector<float> array) {
-            buffer[index++] = array;
-            if (index >= buffer.count()) index=0;
-        }
+        PDEstimate add;
 
-        // get an aggregate of all the bests
-        // currently in the circular buffer
-        QVector<float> aggregate() {
+        // set the data
+        model->setData(fit.bests);
+        model->saveParameters(add.parameters); // save the computed parms
 
-            QVector<float> returning;
+        add.run = fit.run;
+        add.wpk = false;
+        add.from = fit.begin;
+        add.to = fit.end;
+        add.model = model->code();
+        add.WPrime = model->hasWPrime() ? model->WPrime() : 0;
+        add.CP = model->hasCP() ? model->CP() : 0;
+        add.PMax = model->hasPMax() ? model->PMax() : 0;
+        add.FTP = model->hasFTP() ? model->FTP() : 0;
 
-            // set return buffer size
-            int size=0;
-            for(int i=0; i<buffer.count(); i++)
-                if (buffer[i].size() > size)
-                    size = buffer[i].size();
+        if (add.CP && add.WPrime) add.EI = add.WPrime / add.CP ;
+
+        // so long as the important model derived values are sensible ...
+        if (add.WPrime > 1000 && add.CP > 100 && add.CP < 1000) {
+            printd("Estimates for %s - %s: CP=%.f W'=%.f\n", add.from.toString().toStdString().c_str(), add.to.toString().toStdString().c_str(), add.CP, add.WPrime);
+            fit.estimates << add;
+        }
 
-            // initialise return values
-            returning.fill(0.0f, size);
+        //qDebug()<<add.to<<add.from<<model->code()<< "W'="<< model->WPrime() <<"CP="<< model->CP() <<"pMax="<<model->PMax();
+
+        // set the wpk data
+        model->setData(fit.wpk);
+        model->saveParameters(add.parameters); // save the computed parms
+
+        add.wpk = true;
+        add.from = fit.begin;
+        add.to = fit.end;
+        add.model = model->code();
+        add.WPrime = model->hasWPrime() ? model->WPrime() : 0;
+        add.CP = model->hasCP() ? model->CP() : 0;
+        add.PMax = model->hasPMax() ? model->PMax() : 0;
+        add.FTP = model->hasFTP() ? model->FTP() : 0;
+        if (add.CP && add.WPrime) add.EI = add.WPrime / add.CP ;
+
+        // so long as the model derived values are sensible ...
+        if ((!model->hasWPrime() || add.WPrime > 10.0f) &&
+            (!model->hasCP() || (add.CP > 1.0f && add.CP < 10.0)) &&
+            (!model->hasPMax() || add.PMax > 1.0f) &&
+            (!model->hasFTP() || add.FTP > 1.0f)) {
+            printd("WPK Estimates for %s - %s: CP=%.1f W'=%.1f\n", add.from.toString().toStdString().c_str(), add.to.toString().toStdString().c_str(), add.CP, add.WPrime);
+            fit.estimates << add;
+        }
 
-            // get largest values
-            for(int i=0; i<buffer.count(); i++)
-                for (int j=0; j<buffer[i].count(); j++)
-                    if(buffer[i].at(j) > returning[j])
-                        returning[j] = buffer[i].at(j);
+        //qDebug()<<add.from<<model->code()<< "KG W'="<< model->WPrime() <<"CP="<< model->CP() <<"pMax="<<model->PMax();
+    }
+}
 
-            // return the aggregate
-            return returning;
+// keep the best of each duration, the first one wins a tie
+static void
+mergeBests(QVector<float> &into, const QVector<float> &from, QVector<QDate> *dates=NULL, QDate when=QDate())
+{
+    if (into.size() < from.size()) into.resize(from.size());
+    if (dates && dates->size() < from.size()) dates->resize(from.size());
+
+    for (int i=0; i<from.size(); i++) {
+        if (from[i] > into[i]) {
+            into[i] = from[i];
+            if (dates) (*dates)[i] = when;
         }
-};
+    }
+}
 
 Estimator::Estimator(Context *context) : context(context)
 {
@@ -164,6 +226,9 @@ Estimator::calculate()
 void
 Estimator::run()
 {
+  QString activities = context->athlete->home->activities().canonicalPath() + "/";
+  QString cache = context->athlete->home->cache().canonicalPath() + "/";
+
   for (int i = 0; i < 2; i++) {
 
     bool isRun = (i > 0); // two times: one for rides and other for runs
@@ -171,28 +236,26 @@ Estimator::run()
     printd("%s Estimates start.\n", isRun ? "Run" : "Bike");
 
     // this needs to be done once all the other metrics
-    // Calculate a *monthly* estimate of CP, W' etc using
+    // Calculate a *weekly* estimate of CP, W' etc using
     // bests data from the previous 6 weeks
-    RollingBests bests(6);
-    RollingBests bestsWPK(6);
-
-    // clear any previous calculations
     QList<PDEstimate> est;
     QList<Performance> perfs;
 
-    // we do this by aggregating power data into bests
-    // for each month, and having a rolling set of 3 aggregates
-    // then aggregating those up into a rolling 3 month 'bests'
-    // which we feed to the models to get the estimates for that
-    // point in time based upon the available data
+    // we do this by aggregating power data into bests for each
+    // week and having a rolling set of 6 weeks of bests which we
+    // feed to the models to get the estimates for that point in
+    // time based upon the available data
     QDate from, to;
 
     // what dates have any power data ?
+    QList<RideItem*> powerRides;
     foreach(RideItem *item, rides) {
 
         // has power and matches sport
         if (item->present.contains("P") && item->isRun == isRun) {
 
+            powerRides << item;
+
             // no date set
             if (from == QDate()) from = item->dateTime.date();
             if (to == QDate()) to = item->dateTime.date();
@@ -211,28 +274,21 @@ Estimator::run()
         continue;
     }
 
-    // set up the models we support
-    CP2Model p2model(context);
-    CP3Model p3model(context);
-    ExtendedModel extmodel(context);
-#if 0 // disable until model fitting errors are fixed (!!!)
-    WSModel wsmodel(context);
-    MultiModel multimodel(context);
-#endif
-
-    QList <PDModel *> models;
-    models << &p2model;
-    models << &p3model;
-    models << &extmodel;
-#if 0 // disable until model fitting errors are fixed (!!!)
-    models << &multimodel;
-    models << &wsmodel;
-#endif
-
     // from has first ride with Power data / looking at the next 7 days of data with Power
     // calculate Estimates for all data per week including the week of the last Power recording
-    QDate date = from;
-    while (date < to) {
+    int count = (from.daysTo(to) + 6) / 7;
+
+    // bucket the rides by week, once
+    QVector<QList<RideItem*> > bucket(count);
+    foreach(RideItem *item, powerRides) {
+        int week = from.daysTo(item->dateTime.date()) / 7;
+        if (week < count) bucket[week] << item;
+    }
+
+    // only read the bests for weeks that have changed since last time,
+    // the cache files are rewritten when the ride changes
+    QVector<EstimatorWeek> current(count);
+    for (int w=0; w<count; w++) {
 
         // check if we've been asked to stop
         if (abort == true) {
@@ -241,25 +297,39 @@ Estimator::run()
             return;
         }
 
-        QDate begin = date;
-        QDate end = date.addDays(6);
+        QDate begin = from.addDays(w * 7);
+        QDate end = begin.addDays(6);
 
-        printd("Model progress %d/%d\n", date.year(), date.month());
+        EstimatorWeek &week = current[w];
+        foreach(RideItem *item, bucket[w]) {
+            QFileInfo cpx(cache + QFileInfo(item->fileName).baseName() + ".cpx");
+            week.signature << item->fileName + "@" + QString::number(cpx.lastModified().toMSecsSinceEpoch());
+        }
+
+        if (weeks[i].contains(begin) && weeks[i].value(begin).signature == week.signature) {
+            week = weeks[i].value(begin);
+            week.changed = false;
+            continue;
+        }
 
-        // months is a rolling 3 months sets of bests
-        QVector<float> wpk; // for getting the wpk values
+        printd("Model progress %d/%d\n", begin.year(), begin.month());
 
-        // include only rides or runs .............................................................vvvvv
+        // include only rides or runs
         QVector<QDate> weekdates;
-        QVector<float> week = RideFileCache::meanMaxPowerFor(context, wpk, begin, end, &weekdates, isRun);
+        foreach(RideItem *item, bucket[w]) {
+            QVector<float> wpk;
+            QVector<float> ridebest = RideFileCache::meanMaxPowerFor(context, wpk, activities + item->fileName);
+            mergeBests(week.bests, ridebest, &weekdates, item->dateTime.date());
+            mergeBests(week.wpk, wpk);
+        }
 
         // lets extract the best performance of the week first.
         // only care about performances between 3-20 minutes.
         Performance bestperformance(end,0,0,0);
-        for (int t=240; t<week.length() && t<3600; t++) {
+        for (int t=240; t<week.bests.size() && t<3600; t++) {
 
-            double p = double(week[t]);
-            if (week[t]<=0) continue;
+            double p = double(week.bests[t]);
+            if (week.bests[t]<=0) continue;
 
             double pix = powerIndex(p, t, isRun);
             if (pix > bestperformance.powerIndex) {
@@ -273,68 +343,55 @@ Estimator::run()
                 bestperformance.x = bestperformance.when.toJulianDay();
             }
         }
-        if (bestperformance.duration > 0) perfs << bestperformance;
-
-        bests.addBests(week);
-        bestsWPK.addBests(wpk);
-
-        // we now have the data
-        foreach(PDModel *model, models) {
-
-            PDEstimate add;
-
-            // set the data
-            model->setData(bests.aggregate());
-            model->saveParameters(add.parameters); // save the computed parms
+        if (bestperformance.duration > 0) week.performance << bestperformance;
+    }
 
-            add.run = isRun;
-            add.wpk = false;
-            add.from = begin;
-            add.to = end;
-            add.model = model->code();
-            add.WPrime = model->hasWPrime() ? model->WPrime() : 0;
-            add.CP = model->hasCP() ? model->CP() : 0;
-            add.PMax = model->hasPMax() ? model->PMax() : 0;
-            add.FTP = model->hasFTP() ? model->FTP() : 0;
+    // refit the weeks that have a changed week in their rolling
+    // bests, they are independent so can be fitted in parallel
+    QVector<EstimatorFit> fits;
+    QVector<int> fitted;
+    for (int w=0; w<count; w++) {
+
+        int first = qMax(0, w - (ROLLINGWEEKS-1));
+        QDate window = from.addDays(first * 7);
+
+        bool changed = current[w].window != window;
+        for (int k=first; k<=w && !changed; k++) changed = current[k].changed;
+        if (!changed) continue;
+
+        EstimatorFit fit;
+        fit.context = context;
+        fit.run = isRun;
+        fit.begin = from.addDays(w * 7);
+        fit.end = fit.begin.addDays(6);
+        fit.abort = &abort;
+        for (int k=first; k<=w; k++) {
+            mergeBests(fit.bests, current[k].bests);
+            mergeBests(fit.wpk, current[k].wpk);
+        }
+        current[w].window = window;
 
-            if (add.CP && add.WPrime) add.EI = add.WPrime / add.CP ;
+        fits << fit;
+        fitted << w;
+    }
 
-            // so long as the important model derived values are sensible ...
-            if (add.WPrime > 1000 && add.CP > 100 && add.CP < 1000) {
-                printd("Estimates for %s - %s: CP=%.f W'=%.f\n", add.from.toString().toStdString().c_str(), add.to.toString().toStdString().c_str(), add.CP, add.WPrime);
-                est << add;
-            }
+    printd("%s refitting %d of %d weeks.\n", isRun ? "Run" : "Bike", fits.count(), count);
+    QtConcurrent::blockingMap(fits, fitModels);
 
-            //qDebug()<<add.to<<add.from<<model->code()<< "W'="<< model->WPrime() <<"CP="<< model->CP() <<"pMax="<<model->PMax();
-
-            // set the wpk data
-            model->setData(bestsWPK.aggregate());
-            model->saveParameters(add.parameters); // save the computed parms
-
-            add.wpk = true;
-            add.from = begin;
-            add.to = end;
-            add.model = model->code();
-            add.WPrime = model->hasWPrime() ? model->WPrime() : 0;
-            add.CP = model->hasCP() ? model->CP() : 0;
-            add.PMax = model->hasPMax() ? model->PMax() : 0;
-            add.FTP = model->hasFTP() ? model->FTP() : 0;
-            if (add.CP && add.WPrime) add.EI = add.WPrime / add.CP ;
-
-            // so long as the model derived values are sensible ...
-            if ((!model->hasWPrime() || add.WPrime > 10.0f) &&
-                (!model->hasCP() || (add.CP > 1.0f && add.CP < 10.0)) &&
-                (!model->hasPMax() || add.PMax > 1.0f) &&
-                (!model->hasFTP() || add.FTP > 1.0f)) {
-                printd("WPK Estimates for %s - %s: CP=%.1f W'=%.1f\n", add.from.toString().toStdString().c_str(), add.to.toString().toStdString().c_str(), add.CP, add.WPrime);
-                est << add;
-            }
+    if (abort == true) {
+        printd("Model estimator aborted.\n");
+        abort = false;
+        return;
+    }
 
-            //qDebug()<<add.from<<model->code()<< "KG W'="<< model->WPrime() <<"CP="<< model->CP() <<"pMax="<<model->PMax();
-        }
+    for (int f=0; f<fits.count(); f++) current[fitted[f]].estimates = fits[f].estimates;
 
-        // go forward a week
-        date = date.addDays(7);
+    // keep for next time, and collect the results in date order
+    weeks[i].clear();
+    for (int w=0; w<count; w++) {
+        weeks[i].insert(from.addDays(w * 7), current[w]);
+        perfs.append(current[w].performance);
+        est.append(current[w].estimates);
     }
 
     // filter performances
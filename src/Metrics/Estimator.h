@@ -45,6 +45,24 @@ class Performance {
         double x; // different units, but basically when as a julian day
 };
 
+// a week of power bests and what came out of it, kept between runs
+// so only weeks with new or changed rides need the cache files read
+// and only the weeks that see them in their rolling bests are refitted
+class EstimatorWeek {
+
+    public:
+        EstimatorWeek() : changed(true) {}
+
+        QStringList signature; // rides and their cache file timestamps
+        QDate window; // first week in the rolling bests when fitted
+
+        QVector<float> bests, wpk; // best of all the rides in the week
+        QList<Performance> performance; // best of the week, if there is one
+        QList<PDEstimate> estimates; // from the rolling bests
+
+        bool changed; // this run
+};
+
 class Banister;
 class Estimator : public QThread {
 
@@ -87,6 +105,10 @@ class Estimator : public QThread {
         QVector<RideItem*> rides; // worklist
         QTimer singleshot;
 
+        // by week commencing, for bikes [0] and runs [1]
+        // only used by the thread
+        QMap<QDate, EstimatorWeek> weeks[2];
+
         bool abort;
 };
 
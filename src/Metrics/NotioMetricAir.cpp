@@ -110,7 +110,7 @@ void xAirPressure::compute(RideItem *item, Specification iSpec, const QHash<QStr
         DataSeriesIterator it(xdataSeries, iSpec);
 
         while (it.hasNext()) {
-            XDataPoint *xpoint = it.next();
+            const XDataPoint *xpoint = it.next();
 
             count++;
             sum += xpoint->number[varIndex] / (wOldFormat ? 120.0 : 1.0);
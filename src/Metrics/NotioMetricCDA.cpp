@@ -109,7 +109,7 @@ void NotioPmEnergy::compute(RideItem *item, Specification iSpec, const QHash<QSt
         DataSeriesIterator it(xdataSeries, iSpec);
         while (it.hasNext())
         {
-            XDataPoint *xpoint = it.next();
+            const XDataPoint *xpoint = it.next();
             wJoules_pm_total += (wMechEff * xpoint->number[wPowerIndex]) * wRecInt;
         }
         setValue(wJoules_pm_total);
@@ -234,7 +234,7 @@ void NotioCrrEnergy::compute(RideItem *item, Specification iSpec, const QHash<QS
         DataSeriesIterator it(xdataSeries, iSpec);
         while (it.hasNext())
         {
-            XDataPoint *xpoint = it.next();
+            const XDataPoint *xpoint = it.next();
 
             double wSpeed = xpoint->number[wSpeedIndex];
             wJoules_crr_total += GcAlgo::AeroAlgo::rolling_resistance_energy(wCrr, wTotalWeight, wSpeed, wRecInt);
@@ -356,12 +356,12 @@ void NotioAltEnergy::compute(RideItem *item, Specification iSpec, const QHash<QS
         double wJoules_alt_total = 0.0;
 
         DataSeriesIterator it(xdataSeries, iSpec);
-        XDataPoint *wPreviousPoint = xdataSeries->datapoints[std::max(it.firstIndex() - 1, 0)];
+        const XDataPoint *wPreviousPoint = xdataSeries->datapoints[std::max(it.firstIndex() - 1, 0)];
 
         // Calculate the energy.
         while (it.hasNext())
         {
-            XDataPoint *xpoint = it.next();
+            const XDataPoint *xpoint = it.next();
 
             wJoules_alt_total += GcAlgo::AeroAlgo::potential_energy(wTotalWeight, xpoint->number[wAltComputeIndex], wPreviousPoint->number[wAltComputeIndex]);
             wPreviousPoint = xpoint;
@@ -483,12 +483,12 @@ void NotioKineticEnergy::compute(RideItem *item, Specification iSpec, const QHas
         double wJoules_inertia_total = 0.0;
 
         DataSeriesIterator it(xdataSeries, iSpec);
-        XDataPoint *wPreviousPoint = xdataSeries->datapoints[std::max(it.firstIndex() - 1, 0)];
+        const XDataPoint *wPreviousPoint = xdataSeries->datapoints[std::max(it.firstIndex() - 1, 0)];
 
         // Calculate the energy.
         while (it.hasNext())
         {
-            XDataPoint *xpoint = it.next();
+            const XDataPoint *xpoint = it.next();
 
             double wSpeed = xpoint->number[wSpeedIndex];
             double wPrevSpeed = wPreviousPoint->number[wSpeedIndex];
@@ -626,7 +626,7 @@ void NotioCdaEnergy::compute(RideItem *item, Specification iSpec, const QHash<QS
         DataSeriesIterator it(xdataSeries, iSpec);
         while (it.hasNext())
         {
-            XDataPoint *xpoint = it.next();
+            const XDataPoint *xpoint = it.next();
 
             double wAirPress = xpoint->number[wAirPressureIndex] / (wOldFormat ? GcAlgo::AeroAlgo::cAirPressureSensorFactor : 1.0);
             double wSpeed = xpoint->number[wSpeedIndex];
@@ -117,7 +117,7 @@ void xWindSpeed::compute(RideItem *item, Specification iSpec, const QHash<QStrin
         DataSeriesIterator it(xdataSeries, iSpec);
 
         while (it.hasNext()) {
-            XDataPoint *xpoint = it.next();
+            const XDataPoint *xpoint = it.next();
             counter++;
 
             // Calculate head wind.
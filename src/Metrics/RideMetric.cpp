@@ -25,6 +25,12 @@
 #include "Zones.h"
 #include "HrZones.h"
 
+#if QT_VERSION > 0x050000
+#include <QtConcurrent>
+#else
+#include <QtConcurrentMap>
+#endif
+
 // DB Schema Version - YOU MUST UPDATE THIS IF THE SCHEMA VERSION CHANGES!!!
 // Schema version will change if a) the default metadata.xml is updated
 //                            or b) new metrics are added / old changed
@@ -183,8 +189,124 @@ RideMetric::userMetricFingerprint(QList<UserMetricSettings> these)
     return qChecksum(fingers.constData(), fingers.size());
 }
 
+// one metric in a level, computed on the thread pool
+struct RideMetricTask {
+    RideMetric *m;
+    RideItem *item;
+    Specification *spec;
+    const QHash<QString,RideMetric*> *done;
+};
+
+static void
+computeMetricTask(RideMetricTask &task)
+{
+    RideMetric *m = task.m;
+    m->setValue(0.0);
+    m->setCount(0);
+    m->compute(task.item, *task.spec, *task.done);
+
+    // override the computed value if set by user, but not for intervals
+    if (!task.spec->interval() && task.item->ride() && task.item->ride()->metricOverrides.contains(m->symbol()))
+        m->override(task.item->ride()->metricOverrides.value(m->symbol()));
+}
+
 QHash<QString,RideMetricPtr>
 RideMetric::computeMetrics(RideItem *item, Specification spec, const QStringList &metrics)
+{
+    RideMetricFactory &factory = RideMetricFactory::instance();
+    RideMetricGraph graph = factory.graph();
+    int count = factory.metricCount();
+
+    // work out what is needed, the ones asked for and what they depend upon
+    QVector<bool> wanted(count, false);
+    QVector<int> todo;
+    bool anyUser = false;
+    foreach(QString metric, metrics) {
+        const RideMetric *m = factory.rideMetric(metric);
+        if (m && m->index() < count && !wanted[m->index()]) {
+            wanted[m->index()] = true;
+            todo << m->index();
+            if (m->isUser()) anyUser = true;
+        }
+    }
+    while (!todo.isEmpty()) {
+        int index = todo.takeLast();
+        foreach(int dep, graph.deps[index]) {
+            if (!wanted[dep]) {
+                wanted[dep] = true;
+                todo << dep;
+            }
+        }
+    }
+
+    // this is what we've completed as we go
+    QHash<QString,RideMetric*> done;
+
+    // resize the metric array in the interval if needed
+    if (spec.interval() && spec.interval()->metrics().size() < count)
+        spec.interval()->metrics().resize(count);
+
+    // resize the metric array in the interval if needed
+    if (!spec.interval() && item->metrics().size() < count)
+        item->metrics().resize(count);
+
+    // the ride is opened on first use, do it now rather
+    // than have the metrics in a level race to do it
+    item->ride();
+
+    // builtins a level at a time then the user metrics in order, any
+    // in a dependency cycle were reported by the graph and are skipped
+    QVector<QVector<int> > stages = graph.levels;
+    foreach(int index, graph.user) stages << (QVector<int>() << index);
+
+    QVector<RideMetricTask> tasks;
+    foreach(const QVector<int> &stage, stages) {
+
+        // we clone so we can remain thread safe
+        // do not be tempted to change this (!)
+        tasks.resize(0);
+        foreach(int index, stage) {
+            if (!wanted[index]) continue;
+            RideMetricTask task = { factory.newMetric(factory.metricName(index)), item, &spec, &done };
+            tasks << task;
+        }
+
+        // dependencies are all in done and it isn't touched until they finish
+        if (tasks.count() > 1) QtConcurrent::blockingMap(tasks, computeMetricTask);
+        else if (tasks.count() == 1) computeMetricTask(tasks[0]);
+
+        foreach(const RideMetricTask &task, tasks) {
+
+            // all computed add to the return list
+            done.insert(task.m->symbol(), task.m);
+
+            // put into value array too. user metrics will interrogate
+            // this for symbol values, rather than the metric pointer
+            if (anyUser) {
+                if (spec.interval()) spec.interval()->metrics()[task.m->index()] = task.m->value();
+                else item->metrics()[task.m->index()] = task.m->value();
+            }
+        }
+    }
+
+    // lets prepare the results using a shared pointer
+    // which is deleted when reference count 0 and goes out of scope
+    QHash<QString,RideMetricPtr> result;
+    foreach (QString symbol, metrics) {
+        if (done.contains(symbol)) {
+            result.insert(symbol, QSharedPointer<RideMetric>(done.value(symbol)));
+            done.remove(symbol);
+        }
+    }
+
+    // delete the dependencies nobody asked for
+    foreach (RideMetric *m, done) delete m;
+
+    return result;
+}
+
+QHash<QString,RideMetricPtr>
+RideMetric::computeMetricsWorklist(RideItem *item, Specification spec, const QStringList &metrics)
 {
     const RideMetricFactory &factory = RideMetricFactory::instance();
 
@@ -323,3 +445,77 @@ RideMetric::toString(bool useMetricUnits, double v) const
 const RideMetric * RideMetricFactory::rideMetric(QString name) const {
         return metrics.value(name, NULL);
 }
+
+RideMetricGraph
+RideMetricFactory::graph()
+{
+    QMutexLocker locker(&graphLock);
+    if (graphStale) buildGraph();
+    return graph_;
+}
+
+void
+RideMetricFactory::buildGraph()
+{
+    checkDependencies();
+
+    int count = metricNames.count();
+    graph_.deps.fill(QVector<int>(), count);
+    graph_.levels.clear();
+    graph_.user.clear();
+    graph_.cyclic.clear();
+
+    // symbols to indexes, unknown dependencies were reported above
+    QVector<int> level(count, -1);
+    for (int i=0; i<count; i++) {
+        foreach(const QString &dep, dependencies(metricNames[i])) {
+            const RideMetric *m = metrics.value(dep, NULL);
+            if (m) graph_.deps[i] << m->index();
+        }
+        if (metrics.value(metricNames[i])->isUser()) graph_.user << i;
+    }
+
+    // level is one more than the deepest dependency, keep going
+    // until nothing changes, there are only a handful of levels
+    bool changed = true;
+    int passes = 0;
+    while (changed && passes++ <= count) {
+        changed = false;
+        for (int i=0; i<count; i++) {
+            if (level[i] >= 0 || metrics.value(metricNames[i])->isUser()) continue;
+
+            int deepest = -1;
+            bool ready = true;
+            foreach(int dep, graph_.deps[i]) {
+                if (level[dep] < 0) { ready = false; break; }
+                deepest = qMax(deepest, level[dep]);
+            }
+            if (ready) {
+                level[i] = deepest + 1;
+                changed = true;
+            }
+        }
+    }
+
+    for (int i=0; i<count; i++) {
+        if (metrics.value(metricNames[i])->isUser()) continue;
+
+        // in a cycle or depends on one, there is no order that works and
+        // a metric reads its dependencies without checking so they can't
+        // be computed at all (the worklist would loop forever on them)
+        if (level[i] < 0) {
+            graph_.cyclic << i;
+            continue;
+        }
+        if (graph_.levels.count() <= level[i]) graph_.levels.resize(level[i]+1);
+        graph_.levels[level[i]] << i;
+    }
+
+    // say which and what they are waiting on, once per rebuild
+    foreach(int i, graph_.cyclic) {
+        QStringList waiting;
+        foreach(int dep, graph_.deps[i]) if (level[dep] < 0) waiting << metricNames[dep];
+        qWarning()<<"metric dependency cycle, not computed:"<<metricNames[i]<<"waits on"<<waiting.join(", ");
+    }
+    graphStale = false;
+}
@@ -231,9 +231,15 @@ public:
     // members from source and reference count them to be space efficient
     virtual RideMetric *clone() const { return NULL; }
 
+    // builtins are computed a level of the dependency graph at a time
+    // with the metrics in each level computed in parallel
     static QHash<QString,RideMetricPtr>
     computeMetrics(RideItem *item, Specification spec, const QStringList &metrics);
 
+    // the original string worklist, kept as the reference for --benchmark
+    static QHash<QString,RideMetricPtr>
+    computeMetricsWorklist(RideItem *item, Specification spec, const QStringList &metrics);
+
     // get the value for metric m from precomputed values stored at p
     static double getForSymbol(QString m, const QHash<QString,RideMetric*> *p);
 
@@ -365,6 +371,19 @@ public:
 
 };
 
+// dependencies by metric index, builtins are split into levels where
+// each level only depends on the levels before it so the metrics in a
+// level can be computed at the same time. User metrics don't declare
+// their dependencies so they stay in order after all the builtins.
+// Builtins caught in a dependency cycle can't be levelled, they are
+// reported when the graph is built and left out.
+struct RideMetricGraph {
+    QVector<QVector<int> > deps;    // per metric index
+    QVector<QVector<int> > levels;  // builtin metric indexes
+    QVector<int> user;              // user metric indexes
+    QVector<int> cyclic;            // builtins that can't be computed
+};
+
 class RideMetricFactory {
 
 public:
@@ -381,7 +400,13 @@ private:
     QHash<QString,QVector<QString>*> dependencyMap;
     bool dependenciesChecked;
 
-    RideMetricFactory() : dependenciesChecked(false) {}
+    // rebuilt on first use after metrics are added or removed
+    RideMetricGraph graph_;
+    bool graphStale;
+    QMutex graphLock;
+    void buildGraph();
+
+    RideMetricFactory() : dependenciesChecked(false), graphStale(true) {}
     RideMetricFactory(const RideMetricFactory &other);
     RideMetricFactory &operator=(const RideMetricFactory &other);
 
@@ -419,6 +444,9 @@ private:
     const RideMetric::MetricSourceType &metricSourceType(int i) const { return metricSourceTypes[i]; }
     const RideMetric *rideMetric(QString name) const;
 
+    // the dependency graph, a copy since user metrics can be reloaded
+    RideMetricGraph graph();
+
     bool haveMetric(const QString &symbol) const {
         return metrics.contains(symbol);
     }
@@ -450,6 +478,7 @@ private:
                 metricTypes.remove(firstUser);
                 metricSourceTypes.remove(firstUser);
             }
+            graphStale = true;
         }
     }
 
@@ -462,6 +491,7 @@ private:
         metricNames.append(metric.symbol());
         metricTypes.append(metric.type());
         metricSourceTypes.append(metric.sourceType());
+        graphStale = true;
         if (deps) {
             QVector<QString> *copy = new QVector<QString>;
             for (int i = 0; i < deps->size(); ++i)
@@ -38,6 +38,13 @@ UserMetric::UserMetric(Context *context, UserMetricSettings settings)
     fvalue = rt->functions.contains("value") ? rt->functions.value("value") : NULL;
     fcount = rt->functions.contains("count") ? rt->functions.value("count") : NULL;
 
+    // these are called once per ride and usually just a metric or two
+    // so compile them now, clones ask the program for them as they
+    // are used since config changes replace them
+    program->compile(frelevant);
+    program->compile(fvalue);
+    program->compile(fcount);
+
     // we're not a clone, we're the original
     clone_ = false;
 }
@@ -184,6 +191,9 @@ UserMetric::isRelevantForRide(const RideItem *item) const
 {
     if (item->context && root) {
         if (frelevant) {
+            QSharedPointer<DataFilterProgram> prelevant = program->compile(frelevant);
+            if (prelevant && prelevant->usable(rt, false))
+                return prelevant->eval(rt, const_cast<RideItem*>(item));
             Result res = root->eval(rt, frelevant, 0, const_cast<RideItem*>(item), NULL, NULL);
             return res.number;
         } else
@@ -261,15 +271,25 @@ UserMetric::compute(RideItem *item, Specification spec, const QHash<QString,Ride
     //qDebug()<<"VALUE";
     // value ?
     if (fvalue) {
-        Result v = root->eval(rt, fvalue, 0, const_cast<RideItem*>(item), NULL, c, spec);
-        setValue(v.number);
+        QSharedPointer<DataFilterProgram> pvalue = program->compile(fvalue);
+        if (pvalue && pvalue->usable(rt, false)) {
+            setValue(pvalue->eval(rt, item, NULL, c, 0, spec));
+        } else {
+            Result v = root->eval(rt, fvalue, 0, const_cast<RideItem*>(item), NULL, c, spec);
+            setValue(v.number);
+        }
     }
 
     //qDebug()<<"COUNT";
     // count?
     if (fcount) {
-        Result n = root->eval(rt, fcount, 0, const_cast<RideItem*>(item), NULL, c, spec);
-        setCount(n.number);
+        QSharedPointer<DataFilterProgram> pcount = program->compile(fcount);
+        if (pcount && pcount->usable(rt, false)) {
+            setCount(pcount->eval(rt, item, NULL, c, 0, spec));
+        } else {
+            Result n = root->eval(rt, fcount, 0, const_cast<RideItem*>(item), NULL, c, spec);
+            setCount(n.number);
+        }
     }
 
     //qDebug()<<symbol()<<index_<<value_<<"ELAPSED="<<timer.elapsed()<<"ms";
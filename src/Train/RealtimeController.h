@@ -57,6 +57,10 @@ public:
     virtual void getRealtimeData(RealtimeData &rtData); // update realtime data with current values
     virtual void pushRealtimeData(RealtimeData &rtData); // update realtime data with current values
 
+    // getRealtimeData(), setLoad() and setGradient() can be called from the
+    // TrainTelemetry thread right now, see TrainTelemetry.h
+    virtual bool threadSafe() { return false; }
+
     // only relevant for Computrainer like devices
     virtual void setLoad(double) { return; }
     virtual void setGradient(double) { return; }
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TrainJournal.h"
+#include "RealtimeData.h"
+
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+TrainJournal::TrainJournal(QString filename) : filename(filename)
+{
+}
+
+TrainJournal::~TrainJournal()
+{
+    close();
+}
+
+bool
+TrainJournal::open(QDateTime startTime, int sampleMsecs)
+{
+    // our own descriptor, so sync() has one on every platform,
+    // the QFile closes it
+#ifdef Q_OS_WIN
+    int fd = _wopen(reinterpret_cast<const wchar_t*>(filename.utf16()),
+                    _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    int fd = ::open(QFile::encodeName(filename).constData(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (fd < 0) return false;
+    if (!file.open(fd, QFile::WriteOnly, QFileDevice::AutoCloseHandle)) {
+#ifdef Q_OS_WIN
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+        return false;
+    }
+
+    TrainJournalHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "GCTJ", 4);
+    header.version = TrainJournalVersion;
+    header.recordSize = sizeof(TrainJournalRecord);
+    header.sampleMsecs = sampleMsecs;
+    header.startTime = startTime.toMSecsSinceEpoch();
+
+    if (file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header)) {
+        file.close();
+        return false;
+    }
+
+    // so the header is there even if nothing else is
+    file.flush();
+    return true;
+}
+
+void
+TrainJournal::close()
+{
+    if (file.isOpen()) file.close();
+}
+
+void
+TrainJournal::append(qint64 msecs, const RealtimeData &rtData, double km)
+{
+    TrainJournalRecord record;
+    memset(&record, 0, sizeof(record));
+
+    record.type = TrainJournalRecord::Sample;
+    record.msecs = msecs;
+
+    record.km = km;
+    record.alt = rtData.getAltitude();
+    record.lon = rtData.getLongitude();
+    record.lat = rtData.getLatitude();
+
+    record.watts = rtData.getWatts();
+    record.hr = rtData.getHr();
+    record.cad = rtData.getCadence();
+    record.kph = rtData.getSpeed();
+    record.slope = rtData.getSlope();
+    record.load = rtData.getLoad();
+
+    record.lrbalance = rtData.getLRBalance();
+    record.lte = rtData.getLTE();
+    record.rte = rtData.getRTE();
+    record.lps = rtData.getLPS();
+    record.rps = rtData.getRPS();
+
+    record.smo2 = rtData.getSmO2();
+    record.thb = rtData.gettHb();
+    record.lap = rtData.getLap();
+
+    write(record);
+}
+
+void
+TrainJournal::appendRR(qint64 msecs, int bpm, int rr)
+{
+    TrainJournalRecord record;
+    memset(&record, 0, sizeof(record));
+
+    record.type = TrainJournalRecord::RR;
+    record.msecs = msecs;
+    record.hr = bpm;
+    record.rr = rr;
+
+    write(record);
+}
+
+void
+TrainJournal::write(TrainJournalRecord &record)
+{
+    if (!file.isOpen()) return;
+
+    const char *bytes = reinterpret_cast<const char*>(&record);
+    record.checksum = qChecksum(bytes + sizeof(record.checksum), sizeof(record) - sizeof(record.checksum));
+
+    // QFile buffers it, flush() hands it on
+    file.write(bytes, sizeof(record));
+}
+
+bool
+TrainJournal::sync(int handle)
+{
+    if (handle < 0) return false;
+#ifdef Q_OS_WIN
+    return _commit(handle) == 0;
+#else
+    return fsync(handle) == 0;
+#endif
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_TrainJournal_h
+#define _GC_TrainJournal_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QFile>
+#include <QDateTime>
+
+class RealtimeData;
+
+// TrainJournal is what train mode records to, it replaces the .csv that
+// was written once a second and re-parsed at the end. Every sample the
+// telemetry thread polls goes in as it is polled, along with any R-R
+// intervals, and the journal is read back into a RideFile by the
+// TrainJournalFileReader when the session ends.
+//
+// It is a poll rate journal: samples are what the devices last gave at
+// each poll (sampleMsecs, 200ms), not every message they decoded at their
+// own rate, so faster data in between polls is not recorded. Only the
+// R-R intervals are journalled as they arrive.
+//
+// It is only ever appended to and every record carries its own checksum
+// so if GC (or the machine) goes down mid session whatever made it to
+// disk can still be imported; a record that was half written is skipped.
+//
+static const quint32 TrainJournalVersion = 1;
+// revision history:
+// version  date         description
+// 1        17-Oct-26    Initial - samples and R-R intervals
+
+// The journal file (records/yyyy_MM_dd_hh_mm_ss.gcj) has a binary format:
+// 1 x Header - version, record size and when the session started
+// n x Records - fixed width, in the order they were polled
+//
+// Like the other local files it is written in local byte order, it is
+// imported on the machine that recorded it.
+struct TrainJournalHeader {
+
+    char magic[4];          // "GCTJ"
+    quint32 version;        // TrainJournalVersion
+    quint32 recordSize;     // later versions may add to the end of a record
+    quint32 sampleMsecs;    // how often samples were polled
+    qint64 startTime;       // msecs since epoch
+};
+
+struct TrainJournalRecord {
+
+    enum { Sample = 1, RR = 2 };
+
+    quint16 checksum;       // qChecksum of the rest of the record
+    quint8 type;
+    quint8 spare8;
+    qint32 msecs;           // session time, not counting pauses
+
+    double km, alt, lon, lat;
+    float watts, hr, cad, kph, slope, load;
+    float lrbalance, lte, rte, lps, rps;
+    float smo2, thb;
+    float rr;               // R-R msecs, hr is the bpm with it
+    qint32 lap;
+    quint32 spare;
+};
+
+class TrainJournal
+{
+    public:
+
+        TrainJournal(QString filename);
+        ~TrainJournal();
+
+        // truncates and writes the header
+        bool open(QDateTime startTime, int sampleMsecs);
+        void close();
+        bool isOpen() const { return file.isOpen(); }
+        QString fileName() const { return filename; }
+        bool remove() { close(); return QFile::remove(filename); }
+
+        void append(qint64 msecs, const RealtimeData &rtData, double km);
+        void appendRR(qint64 msecs, int bpm, int rr);
+
+        // flush() hands what is buffered to the os, it survives GC going
+        // down. sync() waits for the os to put it on disk, it survives the
+        // machine going down but can take a while so is done without any
+        // locks held, on the handle. we open the descriptor ourselves as
+        // QFile::handle() is -1 on Windows for a file opened by name
+        void flush() { file.flush(); }
+        int handle() const { return file.handle(); }
+        static bool sync(int handle);
+
+    private:
+
+        void write(TrainJournalRecord &record);
+
+        QString filename;
+        QFile file;
+};
+
+#endif // _GC_TrainJournal_h
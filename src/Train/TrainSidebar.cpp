@@ -327,16 +327,15 @@ TrainSidebar::TrainSidebar(Context *context) : GcWindow(context), context(contex
 
     // now the GUI is setup lets sort our control variables
     gui_timer = new QTimer(this);
-    disk_timer = new QTimer(this);
     load_timer = new QTimer(this);
+    telemetry = new TrainTelemetry(context, this);
 
     session_time = QTime();
     session_elapsed_msec = 0;
     lap_time = QTime();
     lap_elapsed_msec = 0;
 
-    rrFile = recordFile = NULL;
-    lastRecordSecs = 0;
+    journal = NULL;
     status = 0;
     setStatusFlags(RT_MODE_ERGO);         // ergo mode by default
     mode = ERG;
@@ -357,7 +356,6 @@ TrainSidebar::TrainSidebar(Context *context) : GcWindow(context), context(contex
     displayLatitude = displayLongitude = displayAltitude = 0.0;
 
     connect(gui_timer, SIGNAL(timeout()), this, SLOT(guiUpdate()));
-    connect(disk_timer, SIGNAL(timeout()), this, SLOT(diskUpdate()));
     connect(load_timer, SIGNAL(timeout()), this, SLOT(loadUpdate()));
 
     configChanged(CONFIG_APPEARANCE | CONFIG_DEVICES | CONFIG_ZONES); // will reset the workout tree
@@ -1120,7 +1118,7 @@ void TrainSidebar::Start()       // when start button is pressed
         clearStatusFlags(RT_PAUSED);
         //foreach(int dev, activeDevices) Devices[dev].controller->restart();
         //gui_timer->start(REFRESHRATE);
-        if (status & RT_RECORDING) disk_timer->start(SAMPLERATE);
+        telemetry->setPaused(false);
         load_period.restart();
         if (status & RT_WORKOUT) load_timer->start(LOADRATE);
 
@@ -1146,7 +1144,7 @@ void TrainSidebar::Start()       // when start button is pressed
         setStatusFlags(RT_PAUSED);
         //foreach(int dev, activeDevices) Devices[dev].controller->pause();
         //gui_timer->stop();
-        if (status & RT_RECORDING) disk_timer->stop();
+        telemetry->setPaused(true);
         if (status & RT_WORKOUT) load_timer->stop();
         load_msecs += load_period.restart();
 
@@ -1227,6 +1225,10 @@ void TrainSidebar::Start()       // when start button is pressed
         //    Devices[dev].controller->resetCalibrationState();
         //}
 
+        // the telemetry thread runs ERG workouts, we keep up with it
+        telemetry->begin((status & RT_WORKOUT) && (status & RT_MODE_ERGO) ? ergFile : NULL);
+        latest = TrainSample();
+
         if (status & RT_WORKOUT) {
             load_timer->start(LOADRATE);      // start recording
         }
@@ -1239,26 +1241,21 @@ void TrainSidebar::Start()       // when start button is pressed
             QDateTime now = QDateTime::currentDateTime();
 
             // setup file
-            QString filename = now.toString(QString("yyyy_MM_dd_hh_mm_ss")) + QString(".csv");
+            QString filename = now.toString(QString("yyyy_MM_dd_hh_mm_ss")) + QString(".gcj");
 
             if (!context->athlete->home->records().exists())
                 context->athlete->home->createAllSubdirs();
 
             QString fulltarget = context->athlete->home->records().canonicalPath() + "/" + filename;
 
-            if (recordFile) delete recordFile;
-            recordFile = new QFile(fulltarget);
-            lastRecordSecs = 0;
-            if (!recordFile->open(QFile::WriteOnly | QFile::Truncate)) {
+            if (journal) delete journal;
+            journal = new TrainJournal(fulltarget);
+            if (!journal->open(now, REFRESHRATE)) {
                 clearStatusFlags(RT_RECORDING);
             } else {
 
-                // CSV File header
-
-                QTextStream recordFileStream(recordFile);
-                recordFileStream << "secs, cad, hr, km, kph, nm, watts, alt, lon, lat, headwind, slope, temp, interval, lrbalance, lte, rte, lps, rps, smo2, thb, o2hb, hhb, target\n";
-
-                disk_timer->start(SAMPLERATE);  // start screen
+                // it journals every poll
+                telemetry->setJournal(journal);
             }
         }
         gui_timer->start(REFRESHRATE);      // start recording
@@ -1281,7 +1278,7 @@ void TrainSidebar::Pause()        // pause capture to recalibrate
         clearStatusFlags(RT_PAUSED);
         foreach(int dev, activeDevices) Devices[dev].controller->restart();
         gui_timer->start(REFRESHRATE);
-        if (status & RT_RECORDING) disk_timer->start(SAMPLERATE);
+        telemetry->setPaused(false);
         load_period.restart();
         if (status & RT_WORKOUT) load_timer->start(LOADRATE);
 
@@ -1301,7 +1298,7 @@ void TrainSidebar::Pause()        // pause capture to recalibrate
         foreach(int dev, activeDevices) Devices[dev].controller->pause();
         setStatusFlags(RT_PAUSED);
         gui_timer->stop();
-        if (status & RT_RECORDING) disk_timer->stop();
+        telemetry->setPaused(true);
         if (status & RT_WORKOUT) load_timer->stop();
         load_msecs += load_period.restart();
 
@@ -1328,6 +1325,7 @@ void TrainSidebar::Stop(int deviceStatus)        // when stop button is pressed
 #endif
 
     clearStatusFlags(RT_RUNNING|RT_PAUSED);
+    telemetry->end();
 
     // Stop users from selecting different devices
     // media or workouts whilst a workout is in progress
@@ -1358,27 +1356,19 @@ void TrainSidebar::Stop(int deviceStatus)        // when stop button is pressed
     QDateTime now = QDateTime::currentDateTime();
 
     if (status & RT_RECORDING) {
-        disk_timer->stop();
+        telemetry->setJournal(NULL);
 
         // close and reset File
-        recordFile->close();
-
-        // close rrFile
-        if (rrFile) {
-            //fprintf(stderr, "Closing r-r file\n"); fflush(stderr);
-            rrFile->close();
-            delete rrFile;
-            rrFile=NULL;
-        }
+        journal->close();
 
         if(deviceStatus == DEVICE_ERROR)
         {
-            recordFile->remove();
+            journal->remove();
         }
         else {
             // add to the view - using basename ONLY
             QString name;
-            name = recordFile->fileName();
+            name = journal->fileName();
 
             QList<QString> list;
             list.append(name);
@@ -1502,6 +1492,19 @@ void TrainSidebar::Connect()
         Devices[dev].controller->start();
         Devices[dev].controller->resetCalibrationState();
     }
+
+    // poll them on the telemetry thread, when they can be
+    QList<TrainTelemetry::Device> polling;
+    foreach(int dev, activeDevices) {
+        TrainTelemetry::Device device;
+        device.index = dev;
+        device.type = Devices[dev].type;
+        device.controller = Devices[dev].controller;
+        polling << device;
+    }
+    polled.clear();
+    telemetry->open(polling, bpmTelemetry, rpmTelemetry, kphTelemetry, wattsTelemetry);
+
     setStatusFlags(RT_CONNECTED);
     gui_timer->start(REFRESHRATE);
 
@@ -1518,6 +1521,7 @@ void TrainSidebar::Disconnect()
 
     qDebug() << "disconnecting..";
 
+    telemetry->close();
     foreach(int dev, activeDevices) Devices[dev].controller->stop();
     clearStatusFlags(RT_CONNECTED);
 
@@ -1551,6 +1555,13 @@ void TrainSidebar::guiUpdate()           // refreshes the telemetry
         IOReturn suspendSreensaverSuccess = IOPMAssertionCreateWithName(kIOPMAssertionTypeNoDisplaySleep, kIOPMAssertionLevelOn, reasonForActivity, &assertionID);
 #endif
 
+        // whatever the telemetry thread polled since last time
+        TrainSample sample;
+        while (telemetry->next(sample)) {
+            if (sample.device >= 0) polled.insert(sample.device, sample.data);
+            latest = sample;
+        }
+
         if(calibrating) {
             foreach(int dev, activeDevices) { // Do for selected device only
                 RealtimeData local = rtData;
@@ -1609,60 +1620,22 @@ void TrainSidebar::guiUpdate()           // refreshes the telemetry
             // fetch the right data from each device...
             foreach(int dev, activeDevices) {
 
+                // the telemetry thread polls the ones it can
                 RealtimeData local = rtData;
-                Devices[dev].controller->getRealtimeData(local);
-
-                // get spinscan data from a computrainer?
-                if (Devices[dev].type == DEV_CT) {
-                    memcpy((uint8_t*)rtData.spinScan, (uint8_t*)local.spinScan, 24);
-                    rtData.setLoad(local.getLoad()); // and get load in case it was adjusted
-                    rtData.setSlope(local.getSlope()); // and get slope in case it was adjusted
-                    // to within defined limits
-                }
-
-                if (Devices[dev].type == DEV_FORTIUS || Devices[dev].type == DEV_IMAGIC) {
-	                rtData.setLoad(local.getLoad()); // and get load in case it was adjusted
-                    rtData.setSlope(local.getSlope()); // and get slope in case it was adjusted
-					// to within defined limits
-				}
-
-                if (Devices[dev].type == DEV_ANTLOCAL || Devices[dev].type == DEV_NULL) {
-                    rtData.setHb(local.getSmO2(), local.gettHb()); //only moxy data from ant and robot devices right now
+                if (Devices[dev].controller->threadSafe()) {
+                    if (!polled.contains(dev)) continue;
+                    local = polled.value(dev);
+                } else {
+                    Devices[dev].controller->getRealtimeData(local);
                 }
 
-                // what are we getting from this one?
-                if (dev == bpmTelemetry) rtData.setHr(local.getHr());
-                if (dev == rpmTelemetry) rtData.setCadence(local.getCadence());
-                if (dev == kphTelemetry) {
-                    rtData.setSpeed(local.getSpeed());
-                    rtData.setDistance(local.getDistance());
-                    rtData.setLapDistance(local.getLapDistance());
-                    rtData.setLapDistanceRemaining(local.getLapDistanceRemaining());
-                }
-                if (dev == wattsTelemetry) {
-                    rtData.setWatts(local.getWatts());
-                    rtData.setAltWatts(local.getAltWatts());
-                    rtData.setLRBalance(local.getLRBalance());
-                    rtData.setLTE(local.getLTE());
-                    rtData.setRTE(local.getRTE());
-                    rtData.setLPS(local.getLPS());
-                    rtData.setRPS(local.getRPS());
-                }
-                if (local.getTrainerStatusAvailable())
-                {
-                    rtData.setTrainerStatusAvailable(true);
-                    rtData.setTrainerReady(local.getTrainerReady());
-                    rtData.setTrainerRunning(local.getTrainerRunning());
-                    rtData.setTrainerCalibRequired(local.getTrainerCalibRequired());
-                    rtData.setTrainerConfigRequired(local.getTrainerConfigRequired());
-                    rtData.setTrainerBrakeFault(local.getTrainerBrakeFault());
-                }
+                telemetry->merge(rtData, local, dev, Devices[dev].type);
             }
 
             // only update time & distance if actively running (not just connected, and not running but paused)
             if ((status&RT_RUNNING) && ((status&RT_PAUSED) == 0)) {
-                // Distance assumes current speed for the last second. from km/h to km/sec
-                double distanceTick = displaySpeed / (5 * 3600); // assumes 200ms refreshrate
+                // the telemetry thread adds up the distance as it polls
+                double distanceTick = qMax(0.0, latest.distance - displayDistance);
                 displayDistance += distanceTick;
                 displayLapDistance += distanceTick;
                 displayLapDistanceRemaining -= distanceTick;
@@ -1811,6 +1784,9 @@ void TrainSidebar::guiUpdate()           // refreshes the telemetry
 
             rtData.setWbal(wbal);
 
+            // the telemetry thread records it, with what it polled over it
+            telemetry->setShown(rtData);
+
             // go update the displays...
             context->notifyTelemetryUpdate(rtData); // signal everyone to update telemetry
 
@@ -1890,82 +1866,6 @@ void TrainSidebar::warnnoConfig()
     QMessageBox::warning(this, tr("No Devices Configured"), tr("Please configure a device in Preferences."));
 }
 
-template<class T, typename T_GetMethod, typename T_SetMethod, typename T_arg>
-struct ScopedOp
-{
-    T* m_pt;
-    T_SetMethod m_setMethod;
-    T_arg m_argSave;
-
-    ScopedOp(T* pt, T_GetMethod getMethod, T_SetMethod setMethod, T_arg argNew) : m_pt(pt), m_setMethod(setMethod) {
-        m_argSave = (m_pt->*getMethod)();
-        (m_pt->*m_setMethod)(argNew);
-    }
-
-    virtual ~ScopedOp() { (m_pt->*m_setMethod)(m_argSave); }
-};
-
-struct ScopedPrecision : ScopedOp<QTextStream, int (QTextStream::*)() const, void (QTextStream::*)(int), int> {
-    ScopedPrecision(QTextStream* pc, int tempPrecision) : ScopedOp::ScopedOp(pc, &QTextStream::realNumberPrecision, &QTextStream::setRealNumberPrecision, tempPrecision) {}
-};
-
-//----------------------------------------------------------------------
-// DISK UPDATE FUNCTIONS
-//----------------------------------------------------------------------
-void TrainSidebar::diskUpdate()
-{
-    int  secs;
-
-    long torq = 0;
-    QTextStream recordFileStream(recordFile);
-
-    if (calibrating) return;
-
-    // convert from milliseconds to secondes
-    total_msecs = session_elapsed_msec + session_time.elapsed();
-    secs = round(total_msecs / 1000.0);
-
-    if (secs <= lastRecordSecs) return; // Avoid duplicates
-    lastRecordSecs = secs;
-
-    // GoldenCheetah CVS Format "secs, cad, hr, km, kph, nm, watts, alt, lon, lat, headwind, slope, temp, interval, lrbalance, lte, rte, lps, rps, smo2, thb, o2hb, hhb\n";
-
-    recordFileStream    << secs
-                        << "," << displayCadence
-                        << "," << displayHeartRate
-                        << "," << displayDistance
-                        << "," << displaySpeed
-                        << "," << torq
-                        << "," << displayPower;
-
-    // QTextStream default precision is 6, location data needs much more than that.
-    // Avoid extra precision for other fields since it isn't needed and would grow
-    // the intermediate file for no reason.
-    {
-        ScopedPrecision tempPrecision(&recordFileStream, 20);
-
-        recordFileStream << "," << displayAltitude
-                         << "," << displayLongitude
-                         << "," << displayLatitude;
-    }
-
-    recordFileStream    << "," // headwind
-                        << "," // slope
-                        << "," // temp
-                        << "," << (displayLap + displayWorkoutLap)
-                        << "," << displayLRBalance
-                        << "," << displayLTE
-                        << "," << displayRTE
-                        << "," << displayLPS
-                        << "," << displayRPS
-                        << "," << displaySMO2
-                        << "," << displayTHB
-                        << "," << displayO2HB
-                        << "," << displayHHB
-                        << "," << load
-                        << "," << "\n";
-}
-
 //----------------------------------------------------------------------
 // WORKOUT MODE
 //----------------------------------------------------------------------
@@ -1982,6 +1882,10 @@ void TrainSidebar::loadUpdate()
     load_msecs += load_period.restart();
 
     if (status&RT_MODE_ERGO) {
+
+        // the telemetry thread keeps the time and sets the load on the
+        // devices it polls, we keep up with it for the rest
+        load_msecs = latest.workoutMsecs;
         load = ergFile->wattsAt(load_msecs, curLap);
 
         if(displayWorkoutLap != curLap)
@@ -1996,7 +1900,8 @@ void TrainSidebar::loadUpdate()
         if (load == -100) {
             Stop(DEVICE_OK);
         } else {
-            foreach(int dev, activeDevices) Devices[dev].controller->setLoad(load);
+            foreach(int dev, activeDevices)
+                if (!Devices[dev].controller->threadSafe()) Devices[dev].controller->setLoad(load);
             context->notifySetNow(load_msecs);
         }
     } else {
@@ -2050,7 +1955,7 @@ void TrainSidebar::toggleCalibration()
 
         clearStatusFlags(RT_CALIBRATING);
         if (status & RT_WORKOUT) load_timer->start(LOADRATE);
-        if (status & RT_RECORDING) disk_timer->start(SAMPLERATE);
+        telemetry->setCalibrating(false);
         context->notifyUnPause(); // get video started again, amongst other things
 
         // back to ergo/slope mode and restore load/gradient
@@ -2082,7 +1987,7 @@ void TrainSidebar::toggleCalibration()
         lap_elapsed_msec += lap_time.elapsed();
 
         setStatusFlags(RT_CALIBRATING);
-        if (status & RT_RECORDING) disk_timer->stop();
+        telemetry->setCalibrating(true); // before we poll the device ourselves
         if (status & RT_WORKOUT) load_timer->stop();
         load_msecs += load_period.restart();
 
@@ -2327,6 +2232,8 @@ void TrainSidebar::FFwd()
 
     if (status&RT_MODE_ERGO) {
         load_msecs += 10000; // jump forward 10 seconds
+        telemetry->seek(load_msecs);
+        latest.workoutMsecs = load_msecs;
         context->notifySeek(load_msecs);
     }
     else if (context->currentVideoSyncFile())
@@ -2345,6 +2252,8 @@ void TrainSidebar::Rewind()
     if (status&RT_MODE_ERGO) {
         load_msecs -=10000; // jump back 10 seconds
         if (load_msecs < 0) load_msecs = 0;
+        telemetry->seek(load_msecs);
+        latest.workoutMsecs = load_msecs;
         context->notifySeek(load_msecs);
     }
     else if (context->currentVideoSyncFile())
@@ -2370,6 +2279,8 @@ void TrainSidebar::FFwdLap()
     if (status&RT_MODE_ERGO) {
         lapmarker = ergFile->nextLap(load_msecs);
         if (lapmarker != -1) load_msecs = lapmarker; // jump forward to lapmarker
+        telemetry->seek(load_msecs);
+        latest.workoutMsecs = load_msecs;
         context->notifySeek(load_msecs);
     } else {
         lapmarker = ergFile->nextLap(displayWorkoutDistance*1000);
@@ -2520,6 +2431,9 @@ void TrainSidebar::adjustIntensity(int value)
     context->currentErgFile()->calculateMetrics();
     setLabels();
 
+    // the telemetry thread has its own copy
+    telemetry->setWorkout(context->currentErgFile());
+
     // unblock signals now we are done
     context->mainWindow->blockSignals(false);
 
@@ -2767,33 +2681,8 @@ TrainSidebar::remoteControl(uint16_t command)
 // HRV R-R data received
 void TrainSidebar::rrData(uint16_t  rrtime, uint8_t count, uint8_t bpm)
 {
-    if (status&RT_RECORDING && rrFile == NULL && recordFile != NULL) {
-        QString rrfile = recordFile->fileName().replace("csv", "rr");
-        //fprintf(stderr, "First r-r, need to open file %s\n", rrfile.toStdString().c_str()); fflush(stderr);
-
-        // setup the rr file
-        rrFile = new QFile(rrfile);
-        if (!rrFile->open(QFile::WriteOnly | QFile::Truncate)) {
-            delete rrFile;
-            rrFile=NULL;
-        } else {
-
-            // CSV File header
-            QTextStream recordFileStream(rrFile);
-            recordFileStream << "secs, hr, msecs\n";
-        }
-    }
-
-    // output a line if recording and file ready
-    if (status&RT_RECORDING && rrFile) {
-        QTextStream recordFileStream(rrFile);
-
-        // convert from milliseconds to secondes
-        double secs = double(session_elapsed_msec + session_time.elapsed()) / 1000.00;
-
-        // output a line
-        recordFileStream << secs << ", " << bpm << ", " << rrtime << "\n";
-    }
+    // they go in the journal with everything else
+    if (status&RT_RECORDING) telemetry->addRR(bpm, rrtime);
     //fprintf(stderr, "R-R: %d ms, HR=%d, count=%d\n", rrtime, bpm, count); fflush(stderr);
 }
 
@@ -23,6 +23,8 @@
 #include "Context.h"
 #include "RealtimeData.h"
 #include "RealtimePlot.h"
+#include "TrainTelemetry.h"
+#include "TrainJournal.h"
 #include "DeviceConfiguration.h"
 #include "DeviceTypes.h"
 #include "ErgFile.h"
@@ -43,6 +45,7 @@
 #include <QHeaderView>
 #include <QFormLayout>
 #include <QSqlTableModel>
+#include <QHash>
 
 #include "cmath" // for round()
 #include "Units.h" // for MILES_PER_KM
@@ -66,6 +69,7 @@
 #define STREAMRATE     200 // rate at which we stream updates to remote peer
 #define SAMPLERATE     1000 // disk update in milliseconds
 #define LOADRATE       1000 // rate at which load is adjusted
+#define SYNCRATE       10000 // rate at which the journal is forced to disk
 
 // device treeview node types
 #define HEAD_TYPE    6666
@@ -190,7 +194,6 @@ class TrainSidebar : public GcWindow
 
         // Timed actions
         void guiUpdate();           // refreshes the telemetry
-        void diskUpdate();          // writes to CSV file
         void loadUpdate();          // sets Load on CT like devices
 
         // When no config has been setup
@@ -267,9 +270,7 @@ class TrainSidebar : public GcWindow
         int status;
         int displaymode;
 
-        QFile *recordFile;      // where we record!
-        int lastRecordSecs;     // to avoid duplicates
-        QFile *rrFile;          // r-r records, if any received.
+        TrainJournal *journal;  // where we record!
         ErgFile *ergFile;       // workout file
         VideoSyncFile *videosyncFile;       // videosync file
 
@@ -289,8 +290,12 @@ class TrainSidebar : public GcWindow
         QTime session_time, lap_time;
 
         QTimer      *gui_timer,     // refresh the gui
-                    *load_timer,    // change the load on the device
-                    *disk_timer;    // write to .CSV file
+                    *load_timer;    // change the load on the device
+
+        // polls, records and runs ERG workouts off the gui thread
+        TrainTelemetry *telemetry;
+        TrainSample latest;                 // last we had from it
+        QHash<int, RealtimeData> polled;    // for each device it polls
 
         bool autoConnect;
         bool pendingConfigChange;
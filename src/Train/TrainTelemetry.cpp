@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TrainTelemetry.h"
+#include "TrainSidebar.h"
+#include "RealtimeController.h"
+#include "DeviceTypes.h"
+#include "ErgFile.h"
+#include "TrainJournal.h"
+
+#include <QDebug>
+#include <string.h>
+
+TrainTelemetry::TrainTelemetry(Context *context, QObject *parent) :
+    QThread(parent), context(context), bpm(-1), rpm(-1), kph(-1), watts(-1), quit(false),
+    running(false), paused(false), calibrating(false), counted(0),
+    workout(NULL), workoutBase(0), workoutFrom(0), load(0),
+    polled(0), distance(0), journal(NULL), syncing(false), syncFailed(false), busy(false)
+{
+}
+
+TrainTelemetry::~TrainTelemetry()
+{
+    close();
+    delete workout;
+}
+
+void
+TrainTelemetry::open(QList<Device> devices, int bpm, int rpm, int kph, int watts)
+{
+    close();
+
+    // only ever read on the thread, so no need to lock
+    this->devices = devices;
+    this->bpm = bpm;
+    this->rpm = rpm;
+    this->kph = kph;
+    this->watts = watts;
+
+    // whatever the gui didn't get last time
+    TrainSample stale;
+    while (samples.pop(stale)) ;
+
+    quit = false;
+    start(QThread::HighPriority);
+}
+
+void
+TrainTelemetry::close()
+{
+    if (!isRunning()) return;
+
+    lock.lock();
+    quit = true;
+    wake.wakeAll();
+    lock.unlock();
+
+    wait();
+}
+
+void
+TrainTelemetry::begin(ErgFile *workout)
+{
+    QMutexLocker locker(&lock);
+
+    running = true;
+    paused = calibrating = false;
+    counted = 0;
+    since.start();
+
+    delete this->workout;
+    this->workout = NULL;
+    if (workout) {
+        this->workout = new ErgFile(context);
+        this->workout->setFrom(workout);
+    }
+    workoutBase = 0;
+    workoutFrom = 0;
+    load = 100;
+
+    polled = 0;
+    distance = 0;
+
+    wake.wakeAll();
+}
+
+void
+TrainTelemetry::setPaused(bool paused)
+{
+    QMutexLocker locker(&lock);
+    count();
+    this->paused = paused;
+    if (running && !this->paused && !calibrating) since.start();
+}
+
+void
+TrainTelemetry::setCalibrating(bool calibrating)
+{
+    // when this returns we aren't in the middle of polling, the
+    // gui is about to poll the device being calibrated itself
+    QMutexLocker locker(&lock);
+    while (busy) idle.wait(&lock);
+    count();
+    this->calibrating = calibrating;
+    if (running && !paused && !this->calibrating) since.start();
+}
+
+void
+TrainTelemetry::end()
+{
+    QMutexLocker locker(&lock);
+    running = paused = calibrating = false;
+    delete workout;
+    workout = NULL;
+    while (syncing) synced.wait(&lock);
+    journal = NULL;
+
+    // so what is polled till the next begin() doesn't look like this one
+    counted = 0;
+    polled = 0;
+    distance = 0;
+}
+
+void
+TrainTelemetry::setWorkout(ErgFile *workout)
+{
+    QMutexLocker locker(&lock);
+    if (!this->workout || !workout) return;
+    this->workout->setFrom(workout);
+}
+
+void
+TrainTelemetry::seek(long workoutMsecs)
+{
+    QMutexLocker locker(&lock);
+    workoutBase = workoutMsecs;
+    workoutFrom = active();
+    wake.wakeAll(); // set the load now
+}
+
+void
+TrainTelemetry::setJournal(TrainJournal *journal)
+{
+    // when this returns we aren't writing to, or syncing, the old one
+    QMutexLocker locker(&lock);
+    while (syncing) synced.wait(&lock);
+    if (this->journal) this->journal->flush();
+    this->journal = journal;
+    syncFailed = false;
+}
+
+void
+TrainTelemetry::addRR(int bpm, int rr)
+{
+    QMutexLocker locker(&lock);
+    if (journal) journal->appendRR(active(), bpm, rr);
+}
+
+void
+TrainTelemetry::setShown(const RealtimeData &shown)
+{
+    QMutexLocker locker(&lock);
+    this->shown = shown;
+}
+
+// the time counted so far, msecs running and not paused or calibrating
+qint64
+TrainTelemetry::active() const
+{
+    if (running && !paused && !calibrating) return counted + since.elapsed();
+    return counted;
+}
+
+// stop the clock, before changing what is counted
+void
+TrainTelemetry::count()
+{
+    counted = active();
+    since.start();
+}
+
+void
+TrainTelemetry::run()
+{
+    QMutexLocker locker(&lock);
+
+    QElapsedTimer clock;
+    clock.start();
+    qint64 nextLoad = 0, nextPoll = 0, nextFlush = 0, nextSync = SYNCRATE;
+
+    while (!quit) {
+
+        // the load first so it goes out with the poll, which journals
+        // it, and the journal is passed on last with what was just polled
+        qint64 msecs = clock.elapsed();
+        if (msecs >= nextLoad) {
+            updateLoad();
+            while (nextLoad <= msecs) nextLoad += LOADRATE;
+        }
+        if (msecs >= nextPoll) {
+            poll();
+            while (nextPoll <= msecs) nextPoll += REFRESHRATE;
+        }
+        if (msecs >= nextFlush) {
+            if (journal) journal->flush();
+            while (nextFlush <= msecs) nextFlush += SAMPLERATE;
+        }
+        if (msecs >= nextSync) {
+            sync();
+            while (nextSync <= msecs) nextSync += SYNCRATE;
+        }
+
+        // sleep till the next one, unless woken to do it now
+        qint64 wait = qMin(qMin(nextPoll, nextLoad), qMin(nextFlush, nextSync)) - clock.elapsed();
+        if (wait <= 0 || !wake.wait(&lock, (unsigned long)wait)) continue;
+
+        // woken by begin() or seek(), start over
+        if (!quit) nextLoad = nextPoll = nextFlush = clock.elapsed();
+    }
+}
+
+void
+TrainTelemetry::updateLoad()
+{
+    if (!workout || !running || paused || calibrating) return;
+
+    int lap;
+    long msecs = workoutBase + active() - workoutFrom;
+    load = workout->wattsAt(msecs, lap);
+
+    // we got to the end, the gui will stop
+    if (load == -100) return;
+
+    long setting = load;
+    busy = true;
+    lock.unlock();
+
+    foreach(const Device &device, devices)
+        if (device.controller->threadSafe()) device.controller->setLoad(setting);
+
+    lock.lock();
+    busy = false;
+    idle.wakeAll();
+}
+
+void
+TrainTelemetry::poll()
+{
+    if (calibrating) return;
+
+    // the gui's, with what the devices here have to say over it
+    RealtimeData now = shown;
+    if (workout) now.setLoad(load);
+
+    // the devices are polled without the lock, the gui can carry on
+    // telling us things meanwhile
+    busy = true;
+    lock.unlock();
+
+    TrainSample sample;
+    QList<TrainSample> polls;
+    foreach(const Device &device, devices) {
+
+        if (!device.controller->threadSafe()) continue;
+
+        RealtimeData local = now;
+        device.controller->getRealtimeData(local);
+        merge(now, local, device.index, device.type);
+
+        sample.device = device.index;
+        sample.data = local;
+        polls << sample;
+    }
+
+    lock.lock();
+    busy = false;
+    idle.wakeAll();
+
+    // when, as of now, the session may have changed while we polled
+    sample.msecs = active();
+    sample.workoutMsecs = workoutBase + sample.msecs - workoutFrom;
+    for (int i=0; i<polls.count(); i++) {
+        polls[i].msecs = sample.msecs;
+        polls[i].workoutMsecs = sample.workoutMsecs;
+    }
+
+    // distance assumes the speed since the last time
+    distance += now.getSpeed() * (sample.msecs - polled) / 3600000.0;
+    polled = sample.msecs;
+
+    // everything, as it was polled
+    if (journal && running && !paused) journal->append(sample.msecs, now, distance);
+
+    // the gui still wants to know the time and distance
+    if (polls.isEmpty()) polls << sample;
+
+    foreach(TrainSample each, polls) {
+        each.distance = distance;
+        samples.push(each);
+    }
+}
+
+// on disk, in case the machine goes down. it can take a while so the
+// gui can carry on meanwhile, but not close the journal under us
+void
+TrainTelemetry::sync()
+{
+    if (!journal || syncing) return;
+
+    journal->flush();
+    int handle = journal->handle();
+
+    syncing = true;
+    lock.unlock();
+    bool ok = TrainJournal::sync(handle);
+    lock.lock();
+    syncing = false;
+    synced.wakeAll();
+
+    // once per journal, it will keep failing
+    if (!ok && !syncFailed) {
+        qDebug()<<"train journal"<<journal->fileName()<<"not synced to disk, a crash may lose the last samples";
+        syncFailed = true;
+    }
+}
+
+// what the gui used to do with each device as it polled it
+void
+TrainTelemetry::merge(RealtimeData &rtData, const RealtimeData &local, int dev, int type) const
+{
+    // get spinscan data from a computrainer?
+    if (type == DEV_CT) {
+        memcpy((uint8_t*)rtData.spinScan, (uint8_t*)local.spinScan, 24);
+        rtData.setLoad(local.getLoad()); // and get load in case it was adjusted
+        rtData.setSlope(local.getSlope()); // and get slope in case it was adjusted
+        // to within defined limits
+    }
+
+    if (type == DEV_FORTIUS || type == DEV_IMAGIC) {
+        rtData.setLoad(local.getLoad()); // and get load in case it was adjusted
+        rtData.setSlope(local.getSlope()); // and get slope in case it was adjusted
+        // to within defined limits
+    }
+
+    if (type == DEV_ANTLOCAL || type == DEV_NULL) {
+        rtData.setHb(local.getSmO2(), local.gettHb()); //only moxy data from ant and robot devices right now
+    }
+
+    // what are we getting from this one?
+    if (dev == bpm) rtData.setHr(local.getHr());
+    if (dev == rpm) rtData.setCadence(local.getCadence());
+    if (dev == kph) {
+        rtData.setSpeed(local.getSpeed());
+        rtData.setDistance(local.getDistance());
+        rtData.setLapDistance(local.getLapDistance());
+        rtData.setLapDistanceRemaining(local.getLapDistanceRemaining());
+    }
+    if (dev == watts) {
+        rtData.setWatts(local.getWatts());
+        rtData.setAltWatts(local.getAltWatts());
+        rtData.setLRBalance(local.getLRBalance());
+        rtData.setLTE(local.getLTE());
+        rtData.setRTE(local.getRTE());
+        rtData.setLPS(local.getLPS());
+        rtData.setRPS(local.getRPS());
+    }
+    if (local.getTrainerStatusAvailable())
+    {
+        rtData.setTrainerStatusAvailable(true);
+        rtData.setTrainerReady(local.getTrainerReady());
+        rtData.setTrainerRunning(local.getTrainerRunning());
+        rtData.setTrainerCalibRequired(local.getTrainerCalibRequired());
+        rtData.setTrainerConfigRequired(local.getTrainerConfigRequired());
+        rtData.setTrainerBrakeFault(local.getTrainerBrakeFault());
+    }
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2026 Notio Technologies
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_TrainTelemetry_h
+#define _GC_TrainTelemetry_h 1
+#include "GoldenCheetah.h"
+
+#include "RealtimeData.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QList>
+
+class Context;
+class ErgFile;
+class RealtimeController;
+class TrainJournal;
+
+// A ring of samples for one thread to push and another to pop, neither
+// ever waits for the other. N must be a power of 2, when it is full the
+// newest are dropped. head and tail count modulo 2N so full and empty
+// can be told apart.
+template <class T, int N>
+class TelemetryRing
+{
+    public:
+        TelemetryRing() : head(0), tail(0) {}
+
+        bool push(const T &value) {
+            int h = head.load();
+            if (((h - tail.loadAcquire()) & (2*N - 1)) == N) return false;
+            items[h & (N - 1)] = value;
+            head.storeRelease((h + 1) & (2*N - 1));
+            return true;
+        }
+
+        bool pop(T &value) {
+            int t = tail.load();
+            if (t == head.loadAcquire()) return false;
+            value = items[t & (N - 1)];
+            tail.storeRelease((t + 1) & (2*N - 1));
+            return true;
+        }
+
+    private:
+        T items[N];
+        QAtomicInt head, tail;
+};
+
+// a device as polled on the telemetry thread, along with where the
+// session and the workout had got to when it was
+struct TrainSample
+{
+    TrainSample() : msecs(0), device(-1), workoutMsecs(0), distance(0) {}
+
+    qint64 msecs;       // running, not paused or calibrating
+    int device;         // Devices index, -1 if none are polled on the thread
+    RealtimeData data;
+
+    long workoutMsecs;  // ERG workouts only
+    double distance;    // km
+};
+
+// TrainTelemetry is the thread that keeps train mode going when the GUI
+// is busy repainting charts. While connected it polls the devices, runs
+// ERG workouts (the load is set on the devices every LOADRATE) and, when
+// recording, journals every poll, all on its own clock.
+//
+// Only controllers that say they are threadSafe() are polled here, the
+// others show dialogs and stop the workout when they fail so the GUI
+// still polls them. What they last gave (and the GUI's distance, lap and
+// location etc) is handed over with setShown() and recorded with the
+// rest. The journal is handed to the os every SAMPLERATE and synced to
+// disk every SYNCRATE, without holding the lock. The devices are polled
+// and have their load set without it too, so the GUI never waits on
+// device I/O.
+//
+// Each device polled here goes to the GUI as a TrainSample through a
+// ring, so TrainSidebar never waits on us and we never wait on it.
+class TrainTelemetry : public QThread
+{
+    public:
+
+        struct Device {
+            int index;      // into Devices
+            int type;       // DEV_xxx
+            RealtimeController *controller;
+        };
+
+        TrainTelemetry(Context *context, QObject *parent);
+        ~TrainTelemetry();
+
+        // polls the devices until close(), the Devices index for each series
+        void open(QList<Device> devices, int bpm, int rpm, int kph, int watts);
+        void close();
+
+        // a session; begin with the ERG workout to run, or NULL
+        void begin(ErgFile *workout);
+        void setPaused(bool paused);
+        void setCalibrating(bool calibrating); // the GUI polls then, we don't
+        void end();
+
+        // when running, copied as it may be changed when it is running
+        void setWorkout(ErgFile *workout);
+        void seek(long workoutMsecs);
+
+        // where to record, NULL to stop
+        void setJournal(TrainJournal *journal);
+
+        // R-R intervals go straight in, whenever they arrive
+        void addRR(int bpm, int rr);
+
+        // what the GUI last showed
+        void setShown(const RealtimeData &shown);
+
+        // from the GUI thread, false when there's no more
+        bool next(TrainSample &sample) { return samples.pop(sample); }
+
+        // add what a device gave to the telemetry, whichever thread polled it
+        void merge(RealtimeData &rtData, const RealtimeData &local, int device, int type) const;
+
+    protected:
+        void run();
+
+    private:
+
+        void updateLoad();
+        void poll();
+        void sync();
+
+        qint64 active() const; // msecs counting
+        void count();
+
+        Context *context;
+        QList<Device> devices;
+        int bpm, rpm, kph, watts;
+
+        QMutex lock; // everything below
+        QWaitCondition wake;
+        bool quit;
+
+        bool running, paused, calibrating;
+        QElapsedTimer since;
+        qint64 counted;
+
+        ErgFile *workout;
+        long workoutBase;
+        qint64 workoutFrom;
+        long load;
+
+        qint64 polled;
+        double distance;
+        RealtimeData shown;
+
+        TrainJournal *journal;
+        bool syncing, syncFailed;
+        QWaitCondition synced;
+
+        // talking to the devices, which is done without the lock
+        bool busy;
+        QWaitCondition idle;
+
+        TelemetryRing<TrainSample, 256> samples;
+};
+
+#endif // _GC_TrainTelemetry_h
@@ -113,8 +113,11 @@ int USBXpress::close(HANDLE *handle)
 
 int USBXpress::read(HANDLE *handle, unsigned char *buf, int bytes)
 {
-    DWORD read;
-    if (SI_Read (*handle, buf, (DWORD) bytes, &read, NULL) == SI_SUCCESS)
+    // a read that times out short still returns what it got, callers
+    // ask for as much as there might be (see ANT::run)
+    DWORD read = 0;
+    int rc = SI_Read (*handle, buf, (DWORD) bytes, &read, NULL);
+    if (rc == SI_SUCCESS || rc == SI_READ_TIMED_OUT)
         return read;
     else return -1;
 }